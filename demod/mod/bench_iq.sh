@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# rs41mod --IQ: wall time (ms), best of 3, without and with --lp --dc
+#
+# usage: ./bench_iq.sh <iq.wav> <fq> [rs41mod ...]
+#   default binary ./rs41mod; several binaries (e.g. before/after builds) are compared
+#   test signal (RS/iq/wavIQ.c): FM-modulated rs41 audio, carrier +12 kHz (fq=0.25)
+#     ./wavIQ -fm ../../rs41/wav/rs41pre_20150802.wav > rs41fm.wav
+#     ./wavIQ -t 12000 rs41fm.wav > rs41iq.wav
+#     ./bench_iq.sh rs41iq.wav 0.25 ./rs41mod
+#
+
+IQ=$1
+FQ=$2
+if [ -z "$IQ" ] || [ ! -f "$IQ" ] || [ -z "$FQ" ]; then
+    echo "usage: $0 <iq.wav> <fq> [rs41mod ...]"
+    exit 1
+fi
+shift 2
+[ $# -eq 0 ] && set -- ./rs41mod
+
+best() {  # best of 3 runs, ms
+    b=0
+    for r in 1 2 3; do
+        t0=$(date +%s%N)
+        "$@" > /dev/null 2>&1
+        t1=$(date +%s%N)
+        t=$(( (t1-t0)/1000000 ))
+        if [ $b -eq 0 ] || [ $t -lt $b ]; then b=$t; fi
+    done
+    echo $b
+}
+
+printf "%-40s %8s %8s %7s\n" "" "--IQ" "--lp --dc" "frames"
+for bin in "$@"; do
+    n=$($bin -vx --ecc --crc -i --IQ $FQ "$IQ" 2>/dev/null | wc -l)
+    t1=$(best $bin -vx --ecc --crc -i --IQ $FQ "$IQ")
+    t2=$(best $bin -vx --ecc --crc -i --IQ $FQ --lp --dc "$IQ")
+    printf "%-40s %8d %8d %7d\n" "$bin" $t1 $t2 $n
+done
@@ -2,7 +2,8 @@
 /*
  *  sync header: correlation/matched filter
  *  compile:
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *
  *  author: zilog80
  */
@@ -15,65 +16,126 @@
 
 #include "demod_mod.h"
 
+#include "sample_io.h"  // RS/io/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+  #define FIR_X86
+  #include <immintrin.h>
+#endif
+
 #define FM_GAIN (0.8)
 
 /* ------------------------------------------------------------------------------------ */
 
 
-static void raw_dft(dft_t *dft, float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
+/*
+ * FFT plan: bit-reversal and twiddle tables are built once per dft_t
+ * (dft_init() in init_buffers()), so the transforms only do butterflies.
+ *   tw[k]   = exp(-2pi*I*k/N), k < N/2
+ *   brv[]   : N/2-point bit-reversal (real transform)
+ * A 2^m-point FFT, 2^m <= N, takes the twiddles with stride N/2^m.
+ */
+static void fft_raw(dft_t *dft, float complex *Z, int log2n, int *brv) {
+    int s, l, l2, i, j, k, st;
+    int n = 1 << log2n;
+    float complex  w, T;
 
-    j = 1;
-    for (i = 1; i < dft->N; i++) {
+    for (i = 0; i < n; i++) {
+        j = brv[i];
         if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = dft->N/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
+            T = Z[j];
+            Z[j] = Z[i];
+            Z[i] = T;
         }
-        j = j + k;
     }
 
-    for (s = 0; s < dft->LOG2N; s++) {
+    for (s = 0; s < log2n; s++) {
         l2 = 1 << s;
         l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = dft->ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= dft->N; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
+        st = dft->N / l; // cexp(-I*M_PI*j/(float)l2) = tw[j*st]
+        for (i = 0; i < n; i += l) {
+            for (j = 0; j < l2; j++) {
+                w = dft->tw[j*st];
+                k = i + j;
+                T = c_mul(Z[k+l2], w);
+                Z[k+l2] = Z[k] - T;
+                Z[k]    = Z[k] + T;
             }
-            w1 = w1 * w2;
         }
     }
 }
 
-static void cdft(dft_t *dft, float complex *z, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = z[i];
-    raw_dft(dft, Z);
+// real input: N/2-point complex FFT of z[n] = x[2n] + I*x[2n+1],
+// split into even/odd spectra; Z[N/2+1..N-1] = conj(Z[N-k]) for drop-in use
+static void rdft(dft_t *dft, float *x, float complex *Z) {
+    int k;
+    int N2 = dft->N/2;
+    float complex  Xe, Xo, a, b, d;
+
+    for (k = 0; k < N2; k++)  Z[k] = c_cf(x[2*k], x[2*k+1]);
+    fft_raw(dft, Z, dft->LOG2N-1, dft->brv);
+
+    a = Z[0];
+    Z[0]  = crealf(a) + cimagf(a);
+    Z[N2] = crealf(a) - cimagf(a);
+    for (k = 1; k <= N2/2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        d = a - b;
+        Xe = 0.5f*(a + b);
+        Xo = c_cf(0.5f*cimagf(d), -0.5f*crealf(d)); // -0.5*I*(a-b)
+        Z[k]    = Xe + c_mul(dft->tw[k], Xo);
+        Z[N2-k] = conjf(Xe) + c_mul(dft->tw[N2-k], conjf(Xo));
+    }
+    for (k = N2+1; k < dft->N; k++)  Z[k] = conjf(Z[dft->N-k]);
 }
 
-static void rdft(dft_t *dft, float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = (float complex)x[i];
-    raw_dft(dft, Z);
+// real output: x = N*idft(Z), Z hermitian, only Z[0..N/2] is read;
+// dft->cx is used as N/2-point work buffer
+static void irdft(dft_t *dft, float complex *Z, float *x) {
+    int k;
+    int N2 = dft->N/2;
+    float complex *z = dft->cx;
+    float complex  Xe, Xo, a, b;
+
+    for (k = 0; k < N2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        Xe = a + b;
+        Xo = c_mulconj(a - b, dft->tw[k]);
+        z[k] = c_cf(crealf(Xe) - cimagf(Xo), -(cimagf(Xe) + crealf(Xo))); // conj(Xe + I*Xo)
+    }
+    fft_raw(dft, z, dft->LOG2N-1, dft->brv);
+    for (k = 0; k < N2; k++) {
+        x[2*k  ] =  crealf(z[k]);
+        x[2*k+1] = -cimagf(z[k]);
+    }
 }
 
-static void Nidft(dft_t *dft, float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  z[i] = conj(Z[i]);
-    raw_dft(dft, z);
-    // idft():
-    // for (i = 0; i < dft->N; i++)  z[i] = conj(z[i])/(float)dft->N; // hier: z reell
+static int bitrev(int i, int log2n) {
+    int j = 0;
+    while (log2n-- > 0) {
+        j = (j << 1) | (i & 1);
+        i >>= 1;
+    }
+    return j;
+}
+
+static int dft_init(dft_t *dft) {
+    int k;
+
+    dft->tw   = calloc(dft->N/2+1, sizeof(float complex));  if (dft->tw   == NULL) return -1;
+    dft->brv  = calloc(dft->N/2+1, sizeof(int));            if (dft->brv  == NULL) return -1;
+
+    for (k = 0; k < dft->N/2; k++)  dft->tw[k] = cexp(-2*M_PI*I*k/(double)dft->N);
+    for (k = 0; k < dft->N/2; k++)  dft->brv[k]  = bitrev(k, dft->LOG2N-1);
+
+    return 0;
+}
+
+static void dft_free(dft_t *dft) {
+    if (dft->tw)   { free(dft->tw);   dft->tw   = NULL; }
+    if (dft->brv)  { free(dft->brv);  dft->brv  = NULL; }
 }
 
 static float bin2freq0(dft_t *dft, int k) {
@@ -98,8 +160,8 @@ static int max_bin(dft_t *dft, float complex *Z) {
 
     max = 0; kmax = 0;
     for (k = 0; k < dft->N; k++) {
-        if (cabs(Z[k]) > max) {
-            max = cabs(Z[k]);
+        if (c_abs2(Z[k]) > max) {
+            max = c_abs2(Z[k]);
             kmax = k;
         }
     }
@@ -139,6 +201,11 @@ static int dft_window(dft_t *dft, int w) {
 
 /* ------------------------------------------------------------------------------------ */
 
+// flops: complex radix-2 FFT, n-point
+static double fft_ops(int n) {
+    return 5.0*n*log2(n);
+}
+
 static int getCorrDFT(dsp_t *dsp) {
     int i;
     int mp = -1;
@@ -146,10 +213,12 @@ static int getCorrDFT(dsp_t *dsp) {
     float mx2 = 0.0;
     float re_cx = 0.0;
     float xnorm = 1;
+    float x;
     ui32_t mpos = 0;
     ui32_t pos = dsp->sample_out;
 
     double dc = 0.0;
+    float ydc = 0.0;
     int mp_ofs = 0;
     float *sbuf = dsp->bufs;
 
@@ -167,11 +236,18 @@ static int getCorrDFT(dsp_t *dsp) {
     else {
         sbuf = dsp->bufs;
     }
+
     for (i = 0; i < dsp->K + dsp->L; i++) (dsp->DFT).xn[i] = sbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
     while (i < dsp->DFT.N) (dsp->DFT).xn[i++] = 0.0;
 
-
     rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
+    for (i = 0; i <= dsp->DFT.N/2; i++) dsp->DFT.Z[i] = c_mul(dsp->DFT.X[i], dsp->DFT.Fm[i]);
+    irdft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.yn);
+
+    // ops: rdft + irdft (N/2-point FFT + split), product on the half spectrum;
+    // ref: the complex path before rdft: N-point FFT, product, N-point inverse (--dc: a 2nd inverse)
+    dsp->ops_cor += 2*(fft_ops(dsp->DFT.N/2) + 5.0*dsp->DFT.N) + 6.0*(dsp->DFT.N/2+1);
+    dsp->ops_ref += (dsp->opt_dc ? 3 : 2)*fft_ops(dsp->DFT.N) + 6.0*dsp->DFT.N;
 
 
     if (dsp->opt_dc) {
@@ -181,15 +257,10 @@ static int getCorrDFT(dsp_t *dsp) {
         dc = 0.0;
         for (i = dsp->K - dsp->L; i < dsp->K + dsp->L; i++) dc += (dsp->DFT).xn[i];
         dc /= 2.0*(float)dsp->L;
-        dsp->DFT.X[0] -= dsp->DFT.N * dc  ;//* 0.95;
-        Nidft(&dsp->DFT, dsp->DFT.X, (dsp->DFT).cx);
-        for (i = 0; i < dsp->DFT.N; i++) (dsp->DFT).xn[i] = creal((dsp->DFT).cx[i])/(float)dsp->DFT.N;
+        // X[0] -= N*dc  <=>  yn[] -= N*dc*Fm[0]
+        ydc = dsp->DFT.N * dc * crealf(dsp->DFT.Fm[0]);
     }
 
-    for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-    Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
     if (fabs(dc) < 0.5) dsp->dc = dc;
 
 
@@ -200,7 +271,7 @@ static int getCorrDFT(dsp_t *dsp) {
     //
     mx2 = 0.0;                                      // t = L-1
     for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-        re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
+        re_cx = dsp->DFT.yn[i] - ydc;
         if (re_cx*re_cx > mx2) {
             mx = re_cx;
             mx2 = mx*mx;
@@ -214,7 +285,10 @@ static int getCorrDFT(dsp_t *dsp) {
 
     //xnorm = sqrt(dsp->qs[(mpos + 2*dsp->M) % dsp->M]); // Nvar = L
     xnorm = 0.0;
-    for (i = 0; i < dsp->L; i++) xnorm += (dsp->DFT).xn[mp-i]*(dsp->DFT).xn[mp-i];
+    for (i = 0; i < dsp->L; i++) {
+        x = (dsp->DFT).xn[mp-i] - dc;
+        xnorm += x*x;
+    }
     xnorm = sqrt(xnorm);
 
     mx /= xnorm*(dsp->DFT).N;
@@ -244,6 +318,12 @@ static int findstr(char *buff, char *str, int pos) {
     return i;
 }
 
+// input file, "shm:<name>": iq_bus ring, "rtl_tcp:<host>[:<port>]?s=<sr>": rtl_tcp server,
+// "<name>.sigmf-meta", "raw:<fmt>:<sr>:<path>", "<name>.iqz": iqzip archive (RS/io/sample_io.c)
+FILE *pcm_fopen(char *path) {
+    return sio_fopen(path);
+}
+
 float read_wav_header(pcm_t *pcm, FILE *fp) {
     char txt[4+1] = "\0\0\0\0";
     unsigned char dat[4];
@@ -307,32 +387,9 @@ float read_wav_header(pcm_t *pcm, FILE *fp) {
 }
 
 
-static int f32read_sample(dsp_t *dsp, float *s) {
-    int i;
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-
-    for (i = 0; i < dsp->nch; i++) {
-
-        if (fread( &word, dsp->bps/8, 1, dsp->fp) != 1) return EOF;
-
-        if (i == dsp->ch) {  // i = 0: links bzw. mono
-            //if (bits_sample ==  8)  sint = b-128;   // 8bit: 00..FF, centerpoint 0x80=128
-            //if (bits_sample == 16)  sint = (short)b;
-
-            if (dsp->bps == 32) {
-                *s = *f;
-            }
-            else {
-                if (dsp->bps ==  8) { *b -= 128; }
-                *s = *b/128.0;
-                if (dsp->bps == 16) { *s /= 256.0; }
-            }
-        }
-    }
-
-    return 0;
+// n samples (channel dsp->ch) -> s[]
+static int f32read_block(dsp_t *dsp, float *s, int n) {
+    return sio_float(dsp->sio, dsp->ch, s, n);
 }
 
 typedef struct {
@@ -346,112 +403,56 @@ typedef struct {
 } iq_dc_t;
 static iq_dc_t IQdc;
 
-static int f32read_csample(dsp_t *dsp, float complex *z) {
-
+// IQ dc offset: running mean, window maxcnt doubling up to maxlim
+static void iq_dc_block(float complex *z, int n) {
+    int k;
     float x, y;
 
-    if (dsp->bps == 32) { //float32
-        float f[2];
-        if (fread( f, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = f[0];
-        y = f[1];
-    }
-    else if (dsp->bps == 16) { //int16
-        short b[2];
-        if (fread( b, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = b[0]/32768.0;
-        y = b[1]/32768.0;
-    }
-    else {  // dsp->bps == 8   //uint8
-        ui8_t u[2];
-        if (fread( u, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = (u[0]-128)/128.0;
-        y = (u[1]-128)/128.0;
+    for (k = 0; k < n; k++) {
+        x = crealf(z[k]);
+        y = cimagf(z[k]);
+        z[k] = (x - IQdc.avgIQx) + I*(y - IQdc.avgIQy);
+
+        IQdc.sumIQx += x;
+        IQdc.sumIQy += y;
+        IQdc.cnt += 1;
+        if (IQdc.cnt == IQdc.maxcnt) {
+            IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
+            IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
+            IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
+            if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
+        }
     }
+}
 
-    *z = (x - IQdc.avgIQx) + I*(y - IQdc.avgIQy);
+// n IQ samples -> z[] (dc removed)
+static int f32read_cblock_n(dsp_t *dsp, float complex *z, int n) {
+    int len;
 
-    IQdc.sumIQx += x;
-    IQdc.sumIQy += y;
-    IQdc.cnt += 1;
-    if (IQdc.cnt == IQdc.maxcnt) {
-        IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-        IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-        IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-        if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-    }
+    len = sio_cfloat(dsp->sio, (float*)z, n);
+    iq_dc_block(z, len);
 
-    return 0;
+    return len;
 }
 
 static int f32read_cblock(dsp_t *dsp) {
-
-    int n;
     int len;
-    float x, y;
 
-    len = dsp->decM;
-
-    if (dsp->bps == 8) { //uint8
-        ui8_t u[2*dsp->decM];
-        len = fread( u, dsp->bps/8, 2*dsp->decM, dsp->fp) / 2;
-        //for (n = 0; n < len; n++) dsp->decMbuf[n] = (u[2*n]-128)/128.0 + I*(u[2*n+1]-128)/128.0;
-        // u8: 0..255, 128 -> 0V
-        for (n = 0; n < len; n++) {
-            x = (u[2*n  ]-128)/128.0;
-            y = (u[2*n+1]-128)/128.0;
-            dsp->decMbuf[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-            IQdc.sumIQx += x;
-            IQdc.sumIQy += y;
-            IQdc.cnt += 1;
-            if (IQdc.cnt == IQdc.maxcnt) {
-                IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-            }
-        }
-    }
-    else if (dsp->bps == 16) { //int16
-        short b[2*dsp->decM];
-        len = fread( b, dsp->bps/8, 2*dsp->decM, dsp->fp) / 2;
-        for (n = 0; n < len; n++) {
-            x = b[2*n  ]/32768.0;
-            y = b[2*n+1]/32768.0;
-            dsp->decMbuf[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-            IQdc.sumIQx += x;
-            IQdc.sumIQy += y;
-            IQdc.cnt += 1;
-            if (IQdc.cnt == IQdc.maxcnt) {
-                IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-            }
-        }
-    }
-    else { // dsp->bps == 32   //float32
-        float f[2*dsp->decM];
-        len = fread( f, dsp->bps/8, 2*dsp->decM, dsp->fp) / 2;
-        for (n = 0; n < len; n++) {
-            x = f[2*n];
-            y = f[2*n+1];
-            dsp->decMbuf[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-            IQdc.sumIQx += x;
-            IQdc.sumIQy += y;
-            IQdc.cnt += 1;
-            if (IQdc.cnt == IQdc.maxcnt) {
-                IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-            }
-        }
-    }
+    len = sio_cfloat(dsp->sio, (float*)dsp->decMbuf, dsp->decM);
+    iq_dc_block(dsp->decMbuf, len);
 
     return len;
 }
 
+// squelch: n IF samples (dc block continues)
+static int f32read_skip(dsp_t *dsp, int n) {
+    int k;
+    for (k = 0; k < n; k++) {
+        if ( f32read_cblock(dsp) < dsp->decM ) break;
+    }
+    return k;
+}
+
 /*
 static int get_SNR_rs41(dsp_t *dsp) {
 
@@ -514,8 +515,8 @@ static int lowpass_init(float f, int taps, float **pws) {
     for (n = 0; n < taps; n++) {
         w[n] = 7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
         h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
+        ws[taps-1-n] = w[n]*h[n]; // time-reversed (FIR kernels)
+        norm += w[n]*h[n]; // 1-norm
     }
     for (n = 0; n < taps; n++) {
         ws[n] /= norm; // 1-norm
@@ -544,8 +545,8 @@ static int lowpass_update(float f, int taps, float *ws) {
     for (n = 0; n < taps; n++) {
         w[n] = 7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
         h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
+        ws[taps-1-n] = w[n]*h[n]; // time-reversed (FIR kernels)
+        norm += w[n]*h[n]; // 1-norm
     }
     for (n = 0; n < taps; n++) {
         ws[n] /= norm; // 1-norm
@@ -557,149 +558,741 @@ static int lowpass_update(float f, int taps, float *ws) {
     return taps;
 }
 
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double complex w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n+1)%taps]*ws[taps-1-n];
+/*
+ * FIR kernels, contiguous window x[0..n-1] (oldest first, mirrored delay line),
+ * time-reversed taps h[] (h[n-1] weights the oldest sample), float accumulation.
+ * SSE/AVX2/AVX-512 selected at runtime (fir_select()), -DNOSIMD: scalar only.
+ * Tolerance vs. double accumulation: |dy| < n * 2^-24 * sum|h[k]*x[k]|,
+ * for the IQ/FM lowpass filters (sum|h| ~ 1) about 1e-6 relative.
+ */
+static float rfir_c(const float *x, const float *h, int n) {
+    int k;
+    float y0 = 0, y1 = 0, y2 = 0, y3 = 0;
+    for (k = 0; k+4 <= n; k += 4) {
+        y0 += x[k  ]*h[k  ];
+        y1 += x[k+1]*h[k+1];
+        y2 += x[k+2]*h[k+2];
+        y3 += x[k+3]*h[k+3];
     }
-    return (float complex)w;
+    for ( ; k < n; k++) y0 += x[k]*h[k];
+    return (y0+y1)+(y2+y3);
 }
 
-static float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n+1)%taps]*ws[taps-1-n];
+static float complex cfir_c(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    int k;
+    float re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+    for (k = 0; k+2 <= n; k += 2) {
+        re0 += x[2*k  ]*h[k];   im0 += x[2*k+1]*h[k];
+        re1 += x[2*k+2]*h[k+1]; im1 += x[2*k+3]*h[k+1];
     }
-    return (float)w;
+    for ( ; k < n; k++) { re0 += x[2*k]*h[k]; im0 += x[2*k+1]*h[k]; }
+    return (re0+re1) + (im0+im1)*I;
 }
 
+#ifdef FIR_X86
+static float rfir_sse(const float *x, const float *h, int n) {
+    __m128 a = _mm_setzero_ps();
+    float s[4], y;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x+k), _mm_loadu_ps(h+k)));
+    }
+    _mm_storeu_ps(s, a);
+    y = (s[0]+s[1])+(s[2]+s[3]);
+    for ( ; k < n; k++) y += x[k]*h[k];
+    return y;
+}
 
-int f32buf_sample(dsp_t *dsp, int inv) {
-    float s = 0.0;
-    float xneu, xalt;
+// (re,im) interleaved: taps h0 h1 h2 h3 -> h0 h0 h1 h1 | h2 h2 h3 h3
+static float complex cfir_sse(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+    __m128 h4;
+    float s[4], re, im;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        h4 = _mm_loadu_ps(h+k);
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x+2*k  ), _mm_unpacklo_ps(h4, h4)));
+        b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(x+2*k+4), _mm_unpackhi_ps(h4, h4)));
+    }
+    _mm_storeu_ps(s, _mm_add_ps(a, b));
+    re = s[0]+s[2];
+    im = s[1]+s[3];
+    for ( ; k < n; k++) { re += x[2*k]*h[k]; im += x[2*k+1]*h[k]; }
+    return re + im*I;
+}
 
-    float complex z, w, z0;
-    double gain = FM_GAIN;
+__attribute__((target("avx2,fma")))
+static float rfir_avx2(const float *x, const float *h, int n) {
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+    __m128 c;
+    float s[4], y;
+    int k;
+    for (k = 0; k+16 <= n; k += 16) {
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+k  ), _mm256_loadu_ps(h+k  ), a);
+        b = _mm256_fmadd_ps(_mm256_loadu_ps(x+k+8), _mm256_loadu_ps(h+k+8), b);
+    }
+    for ( ; k+8 <= n; k += 8) {
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+k), _mm256_loadu_ps(h+k), a);
+    }
+    a = _mm256_add_ps(a, b);
+    c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(s, c);
+    y = (s[0]+s[1])+(s[2]+s[3]);
+    for ( ; k < n; k++) y += x[k]*h[k];
+    return y;
+}
+
+__attribute__((target("avx2,fma")))
+static float complex cfir_avx2(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+    __m256 h8;
+    __m128 c;
+    float s[4], re, im;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        h8 = _mm256_loadu_ps(h+k);
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+2*k  ), _mm256_permutevar8x32_ps(h8, dup), a);
+        h8 = _mm256_permute2f128_ps(h8, h8, 0x01);
+        b = _mm256_fmadd_ps(_mm256_loadu_ps(x+2*k+8), _mm256_permutevar8x32_ps(h8, dup), b);
+    }
+    a = _mm256_add_ps(a, b);
+    c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(s, c);
+    re = s[0]+s[2];
+    im = s[1]+s[3];
+    for ( ; k < n; k++) { re += x[2*k]*h[k]; im += x[2*k+1]*h[k]; }
+    return re + im*I;
+}
 
-    double t = dsp->sample_in / (double)dsp->sr;
+__attribute__((target("avx512f")))
+static float rfir_avx512(const float *x, const float *h, int n) {
+    __m512 a = _mm512_setzero_ps();
+    __mmask16 m;
+    int k;
+    for (k = 0; k+16 <= n; k += 16) {
+        a = _mm512_fmadd_ps(_mm512_loadu_ps(x+k), _mm512_loadu_ps(h+k), a);
+    }
+    if (k < n) {
+        m = (__mmask16)((1u << (n-k)) - 1);
+        a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x+k), _mm512_maskz_loadu_ps(m, h+k), a);
+    }
+    return _mm512_reduce_add_ps(a);
+}
 
-    if (dsp->opt_iq) {
+__attribute__((target("avx512f")))
+static float complex cfir_avx512(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    const __m512i dup = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+    __m512 a = _mm512_setzero_ps();
+    __m512 h8;
+    __mmask16 m;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        h8 = _mm512_castps256_ps512(_mm256_loadu_ps(h+k));
+        a = _mm512_fmadd_ps(_mm512_loadu_ps(x+2*k), _mm512_permutexvar_ps(dup, h8), a);
+    }
+    if (k < n) {
+        m = (__mmask16)((1u << 2*(n-k)) - 1);
+        h8 = _mm512_maskz_loadu_ps((__mmask16)((1u << (n-k)) - 1), h+k);
+        a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x+2*k), _mm512_permutexvar_ps(dup, h8), a);
+    }
+    return _mm512_mask_reduce_add_ps(0x5555, a) + _mm512_mask_reduce_add_ps(0xAAAA, a)*I;
+}
+#endif
 
-        if (dsp->opt_iq == 5) {
-            ui32_t s_reset = dsp->dectaps*dsp->lut_len;
-            int j;
-            if ( f32read_cblock(dsp) < dsp->decM ) return EOF;
-            for (j = 0; j < dsp->decM; j++) {
-                dsp->decXbuffer[dsp->sample_dec % dsp->dectaps] = dsp->decMbuf[j] * dsp->ex[dsp->sample_dec % dsp->lut_len];
-                dsp->sample_dec += 1;
-                if (dsp->sample_dec == s_reset) dsp->sample_dec = 0;
-            }
-            z = lowpass(dsp->decXbuffer, dsp->sample_dec, dsp->dectaps, ws_dec);
-        }
-        else if ( f32read_csample(dsp, &z) == EOF ) return EOF;
+/*
+ * FM discriminator: s[k] = gain * arg(z[k]*conj(z0[k])) / pi
+ * branch-free atan2: octant reduction, t = min/max in [0,1],
+ * atan(t)/pi = t*P(t^2), P minimax deg 5; |err| < 2e-6 rad
+ * (FM bit decision margin ~ h*pi/sps >> 1e-3 rad)
+ */
+#define ATP1  ((float)( 0.99997726/M_PI))
+#define ATP3  ((float)(-0.33262347/M_PI))
+#define ATP5  ((float)( 0.19354346/M_PI))
+#define ATP7  ((float)(-0.11643287/M_PI))
+#define ATP9  ((float)( 0.05265332/M_PI))
+#define ATP11 ((float)(-0.01172120/M_PI))
+
+static float atan2pi(float y, float x) {  // atan2(y,x)/pi
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = fmaxf(ax, ay), mn = fminf(ax, ay);
+    float t = mn / fmaxf(mx, 1e-30f);
+    float t2 = t*t;
+    float a = t*(ATP1+t2*(ATP3+t2*(ATP5+t2*(ATP7+t2*(ATP9+t2*ATP11)))));
+    a = (ay > ax) ? 0.5f-a : a;
+    a = (x < 0) ? 1.0f-a : a;
+    return copysignf(a, y);
+}
 
-        z *= cexp(-t*2*M_PI*dsp->Df*I);
+static void fmdisc_c(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    int k;
+    for (k = 0; k < n; k++) {
+        float wr = x[2*k  ]*x0[2*k] + x[2*k+1]*x0[2*k+1];
+        float wi = x[2*k+1]*x0[2*k] - x[2*k  ]*x0[2*k+1];
+        s[k] = gain * atan2pi(wi, wr);
+    }
+}
 
-        // IF-lowpass
-        if (dsp->opt_lp) {
-            dsp->lpIQ_buf[dsp->sample_in % dsp->lpIQtaps] = z;
-            z = lowpass(dsp->lpIQ_buf, dsp->sample_in, dsp->lpIQtaps, dsp->ws_lpIQ);
-        }
+#ifdef FIR_X86
+static __m128 atan2pi_sse(__m128 y, __m128 x) {
+    const __m128 sgn = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sgn, x), ay = _mm_andnot_ps(sgn, y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    __m128 t = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(1e-30f)));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 a, m;
+    a = _mm_add_ps(_mm_set1_ps(ATP9), _mm_mul_ps(t2, _mm_set1_ps(ATP11)));
+    a = _mm_add_ps(_mm_set1_ps(ATP7), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP5), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP3), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP1), _mm_mul_ps(t2, a));
+    a = _mm_mul_ps(t, a);
+    m = _mm_cmpgt_ps(ay, ax);
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(0.5f), a)), _mm_andnot_ps(m, a));
+    m = _mm_cmplt_ps(x, _mm_setzero_ps());
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(1.0f), a)), _mm_andnot_ps(m, a));
+    return _mm_or_ps(a, _mm_and_ps(sgn, y));
+}
 
+static void fmdisc_sse(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m128 a, b, zr, zi, pr, pi, wr, wi;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        a = _mm_loadu_ps(x+2*k); b = _mm_loadu_ps(x+2*k+4);
+        zr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm_loadu_ps(x0+2*k); b = _mm_loadu_ps(x0+2*k+4);
+        pr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm_add_ps(_mm_mul_ps(zr, pr), _mm_mul_ps(zi, pi));
+        wi = _mm_sub_ps(_mm_mul_ps(zi, pr), _mm_mul_ps(zr, pi));
+        _mm_storeu_ps(s+k, _mm_mul_ps(_mm_set1_ps(gain), atan2pi_sse(wi, wr)));
+    }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
 
-        z0 = dsp->rot_iqbuf[(dsp->sample_in-1 + dsp->N_IQBUF) % dsp->N_IQBUF];
-        w = z * conj(z0);
-        s = gain * carg(w)/M_PI;
+__attribute__((target("avx2,fma")))
+static __m256 atan2pi_avx2(__m256 y, __m256 x) {
+    const __m256 sgn = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(sgn, x), ay = _mm256_andnot_ps(sgn, y);
+    __m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+    __m256 t = _mm256_div_ps(mn, _mm256_max_ps(mx, _mm256_set1_ps(1e-30f)));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 a;
+    a = _mm256_fmadd_ps(t2, _mm256_set1_ps(ATP11), _mm256_set1_ps(ATP9));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP7));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP5));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP3));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP1));
+    a = _mm256_mul_ps(t, a);
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(0.5f), a), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(1.0f), a), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+    return _mm256_or_ps(a, _mm256_and_ps(sgn, y));
+}
 
-        dsp->rot_iqbuf[dsp->sample_in % dsp->N_IQBUF] = z;
+// shuffle_ps deinterleaves per 128-bit lane: sample order 0,1,4,5,2,3,6,7 -> permute4x64 back
+__attribute__((target("avx2,fma")))
+static void fmdisc_avx2(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m256 a, b, zr, zi, pr, pi, wr, wi, v;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        a = _mm256_loadu_ps(x+2*k); b = _mm256_loadu_ps(x+2*k+8);
+        zr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm256_loadu_ps(x0+2*k); b = _mm256_loadu_ps(x0+2*k+8);
+        pr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm256_fmadd_ps(zr, pr, _mm256_mul_ps(zi, pi));
+        wi = _mm256_fmsub_ps(zi, pr, _mm256_mul_ps(zr, pi));
+        v = _mm256_mul_ps(_mm256_set1_ps(gain), atan2pi_avx2(wi, wr));
+        v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0)));
+        _mm256_storeu_ps(s+k, v);
+    }
+    if (k+4 <= n) { fmdisc_sse(z+k, z0+k, s+k, n-k, gain); return; }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
+#endif
+
+// FIR/FM kernels
+static void fir_select(dsp_t *dsp) {
+    dsp->rfir = rfir_c;
+    dsp->cfir = cfir_c;
+    dsp->fmdisc = fmdisc_c;
+#ifdef FIR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        dsp->rfir = rfir_avx512;
+        dsp->cfir = cfir_avx512;
+    }
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dsp->rfir = rfir_avx2;
+        dsp->cfir = cfir_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        dsp->rfir = rfir_sse;
+        dsp->cfir = cfir_sse;
+    }
+    // FM discriminator: no AVX-512 kernel, avx512f does not imply avx2/fma
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dsp->fmdisc = fmdisc_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        dsp->fmdisc = fmdisc_sse;
+    }
+#endif
+}
 
+// mirrored delay line buffer[0..2*taps-1]: x at sample%taps and sample%taps+taps,
+// the window buffer[sample%taps+1..] holds the last taps samples (newest last)
+static float complex lowpass(dsp_t *dsp, float complex buffer[], ui32_t sample, ui32_t taps, float *ws, float complex x) {
+    ui32_t i = sample % taps;
+    buffer[i] = x;
+    buffer[i+taps] = x;
+    return dsp->cfir(buffer+i+1, ws, taps);
+}
 
-        // FM-lowpass
-        if (dsp->opt_lp) {
-            dsp->lpFM_buf[dsp->sample_in % dsp->lpFMtaps] = s;
-            s = re_lowpass(dsp->lpFM_buf, dsp->sample_in, dsp->lpFMtaps, dsp->ws_lpFM);
-        }
+static float re_lowpass(dsp_t *dsp, float buffer[], ui32_t sample, ui32_t taps, float *ws, float x) {
+    ui32_t i = sample % taps;
+    buffer[i] = x;
+    buffer[i+taps] = x;
+    return dsp->rfir(buffer+i+1, ws, taps);
+}
 
-        dsp->fm_buffer[(dsp->sample_in - dsp->lpFMtaps/2 + dsp->M) % dsp->M] = s;
+/* ------------------------------------------------------------------------------------ */
 
+// NCO: recursive rotator z *= w (double), re-anchored every NCO_NORM samples
+// from the phase accumulator ph (cycles, mod 1), i.e. no amplitude/phase drift;
+// per sample 4 mul + 2 add, one cexp() per NCO_NORM samples
+#define NCO_NORM 1024
+
+static void nco_init(nco_t *nco, double f, double ph) {  // f: cycles/sample
+    nco->f = f;
+    nco->ph = ph - floor(ph);
+    nco->cnt = 0;
+    nco->z = cexp(2*M_PI*nco->ph*I);
+    nco->w = cexp(2*M_PI*f*I);
+}
 
-        if (dsp->opt_iq >= 2)
-        {
-            double xbit = 0.0;
-            //float complex xi = cexp(+I*M_PI*dsp->h/dsp->sps);
-            double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
-            double f2 = -f1;
+// phase-continuous frequency update
+static void nco_freq(nco_t *nco, double f) {
+    nco->ph += nco->cnt * nco->f;
+    nco->ph -= floor(nco->ph);
+    nco->cnt = 0;
+    nco->f = f;
+    nco->w = cexp(2*M_PI*f*I);
+}
 
-            float complex X0 = 0;
-            float complex X  = 0;
+static float complex nco_step(nco_t *nco) {
+    double re = creal(nco->z), im = cimag(nco->z);
+    double wr = creal(nco->w), wi = cimag(nco->w);
 
-            int n = dsp->sps;
-            double tn = (dsp->sample_in-n) / (double)dsp->sr;
-            //t = dsp->sample_in / (double)dsp->sr;
-            //z = dsp->rot_iqbuf[dsp->sample_in % dsp->N_IQBUF];
-            z0 = dsp->rot_iqbuf[(dsp->sample_in-n + dsp->N_IQBUF) % dsp->N_IQBUF];
+    nco->cnt += 1;
+    if (nco->cnt == NCO_NORM) {
+        nco->ph += NCO_NORM * nco->f;
+        nco->ph -= floor(nco->ph);
+        nco->cnt = 0;
+        nco->z = cexp(2*M_PI*nco->ph*I);
+    }
+    else {
+        nco->z = (re*wr - im*wi) + (re*wi + im*wr)*I;
+    }
+    return (float)re + (float)im*I;
+}
 
-            // f1
-            X0 = z0 * cexp(-tn*2*M_PI*f1*I); // alt
-            X  = z  * cexp(-t *2*M_PI*f1*I); // neu
-            dsp->F1sum +=  X - X0;
 
-            // f2
-            X0 = z0 * cexp(-tn*2*M_PI*f2*I); // alt
-            X  = z  * cexp(-t *2*M_PI*f2*I); // neu
-            dsp->F2sum +=  X - X0;
+/* ------------------------------------------------------------------------------------ */
 
-            xbit = cabs(dsp->F2sum) - cabs(dsp->F1sum);
+// multistage decimation (opt_iq == 5):
+//   decM = R * 2^nhb
+//   CIC(R, order DEC_CIC_N) -> nhb half-band stages (2:1) -> FIR at IF rate
+// the IF FIR (ws_f) compensates the CIC droop and sets the IF bandwidth.
+// CIC in 64bit integer arithmetic (wrap-around, exact); decM < 4: single FIR (ws_dec)
+typedef struct {
+    int R;      // CIC decimation
+    int nhb;    // half-band stages
+    int hbtaps[DEC_HB_MAX];
+    float hbc[DEC_HB_MAX];  // center tap
+    float *hb[DEC_HB_MAX];  // odd taps (symmetric)
+    int ftaps;
+    float *ws_f;
+    double gain;
+} decim_t;
+
+static decim_t dec;
+
+#define DEC_SCALE  (1<<20)  // float -> int, CIC input
+#define DEC_FTAPS  31       // IF FIR taps
+#define DEC_RMAX   128      // max CIC decimation
+
+static double cic_resp(int R, double f) { // f: cycles/sample at CIC input
+    double a = sin(M_PI*f);
+    int n;
+    double h = 1.0;
+    if (fabs(a) < 1e-12) return 1.0;
+    for (n = 0; n < DEC_CIC_N; n++) h *= sin(M_PI*f*R)/(R*a);
+    return fabs(h);
+}
 
-            s = xbit / dsp->sps;
+static int decim_design(int decM, float f_lp) {
+    int n, k, m, s;
+    int R = decM, nhb = 0;
+    float fc = f_lp * decM; // IF-rate cutoff
+    double norm, df, f, d;
+    double *h;
+
+    memset(&dec, 0, sizeof(dec));
+    if (decM < 4) return 0;
+
+    while (R % 2 == 0 && (nhb == 0 || R > DEC_RMAX) && nhb < DEC_HB_MAX) {
+        R /= 2;
+        nhb += 1;
+    }
+    if (R > DEC_RMAX) return 0;
+
+    dec.R = R;
+    dec.nhb = nhb;
+
+    // half-band stages: taps = 4k+3
+    for (s = 0; s < nhb; s++) {
+        double fpass = fc / (double)(1 << (nhb-s));  // fc relative to stage input rate
+        double tbw = 0.5 - 2*fpass;
+        int taps, c;
+        if (tbw < 0.05) tbw = 0.05;
+        taps = 5.5/tbw;
+        k = taps/4; if (k < 1) k = 1;
+        taps = 4*k+3;
+        c = (taps-1)/2;
+        dec.hbtaps[s] = taps;
+        dec.hb[s] = calloc(k+2, sizeof(float));  if (dec.hb[s] == NULL) return -1;
+        norm = 0.5;
+        for (m = 0; m <= k; m++) {  // offsets 2m+1
+            n = c + 2*m+1;
+            d = 0.5*sin(M_PI*(n-c)/2.0)/(M_PI*(n-c)/2.0)
+                * (7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)));
+            dec.hb[s][m] = d;
+            norm += 2*d;
         }
-        else if (0 && dsp->opt_iq >= 4)
-        {
-            double xbit = 0.0;
-            //float complex xi = cexp(+I*M_PI*dsp->h/dsp->sps);
-            double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
-            double f2 = -f1;
-
-            float complex X1 = 0;
-            float complex X2 = 0;
-
-            int n = dsp->sps;
-
-            while (n > 0) {
-                n--;
-                t = -n / (double)dsp->sr;
-                z = dsp->rot_iqbuf[(dsp->sample_in - n + dsp->N_IQBUF) % dsp->N_IQBUF];  // +1
-                X1 += z*cexp(-t*2*M_PI*f1*I);
-                X2 += z*cexp(-t*2*M_PI*f2*I);
+        for (m = 0; m <= k; m++) dec.hb[s][m] /= norm;
+        dec.hbc[s] = 0.5/norm;
+    }
+
+    // IF FIR, frequency sampling: ideal lowpass(fc) / H_cic(f)
+    dec.ftaps = DEC_FTAPS;
+    dec.ws_f = calloc(dec.ftaps+1, sizeof(float));  if (dec.ws_f == NULL) return -1;
+    h = calloc(dec.ftaps+1, sizeof(double));  if (h == NULL) return -1;
+    df = fc / 256.0;
+    norm = 0.0;
+    for (n = 0; n < dec.ftaps; n++) {
+        double t = n - (dec.ftaps-1)/2.0;
+        d = 0.0;
+        for (m = 0; m < 256; m++) {
+            f = (m+0.5)*df;
+            d += cos(2*M_PI*f*t) / cic_resp(R, f/(double)decM);
+        }
+        h[n] = 2*d*df * (7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(dec.ftaps-1))
+                                      + 1430/18608.0*cos(4*M_PI*n/(dec.ftaps-1)));
+        norm += h[n];
+    }
+    for (n = 0; n < dec.ftaps; n++) dec.ws_f[n] = h[n]/norm;
+    free(h); h = NULL;
+
+    dec.gain = 1.0 / ((double)DEC_SCALE * pow(R, DEC_CIC_N));
+
+    return nhb+2;
+}
+
+static void decim_design_free(void) {
+    int s;
+    for (s = 0; s < DEC_HB_MAX; s++) {
+        if (dec.hb[s]) { free(dec.hb[s]); dec.hb[s] = NULL; }
+    }
+    if (dec.ws_f) { free(dec.ws_f); dec.ws_f = NULL; }
+    dec.R = 0;
+}
+
+static int decim_stages_init(dsp_t *dsp) {
+    int s;
+    memset(&dsp->dst, 0, sizeof(dsp->dst));
+    for (s = 0; s < dec.nhb; s++) {
+        dsp->dst.hbbuf[s] = calloc(2*dec.hbtaps[s]+1, sizeof(float complex));
+        if (dsp->dst.hbbuf[s] == NULL) return -1;
+    }
+    dsp->dst.fbuf = calloc(2*dec.ftaps+1, sizeof(float complex));
+    if (dsp->dst.fbuf == NULL) return -1;
+    return 0;
+}
+
+static void decim_stages_free(dsp_t *dsp) {
+    int s;
+    for (s = 0; s < DEC_HB_MAX; s++) {
+        if (dsp->dst.hbbuf[s]) { free(dsp->dst.hbbuf[s]); dsp->dst.hbbuf[s] = NULL; }
+    }
+    if (dsp->dst.fbuf) { free(dsp->dst.fbuf); dsp->dst.fbuf = NULL; }
+}
+
+// mirrored delay line: x at pos and pos+taps, window buf[pos+1..pos+taps] (newest last)
+static float complex *dline_push(float complex *buf, int *pos, int taps, float complex x) {
+    *pos += 1; if (*pos == taps) *pos = 0;
+    buf[*pos] = x;
+    buf[*pos+taps] = x;
+    return buf + *pos+1;
+}
+
+// half-band stages s.. ; returns 1 if an IF sample is ready in *z
+static int decim_hb(dsp_t *dsp, int s, float complex x, float complex *z) {
+    float complex *w;
+    float complex y;
+    int taps, c, m, k;
+
+    for ( ; s < dec.nhb; s++) {
+        taps = dec.hbtaps[s];
+        w = dline_push(dsp->dst.hbbuf[s], &dsp->dst.hbpos[s], taps, x);
+        dsp->dst.hbph[s] ^= 1;
+        if (dsp->dst.hbph[s]) return 0; // 2:1
+        c = (taps-1)/2;
+        k = (taps-3)/4;
+        y = dec.hbc[s] * w[c];
+        for (m = 0; m <= k; m++) y += dec.hb[s][m] * (w[c-2*m-1] + w[c+2*m+1]);
+        x = y;
+    }
+    *z = x;
+    return 1;
+}
+
+// decM input samples (decMbuf) -> one IF sample
+static float complex decim_block(dsp_t *dsp) {
+    int j, n, r;
+    float complex x, y = 0, z = 0;
+    float complex *w;
+    ui64_t v[2];
+    i64_t t;
+
+    for (j = 0; j < dsp->decM; j++) {
+        x = c_mul(dsp->decMbuf[j], dsp->ex[dsp->sample_dec]);
+        dsp->sample_dec += 1;
+        if (dsp->sample_dec == dsp->lut_len) dsp->sample_dec = 0;
+
+        if (dec.R > 1) {
+            v[0] = (ui64_t)(i64_t)lrintf(crealf(x)*DEC_SCALE);
+            v[1] = (ui64_t)(i64_t)lrintf(cimagf(x)*DEC_SCALE);
+            for (r = 0; r < 2; r++) {
+                for (n = 0; n < DEC_CIC_N; n++) {
+                    dsp->dst.ig[r][n] += v[r];
+                    v[r] = dsp->dst.ig[r][n];
+                }
             }
+            dsp->dst.cnt += 1;
+            if (dsp->dst.cnt < dec.R) continue;
+            dsp->dst.cnt = 0;
+            for (r = 0; r < 2; r++) {
+                for (n = 0; n < DEC_CIC_N; n++) {
+                    ui64_t u = v[r];
+                    v[r] -= dsp->dst.cb[r][n];
+                    dsp->dst.cb[r][n] = u;
+                }
+            }
+            t = (i64_t)v[0]; x  = (float)(t * dec.gain);
+            t = (i64_t)v[1]; x += (float)(t * dec.gain) * I;
+        }
+        if (decim_hb(dsp, 0, x, &y)) {
+            w = dline_push(dsp->dst.fbuf, &dsp->dst.fpos, dec.ftaps, y);
+            z = dsp->cfir(w, dec.ws_f, dec.ftaps);
+        }
+    }
+
+    return z;
+}
+
+
+// decMbuf -> one IF sample
+static float complex decimate(dsp_t *dsp) {
+    ui32_t s_reset = dsp->dectaps*dsp->lut_len;
+    ui32_t i;
+    int j;
+
+    if (dec.R) return decim_block(dsp);
 
-            xbit = cabs(X2) - cabs(X1);
+    for (j = 0; j < dsp->decM; j++) {
+        i = dsp->sample_dec % dsp->dectaps;
+        dsp->decXbuffer[i] = c_mul(dsp->decMbuf[j], dsp->ex[dsp->sample_dec % dsp->lut_len]);
+        dsp->decXbuffer[i+dsp->dectaps] = dsp->decXbuffer[i];
+        dsp->sample_dec += 1;
+        if (dsp->sample_dec == s_reset) dsp->sample_dec = 0;
+    }
+    // window from (sample_dec+1)%dectaps, as before
+    return dsp->cfir(dsp->decXbuffer + (dsp->sample_dec+1)%dsp->dectaps, ws_dec, dsp->dectaps);
+}
 
-            s = xbit / dsp->sps;
+// squelch: mean |z|^2 per block (decimated IQ), averaged
+//   noise floor: follows the minimum, slowly up (not from blocks above the open level)
+//   open > SQ_ON*nf, close < SQ_OFF*nf for SQ_HOLD sec without header
+//   closed: mix/decimate only every SQ_DUTY-th block, power from the 2nd half (filters settled)
+#define SQ_ON    2.0    // +3dB
+#define SQ_OFF   1.26   // +1dB
+#define SQ_HOLD  2      // sec
+#define SQ_AVG   8      // blocks
+#define SQ_NF    1024   // blocks
+#define SQ_DUTY  8
+
+static int sq_level(dsp_t *dsp, float complex *z, int m) {
+    ui32_t hold = SQ_HOLD*dsp->sr;
+    double p = 0.0;
+    int k, k0 = dsp->sq_open ? 0 : m/2;
+
+    for (k = k0; k < m; k++) p += c_abs2(z[k]);
+    p /= m - k0;
+
+    if (dsp->sq_nf <= 0.0) dsp->sq_p = dsp->sq_nf = p;
+    dsp->sq_p += (p - dsp->sq_p)/(dsp->sq_open ? SQ_AVG : 2); // closed: every SQ_DUTY blocks
+    p = dsp->sq_p;
+
+    if (p < dsp->sq_nf) dsp->sq_nf = p;
+    else if (p < SQ_ON*dsp->sq_nf) dsp->sq_nf += (p - dsp->sq_nf)/SQ_NF;
+
+    if (dsp->sq_open) {
+        if (p > SQ_OFF*dsp->sq_nf) dsp->sq_last = dsp->sample_in;
+        else if (dsp->sample_in - dsp->sq_last > hold && dsp->sample_in - dsp->sq_hdr > hold) {
+            // closed: only sample_in advances, cleared buffers stay consistent
+            dsp->sq_open = 0;
+            memset(dsp->bufs, 0, dsp->M*sizeof(float));
+            memset(dsp->xs, 0, dsp->M*sizeof(float));
+            memset(dsp->qs, 0, dsp->M*sizeof(float));
+            memset(dsp->fm_buffer, 0, dsp->M*sizeof(float));
+            memset(dsp->rot_iqbuf, 0, dsp->N_IQBUF*sizeof(float complex));
+            dsp->xsum = dsp->qsum = 0;
+            dsp->F1sum = dsp->F2sum = 0;
         }
     }
-    else {
-        if (f32read_sample(dsp, &s) == EOF) return EOF;
+    else if (p > SQ_ON*dsp->sq_nf) {
+        dsp->sq_open = 1;
+        dsp->sq_last = dsp->sample_in;
     }
 
-    if (inv) s = -s;
-    dsp->bufs[dsp->sample_in % dsp->M] = s;
+    return dsp->sq_open;
+}
+
+/*
+ * block pipeline: n samples, stage by stage on contiguous arrays (DSP_BLK per pass)
+ *   read/dc -> [mix/decimate] -> [squelch] -> Df-NCO -> IF-lowpass -> FM -> FM-lowpass -> [F1/F2] -> bufs/xs/qs
+ * Df, ws_lpIQ are only changed in find_header(), between blocks.
+ * returns number of samples, < n: EOF
+ */
+int f32buf_block(dsp_t *dsp, int n, int inv) {
+    float complex *z = dsp->blk_z+1;  // blk_z[0]: previous IF sample (FM)
+    float *s = dsp->blk_s;
+    float xneu, xalt;
+    float gain = FM_GAIN;
+    ui32_t si;
+    int cnt = 0;
+    int m, l, k;
+    int skip;
+
+    while (cnt < n) {
+        l = n - cnt; if (l > DSP_BLK) l = DSP_BLK;
+        si = dsp->sample_in;
 
-    xneu = dsp->bufs[(dsp->sample_in  ) % dsp->M];
-    xalt = dsp->bufs[(dsp->sample_in+dsp->M - dsp->Nvar) % dsp->M];
-    dsp->xsum +=  xneu - xalt;                 // + xneu - xalt
-    dsp->qsum += (xneu - xalt)*(xneu + xalt);  // + xneu*xneu - xalt*xalt
-    dsp->xs[dsp->sample_in % dsp->M] = dsp->xsum;
-    dsp->qs[dsp->sample_in % dsp->M] = dsp->qsum;
+        if (dsp->opt_iq) {
 
+            skip = dsp->opt_sq && !dsp->sq_open && dsp->opt_iq == 5 && ++dsp->sq_blk % SQ_DUTY;
+
+            if (skip) m = f32read_skip(dsp, l);
+            else if (dsp->opt_iq == 5) {
+                for (m = 0; m < l; m++) {
+                    if ( f32read_cblock(dsp) < dsp->decM ) break;
+                    z[m] = decimate(dsp);
+                }
+            }
+            else m = f32read_cblock_n(dsp, z, l);
+            if (m <= 0) break;
+
+            if (dsp->opt_sq && (skip || sq_level(dsp, z, m) == 0)) {
+                // squelch closed: buffers are zero, header search is off
+                dsp->sample_in += m;
+                dsp->sample_out = dsp->sample_in-1 - dsp->delay;
+                cnt += m;
+                if (m < l) break;
+                continue;
+            }
 
-    dsp->sample_out = dsp->sample_in - dsp->delay;
+            for (k = 0; k < m; k++) z[k] = c_mul(z[k], nco_step(&dsp->nco_Df)); // exp(-t*2*M_PI*dsp->Df*I)
 
-    dsp->sample_in += 1;
+            // IF-lowpass
+            if (dsp->opt_lp) {
+                for (k = 0; k < m; k++) z[k] = lowpass(dsp, dsp->lpIQ_buf, si+k, dsp->lpIQtaps, dsp->ws_lpIQ, z[k]);
+            }
 
-    return 0;
+            dsp->blk_z[0] = dsp->rot_iqbuf[(si-1 + dsp->N_IQBUF) % dsp->N_IQBUF];
+            dsp->fmdisc(z, dsp->blk_z, s, m, gain); // s = gain * carg(z*conj(z0))/M_PI
+
+            // FM-lowpass
+            if (dsp->opt_lp) {
+                for (k = 0; k < m; k++) s[k] = re_lowpass(dsp, dsp->lpFM_buf, si+k, dsp->lpFMtaps, dsp->ws_lpFM, s[k]);
+            }
+
+            for (k = 0; k < m; k++) dsp->fm_buffer[(si+k - dsp->lpFMtaps/2 + dsp->M) % dsp->M] = s[k];
+
+            if (dsp->opt_iq >= 2)
+            {
+                // f1 = -dsp->h*dsp->sr/(2*dsp->sps), f2 = -f1:
+                //   e1 = exp(-t*2*M_PI*f1*I), e2 = conj(e1)
+                //   exp(-tn*2*M_PI*f1*I) = e1 * F1c, tn = t - sps/sr
+                int d = dsp->sps;
+                for (k = 0; k < m; k++) {
+                    float complex e1 = nco_step(&dsp->nco_F1);
+                    float complex z0;
+                    double xbit;
+
+                    dsp->rot_iqbuf[(si+k) % dsp->N_IQBUF] = z[k];
+                    z0 = dsp->rot_iqbuf[(si+k-d + dsp->N_IQBUF) % dsp->N_IQBUF];
+
+                    dsp->F1sum = c_mac(dsp->F1sum, z[k] - c_mul(z0, dsp->F1c), e1);               // f1: X - X0
+                    dsp->F2sum = c_mac(dsp->F2sum, z[k] - c_mulconj(z0, dsp->F1c), conjf(e1));    // f2
+
+                    xbit = sqrtf(c_abs2(dsp->F2sum)) - sqrtf(c_abs2(dsp->F1sum));
+                    s[k] = xbit / dsp->sps;
+                }
+            }
+            else {
+                for (k = 0; k < m; k++) dsp->rot_iqbuf[(si+k) % dsp->N_IQBUF] = z[k];
+            }
+        }
+        else {
+            m = f32read_block(dsp, s, l);
+            if (m <= 0) break;
+        }
+
+        for (k = 0; k < m; k++) {
+            if (inv) s[k] = -s[k];
+            dsp->bufs[dsp->sample_in % dsp->M] = s[k];
+
+            xneu = dsp->bufs[(dsp->sample_in  ) % dsp->M];
+            xalt = dsp->bufs[(dsp->sample_in+dsp->M - dsp->Nvar) % dsp->M];
+            dsp->xsum +=  xneu - xalt;                 // + xneu - xalt
+            dsp->qsum += (xneu - xalt)*(xneu + xalt);  // + xneu*xneu - xalt*xalt
+            dsp->xs[dsp->sample_in % dsp->M] = dsp->xsum;
+            dsp->qs[dsp->sample_in % dsp->M] = dsp->qsum;
+
+            dsp->sample_out = dsp->sample_in - dsp->delay;
+
+            dsp->sample_in += 1;
+        }
+
+        cnt += m;
+        if (m < l) break;
+    }
+
+    return cnt;
+}
+
+int f32buf_sample(dsp_t *dsp, int inv) {
+    return f32buf_block(dsp, 1, inv) == 1 ? 0 : EOF;
 }
 
 static int read_bufbit(dsp_t *dsp, int symlen, char *bits, ui32_t mvp, int pos) {
@@ -769,6 +1362,13 @@ static int headcmp(dsp_t *dsp, int opt_dc) {
 
 /* -------------------------------------------------------------------------- */
 
+// samples up to bit boundary bg in one block, consumed via dsp->buffered
+static void f32buf_fill(dsp_t *dsp, double bg, int inv) {
+    int n = 1;
+    if (dsp->sc < bg) n = ceil(bg - dsp->sc);
+    if (n > dsp->buffered) dsp->buffered += f32buf_block(dsp, n - dsp->buffered, inv);
+}
+
 int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spike) {
 // symlen==2: manchester2 10->0,01->1: 2.bit
 
@@ -795,6 +1395,7 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
     if (dsp->symlen == 2) {
         mid = bg + (dsp->sps-1)/2.0;
         bg += dsp->sps;
+        f32buf_fill(dsp, bg, inv);
         do {
             if (dsp->buffered > 0) dsp->buffered -= 1;
             else if (f32buf_sample(dsp, inv) == EOF) return EOF;
@@ -815,6 +1416,7 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
 
     mid = bg + (dsp->sps-1)/2.0;
     bg += dsp->sps;
+    f32buf_fill(dsp, bg, inv);
     do {
         if (dsp->buffered > 0) dsp->buffered -= 1;
         else if (f32buf_sample(dsp, inv) == EOF) return EOF;
@@ -880,6 +1482,8 @@ int init_buffers(dsp_t *dsp) {
     float *m = NULL;
 
 
+    fir_select(dsp);
+
     if (dsp->opt_iq == 5)
     {
         int IF_sr = 48000; // designated IF sample rate
@@ -900,8 +1504,18 @@ int init_buffers(dsp_t *dsp) {
         t_bw /= sr_base;
         taps = 4.0/t_bw; if (taps%2==0) taps++;
 
-        taps = lowpass_init(f_lp, taps, &ws_dec); // decimate lowpass
-        if (taps < 0) return -1;
+        k = decim_design(decM, f_lp); // CIC + half-band + IF-FIR
+        if (k < 0) return -1;
+        if (k > 0) {
+            taps = 0;
+            fprintf(stderr, "dec: CIC %d, HB %d", dec.R, dec.nhb);
+            for (n = 0; n < dec.nhb; n++) fprintf(stderr, " [%d]", dec.hbtaps[n]);
+            fprintf(stderr, ", FIR %d\n", dec.ftaps);
+        }
+        else {
+            taps = lowpass_init(f_lp, taps, &ws_dec); // decimate lowpass
+            if (taps < 0) return -1;
+        }
         dsp->dectaps = (ui32_t)taps;
 
         dsp->sr_base = sr_base;
@@ -949,8 +1563,13 @@ int init_buffers(dsp_t *dsp) {
         }
 
 
-        dsp->decXbuffer = calloc( dsp->dectaps+1, sizeof(float complex));
-        if (dsp->decXbuffer == NULL) return -1;
+        if (dec.R) {
+            if (decim_stages_init(dsp) < 0) return -1;
+        }
+        else {
+            dsp->decXbuffer = calloc( 2*dsp->dectaps+1, sizeof(float complex));
+            if (dsp->decXbuffer == NULL) return -1;
+        }
 
         dsp->decMbuf = calloc( dsp->decM+1, sizeof(float complex));
         if (dsp->decMbuf == NULL) return -1;
@@ -970,7 +1589,7 @@ int init_buffers(dsp_t *dsp) {
 
         dsp->lpIQ_fbw = f_lp;
         dsp->lpIQtaps = taps;
-        dsp->lpIQ_buf = calloc( dsp->lpIQtaps+3, sizeof(float complex));
+        dsp->lpIQ_buf = calloc( 2*dsp->lpIQtaps+3, sizeof(float complex));
         if (dsp->lpIQ_buf == NULL) return -1;
 
         dsp->ws_lpIQ = dsp->ws_lpIQ1;
@@ -992,7 +1611,7 @@ int init_buffers(dsp_t *dsp) {
         taps = lowpass_init(f_lp, taps, &dsp->ws_lpFM); if (taps < 0) return -1;
 
         dsp->lpFMtaps = taps;
-        dsp->lpFM_buf = calloc( dsp->lpFMtaps+3, sizeof(float complex));
+        dsp->lpFM_buf = calloc( 2*dsp->lpFMtaps+3, sizeof(float));
         if (dsp->lpFM_buf == NULL) return -1;
     }
 
@@ -1012,6 +1631,18 @@ int init_buffers(dsp_t *dsp) {
     dsp->delay = L/16;
     dsp->sample_in = 0;
 
+    nco_init(&dsp->nco_Df, -dsp->Df/(double)dsp->sr, 0.0);
+
+    dsp->sq_open = 1;
+    dsp->sq_nf = 0.0;
+
+    if (dsp->opt_iq >= 2) {
+        double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
+        int n = dsp->sps;
+        nco_init(&dsp->nco_F1, -f1/(double)dsp->sr, 0.0);
+        dsp->F1c = cexp(2*M_PI*f1*n/(double)dsp->sr*I);
+    }
+
     p2 = 1;
     while (p2 < M) p2 <<= 1;
     while (p2 < 0x2000) p2 <<= 1;  // or 0x4000, if sample not too short
@@ -1076,7 +1707,9 @@ int init_buffers(dsp_t *dsp) {
     dsp->DFT.Z  = calloc(dsp->DFT.N+1, sizeof(float complex));  if (dsp->DFT.Z  == NULL) return -1;
     dsp->DFT.cx = calloc(dsp->DFT.N+1, sizeof(float complex));  if (dsp->DFT.cx == NULL) return -1;
 
-    dsp->DFT.ew = calloc(dsp->DFT.LOG2N+1, sizeof(float complex));  if (dsp->DFT.ew == NULL) return -1;
+    dsp->DFT.yn = calloc(dsp->DFT.N+1, sizeof(float));  if (dsp->DFT.yn == NULL) return -1;
+
+    if (dft_init(&dsp->DFT) < 0) return -1;
 
     // FFT window
     // a) N2 = N
@@ -1086,11 +1719,6 @@ int init_buffers(dsp_t *dsp) {
     //dsp->DFT.N2 = dsp->DFT.N/2 - 1; // N=2^log2N
     dft_window(&dsp->DFT, 1);
 
-    for (n = 0; n < dsp->DFT.LOG2N; n++) {
-        k = 1 << n;
-        dsp->DFT.ew[n] = cexp(-I*M_PI/(float)k);
-    }
-
     m = calloc(dsp->DFT.N+1, sizeof(float));  if (m  == NULL) return -1;
     for (i = 0; i < L; i++) m[L-1 - i] = dsp->match[i]; // t = L-1
     while (i < dsp->DFT.N) m[i++] = 0.0;
@@ -1109,6 +1737,12 @@ int init_buffers(dsp_t *dsp) {
 
     dsp->fm_buffer = (float *)calloc( M+1, sizeof(float));  if (dsp->fm_buffer == NULL) return -1; // dsp->bufs[]
 
+    dsp->blk_z = calloc(DSP_BLK+1, sizeof(float complex));  if (dsp->blk_z == NULL) return -1;
+    dsp->blk_s = calloc(DSP_BLK+1, sizeof(float));  if (dsp->blk_s == NULL) return -1;
+    dsp->sio = calloc(1, sizeof(sio_t));  if (dsp->sio == NULL) return -1;
+    if (sio_open(dsp->sio, dsp->fp, dsp->bps, dsp->nch, dsp->decM > 1 ? (int)dsp->sr_base : dsp->sr) < 0) return -1;
+    if ((dsp->t_start > 0 || dsp->t_dur > 0) && sio_window(dsp->sio, dsp->t_start, dsp->t_dur) < 0) return -1;
+
 
     return K;
 }
@@ -1122,7 +1756,7 @@ int free_buffers(dsp_t *dsp) {
     if (dsp->rawbits) { free(dsp->rawbits); dsp->rawbits = NULL; }
 
     if (dsp->DFT.xn) { free(dsp->DFT.xn); dsp->DFT.xn = NULL; }
-    if (dsp->DFT.ew) { free(dsp->DFT.ew); dsp->DFT.ew = NULL; }
+    if (dsp->DFT.yn) { free(dsp->DFT.yn); dsp->DFT.yn = NULL; }
     if (dsp->DFT.Fm) { free(dsp->DFT.Fm); dsp->DFT.Fm = NULL; }
     if (dsp->DFT.X)  { free(dsp->DFT.X);  dsp->DFT.X  = NULL; }
     if (dsp->DFT.Z)  { free(dsp->DFT.Z);  dsp->DFT.Z  = NULL; }
@@ -1130,6 +1764,8 @@ int free_buffers(dsp_t *dsp) {
 
     if (dsp->DFT.win) { free(dsp->DFT.win); dsp->DFT.win = NULL; }
 
+    dft_free(&dsp->DFT);
+
     if (dsp->opt_iq)
     {
         if (dsp->rot_iqbuf) { free(dsp->rot_iqbuf); dsp->rot_iqbuf = NULL; }
@@ -1140,10 +1776,12 @@ int free_buffers(dsp_t *dsp) {
     if (dsp->opt_iq == 5)
     {
         if (dsp->decXbuffer) { free(dsp->decXbuffer); dsp->decXbuffer = NULL; }
+        decim_stages_free(dsp);
         if (dsp->decMbuf)    { free(dsp->decMbuf);    dsp->decMbuf    = NULL; }
         if (dsp->ex)         { free(dsp->ex);         dsp->ex         = NULL; }
 
         if (ws_dec) { free(ws_dec); ws_dec = NULL; }
+        decim_design_free();
     }
 
     // IF lowpass
@@ -1158,12 +1796,26 @@ int free_buffers(dsp_t *dsp) {
     }
 
     if (dsp->fm_buffer) { free(dsp->fm_buffer); dsp->fm_buffer = NULL; }
+    if (dsp->blk_z) { free(dsp->blk_z); dsp->blk_z = NULL; }
+    if (dsp->blk_s) { free(dsp->blk_s); dsp->blk_s = NULL; }
+    if (dsp->sio) { sio_close(dsp->sio); free(dsp->sio); dsp->sio = NULL; }
 
     return 0;
 }
 
 /* ------------------------------------------------------------------------------------ */
 
+// correlator flops since last frame
+static void corr_ops(dsp_t *dsp) {
+    fprintf(stderr, "corr: %.1f kFLOP/frame (complex FFT: %.1f kFLOP, saved: %.1f kFLOP = %.0f%%)\n",
+                    dsp->ops_cor*1e-3, dsp->ops_ref*1e-3, (dsp->ops_ref-dsp->ops_cor)*1e-3,
+                    dsp->ops_ref > 0 ? 100.0*(dsp->ops_ref-dsp->ops_cor)/dsp->ops_ref : 0.0);
+    dsp->ops_cor = 0.0;
+    dsp->ops_ref = 0.0;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
 ui32_t get_sample(dsp_t *dsp) {
     return dsp->sample_out;
 }
@@ -1177,13 +1829,23 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
     int mp;
     int header_found = 0;
     int herrs;
+    int n, m;
 
-    while ( f32buf_sample(dsp, 0) != EOF ) {
+    while ( 1 ) {
+
+        // block up to the next correlation
+        n = dsp->K-4 - k; if (n < 1) n = 1;
+        m = f32buf_block(dsp, n, 0);
+        k += m;
+        if (m < n) {
+            if (m > 0) dsp->mv = 0.0;
+            break; // EOF
+        }
 
-        k += 1;
         if (k >= dsp->K-4) {
             mvpos0 = dsp->mv_pos;
-            mp = getCorrDFT(dsp); // correlation score -> dsp->mv
+            if (dsp->opt_sq && !dsp->sq_open) dsp->mv = 0.0; // squelch
+            else mp = getCorrDFT(dsp); // correlation score -> dsp->mv
             //if (option_auto == 0 && dsp->mv < 0) mv = 0;
             k = 0;
         }
@@ -1217,6 +1879,7 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
                         }
                     }
                 }
+                nco_freq(&dsp->nco_Df, -dsp->Df/(double)dsp->sr);
             }
 
             if (dsp->mv_pos > mvpos0) {
@@ -1225,7 +1888,11 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
                 herrs = headcmp(dsp, opt_dc);
                 if (herrs <= hdmax) header_found = 1; // max bitfehler in header
 
-                if (header_found) return 1;
+                if (header_found) {
+                    dsp->sq_hdr = dsp->sample_in;
+                    if (dsp->opt_ops) corr_ops(dsp);
+                    return 1;
+                }
             }
         }
 
@@ -9,7 +9,58 @@ typedef unsigned int   ui32_t;
 typedef char  i8_t;
 typedef short i16_t;
 typedef int   i32_t;
-
+typedef unsigned long long ui64_t;
+typedef long long i64_t;
+
+
+#define DEC_CIC_N   4  // CIC order
+#define DEC_HB_MAX  8  // max half-band stages
+
+#define DSP_BLK  256  // f32buf_block(): samples per stage pass
+
+// complex arithmetic on split re/im (limited range):
+// no C99 Annex G inf/nan recovery (__mulsc3/__muldc3), always inlined,
+// independent of -fcx-limited-range/-ffast-math
+static inline float complex c_cf(float re, float im) {
+    float complex z;
+    ((float *)&z)[0] = re;
+    ((float *)&z)[1] = im;
+    return z;
+}
+static inline float complex c_mul(float complex a, float complex b) {  // a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br - ai*bi, ar*bi + ai*br);
+}
+static inline float complex c_mulconj(float complex a, float complex b) {  // a*conj(b)
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br + ai*bi, ai*br - ar*bi);
+}
+static inline float complex c_mac(float complex acc, float complex a, float complex b) {  // acc + a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(crealf(acc) + (ar*br - ai*bi), cimagf(acc) + (ar*bi + ai*br));
+}
+static inline float c_abs2(float complex a) {  // |a|^2
+    return crealf(a)*crealf(a) + cimagf(a)*cimagf(a);
+}
+
+typedef struct {  // numerically controlled oscillator
+    double complex z;
+    double complex w;
+    double f;   // cycles/sample
+    double ph;  // phase (cycles) at cnt=0
+    int cnt;
+} nco_t;
+
+typedef struct {  // multistage decimation state
+    ui64_t ig[2][DEC_CIC_N];  // CIC integrators (re, im)
+    ui64_t cb[2][DEC_CIC_N];  // CIC combs
+    int cnt;
+    float complex *hbbuf[DEC_HB_MAX];
+    int hbpos[DEC_HB_MAX];
+    int hbph[DEC_HB_MAX];
+    float complex *fbuf;
+    int fpos;
+} decst_t;
 
 typedef struct {
     int sr;       // sample_rate
@@ -17,12 +68,15 @@ typedef struct {
     int N;
     int N2;
     float *xn;
-    float complex  *ew;
+    float *yn;
     float complex  *Fm;
     float complex  *X;
     float complex  *Z;
     float complex  *cx;
     float complex  *win; // float real
+    // FFT plan
+    float complex  *tw;  // twiddles exp(-2pi*I*k/N), k < N/2
+    int *brv;            // bit-reversal N/2
 } dft_t;
 
 
@@ -64,8 +118,11 @@ typedef struct {
     int opt_iq;
     int N_IQBUF;
     float complex *rot_iqbuf;
+    void (*fmdisc)(const float complex *, const float complex *, float *, int, float);
     float complex F1sum;
     float complex F2sum;
+    float complex F1c;  // exp(2pi*I*f1*sps/sr)
+    nco_t nco_F1;
 
     //
     char *rawbits;
@@ -78,12 +135,16 @@ typedef struct {
 
     // DFT
     dft_t DFT;
+    int opt_ops;   // report correlator flops per frame
+    double ops_cor;
+    double ops_ref;
 
     // dc offset
     int opt_dc;
     int locked;
     double dc;
     double Df;
+    nco_t nco_Df;
     double dDf;
 
     ui32_t sample_posframe;
@@ -102,8 +163,18 @@ typedef struct {
     float complex *decXbuffer;
     float complex *decMbuf;
     float complex *ex; // exp_lut
+    decst_t dst;
     double xlt_fq;
 
+    // squelch (IQ): block power vs. noise floor
+    int opt_sq;
+    int sq_open;
+    double sq_p;        // block power (avg)
+    double sq_nf;       // noise floor
+    ui32_t sq_last;     // last block above close level
+    ui32_t sq_hdr;      // last header
+    ui32_t sq_blk;
+
     // IF: lowpass
     int opt_lp;
     int lpIQ_bw;
@@ -114,6 +185,10 @@ typedef struct {
     float *ws_lpIQ;
     float complex *lpIQ_buf;
 
+    // FIR kernels (SSE/AVX2/AVX-512/scalar)
+    float complex (*cfir)(const float complex *, const float *, int);
+    float (*rfir)(const float *, const float *, int);
+
     // FM: lowpass
     int lpFM_bw;
     int lpFMtaps; // ui32_t
@@ -121,6 +196,16 @@ typedef struct {
     float *lpFM_buf;
 	float *fm_buffer;
 
+
+    // input window (sio_window), seconds; 0: whole input
+    double t_start;
+    double t_dur;
+
+    // block pipeline (f32buf_block)
+    float complex *blk_z;
+    float *blk_s;
+
+    struct sio_s *sio;  // sample input (RS/io/sample_io.c)
 } dsp_t;
 
 
@@ -134,7 +219,9 @@ typedef struct {
 
 
 float read_wav_header(pcm_t *, FILE *);
+FILE *pcm_fopen(char *);
 int f32buf_sample(dsp_t *, int);
+int f32buf_block(dsp_t *, int, int);
 int read_slbit(dsp_t *, int*, int, int, int, float, int);
 
 int init_buffers(dsp_t *);
@@ -4,8 +4,9 @@
  *  sync header: correlation/matched filter
  *  files: dfm09mod.c demod_mod.h demod_mod.c
  *  compile:
- *      gcc -c demod_mod.c
- *      gcc dfm09mod.c demod_mod.o -lm -o dfm09mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc dfm09mod.c demod_mod.o sample_io.o -lm -pthread -o dfm09mod
  *
  *  author: zilog80
  */
@@ -853,6 +854,7 @@ int main(int argc, char **argv) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int option_bin = 0;
     int option_json = 0;     // JSON blob output (for auto_rx)
     int wavloaded = 0;
@@ -936,6 +938,15 @@ int main(int argc, char **argv) {
         else if ( (strcmp(*argv, "--auto") == 0) ) { option_auto = 1; }
         else if   (strcmp(*argv, "--bin") == 0) { option_bin = 1; }   // bit/byte binary input
         else if ( (strcmp(*argv, "--dist") == 0) ) { option_dist = 1; option_ecc = 1; }
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if ( (strcmp(*argv, "--json") == 0) ) { option_json = 1; option_ecc = 1; }
         else if ( (strcmp(*argv, "--ch2") == 0) ) { sel_wavch = 1; }  // right channel (default: 0=left)
         else if ( (strcmp(*argv, "--ths") == 0) ) {
@@ -969,9 +980,10 @@ int main(int argc, char **argv) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--sq") == 0) { option_sq = 1; }
         else if   (strcmp(*argv, "--dbg") == 0) { gpx.option.dbg = 1; }
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -1034,6 +1046,7 @@ int main(int argc, char **argv) {
         dsp.lpIQ_bw = 12e3; // IF lowpass bandwidth
         dsp.lpFM_bw = 4e3; // FM audio lowpass
         dsp.opt_dc = option_dc;
+        dsp.opt_sq = option_sq;
 
         if ( dsp.sps < 8 ) {
             fprintf(stderr, "note: sample rate low\n");
@@ -7,12 +7,14 @@
  *  files: lms6Xmod.c demod_mod.c demod_mod.h bch_ecc_mod.c bch_ecc_mod.h
  *  compile, either (a) or (b):
  *  (a)
- *      gcc -c demod_mod.c
- *      gcc -DINCLUDESTATIC lms6Xmod.c demod_mod.o -lm -o lms6Xmod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc -DINCLUDESTATIC lms6Xmod.c demod_mod.o sample_io.o -lm -pthread -o lms6Xmod
  *  (b)
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *      gcc -c bch_ecc_mod.c
- *      gcc lms6Xmod.c demod_mod.o bch_ecc_mod.o -lm -o lms6Xmod
+ *      gcc lms6Xmod.c demod_mod.o sample_io.o bch_ecc_mod.o -lm -pthread -o lms6Xmod
  *
  *  usage:
  *      ./lms6Xmod --vit --ecc <audio.wav>
@@ -926,6 +928,7 @@ int main(int argc, char **argv) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int wavloaded = 0;
     int sel_wavch = 0;     // audio channel: left
     int gpsweek = 0;
@@ -1049,13 +1052,23 @@ int main(int argc, char **argv) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--sq") == 0) { option_sq = 1; }
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if   (strcmp(*argv, "--json") == 0) {
             gpx->option.jsn = 1;
             gpx->option.ecc = 1;
             gpx->option.vit = 1;
         }
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -1114,6 +1127,7 @@ int main(int argc, char **argv) {
     dsp.lpIQ_bw = 8e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 6e3; // FM audio lowpass
     dsp.opt_dc = option_dc;
+    dsp.opt_sq = option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
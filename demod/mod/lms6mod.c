@@ -7,12 +7,14 @@
  *  files: lms6mod.c demod_mod.c demod_mod.h bch_ecc_mod.c bch_ecc_mod.h
  *  compile, either (a) or (b):
  *  (a)
- *      gcc -c demod_mod.c
- *      gcc -DINCLUDESTATIC lms6mod.c demod_mod.o -lm -o lms6mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc -DINCLUDESTATIC lms6mod.c demod_mod.o sample_io.o -lm -pthread -o lms6mod
  *  (b)
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *      gcc -c bch_ecc_mod.c
- *      gcc lms6mod.c demod_mod.o bch_ecc_mod.o -lm -o lms6mod
+ *      gcc lms6mod.c demod_mod.o sample_io.o bch_ecc_mod.o -lm -pthread -o lms6mod
  *
  *  usage:
  *      ./lms6mod --vit --ecc <audio.wav>
@@ -796,6 +798,7 @@ int main(int argc, char **argv) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int wavloaded = 0;
     int sel_wavch = 0;     // audio channel: left
     int gpsweek = 0;
@@ -882,6 +885,9 @@ int main(int argc, char **argv) {
         else if ( (strcmp(*argv, "--dc") == 0) ) {
             option_dc = 1;
         }
+        else if ( (strcmp(*argv, "--sq") == 0) ) {
+            option_sq = 1;
+        }
         else if ( (strcmp(*argv, "--ch2") == 0) ) { sel_wavch = 1; }  // right channel (default: 0=left)
         else if ( (strcmp(*argv, "--ths") == 0) ) {
             ++argv;
@@ -913,13 +919,22 @@ int main(int argc, char **argv) {
             option_iq = 5;
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if   (strcmp(*argv, "--json") == 0) {
             gpx->option.jsn = 1;
             gpx->option.ecc = 1;
             gpx->option.vit = 1;
         }
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -974,6 +989,7 @@ int main(int argc, char **argv) {
     dsp.lpIQ_bw = 8e3;
     dsp.opt_iq = option_iq;
     dsp.opt_lp = option_lp;
+    dsp.opt_sq = option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
@@ -4,8 +4,9 @@
  *  sync header: correlation/matched filter
  *  files: m10mod.c demod_mod.h demod_mod.c
  *  compile:
- *      gcc -c demod_mod.c
- *      gcc m10mod.c demod_mod.o -lm -o m10mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc m10mod.c demod_mod.o sample_io.o -lm -pthread -o m10mod
  *
  *  author: zilog80
  */
@@ -895,6 +896,7 @@ int main(int argc, char **argv) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int wavloaded = 0;
     int sel_wavch = 0;     // audio channel: left
     int spike = 0;
@@ -996,9 +998,19 @@ int main(int argc, char **argv) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--sq") == 0) { option_sq = 1; }
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if   (strcmp(*argv, "--json") == 0) { gpx.option.jsn = 1; }
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -1051,6 +1063,7 @@ int main(int argc, char **argv) {
     dsp.lpIQ_bw = 24e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 10e3; // FM audio lowpass
     dsp.opt_dc = option_dc;
+    dsp.opt_sq = option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
@@ -6,12 +6,14 @@
  *  files: meisei100mod.c demod_mod.c demod_mod.h bch_ecc_mod.c bch_ecc_mod.h
  *  compile, either (a) or (b):
  *  (a)
- *      gcc -c demod_mod.c
- *      gcc -DINCLUDESTATIC meisei100mod.c demod_mod.o -lm -o meisei100mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc -DINCLUDESTATIC meisei100mod.c demod_mod.o sample_io.o -lm -pthread -o meisei100mod
  *  (b)
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *      gcc -c bch_ecc_mod.c
- *      gcc meisei100mod.c demod_mod.o bch_ecc_mod.o -lm -o meisei100mod
+ *      gcc meisei100mod.c demod_mod.o sample_io.o bch_ecc_mod.o -lm -pthread -o meisei100mod
  *
  *  usage:
  *      ./meisei100mod --ecc -v <audio.wav>
@@ -212,6 +214,7 @@ int main(int argc, char **argv) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int sel_wavch = 0;
 
     int option1 = 0,
@@ -337,6 +340,16 @@ int main(int argc, char **argv) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if ( (strcmp(*argv, "--dc") == 0) ) { option_dc = 1; }
+        else if ( (strcmp(*argv, "--sq") == 0) ) { option_sq = 1; }
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if   (strcmp(*argv, "--json") == 0) {
             option_jsn = 1;
             option_ecc = 1;
@@ -344,7 +357,7 @@ int main(int argc, char **argv) {
         else {
             if (option1 == 1 && option2 == 1) goto help_out;
             if (!option_raw && option1 == 0 && option2 == 0) option2 = 1;
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -387,6 +400,7 @@ int main(int argc, char **argv) {
     dsp.lpIQ_bw = 16e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 4e3; // FM audio lowpass
     dsp.opt_dc = option_dc;
+    dsp.opt_sq = option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
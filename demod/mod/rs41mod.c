@@ -5,12 +5,14 @@
  *  files: rs41mod.c bch_ecc_mod.c demod_mod.c demod_mod.h
  *  compile, either (a) or (b):
  *  (a)
- *      gcc -c demod_mod.c
- *      gcc -DINCLUDESTATIC rs41mod.c demod_mod.o -lm -o rs41mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc -DINCLUDESTATIC rs41mod.c demod_mod.o sample_io.o -lm -pthread -o rs41mod
  *  (b)
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *      gcc -c bch_ecc_mod.c
- *      gcc rs41mod.c demod_mod.o bch_ecc_mod.o -lm -o rs41mod
+ *      gcc rs41mod.c demod_mod.o sample_io.o bch_ecc_mod.o -lm -pthread -o rs41mod
  *
  *  author: zilog80
  */
@@ -1535,6 +1537,7 @@ int main(int argc, char *argv[]) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int option_bin = 0;
     int wavloaded = 0;
     int sel_wavch = 0;     // audio channel: left
@@ -1642,6 +1645,16 @@ int main(int argc, char *argv[]) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--sq") == 0) { option_sq = 1; }
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if   (strcmp(*argv, "--json") == 0) {
             gpx.option.jsn = 1;
             gpx.option.ecc = 2;
@@ -1650,7 +1663,7 @@ int main(int argc, char *argv[]) {
         else if   (strcmp(*argv, "--rawhex") == 0) { rawhex = 2; }  // raw hex input
         else if   (strcmp(*argv, "--xorhex") == 0) { rawhex = 2; xorhex = 1; }  // raw xor input
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -1710,6 +1723,7 @@ int main(int argc, char *argv[]) {
             dsp.lpIQ_bw = 8e3; // IF lowpass bandwidth
             dsp.lpFM_bw = 6e3; // FM audio lowpass
             dsp.opt_dc = option_dc;
+            dsp.opt_sq = option_sq;
 
             if ( dsp.sps < 8 ) {
                 fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
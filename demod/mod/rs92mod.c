@@ -5,12 +5,14 @@
  *  files: rs92mod.c nav_gps_vel.c bch_ecc_mod.c demod_mod.c demod_mod.h
  *  compile:
  *  (a)
- *      gcc -c demod_mod.c
- *      gcc -DINCLUDESTATIC rs92mod.c demod_mod.o -lm -o rs92mod
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
+ *      gcc -DINCLUDESTATIC rs92mod.c demod_mod.o sample_io.o -lm -pthread -o rs92mod
  *  (b)
- *      gcc -c demod_mod.c
+ *      gcc -I../../io -c demod_mod.c
+ *      gcc -c ../../io/sample_io.c
  *      gcc -c bch_ecc_mod.c
- *      gcc rs92mod.c demod_mod.o bch_ecc_mod.o -lm -o rs92mod
+ *      gcc rs92mod.c demod_mod.o sample_io.o bch_ecc_mod.o -lm -pthread -o rs92mod
  *
  *  author: zilog80
  */
@@ -1234,6 +1236,7 @@ int main(int argc, char *argv[]) {
     int option_iq = 0;
     int option_lp = 0;
     int option_dc = 0;
+    int option_sq = 0;
     int sel_wavch = 0;     // audio channel: left
     int spike = 0;
     int fileloaded = 0;
@@ -1374,6 +1377,15 @@ int main(int argc, char *argv[]) {
         else if (strcmp(*argv, "-g1") == 0) { gpx.gps.opt_vergps = 1; }  //  verbose1 GPS
         else if (strcmp(*argv, "-g2") == 0) { gpx.gps.opt_vergps = 2; }  //  verbose2 GPS (bancroft)
         else if (strcmp(*argv, "-gg") == 0) { gpx.gps.opt_vergps = 8; }  // vverbose GPS
+        else if   (strcmp(*argv, "--ops") == 0) { dsp.opt_ops = 1; }  // correlator flops/frame
+        else if   (strcmp(*argv, "--start") == 0) {  // input window: skip <s> seconds (file: offset)
+            ++argv;
+            if (*argv) dsp.t_start = atof(*argv); else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {  // input window: <s> seconds
+            ++argv;
+            if (*argv) dsp.t_dur = atof(*argv); else return -1;
+        }
         else if (strcmp(*argv, "--json") == 0) {
             gpx.option.jsn = 1;
             gpx.option.ecc = 2;
@@ -1413,9 +1425,10 @@ int main(int argc, char *argv[]) {
         }
         else if   (strcmp(*argv, "--lp") == 0) { option_lp = 1; }  // IQ lowpass
         else if   (strcmp(*argv, "--dc") == 0) { option_dc = 1; }
+        else if   (strcmp(*argv, "--sq") == 0) { option_sq = 1; }
         else if   (strcmp(*argv, "--ngp") == 0) { gpx.option.ngp = 1; }  // RS92-NGP, RS92-D: 1680 MHz
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -1489,6 +1502,7 @@ int main(int argc, char *argv[]) {
     dsp.lpIQ_bw = 8e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 6e3; // FM audio lowpass
     dsp.opt_dc = option_dc;
+    dsp.opt_sq = option_sq;
     if (gpx.option.ngp) { // L-band rs92-ngp
         dsp.h *= 4.5;
         dsp.lpIQ_bw = 32e3; // IF lowpass bandwidth // 36=4.5*8, 27=4.5*6
@@ -0,0 +1,227 @@
+
+/*
+ *  simd_check: FIR and FM discriminator kernels (SSE/AVX2/AVX-512, as far as the cpu
+ *  supports them) and rdft/irdft against double precision references
+ *
+ *  gcc -c ../../io/sample_io.c
+ *  gcc -O2 -I../../io simd_check.c sample_io.o -lm -pthread -o simd_check   (includes demod_mod.c)
+ *  (-DNOSIMD: scalar kernels only)
+ *  ./simd_check  [-v]
+ *    exit 0: all kernels within tolerance
+ *
+ *  tolerances (demod_mod.c):
+ *    FIR:    |dy| < n * 2^-24 * sum|h[k]*x[k]|
+ *    fmdisc: |ds| < gain * (2e-6 + 8*2^-24) / pi   (atan2 polynomial, float products)
+ *    rdft:   max|dX| < 2*log2(N) * 2^-24 * sqrt(N) * rms(x)   (vs. double DFT)
+ *    irdft:  max|irdft(rdft(x))/N - x| < 2*log2(N) * 2^-24 * max|x|
+ *
+ *  demod/multi/demod_base.c carries the same kernels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#include "demod_mod.c"
+
+
+static int verbose = 0;
+static int fails = 0;
+
+static double urand(void) {  // [-1,1)
+    return 2.0*rand()/((double)RAND_MAX+1.0) - 1.0;
+}
+
+static void report(const char *name, int n, double err, double tol) {
+    int ok = err <= tol;
+    if (!ok) fails++;
+    if (verbose || !ok) {
+        printf("%-14s n=%-6d err %.3e  tol %.3e  %s\n", name, n, err, tol, ok ? "ok" : "FAIL");
+    }
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+typedef struct {
+    const char *name;
+    float (*rfir)(const float *, const float *, int);
+    float complex (*cfir)(const float complex *, const float *, int);
+} firk_t;
+
+typedef struct {
+    const char *name;
+    void (*fmdisc)(const float complex *, const float complex *, float *, int, float);
+} fmk_t;
+
+static int fir_kernels(firk_t *k) {
+    int n = 0;
+    k[n].name = "c";  k[n].rfir = rfir_c;  k[n].cfir = cfir_c;  n++;
+#ifdef FIR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        k[n].name = "sse";  k[n].rfir = rfir_sse;  k[n].cfir = cfir_sse;  n++;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        k[n].name = "avx2";  k[n].rfir = rfir_avx2;  k[n].cfir = cfir_avx2;  n++;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        k[n].name = "avx512";  k[n].rfir = rfir_avx512;  k[n].cfir = cfir_avx512;  n++;
+    }
+#endif
+    return n;
+}
+
+static int fm_kernels(fmk_t *k) {
+    int n = 0;
+    k[n].name = "c";  k[n].fmdisc = fmdisc_c;  n++;
+#ifdef FIR_X86
+    if (__builtin_cpu_supports("sse2")) {
+        k[n].name = "sse";  k[n].fmdisc = fmdisc_sse;  n++;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        k[n].name = "avx2";  k[n].fmdisc = fmdisc_avx2;  n++;
+    }
+#endif
+    return n;
+}
+
+// taps: odd/even lengths, all SIMD tails (n%4, n%8, n%16)
+static void check_fir(void) {
+    static const int taps[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 23, 31, 32, 33, 47, 63, 64, 65, 97, 127, 128, 255 };
+    firk_t kern[4];
+    int nk = fir_kernels(kern);
+    int t, i, j, n, it;
+    float *x, *h;
+    float complex *z;
+    char name[32];
+
+    x = calloc(2*256, sizeof(float));
+    h = calloc(256, sizeof(float));
+    z = calloc(256, sizeof(float complex));
+    if (x == NULL || h == NULL || z == NULL) { fails++; return; }
+
+    for (t = 0; t < (int)(sizeof(taps)/sizeof(taps[0])); t++) {
+        n = taps[t];
+        for (it = 0; it < 20; it++) {
+            double sh = 0, yr = 0, yi = 0, ar = 0, ai = 0, s = 0, sa = 0;
+            for (i = 0; i < n; i++) { h[i] = urand(); sh += fabs(h[i]); }
+            for (i = 0; i < n; i++) h[i] /= sh;  // sum|h| = 1
+            for (i = 0; i < n; i++) {
+                x[i] = urand();
+                z[i] = urand() + urand()*I;
+                s  += (double)x[i]*h[i];  sa += fabs((double)x[i]*h[i]);
+                yr += (double)crealf(z[i])*h[i];  ar += fabs((double)crealf(z[i])*h[i]);
+                yi += (double)cimagf(z[i])*h[i];  ai += fabs((double)cimagf(z[i])*h[i]);
+            }
+            for (j = 0; j < nk; j++) {
+                float complex y = kern[j].cfir(z, h, n);
+                double er = fabs(crealf(y) - yr), ei = fabs(cimagf(y) - yi);
+                snprintf(name, sizeof(name), "rfir_%s", kern[j].name);
+                report(name, n, fabs(kern[j].rfir(x, h, n) - s), n * ldexp(1, -24) * sa);
+                snprintf(name, sizeof(name), "cfir_%s re", kern[j].name);
+                report(name, n, er, n * ldexp(1, -24) * ar);
+                snprintf(name, sizeof(name), "cfir_%s im", kern[j].name);
+                report(name, n, ei, n * ldexp(1, -24) * ai);
+            }
+        }
+    }
+    free(x); free(h); free(z);
+}
+
+// random phases and amplitudes, all octants; n not a multiple of 8 (tails)
+static void check_fmdisc(void) {
+    fmk_t kern[4];
+    int nk = fm_kernels(kern);
+    int n = 1000 + 5, i, j;
+    float gain = FM_GAIN;
+    float complex *z, *z0;
+    float *s;
+    double err, tol = gain * (2e-6 + 8*ldexp(1, -24)) / M_PI;
+    char name[32];
+
+    z  = calloc(n, sizeof(float complex));
+    z0 = calloc(n, sizeof(float complex));
+    s  = calloc(n, sizeof(float));
+    if (z == NULL || z0 == NULL || s == NULL) { fails++; return; }
+
+    for (i = 0; i < n; i++) {
+        double a = exp(4*urand()), b = exp(4*urand());
+        z[i]  = a * cexp(I*M_PI*urand());
+        z0[i] = b * cexp(I*M_PI*urand());
+    }
+    for (j = 0; j < nk; j++) {
+        err = 0;
+        kern[j].fmdisc(z, z0, s, n, gain);
+        for (i = 0; i < n; i++) {
+            double complex w = (double complex)z[i] * conj((double complex)z0[i]);
+            double d = fabs(s[i] - gain * carg(w) / M_PI);
+            if (d > gain) d = fabs(2*gain - d);  // +-pi
+            if (d > err) err = d;
+        }
+        snprintf(name, sizeof(name), "fmdisc_%s", kern[j].name);
+        report(name, n, err, tol);
+    }
+    free(z); free(z0); free(s);
+}
+
+// rdft vs. direct DFT (double), irdft(rdft(x)) = N*x
+static void check_rdft(void) {
+    dft_t dft;
+    int L, N, i, k;
+    float *x, *y;
+    float complex *X;
+    double rms, mx, err, tol;
+
+    for (L = 2; L <= 12; L++) {
+        N = 1 << L;
+        memset(&dft, 0, sizeof(dft));
+        dft.N = N;
+        dft.LOG2N = L;
+        x = calloc(N, sizeof(float));
+        y = calloc(N, sizeof(float));
+        X = calloc(N, sizeof(float complex));
+        dft.cx = calloc(N/2+1, sizeof(float complex));
+        if (x == NULL || y == NULL || X == NULL || dft.cx == NULL || dft_init(&dft) < 0) { fails++; return; }
+
+        rms = 0; mx = 0;
+        for (i = 0; i < N; i++) {
+            x[i] = urand();
+            rms += x[i]*x[i];
+            if (fabs(x[i]) > mx) mx = fabs(x[i]);
+        }
+        rms = sqrt(rms/N);
+
+        rdft(&dft, x, X);
+        err = 0;
+        for (k = 0; k < N; k++) {
+            double complex S = 0;
+            for (i = 0; i < N; i++) S += x[i] * cexp(-2*M_PI*I*(double)((long)i*k % N)/N);
+            if (cabs(X[k] - S) > err) err = cabs(X[k] - S);
+        }
+        tol = 2*L * ldexp(1, -24) * sqrt(N) * rms;
+        report("rdft", N, err, tol);
+
+        irdft(&dft, X, y);
+        err = 0;
+        for (i = 0; i < N; i++) if (fabs(y[i]/N - x[i]) > err) err = fabs(y[i]/N - x[i]);
+        tol = 2*L * ldexp(1, -24) * mx;
+        report("irdft", N, err, tol);
+
+        dft_free(&dft);
+        free(dft.cx); free(x); free(y); free(X);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) verbose = 1;
+    srand(1);
+
+    check_fir();
+    check_fmdisc();
+    check_rdft();
+
+    printf("simd_check: %s\n", fails ? "FAIL" : "ok");
+    return fails ? 1 : 0;
+}
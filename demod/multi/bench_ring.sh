@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# rs_multi: channel scaling, wall time of n --dfm channels on one IQ file
+# (n = 1 2 4 8 16 32), best of 3 runs, ms
+#
+# usage: ./bench_ring.sh <iq.wav> [fq] [rs_multi options]
+#   e.g. ./bench_ring.sh iq_2400k.wav 0.0 --workers 0
+#   RS_MULTI=<binary> (default ./rs_multi, see rs_multi.c for the build)
+#   the old handoff (MAX_FQ 5): build with MAX_FQ 32 and compare
+#
+
+RS_MULTI=${RS_MULTI:-./rs_multi}
+IQ=$1
+FQ=${2:-0.0}
+[ $# -gt 2 ] && shift 2 || shift $#
+
+if [ -z "$IQ" ] || [ ! -f "$IQ" ]; then
+    echo "usage: $0 <iq.wav> [fq] [rs_multi options]"
+    exit 1
+fi
+
+printf "channels"
+for n in 1 2 4 8 16 32; do printf " %6d" $n; done
+printf "\n%-8s" "ms"
+
+for n in 1 2 4 8 16 32; do
+    ch=""
+    i=0
+    while [ $i -lt $n ]; do ch="$ch --dfm $FQ"; i=$((i+1)); done
+    best=0
+    for r in 1 2 3; do
+        t0=$(date +%s%N)
+        $RS_MULTI "$@" $ch "$IQ" > /dev/null 2>&1
+        t1=$(date +%s%N)
+        t=$(( (t1-t0)/1000000 ))
+        if [ $best -eq 0 ] || [ $t -lt $best ]; then best=$t; fi
+    done
+    printf " %6d" $best
+done
+printf "\n"
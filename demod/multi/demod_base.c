@@ -2,7 +2,7 @@
 /*
  *  sync header: correlation/matched filter
  *  compile:
- *      gcc -c demod_base.c
+ *      gcc -I../../io -c demod_base.c
  *
  *  author: zilog80
  */
@@ -15,65 +15,132 @@
 
 #include "demod_base.h"
 
-#define FM_GAIN (0.8)
+#include "sample_io.h"  // RS/io/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+  #define FIR_X86
+  #include <immintrin.h>
+#endif
 
 /* ------------------------------------------------------------------------------------ */
 
 
-static void raw_dft(dft_t *dft, float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
+/*
+ * FFT plan: bit-reversal and twiddle tables are built once per dft_t
+ * (dft_init() in init_buffers()), so the transforms only do butterflies.
+ *   tw[k]   = exp(-2pi*I*k/N), k < N/2
+ *   brv[]   : N/2-point bit-reversal (real transform)
+ *   brvN[]  : N-point bit-reversal (complex transform)
+ * A 2^m-point FFT, 2^m <= N, takes the twiddles with stride N/2^m.
+ */
+static void fft_raw(dft_t *dft, float complex *Z, int log2n, int *brv) {
+    int s, l, l2, i, j, k, st;
+    int n = 1 << log2n;
+    float complex  w, T;
 
-    j = 1;
-    for (i = 1; i < dft->N; i++) {
+    for (i = 0; i < n; i++) {
+        j = brv[i];
         if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = dft->N/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
+            T = Z[j];
+            Z[j] = Z[i];
+            Z[i] = T;
         }
-        j = j + k;
     }
 
-    for (s = 0; s < dft->LOG2N; s++) {
+    for (s = 0; s < log2n; s++) {
         l2 = 1 << s;
         l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = dft->ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= dft->N; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
+        st = dft->N / l; // cexp(-I*M_PI*j/(float)l2) = tw[j*st]
+        for (i = 0; i < n; i += l) {
+            for (j = 0; j < l2; j++) {
+                w = dft->tw[j*st];
+                k = i + j;
+                T = c_mul(Z[k+l2], w);
+                Z[k+l2] = Z[k] - T;
+                Z[k]    = Z[k] + T;
             }
-            w1 = w1 * w2;
         }
     }
 }
 
-static void cdft(dft_t *dft, float complex *z, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = z[i];
-    raw_dft(dft, Z);
+void raw_dft(dft_t *dft, float complex *Z) {
+    fft_raw(dft, Z, dft->LOG2N, dft->brvN);
 }
 
-static void rdft(dft_t *dft, float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  Z[i] = (float complex)x[i];
-    raw_dft(dft, Z);
+// real input: N/2-point complex FFT of z[n] = x[2n] + I*x[2n+1],
+// split into even/odd spectra; Z[N/2+1..N-1] = conj(Z[N-k]) for drop-in use
+void rdft(dft_t *dft, float *x, float complex *Z) {
+    int k;
+    int N2 = dft->N/2;
+    float complex  Xe, Xo, a, b, d;
+
+    for (k = 0; k < N2; k++)  Z[k] = c_cf(x[2*k], x[2*k+1]);
+    fft_raw(dft, Z, dft->LOG2N-1, dft->brv);
+
+    a = Z[0];
+    Z[0]  = crealf(a) + cimagf(a);
+    Z[N2] = crealf(a) - cimagf(a);
+    for (k = 1; k <= N2/2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        d = a - b;
+        Xe = 0.5f*(a + b);
+        Xo = c_cf(0.5f*cimagf(d), -0.5f*crealf(d)); // -0.5*I*(a-b)
+        Z[k]    = Xe + c_mul(dft->tw[k], Xo);
+        Z[N2-k] = conjf(Xe) + c_mul(dft->tw[N2-k], conjf(Xo));
+    }
+    for (k = N2+1; k < dft->N; k++)  Z[k] = conjf(Z[dft->N-k]);
 }
 
-static void Nidft(dft_t *dft, float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < dft->N; i++)  z[i] = conj(Z[i]);
-    raw_dft(dft, z);
-    // idft():
-    // for (i = 0; i < dft->N; i++)  z[i] = conj(z[i])/(float)dft->N; // hier: z reell
+// real output: x = N*idft(Z), Z hermitian, only Z[0..N/2] is read;
+// dft->cx is used as N/2-point work buffer
+void irdft(dft_t *dft, float complex *Z, float *x) {
+    int k;
+    int N2 = dft->N/2;
+    float complex *z = dft->cx;
+    float complex  Xe, Xo, a, b;
+
+    for (k = 0; k < N2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        Xe = a + b;
+        Xo = c_mulconj(a - b, dft->tw[k]);
+        z[k] = c_cf(crealf(Xe) - cimagf(Xo), -(cimagf(Xe) + crealf(Xo))); // conj(Xe + I*Xo)
+    }
+    fft_raw(dft, z, dft->LOG2N-1, dft->brv);
+    for (k = 0; k < N2; k++) {
+        x[2*k  ] =  crealf(z[k]);
+        x[2*k+1] = -cimagf(z[k]);
+    }
+}
+
+static int bitrev(int i, int log2n) {
+    int j = 0;
+    while (log2n-- > 0) {
+        j = (j << 1) | (i & 1);
+        i >>= 1;
+    }
+    return j;
+}
+
+int dft_init(dft_t *dft) {
+    int k;
+
+    dft->tw   = calloc(dft->N/2+1, sizeof(float complex));  if (dft->tw   == NULL) return -1;
+    dft->brv  = calloc(dft->N/2+1, sizeof(int));            if (dft->brv  == NULL) return -1;
+    dft->brvN = calloc(dft->N+1,   sizeof(int));            if (dft->brvN == NULL) return -1;
+
+    for (k = 0; k < dft->N/2; k++)  dft->tw[k] = cexp(-2*M_PI*I*k/(double)dft->N);
+    for (k = 0; k < dft->N/2; k++)  dft->brv[k]  = bitrev(k, dft->LOG2N-1);
+    for (k = 0; k < dft->N;   k++)  dft->brvN[k] = bitrev(k, dft->LOG2N);
+
+    return 0;
+}
+
+void dft_free(dft_t *dft) {
+    if (dft->tw)   { free(dft->tw);   dft->tw   = NULL; }
+    if (dft->brv)  { free(dft->brv);  dft->brv  = NULL; }
+    if (dft->brvN) { free(dft->brvN); dft->brvN = NULL; }
 }
 
 static float bin2freq0(dft_t *dft, int k) {
@@ -81,12 +148,12 @@ static float bin2freq0(dft_t *dft, int k) {
     if (fq >= dft->sr/2.0) fq -= dft->sr;
     return fq;
 }
-static float bin2freq(dft_t *dft, int k) {
+float bin2freq(dft_t *dft, int k) {
     float fq = k / (float)dft->N;
     if ( fq >= 0.5) fq -= 1.0;
     return fq*dft->sr;
 }
-static float bin2fq(dft_t *dft, int k) {
+float bin2fq(dft_t *dft, int k) {
     float fq = k / (float)dft->N;
     if ( fq >= 0.5) fq -= 1.0;
     return fq;
@@ -98,8 +165,8 @@ static int max_bin(dft_t *dft, float complex *Z) {
 
     max = 0; kmax = 0;
     for (k = 0; k < dft->N; k++) {
-        if (cabs(Z[k]) > max) {
-            max = cabs(Z[k]);
+        if (c_abs2(Z[k]) > max) {
+            max = c_abs2(Z[k]);
             kmax = k;
         }
     }
@@ -107,7 +174,7 @@ static int max_bin(dft_t *dft, float complex *Z) {
     return kmax;
 }
 
-static int dft_window(dft_t *dft, int w) {
+int dft_window(dft_t *dft, int w) {
     int n;
 
     if (w < 0 || w > 3) return -1;
@@ -139,6 +206,11 @@ static int dft_window(dft_t *dft, int w) {
 
 /* ------------------------------------------------------------------------------------ */
 
+// flops: complex radix-2 FFT, n-point
+static double fft_ops(int n) {
+    return 5.0*n*log2(n);
+}
+
 static int getCorrDFT(dsp_t *dsp) {
     int i;
     int mp = -1;
@@ -146,10 +218,12 @@ static int getCorrDFT(dsp_t *dsp) {
     float mx2 = 0.0;
     float re_cx = 0.0;
     float xnorm = 1;
+    float x;
     ui32_t mpos = 0;
     ui32_t pos = dsp->sample_out;
 
     double dc = 0.0;
+    float ydc = 0.0;
     int mp_ofs = 0;
     float *sbuf = dsp->bufs;
 
@@ -167,11 +241,18 @@ static int getCorrDFT(dsp_t *dsp) {
     else {
         sbuf = dsp->bufs;
     }
+
     for (i = 0; i < dsp->K + dsp->L; i++) (dsp->DFT).xn[i] = sbuf[(pos+dsp->M -(dsp->K + dsp->L-1) + i) % dsp->M];
     while (i < dsp->DFT.N) (dsp->DFT).xn[i++] = 0.0;
 
-
     rdft(&dsp->DFT, dsp->DFT.xn, dsp->DFT.X);
+    for (i = 0; i <= dsp->DFT.N/2; i++) dsp->DFT.Z[i] = c_mul(dsp->DFT.X[i], dsp->DFT.Fm[i]);
+    irdft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.yn);
+
+    // ops: rdft + irdft (N/2-point FFT + split), product on the half spectrum;
+    // ref: the complex path before rdft: N-point FFT, product, N-point inverse (--dc: a 2nd inverse)
+    dsp->ops_cor += 2*(fft_ops(dsp->DFT.N/2) + 5.0*dsp->DFT.N) + 6.0*(dsp->DFT.N/2+1);
+    dsp->ops_ref += (dsp->opt_dc ? 3 : 2)*fft_ops(dsp->DFT.N) + 6.0*dsp->DFT.N;
 
 
     if (dsp->opt_dc) {
@@ -181,15 +262,10 @@ static int getCorrDFT(dsp_t *dsp) {
         dc = 0.0;
         for (i = dsp->K - dsp->L; i < dsp->K + dsp->L; i++) dc += (dsp->DFT).xn[i];
         dc /= 2.0*(float)dsp->L;
-        dsp->DFT.X[0] -= dsp->DFT.N * dc  ;//* 0.95;
-        Nidft(&dsp->DFT, dsp->DFT.X, (dsp->DFT).cx);
-        for (i = 0; i < dsp->DFT.N; i++) (dsp->DFT).xn[i] = creal((dsp->DFT).cx[i])/(float)dsp->DFT.N;
+        // X[0] -= N*dc  <=>  yn[] -= N*dc*Fm[0]
+        ydc = dsp->DFT.N * dc * crealf(dsp->DFT.Fm[0]);
     }
 
-    for (i = 0; i < dsp->DFT.N; i++) dsp->DFT.Z[i] = dsp->DFT.X[i]*dsp->DFT.Fm[i];
-
-    Nidft(&dsp->DFT, dsp->DFT.Z, dsp->DFT.cx);
-
     if (fabs(dc) < 0.5) dsp->dc = dc;
 
 
@@ -200,7 +276,7 @@ static int getCorrDFT(dsp_t *dsp) {
     //
     mx2 = 0.0;                                      // t = L-1
     for (i = dsp->L-1; i < dsp->K + dsp->L; i++) {  // i=t .. i=t+K < t+1+K
-        re_cx = creal(dsp->DFT.cx[i]);  // imag(cx)=0
+        re_cx = dsp->DFT.yn[i] - ydc;
         if (re_cx*re_cx > mx2) {
             mx = re_cx;
             mx2 = mx*mx;
@@ -214,7 +290,10 @@ static int getCorrDFT(dsp_t *dsp) {
 
     //xnorm = sqrt(dsp->qs[(mpos + 2*dsp->M) % dsp->M]); // Nvar = L
     xnorm = 0.0;
-    for (i = 0; i < dsp->L; i++) xnorm += (dsp->DFT).xn[mp-i]*(dsp->DFT).xn[mp-i];
+    for (i = 0; i < dsp->L; i++) {
+        x = (dsp->DFT).xn[mp-i] - dc;
+        xnorm += x*x;
+    }
     xnorm = sqrt(xnorm);
 
     mx /= xnorm*(dsp->DFT).N;
@@ -244,6 +323,12 @@ static int findstr(char *buff, char *str, int pos) {
     return i;
 }
 
+// input file, "shm:<name>": iq_bus ring, "rtl_tcp:<host>[:<port>]?s=<sr>": rtl_tcp server,
+// "<name>.sigmf-meta", "raw:<fmt>:<sr>:<path>", "<name>.iqz": iqzip archive (RS/io/sample_io.c)
+FILE *pcm_fopen(char *path) {
+    return sio_fopen(path);
+}
+
 float read_wav_header(pcm_t *pcm) {
     FILE *fp = pcm->fp;
     char txt[4+1] = "\0\0\0\0";
@@ -307,242 +392,463 @@ float read_wav_header(pcm_t *pcm) {
     return 0;
 }
 
-static int f32read_sample(dsp_t *dsp, float *s) {
-    int i;
-    unsigned int word = 0;
-    short *b = (short*)&word;
-    float *f = (float*)&word;
-
-    for (i = 0; i < dsp->nch; i++) {
-
-        if (fread( &word, dsp->bps/8, 1, dsp->fp) != 1) return EOF;
-
-        if (i == dsp->ch) {  // i = 0: links bzw. mono
-            //if (bits_sample ==  8)  sint = b-128;   // 8bit: 00..FF, centerpoint 0x80=128
-            //if (bits_sample == 16)  sint = (short)b;
+// n samples (channel dsp->ch) -> s[]
+static int f32read_block(dsp_t *dsp, float *s, int n) {
+    return sio_float(dsp->sio, dsp->ch, s, n);
+}
 
-            if (dsp->bps == 32) {
-                *s = *f;
-            }
-            else {
-                if (dsp->bps ==  8) { *b -= 128; }
-                *s = *b/128.0;
-                if (dsp->bps == 16) { *s /= 256.0; }
-            }
-        }
+int iq_dc_init(stream_t *st) {
+    iq_dc_t *IQdc = &st->IQdc;
+    memset(IQdc, 0, sizeof(*IQdc));
+    IQdc->maxlim = st->pcm.sr;
+    IQdc->maxcnt = IQdc->maxlim/32; // 32,16,8,4,2,1
+    if (st->pcm.decM > 1) {
+        IQdc->maxlim *= st->pcm.decM;
+        IQdc->maxcnt *= st->pcm.decM;
     }
 
     return 0;
 }
 
-typedef struct {
-    double sumIQx;
-    double sumIQy;
-    float avgIQx;
-    float avgIQy;
-    ui32_t cnt;
-    ui32_t maxcnt;
-    ui32_t maxlim;
-} iq_dc_t;
-static iq_dc_t IQdc;
-
-int iq_dc_init(pcm_t *pcm) {
-    memset(&IQdc, 0, sizeof(IQdc));
-    IQdc.maxlim = pcm->sr;
-    IQdc.maxcnt = IQdc.maxlim/32; // 32,16,8,4,2,1
-    if (pcm->decM > 1) {
-        IQdc.maxlim *= pcm->decM;
-        IQdc.maxcnt *= pcm->decM;
-    }
-
+// shared input for all channel threads (iq_ring_thread)
+int pcm_io_init(pcm_t *pcm) {
+    pcm->sio = calloc(1, sizeof(sio_t));  if (pcm->sio == NULL) return -1;
+    if (sio_open(pcm->sio, pcm->fp, pcm->bps, pcm->nch, pcm->sr) < 0) return -1;
+    if ((pcm->t_start > 0 || pcm->t_dur > 0) && sio_window(pcm->sio, pcm->t_start, pcm->t_dur) < 0) return -1;
     return 0;
 }
 
-static int f32read_csample(dsp_t *dsp, float complex *z) {
+int pcm_io_free(pcm_t *pcm) {
+    if (pcm->sio) { sio_close(pcm->sio); free(pcm->sio); pcm->sio = NULL; }
+    return 0;
+}
 
+// IQ dc offset: running mean, window maxcnt doubling up to maxlim
+void iq_dc_block(iq_dc_t *IQdc, float complex *z, int n) {
+    int k;
     float x, y;
 
-    if (dsp->bps == 32) { //float32
-        float f[2];
-        if (fread( f, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = f[0];
-        y = f[1];
-    }
-    else if (dsp->bps == 16) { //int16
-        short b[2];
-        if (fread( b, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = b[0]/32768.0;
-        y = b[1]/32768.0;
-    }
-    else {  // dsp->bps == 8   //uint8
-        ui8_t u[2];
-        if (fread( u, dsp->bps/8, 2, dsp->fp) != 2) return EOF;
-        x = (u[0]-128)/128.0;
-        y = (u[1]-128)/128.0;
+    for (k = 0; k < n; k++) {
+        x = crealf(z[k]);
+        y = cimagf(z[k]);
+        z[k] = (x - IQdc->avgIQx) + I*(y - IQdc->avgIQy);
+
+        IQdc->sumIQx += x;
+        IQdc->sumIQy += y;
+        IQdc->cnt += 1;
+        if (IQdc->cnt == IQdc->maxcnt) {
+            IQdc->avgIQx = IQdc->sumIQx/(float)IQdc->maxcnt;
+            IQdc->avgIQy = IQdc->sumIQy/(float)IQdc->maxcnt;
+            IQdc->sumIQx = 0; IQdc->sumIQy = 0; IQdc->cnt = 0;
+            if (IQdc->maxcnt < IQdc->maxlim) IQdc->maxcnt *= 2;
+        }
     }
+}
 
-    *z = (x - IQdc.avgIQx) + I*(y - IQdc.avgIQy);
+// n IQ samples -> z[] (dc removed)
+static int f32read_cblock_n(dsp_t *dsp, float complex *z, int n) {
+    int len;
 
-    IQdc.sumIQx += x;
-    IQdc.sumIQy += y;
-    IQdc.cnt += 1;
-    if (IQdc.cnt == IQdc.maxcnt) {
-        IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-        IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-        IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-        if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-    }
+    len = sio_cfloat(dsp->sio, (float*)z, n);
+    iq_dc_block(&dsp->thd.st->IQdc, z, len);
 
-    return 0;
+    return len;
 }
 
 
-static volatile int bufeof = 0;      // threads exit
-static volatile int rbf;
-extern int rbf1;
+// polyphase FFT filter bank (channelizer, rs_multi --pfb):
+//   M = decM channels, spacing sr_base/M = IF_sr, 2x oversampled (D = M/2),
+//   channel rate 2*IF_sr; all channels in one pass, independent of the number of decoders.
+//   channel k:  y_k[m] = sum_n h[n] x[mD-n] exp(-2pi*I*k*(mD-n)/M)
+//                      = (-1)^(k*m) sum_r v_r exp(2pi*I*k*r/M),  v_r = sum_l h[r+lM] x[mD-r-lM]
+//   i.e. L-tap branch sums v_r and one M-point (mixed radix) FFT per D input samples.
+// decoder: channel k nearest fq, residual shift (nco_pfb), 2:1 FIR -> IF (pfb_dec)
+#define PFB_MAXP  64  // max radix
+
+// radix-p butterfly, y_j = sum_r u_r exp(2pi*I*r*j/p)
+static inline void pfb_bfly(const pfb_t *pfb, int p, const float complex *u, float complex *y) {
+    float complex t1, t2, t3, t4, a, b;
+    int j, r;
+
+    switch (p) {
+        case 2:
+            y[0] = u[0] + u[1];
+            y[1] = u[0] - u[1];
+            break;
+        case 3:  // exp(2pi*I/3) = -1/2 + I*sqrt(3)/2
+            t1 = u[1] + u[2];
+            t2 = u[1] - u[2];
+            a = u[0] - 0.5f*t1;
+            b = c_cf(-0.8660254f*cimagf(t2), 0.8660254f*crealf(t2));
+            y[0] = u[0] + t1;
+            y[1] = a + b;
+            y[2] = a - b;
+            break;
+        case 4:
+            t1 = u[0] + u[2];  t2 = u[0] - u[2];
+            t3 = u[1] + u[3];  t4 = u[1] - u[3];
+            t4 = c_cf(-cimagf(t4), crealf(t4)); // I*t4
+            y[0] = t1 + t3;
+            y[1] = t2 + t4;
+            y[2] = t1 - t3;
+            y[3] = t2 - t4;
+            break;
+        case 5:  // c1 = cos(2pi/5), c2 = cos(4pi/5), s1, s2
+            t1 = u[1] + u[4];  t2 = u[2] + u[3];
+            t3 = u[1] - u[4];  t4 = u[2] - u[3];
+            y[0] = u[0] + t1 + t2;
+            a = u[0] + 0.30901699f*t1 - 0.80901699f*t2;
+            b = 0.95105652f*t3 + 0.58778525f*t4;
+            b = c_cf(-cimagf(b), crealf(b));
+            y[1] = a + b;
+            y[4] = a - b;
+            a = u[0] - 0.80901699f*t1 + 0.30901699f*t2;
+            b = 0.58778525f*t3 - 0.95105652f*t4;
+            b = c_cf(-cimagf(b), crealf(b));
+            y[2] = a + b;
+            y[3] = a - b;
+            break;
+        default:
+            for (j = 0; j < p; j++) {
+                y[j] = u[0];
+                for (r = 1; r < p; r++) y[j] = c_mac(y[j], u[r], pfb->tw[pfb->M/p*(r*j % p)]);
+            }
+    }
+}
 
+// Stockham autosort, radix fac[f]: x[] -> x[], w[] work
+static void pfb_fft(const pfb_t *pfb, float complex *x, float complex *w) {
+    int n = pfb->M, s = 1;
+    int f, p, m, q, j, k, r;
+    float complex *a = x, *b = w, *t;
+    const float complex *tw = pfb->tws;
+    float complex u[PFB_MAXP], y[PFB_MAXP];
+
+    for (f = 0; f < pfb->nf; f++) {
+        p = pfb->fac[f];
+        m = n / p;
+        for (q = 0; q < m; q++) {
+            for (k = 0; k < s; k++) {
+                for (r = 0; r < p; r++) u[r] = a[k + s*(q + m*r)];
+                pfb_bfly(pfb, p, u, y);
+                b[k + s*p*q] = y[0];
+                for (j = 1; j < p; j++) b[k + s*(p*q + j)] = c_mul(y[j], tw[q*p + j]);
+            }
+        }
+        tw += m*p;
+        n = m;
+        s *= p;
+        t = a; a = b; b = t;
+    }
+    if (a != x) memcpy(x, a, pfb->M*sizeof(float complex));
+}
 
-static int __f32read_cblock_nocond(dsp_t *dsp) { // blk
-                                      // faster; however if #{fqs} > #{cores}, very very slow, quasi-lock
-    int n;
-    int BL = dsp->decM * blk_sz;
-    int len = BL;
+// n input samples -> out[k*clen + i], returns outputs per channel (n/D, remainder kept)
+int pfb_block(pfb_t *pfb, float complex *x, int n, float complex *out, int clen) {
+    int M = pfb->M, L = pfb->L, P = pfb->L*pfb->M;
+    int i = 0, k, l, xp = P;
+    const float *xf, *h;
+    float *acc = pfb->acc;
+    float a;
+
+    memcpy(pfb->xb + pfb->xn, x, n*sizeof(float complex));
+    pfb->xn += n;
+
+    while (pfb->xn - xp >= pfb->D && i < clen) {
+        xp += pfb->D;
+        // v_r, r = M-1-k: sum_l h[M-1-k+lM] x[xp-M+k-lM], contiguous in k (re/im interleaved)
+        xf = (const float *)(pfb->xb + xp-M);
+        k = 0;
+    #ifdef FIR_X86
+        for ( ; k+4 <= 2*M; k += 4) {
+            __m128 a4 = _mm_setzero_ps();
+            for (l = 0; l < L; l++) {
+                a4 = _mm_add_ps(a4, _mm_mul_ps(_mm_loadu_ps(pfb->h + 2*l*M + k), _mm_loadu_ps(xf - 2*l*M + k)));
+            }
+            _mm_storeu_ps(acc+k, a4);
+        }
+    #endif
+        for ( ; k < 2*M; k++) {
+            a = 0;
+            for (l = 0, h = pfb->h + k; l < L; l++, h += 2*M) a += *h * xf[k - 2*l*M];
+            acc[k] = a;
+        }
+        for (k = 0; k < M; k++) pfb->v[M-1-k] = c_cf(acc[2*k], acc[2*k+1]);
+        pfb_fft(pfb, pfb->v, pfb->w);
+        if (pfb->m & 1) {
+            for (k = 0; k < M; k++) out[k*clen + i] = (k & 1) ? -pfb->v[k] : pfb->v[k];
+        }
+        else {
+            for (k = 0; k < M; k++) out[k*clen + i] = pfb->v[k];
+        }
+        pfb->m += 1;
+        i += 1;
+    }
+    memmove(pfb->xb, pfb->xb + xp-P, (pfb->xn - xp + P)*sizeof(float complex));
+    pfb->xn -= xp-P;
 
-    if (bufeof) return 0;
+    return i;
+}
 
-    pthread_mutex_lock( dsp->thd.mutex );
 
-    if (rbf == 0)
-    {
-        if (dsp->bps == 8) { //uint8
-            ui8_t u[2*BL];
-            len = fread( u, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            for (n = 0; n < len; n++) dsp->thd.blk[n] = (u[2*n]-128)/128.0 + I*(u[2*n+1]-128)/128.0;
+// consumer: decM samples -> decMbuf (pfb: channel pfb_ch)
+// n samples from the ring -> buf (NULL: skip)
+static int f32read_ring(dsp_t *dsp, float complex *buf, int nr) {
+    iqring_t *r = &dsp->thd.st->ring;
+    int n = 0, l, len, slot;
+    int spin = 0;
+
+    while (n < nr) {
+        if (dsp->thd.rpos == 0 && atomic_load_explicit(&dsp->thd.cur->stop, memory_order_relaxed)) break;
+        if (dsp->thd.rseq == atomic_load_explicit(&r->wseq, memory_order_acquire)) {
+            if (atomic_load_explicit(&r->eof, memory_order_acquire)
+               && dsp->thd.rseq == atomic_load_explicit(&r->wseq, memory_order_acquire)) break;
+            if (dsp->thd.task) task_yield(dsp->thd.task, 1);
+            else iqr_wait(&spin);
+            continue;
         }
-        else if (dsp->bps == 16) { //int16
-            short b[2*BL];
-            len = fread( b, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            for (n = 0; n < len; n++) dsp->thd.blk[n] = b[2*n]/32768.0 + I*b[2*n+1]/32768.0;
+        spin = 0;
+        if (r->drop) { // lagging: skip to the oldest block, discard a block overwritten while read
+            ui64_t d = iq_ring_skip(r, &dsp->thd.rseq);
+            if (d) {
+                dsp->thd.lost += d;
+                dsp->thd.rpos = 0;
+                atomic_store_explicit(&dsp->thd.cur->seq, dsp->thd.rseq, memory_order_release);
+            }
         }
-        else { // dsp->bps == 32   //float32
-            float f[2*BL];
-            len = fread( f, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            for (n = 0; n < len; n++) dsp->thd.blk[n] = f[2*n] + I*f[2*n+1];
+        slot = dsp->thd.rseq % r->nslot;
+        len = r->len[slot];
+        l = len - dsp->thd.rpos;
+        if (l > nr - n) l = nr - n;
+        if (buf) memcpy(buf+n, r->buf + (size_t)slot*r->ssz + dsp->pfb_ch*r->chlen + dsp->thd.rpos, l*sizeof(float complex));
+        if (!iq_ring_valid(r, dsp->thd.rseq)) continue;
+        n += l;
+        dsp->thd.rpos += l;
+        if (dsp->thd.rpos == len) {
+            dsp->thd.rpos = 0;
+            dsp->thd.rseq += 1;
+            atomic_store_explicit(&dsp->thd.cur->seq, dsp->thd.rseq, memory_order_release);
+            if (dsp->thd.task) task_yield(dsp->thd.task, 0);
         }
-        if (len < BL) bufeof = 1;
-
-        rbf = rbf1; // set all bits
     }
-    pthread_mutex_unlock( dsp->thd.mutex );
 
-    while ((rbf & dsp->thd.tn_bit) == 0) ;  // only if #{fqs} leq #{cores} ...
+    return n;
+}
 
-    for (n = 0; n < dsp->decM; n++) dsp->decMbuf[n] = dsp->thd.blk[dsp->decM*dsp->blk_cnt + n];
+int f32read_cblock(dsp_t *dsp) {
+    return f32read_ring(dsp, dsp->decMbuf, dsp->decM);
+}
 
-    dsp->blk_cnt += 1;
-    if (dsp->blk_cnt == blk_sz) {
-        pthread_mutex_lock( dsp->thd.mutex );
-        rbf &= ~(dsp->thd.tn_bit); // clear bit(tn)
-        dsp->blk_cnt = 0;
-        pthread_mutex_unlock( dsp->thd.mutex );
-    }
+// squelch: n IF samples, no copy
+static int f32read_skip(dsp_t *dsp, int n) {
+    return f32read_ring(dsp, NULL, n*dsp->decM) / dsp->decM;
+}
 
-    return len;
+// --auto: IF samples of the detector (det_handoff), before the ring
+static int f32read_det(dsp_t *dsp, float complex *z, int n) {
+    int l = dsp->det_n - dsp->det_pos;
+    if (l > n) l = n;
+    memcpy(z, dsp->det_z + dsp->det_pos, l*sizeof(float complex));
+    dsp->det_pos += l;
+    if (dsp->det_pos == dsp->det_n) {
+        free(dsp->det_z);
+        dsp->det_z = NULL;
+    }
+    return l;
 }
 
-static int f32read_cblock(dsp_t *dsp) { // blk_cond
 
+
+// multistage decimation (opt_iq == 5):
+//   decM = R * 2^nhb
+//   CIC(R, order DEC_CIC_N) -> nhb half-band stages (2:1) -> FIR at IF rate
+// the IF FIR (ws_f) compensates the CIC droop and sets the IF bandwidth.
+// CIC in 64bit integer arithmetic (wrap-around, exact); decM < 4: single FIR (ws_dec)
+#define DEC_SCALE  (1<<20)  // float -> int, CIC input
+#define DEC_FTAPS  31       // IF FIR taps
+#define DEC_RMAX   128      // max CIC decimation
+
+static double cic_resp(int R, double f) { // f: cycles/sample at CIC input
+    double a = sin(M_PI*f);
     int n;
-    int BL = dsp->decM * blk_sz;
-    int len = BL;
-    float x, y;
+    double h = 1.0;
+    if (fabs(a) < 1e-12) return 1.0;
+    for (n = 0; n < DEC_CIC_N; n++) h *= sin(M_PI*f*R)/(R*a);
+    return fabs(h);
+}
 
-    if (bufeof) return 0;
+static int decim_design(decim_t *dec, int decM, float f_lp) {
+    int n, k, m, s;
+    int R = decM, nhb = 0;
+    float fc = f_lp * decM; // IF-rate cutoff
+    double norm, df, f, d;
+    double *h;
 
-    pthread_mutex_lock( dsp->thd.mutex );
+    memset(dec, 0, sizeof(*dec));
+    if (decM < 4) return 0;
 
-    if (rbf == 0)
-    {
-        if (dsp->bps == 8) { //uint8
-            ui8_t u[2*BL];
-            len = fread( u, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            //for (n = 0; n < len; n++) dsp->thd.blk[n] = (u[2*n]-128)/128.0 + I*(u[2*n+1]-128)/128.0;
-            // u8: 0..255, 128 -> 0V
-            for (n = 0; n < len; n++) {
-                x = (u[2*n  ]-128)/128.0;
-                y = (u[2*n+1]-128)/128.0;
-                dsp->thd.blk[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-                IQdc.sumIQx += x;
-                IQdc.sumIQy += y;
-                IQdc.cnt += 1;
-                if (IQdc.cnt == IQdc.maxcnt) {
-                    IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                    IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                    IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                    if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-                }
-            }
-        }
-        else if (dsp->bps == 16) { //int16
-            short b[2*BL];
-            len = fread( b, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            for (n = 0; n < len; n++) {
-                x = b[2*n  ]/32768.0;
-                y = b[2*n+1]/32768.0;
-                dsp->thd.blk[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-                IQdc.sumIQx += x;
-                IQdc.sumIQy += y;
-                IQdc.cnt += 1;
-                if (IQdc.cnt == IQdc.maxcnt) {
-                    IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                    IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                    IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                    if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-                }
-            }
-        }
-        else { // dsp->bps == 32   //float32
-            float f[2*BL];
-            len = fread( f, dsp->bps/8, 2*BL, dsp->fp) / 2;
-            for (n = 0; n < len; n++) {
-                x = f[2*n];
-                y = f[2*n+1];
-                dsp->thd.blk[n] = (x-IQdc.avgIQx) + I*(y-IQdc.avgIQy);
-                IQdc.sumIQx += x;
-                IQdc.sumIQy += y;
-                IQdc.cnt += 1;
-                if (IQdc.cnt == IQdc.maxcnt) {
-                    IQdc.avgIQx = IQdc.sumIQx/(float)IQdc.maxcnt;
-                    IQdc.avgIQy = IQdc.sumIQy/(float)IQdc.maxcnt;
-                    IQdc.sumIQx = 0; IQdc.sumIQy = 0; IQdc.cnt = 0;
-                    if (IQdc.maxcnt < IQdc.maxlim) IQdc.maxcnt *= 2;
-                }
-            }
+    while (R % 2 == 0 && (nhb == 0 || R > DEC_RMAX) && nhb < DEC_HB_MAX) {
+        R /= 2;
+        nhb += 1;
+    }
+    if (R > DEC_RMAX) return 0;
+
+    dec->R = R;
+    dec->nhb = nhb;
+
+    // half-band stages: taps = 4k+3
+    for (s = 0; s < nhb; s++) {
+        double fpass = fc / (double)(1 << (nhb-s));  // fc relative to stage input rate
+        double tbw = 0.5 - 2*fpass;
+        int taps, c;
+        if (tbw < 0.05) tbw = 0.05;
+        taps = 5.5/tbw;
+        k = taps/4; if (k < 1) k = 1;
+        taps = 4*k+3;
+        c = (taps-1)/2;
+        dec->hbtaps[s] = taps;
+        dec->hb[s] = calloc(k+2, sizeof(float));  if (dec->hb[s] == NULL) return -1;
+        norm = 0.5;
+        for (m = 0; m <= k; m++) {  // offsets 2m+1
+            n = c + 2*m+1;
+            d = 0.5*sin(M_PI*(n-c)/2.0)/(M_PI*(n-c)/2.0)
+                * (7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)));
+            dec->hb[s][m] = d;
+            norm += 2*d;
         }
-        if (len < BL) bufeof = 1;
+        for (m = 0; m <= k; m++) dec->hb[s][m] /= norm;
+        dec->hbc[s] = 0.5/norm;
+    }
 
-        rbf = rbf1; // set all bits
-        pthread_cond_broadcast( dsp->thd.cond );
+    // IF FIR, frequency sampling: ideal lowpass(fc) / H_cic(f)
+    dec->ftaps = DEC_FTAPS;
+    dec->ws_f = calloc(dec->ftaps+1, sizeof(float));  if (dec->ws_f == NULL) return -1;
+    h = calloc(dec->ftaps+1, sizeof(double));  if (h == NULL) return -1;
+    df = fc / 256.0;
+    norm = 0.0;
+    for (n = 0; n < dec->ftaps; n++) {
+        double t = n - (dec->ftaps-1)/2.0;
+        d = 0.0;
+        for (m = 0; m < 256; m++) {
+            f = (m+0.5)*df;
+            d += cos(2*M_PI*f*t) / cic_resp(R, f/(double)decM);
+        }
+        h[n] = 2*d*df * (7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(dec->ftaps-1))
+                                      + 1430/18608.0*cos(4*M_PI*n/(dec->ftaps-1)));
+        norm += h[n];
     }
+    for (n = 0; n < dec->ftaps; n++) dec->ws_f[n] = h[n]/norm;
+    free(h); h = NULL;
 
-    while ((rbf & dsp->thd.tn_bit) == 0) pthread_cond_wait( dsp->thd.cond, dsp->thd.mutex );
+    dec->gain = 1.0 / ((double)DEC_SCALE * pow(R, DEC_CIC_N));
 
-    for (n = 0; n < dsp->decM; n++) dsp->decMbuf[n] = dsp->thd.blk[dsp->decM*dsp->blk_cnt + n];
+    return nhb+2;
+}
 
-    dsp->blk_cnt += 1;
-    if (dsp->blk_cnt == blk_sz) {
-        rbf &= ~(dsp->thd.tn_bit); // clear bit(tn)
-        dsp->blk_cnt = 0;
+static void decim_design_free(decim_t *dec) {
+    int s;
+    for (s = 0; s < DEC_HB_MAX; s++) {
+        if (dec->hb[s]) { free(dec->hb[s]); dec->hb[s] = NULL; }
     }
+    if (dec->ws_f) { free(dec->ws_f); dec->ws_f = NULL; }
+    dec->R = 0;
+}
 
-    pthread_mutex_unlock( dsp->thd.mutex );
+static int decim_stages_init(dsp_t *dsp) {
+    const decim_t *dec = &dsp->thd.st->dec;
+    int s;
+    memset(&dsp->dst, 0, sizeof(dsp->dst));
+    for (s = 0; s < dec->nhb; s++) {
+        dsp->dst.hbbuf[s] = calloc(2*dec->hbtaps[s]+1, sizeof(float complex));
+        if (dsp->dst.hbbuf[s] == NULL) return -1;
+    }
+    dsp->dst.fbuf = calloc(2*dec->ftaps+1, sizeof(float complex));
+    if (dsp->dst.fbuf == NULL) return -1;
+    return 0;
+}
 
-    return len;
+static void decim_stages_free(dsp_t *dsp) {
+    int s;
+    for (s = 0; s < DEC_HB_MAX; s++) {
+        if (dsp->dst.hbbuf[s]) { free(dsp->dst.hbbuf[s]); dsp->dst.hbbuf[s] = NULL; }
+    }
+    if (dsp->dst.fbuf) { free(dsp->dst.fbuf); dsp->dst.fbuf = NULL; }
 }
 
+// mirrored delay line: x at pos and pos+taps, window buf[pos+1..pos+taps] (newest last)
+static float complex *dline_push(float complex *buf, int *pos, int taps, float complex x) {
+    *pos += 1; if (*pos == taps) *pos = 0;
+    buf[*pos] = x;
+    buf[*pos+taps] = x;
+    return buf + *pos+1;
+}
 
-// decimate lowpass
-static float *ws_dec;
+// half-band stages s.. ; returns 1 if an IF sample is ready in *z
+static int decim_hb(dsp_t *dsp, int s, float complex x, float complex *z) {
+    const decim_t *dec = &dsp->thd.st->dec;
+    float complex *w;
+    float complex y;
+    int taps, c, m, k;
+
+    for ( ; s < dec->nhb; s++) {
+        taps = dec->hbtaps[s];
+        w = dline_push(dsp->dst.hbbuf[s], &dsp->dst.hbpos[s], taps, x);
+        dsp->dst.hbph[s] ^= 1;
+        if (dsp->dst.hbph[s]) return 0; // 2:1
+        c = (taps-1)/2;
+        k = (taps-3)/4;
+        y = dec->hbc[s] * w[c];
+        for (m = 0; m <= k; m++) y += dec->hb[s][m] * (w[c-2*m-1] + w[c+2*m+1]);
+        x = y;
+    }
+    *z = x;
+    return 1;
+}
+
+// decM input samples (decMbuf) -> one IF sample
+static float complex decim_block(dsp_t *dsp) {
+    const decim_t *dec = &dsp->thd.st->dec;
+    int j, n, r;
+    float complex x, y = 0, z = 0;
+    float complex *w;
+    ui64_t v[2];
+    i64_t t;
+
+    for (j = 0; j < dsp->decM; j++) {
+        x = c_mul(dsp->decMbuf[j], dsp->ex[dsp->sample_dec]);
+        dsp->sample_dec += 1;
+        if (dsp->sample_dec == dsp->lut_len) dsp->sample_dec = 0;
+
+        if (dec->R > 1) {
+            v[0] = (ui64_t)(i64_t)lrintf(crealf(x)*DEC_SCALE);
+            v[1] = (ui64_t)(i64_t)lrintf(cimagf(x)*DEC_SCALE);
+            for (r = 0; r < 2; r++) {
+                for (n = 0; n < DEC_CIC_N; n++) {
+                    dsp->dst.ig[r][n] += v[r];
+                    v[r] = dsp->dst.ig[r][n];
+                }
+            }
+            dsp->dst.cnt += 1;
+            if (dsp->dst.cnt < dec->R) continue;
+            dsp->dst.cnt = 0;
+            for (r = 0; r < 2; r++) {
+                for (n = 0; n < DEC_CIC_N; n++) {
+                    ui64_t u = v[r];
+                    v[r] -= dsp->dst.cb[r][n];
+                    dsp->dst.cb[r][n] = u;
+                }
+            }
+            t = (i64_t)v[0]; x  = (float)(t * dec->gain);
+            t = (i64_t)v[1]; x += (float)(t * dec->gain) * I;
+        }
+        if (decim_hb(dsp, 0, x, &y)) {
+            w = dline_push(dsp->dst.fbuf, &dsp->dst.fpos, dec->ftaps, y);
+            z = dsp->cfir(w, dec->ws_f, dec->ftaps);
+        }
+    }
+
+    return z;
+}
 
 static double sinc(double x) {
     double y;
@@ -551,7 +857,7 @@ static double sinc(double x) {
     return y;
 }
 
-static int lowpass_init(float f, int taps, float **pws) {
+int lowpass_init(float f, int taps, float **pws) {
     double *h, *w;
     double norm = 0;
     int n;
@@ -568,8 +874,8 @@ static int lowpass_init(float f, int taps, float **pws) {
     for (n = 0; n < taps; n++) {
         w[n] = 7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(taps-1)) + 1430/18608.0*cos(4*M_PI*n/(taps-1)); // Blackmann
         h[n] = 2*f*sinc(2*f*(n-(taps-1)/2));
-        ws[n] = w[n]*h[n];
-        norm += ws[n]; // 1-norm
+        ws[taps-1-n] = w[n]*h[n]; // time-reversed (FIR kernels)
+        norm += w[n]*h[n]; // 1-norm
     }
     for (n = 0; n < taps; n++) {
         ws[n] /= norm; // 1-norm
@@ -582,160 +888,730 @@ static int lowpass_init(float f, int taps, float **pws) {
     return taps;
 }
 
-int decimate_init(float f, int taps) {
-    return lowpass_init(f, taps, &ws_dec);
+int decimate_init(stream_t *st, float f, int taps) {
+    return lowpass_init(f, taps, &st->ws_dec);
+}
+
+// returns 0: single FIR, decimate_init()
+int decimate_stages_init(stream_t *st, int decM, float f) {
+    const decim_t *dec = &st->dec;
+    int s;
+    int n = decim_design(&st->dec, decM, f);
+    if (n > 0) {
+        fprintf(stderr, "dec: CIC %d, HB %d", dec->R, dec->nhb);
+        for (s = 0; s < dec->nhb; s++) fprintf(stderr, " [%d]", dec->hbtaps[s]);
+        fprintf(stderr, ", FIR %d\n", dec->ftaps);
+    }
+    return n;
+}
+
+// prototype: passband IF_sr/2 + f (sonde at channel edge), stopband 2*IF_sr - passband,
+// windowed sinc (Blackman), L = taps/M per branch
+// returns M, 0: not possible (decM odd or < 4)
+int pfb_init(stream_t *st, int decM, float f) {
+    pfb_t *pfb = &st->pfb;
+    int M = decM, L, n, l, r, p;
+    double fp, tbw, norm, w, *h;
+    float fl;
+
+    memset(pfb, 0, sizeof(*pfb));
+    if (M < 4 || M % 2) return 0;
+
+    n = M;
+    while (n % 4 == 0 && pfb->nf < PFB_MAXF) { pfb->fac[pfb->nf++] = 4; n /= 4; }
+    for (p = 2; n > 1; p++) {
+        while (n % p == 0) {
+            if (pfb->nf == PFB_MAXF || p > PFB_MAXP) return 0;
+            pfb->fac[pfb->nf++] = p;
+            n /= p;
+        }
+    }
+
+    fp = 0.5/M + f;
+    tbw = 2.0/M - 2*fp;
+    if (tbw < 0.25/M) tbw = 0.25/M;
+    L = 5.5/tbw/M + 1;
+    if (L < 2) L = 2;
+
+    pfb->M = M;
+    pfb->D = M/2;
+    pfb->L = L;
+
+    h = calloc(L*M+1, sizeof(double));  if (h == NULL) return -1;
+    pfb->h = calloc(2*L*M+1, sizeof(float));  if (pfb->h == NULL) return -1;
+    pfb->acc = calloc(2*M+1, sizeof(float));  if (pfb->acc == NULL) return -1;
+    norm = 0.0;
+    for (n = 0; n < L*M; n++) {
+        w = 7938/18608.0 - 9240/18608.0*cos(2*M_PI*n/(L*M-1)) + 1430/18608.0*cos(4*M_PI*n/(L*M-1)); // Blackmann
+        h[n] = w * 2.0/M * sinc(2.0/M*(n-(L*M-1)/2.0));  // cutoff 1/M
+        norm += h[n];
+    }
+    for (l = 0; l < L; l++) {
+        for (r = 0; r < M; r++) pfb->h[2*(l*M+r)] = pfb->h[2*(l*M+r)+1] = h[M-1-r+l*M]/norm;
+    }
+    free(h); h = NULL;
+
+    pfb->tw = calloc(M+1, sizeof(float complex));  if (pfb->tw == NULL) return -1;
+    for (n = 0; n < M; n++) pfb->tw[n] = cexp(2*M_PI*n/(double)M*I);
+    pfb->tws = calloc(pfb->nf*M+1, sizeof(float complex));  if (pfb->tws == NULL) return -1;
+    for (n = M, l = 0, r = 0; r < pfb->nf; r++) {  // stage r: n, m = n/p
+        int q, j, m = n / pfb->fac[r];
+        for (q = 0; q < m; q++) {
+            for (j = 0; j < pfb->fac[r]; j++) pfb->tws[l++] = pfb->tw[M/n*q*j];
+        }
+        n = m;
+    }
+
+    pfb->xb = calloc(L*M + (IQR_BLK+1)*M + 1, sizeof(float complex));  if (pfb->xb == NULL) return -1;
+    pfb->xn = L*M;
+    pfb->v = calloc(M+1, sizeof(float complex));  if (pfb->v == NULL) return -1;
+    pfb->w = calloc(M+1, sizeof(float complex));  if (pfb->w == NULL) return -1;
+
+    // 2:1 FIR at channel rate 2/M: lowpass f (sr_base) -> f*M/2
+    fl = f*M/2.0;
+    n = 4.0/(0.5 - 2*fl); if (n < 7) n = 7;
+    pfb->ptaps = lowpass_init(fl, n, &pfb->ws_p);  if (pfb->ptaps < 0) return -1;
+
+    fprintf(stderr, "pfb: %d channels, D %d, %d x %d taps, FIR %d, FFT", pfb->M, pfb->D, pfb->M, pfb->L, pfb->ptaps);
+    for (n = 0; n < pfb->nf; n++) fprintf(stderr, " %d", pfb->fac[n]);
+    fprintf(stderr, "\n");
+
+    return M;
+}
+
+static void pfb_free(pfb_t *pfb) {
+    if (pfb->h)    { free(pfb->h);    pfb->h    = NULL; }
+    if (pfb->acc)  { free(pfb->acc);  pfb->acc  = NULL; }
+    if (pfb->tw)   { free(pfb->tw);   pfb->tw   = NULL; }
+    if (pfb->tws)  { free(pfb->tws);  pfb->tws  = NULL; }
+    if (pfb->ws_p) { free(pfb->ws_p); pfb->ws_p = NULL; }
+    if (pfb->xb)   { free(pfb->xb);   pfb->xb   = NULL; }
+    if (pfb->v)    { free(pfb->v);    pfb->v    = NULL; }
+    if (pfb->w)    { free(pfb->w);    pfb->w    = NULL; }
+    pfb->M = 0;
 }
 
-int decimate_free() {
+int decimate_free(stream_t *st) {
+    decim_design_free(&st->dec);
+    pfb_free(&st->pfb);
 
-    if (ws_dec) { free(ws_dec); ws_dec = NULL; }
+    if (st->ws_dec) { free(st->ws_dec); st->ws_dec = NULL; }
 
     return 0;
 }
 
-static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double complex w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n+1)%taps]*ws[taps-1-n];
+
+#define IF_SAMPLE_RATE  48000
+
+// st->pcm: input after read_wav_header() and pcm_io_init();
+// IF rate and decimator design (IQ: CIC/half-band, FIR or pfb), IQ ring of nslot blocks.
+// channels: thd.st = st, thd.cur = iq_ring_attach(&st->ring, live), pcm = st->pcm
+int stream_init(stream_t *st, int nslot) {
+    pcm_t *p = &st->pcm;
+
+    int IF_sr = IF_SAMPLE_RATE; // designated IF sample rate
+    int decM = 1; // decimate M:1
+    int sr_base = p->sr;
+    float f_lp; // dec_lowpass: lowpass_bandwidth/2
+    float tbw;  // dec_lowpass: transition_bandwidth/Hz
+    int taps;   // dec_lowpass: taps
+    int stages; // multistage decimation
+
+    if (IF_sr > sr_base) IF_sr = sr_base;
+    if (IF_sr < sr_base) {
+        while (sr_base % IF_sr) IF_sr += 1;
+        decM = sr_base / IF_sr;
+    }
+
+    f_lp = (IF_sr+20e3)/(4.0*sr_base);
+    tbw  = (IF_sr-20e3)/*/2.0*/; if (tbw < 0) tbw = 8e3;
+    taps = sr_base*4.0/tbw; if (taps%2==0) taps++;
+
+    if (p->pfb) {
+        p->pfb = pfb_init(st, decM, f_lp); // M channels, if decM even
+        if (p->pfb < 0) return -1;
+        if (p->pfb == 0) fprintf(stderr, "pfb: decM %d odd\n", decM);
     }
-    return (float complex)w;
+
+    stages = 0;
+    if (p->pfb == 0) {
+        stages = decimate_stages_init(st, decM, f_lp); // CIC + half-band + IF-FIR, if decM >= 4
+        if (stages < 0) return -1;
+    }
+    if (stages == 0 && p->pfb == 0) taps = decimate_init(st, f_lp, taps);
+    else taps = 0;
+
+    if (taps < 0) return -1;
+    p->dectaps = (ui32_t)taps;
+    p->sr_base = sr_base;
+    p->sr = IF_sr; // sr_base/decM
+    p->decM = decM;
+
+    iq_dc_init(st);
+
+    fprintf(stderr, "IF: %d\n", IF_sr);
+    fprintf(stderr, "dec: %d\n", decM);
+
+    fprintf(stderr, "taps: %d\n", taps);
+    fprintf(stderr, "transBW: %.4f = %.1f Hz\n", tbw/sr_base, tbw);
+    fprintf(stderr, "f: +/-%.4f = +/-%.1f Hz\n", f_lp, f_lp*sr_base);
+
+    return iq_ring_init(st, nslot);
 }
 
-static float re_lowpass(float buffer[], ui32_t sample, ui32_t taps, float *ws) {
-    ui32_t n;
-    double w = 0;
-    for (n = 0; n < taps; n++) {
-        w += buffer[(sample+n+1)%taps]*ws[taps-1-n];
+// after the producer and all channels have stopped
+void stream_free(stream_t *st) {
+    rec_free(st);
+    iq_ring_free(&st->ring);
+    decimate_free(st);
+    pcm_io_free(&st->pcm);
+}
+
+
+/*
+ * FIR kernels, contiguous window x[0..n-1] (oldest first, mirrored delay line),
+ * time-reversed taps h[] (h[n-1] weights the oldest sample), float accumulation.
+ * SSE/AVX2/AVX-512 selected at runtime (fir_select()), -DNOSIMD: scalar only.
+ * Tolerance vs. double accumulation: |dy| < n * 2^-24 * sum|h[k]*x[k]|,
+ * for the IQ/FM lowpass filters (sum|h| ~ 1) about 1e-6 relative.
+ */
+static float rfir_c(const float *x, const float *h, int n) {
+    int k;
+    float y0 = 0, y1 = 0, y2 = 0, y3 = 0;
+    for (k = 0; k+4 <= n; k += 4) {
+        y0 += x[k  ]*h[k  ];
+        y1 += x[k+1]*h[k+1];
+        y2 += x[k+2]*h[k+2];
+        y3 += x[k+3]*h[k+3];
     }
-    return (float)w;
+    for ( ; k < n; k++) y0 += x[k]*h[k];
+    return (y0+y1)+(y2+y3);
 }
 
+static float complex cfir_c(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    int k;
+    float re0 = 0, im0 = 0, re1 = 0, im1 = 0;
+    for (k = 0; k+2 <= n; k += 2) {
+        re0 += x[2*k  ]*h[k];   im0 += x[2*k+1]*h[k];
+        re1 += x[2*k+2]*h[k+1]; im1 += x[2*k+3]*h[k+1];
+    }
+    for ( ; k < n; k++) { re0 += x[2*k]*h[k]; im0 += x[2*k+1]*h[k]; }
+    return (re0+re1) + (im0+im1)*I;
+}
 
-int f32buf_sample(dsp_t *dsp, int inv) {
-    float s = 0.0;
-    float xneu, xalt;
+#ifdef FIR_X86
+static float rfir_sse(const float *x, const float *h, int n) {
+    __m128 a = _mm_setzero_ps();
+    float s[4], y;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x+k), _mm_loadu_ps(h+k)));
+    }
+    _mm_storeu_ps(s, a);
+    y = (s[0]+s[1])+(s[2]+s[3]);
+    for ( ; k < n; k++) y += x[k]*h[k];
+    return y;
+}
 
-    float complex z, w, z0;
-    double gain = FM_GAIN;
+// (re,im) interleaved: taps h0 h1 h2 h3 -> h0 h0 h1 h1 | h2 h2 h3 h3
+static float complex cfir_sse(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+    __m128 h4;
+    float s[4], re, im;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        h4 = _mm_loadu_ps(h+k);
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x+2*k  ), _mm_unpacklo_ps(h4, h4)));
+        b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(x+2*k+4), _mm_unpackhi_ps(h4, h4)));
+    }
+    _mm_storeu_ps(s, _mm_add_ps(a, b));
+    re = s[0]+s[2];
+    im = s[1]+s[3];
+    for ( ; k < n; k++) { re += x[2*k]*h[k]; im += x[2*k+1]*h[k]; }
+    return re + im*I;
+}
 
-    double t = dsp->sample_in / (double)dsp->sr;
+__attribute__((target("avx2,fma")))
+static float rfir_avx2(const float *x, const float *h, int n) {
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+    __m128 c;
+    float s[4], y;
+    int k;
+    for (k = 0; k+16 <= n; k += 16) {
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+k  ), _mm256_loadu_ps(h+k  ), a);
+        b = _mm256_fmadd_ps(_mm256_loadu_ps(x+k+8), _mm256_loadu_ps(h+k+8), b);
+    }
+    for ( ; k+8 <= n; k += 8) {
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+k), _mm256_loadu_ps(h+k), a);
+    }
+    a = _mm256_add_ps(a, b);
+    c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(s, c);
+    y = (s[0]+s[1])+(s[2]+s[3]);
+    for ( ; k < n; k++) y += x[k]*h[k];
+    return y;
+}
 
-    if (dsp->opt_iq) {
+__attribute__((target("avx2,fma")))
+static float complex cfir_avx2(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+    __m256 h8;
+    __m128 c;
+    float s[4], re, im;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        h8 = _mm256_loadu_ps(h+k);
+        a = _mm256_fmadd_ps(_mm256_loadu_ps(x+2*k  ), _mm256_permutevar8x32_ps(h8, dup), a);
+        h8 = _mm256_permute2f128_ps(h8, h8, 0x01);
+        b = _mm256_fmadd_ps(_mm256_loadu_ps(x+2*k+8), _mm256_permutevar8x32_ps(h8, dup), b);
+    }
+    a = _mm256_add_ps(a, b);
+    c = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(s, c);
+    re = s[0]+s[2];
+    im = s[1]+s[3];
+    for ( ; k < n; k++) { re += x[2*k]*h[k]; im += x[2*k+1]*h[k]; }
+    return re + im*I;
+}
 
-        if (dsp->opt_iq == 5) {
-            ui32_t s_reset = dsp->dectaps*dsp->lut_len;
-            int j;
-            if ( f32read_cblock(dsp) < dsp->decM ) return EOF;
-            for (j = 0; j < dsp->decM; j++) {
-                dsp->decXbuffer[dsp->sample_dec % dsp->dectaps] = dsp->decMbuf[j] * dsp->ex[dsp->sample_dec % dsp->lut_len];
-                dsp->sample_dec += 1;
-                if (dsp->sample_dec == s_reset) dsp->sample_dec = 0;
-            }
-            z = lowpass(dsp->decXbuffer, dsp->sample_dec, dsp->dectaps, ws_dec);
-        }
-        else if ( f32read_csample(dsp, &z) == EOF ) return EOF;
+__attribute__((target("avx512f")))
+static float rfir_avx512(const float *x, const float *h, int n) {
+    __m512 a = _mm512_setzero_ps();
+    __mmask16 m;
+    int k;
+    for (k = 0; k+16 <= n; k += 16) {
+        a = _mm512_fmadd_ps(_mm512_loadu_ps(x+k), _mm512_loadu_ps(h+k), a);
+    }
+    if (k < n) {
+        m = (__mmask16)((1u << (n-k)) - 1);
+        a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x+k), _mm512_maskz_loadu_ps(m, h+k), a);
+    }
+    return _mm512_reduce_add_ps(a);
+}
 
-        z *= cexp(-t*2*M_PI*dsp->Df*I);
+__attribute__((target("avx512f")))
+static float complex cfir_avx512(const float complex *z, const float *h, int n) {
+    const float *x = (const float*)z;
+    const __m512i dup = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+    __m512 a = _mm512_setzero_ps();
+    __m512 h8;
+    __mmask16 m;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        h8 = _mm512_castps256_ps512(_mm256_loadu_ps(h+k));
+        a = _mm512_fmadd_ps(_mm512_loadu_ps(x+2*k), _mm512_permutexvar_ps(dup, h8), a);
+    }
+    if (k < n) {
+        m = (__mmask16)((1u << 2*(n-k)) - 1);
+        h8 = _mm512_maskz_loadu_ps((__mmask16)((1u << (n-k)) - 1), h+k);
+        a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x+2*k), _mm512_permutexvar_ps(dup, h8), a);
+    }
+    return _mm512_mask_reduce_add_ps(0x5555, a) + _mm512_mask_reduce_add_ps(0xAAAA, a)*I;
+}
+#endif
 
-        // IF-lowpass
-        if (dsp->opt_lp) {
-            dsp->lpIQ_buf[dsp->sample_in % dsp->lpIQtaps] = z;
-            z = lowpass(dsp->lpIQ_buf, dsp->sample_in, dsp->lpIQtaps, dsp->ws_lpIQ);
-        }
+/*
+ * FM discriminator: s[k] = gain * arg(z[k]*conj(z0[k])) / pi
+ * branch-free atan2: octant reduction, t = min/max in [0,1],
+ * atan(t)/pi = t*P(t^2), P minimax deg 5; |err| < 2e-6 rad
+ * (FM bit decision margin ~ h*pi/sps >> 1e-3 rad)
+ */
+#define ATP1  ((float)( 0.99997726/M_PI))
+#define ATP3  ((float)(-0.33262347/M_PI))
+#define ATP5  ((float)( 0.19354346/M_PI))
+#define ATP7  ((float)(-0.11643287/M_PI))
+#define ATP9  ((float)( 0.05265332/M_PI))
+#define ATP11 ((float)(-0.01172120/M_PI))
+
+static float atan2pi(float y, float x) {  // atan2(y,x)/pi
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = fmaxf(ax, ay), mn = fminf(ax, ay);
+    float t = mn / fmaxf(mx, 1e-30f);
+    float t2 = t*t;
+    float a = t*(ATP1+t2*(ATP3+t2*(ATP5+t2*(ATP7+t2*(ATP9+t2*ATP11)))));
+    a = (ay > ax) ? 0.5f-a : a;
+    a = (x < 0) ? 1.0f-a : a;
+    return copysignf(a, y);
+}
 
+static void fmdisc_c(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    int k;
+    for (k = 0; k < n; k++) {
+        float wr = x[2*k  ]*x0[2*k] + x[2*k+1]*x0[2*k+1];
+        float wi = x[2*k+1]*x0[2*k] - x[2*k  ]*x0[2*k+1];
+        s[k] = gain * atan2pi(wi, wr);
+    }
+}
 
-        z0 = dsp->rot_iqbuf[(dsp->sample_in-1 + dsp->N_IQBUF) % dsp->N_IQBUF];
-        w = z * conj(z0);
-        s = gain * carg(w)/M_PI;
+#ifdef FIR_X86
+static __m128 atan2pi_sse(__m128 y, __m128 x) {
+    const __m128 sgn = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sgn, x), ay = _mm_andnot_ps(sgn, y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    __m128 t = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(1e-30f)));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 a, m;
+    a = _mm_add_ps(_mm_set1_ps(ATP9), _mm_mul_ps(t2, _mm_set1_ps(ATP11)));
+    a = _mm_add_ps(_mm_set1_ps(ATP7), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP5), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP3), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP1), _mm_mul_ps(t2, a));
+    a = _mm_mul_ps(t, a);
+    m = _mm_cmpgt_ps(ay, ax);
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(0.5f), a)), _mm_andnot_ps(m, a));
+    m = _mm_cmplt_ps(x, _mm_setzero_ps());
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(1.0f), a)), _mm_andnot_ps(m, a));
+    return _mm_or_ps(a, _mm_and_ps(sgn, y));
+}
 
-        dsp->rot_iqbuf[dsp->sample_in % dsp->N_IQBUF] = z;
+static void fmdisc_sse(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m128 a, b, zr, zi, pr, pi, wr, wi;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        a = _mm_loadu_ps(x+2*k); b = _mm_loadu_ps(x+2*k+4);
+        zr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm_loadu_ps(x0+2*k); b = _mm_loadu_ps(x0+2*k+4);
+        pr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm_add_ps(_mm_mul_ps(zr, pr), _mm_mul_ps(zi, pi));
+        wi = _mm_sub_ps(_mm_mul_ps(zi, pr), _mm_mul_ps(zr, pi));
+        _mm_storeu_ps(s+k, _mm_mul_ps(_mm_set1_ps(gain), atan2pi_sse(wi, wr)));
+    }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
 
+__attribute__((target("avx2,fma")))
+static __m256 atan2pi_avx2(__m256 y, __m256 x) {
+    const __m256 sgn = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(sgn, x), ay = _mm256_andnot_ps(sgn, y);
+    __m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+    __m256 t = _mm256_div_ps(mn, _mm256_max_ps(mx, _mm256_set1_ps(1e-30f)));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 a;
+    a = _mm256_fmadd_ps(t2, _mm256_set1_ps(ATP11), _mm256_set1_ps(ATP9));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP7));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP5));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP3));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP1));
+    a = _mm256_mul_ps(t, a);
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(0.5f), a), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(1.0f), a), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+    return _mm256_or_ps(a, _mm256_and_ps(sgn, y));
+}
 
-        // FM-lowpass
-        if (dsp->opt_lp) {
-            dsp->lpFM_buf[dsp->sample_in % dsp->lpFMtaps] = s;
-            s = re_lowpass(dsp->lpFM_buf, dsp->sample_in, dsp->lpFMtaps, dsp->ws_lpFM);
-        }
+// shuffle_ps deinterleaves per 128-bit lane: sample order 0,1,4,5,2,3,6,7 -> permute4x64 back
+__attribute__((target("avx2,fma")))
+static void fmdisc_avx2(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m256 a, b, zr, zi, pr, pi, wr, wi, v;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        a = _mm256_loadu_ps(x+2*k); b = _mm256_loadu_ps(x+2*k+8);
+        zr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm256_loadu_ps(x0+2*k); b = _mm256_loadu_ps(x0+2*k+8);
+        pr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm256_fmadd_ps(zr, pr, _mm256_mul_ps(zi, pi));
+        wi = _mm256_fmsub_ps(zi, pr, _mm256_mul_ps(zr, pi));
+        v = _mm256_mul_ps(_mm256_set1_ps(gain), atan2pi_avx2(wi, wr));
+        v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0)));
+        _mm256_storeu_ps(s+k, v);
+    }
+    if (k+4 <= n) { fmdisc_sse(z+k, z0+k, s+k, n-k, gain); return; }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
+#endif
+
+// FIR/FM kernels
+void fir_select(dsp_t *dsp) {
+    dsp->rfir = rfir_c;
+    dsp->cfir = cfir_c;
+    dsp->fmdisc = fmdisc_c;
+#ifdef FIR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        dsp->rfir = rfir_avx512;
+        dsp->cfir = cfir_avx512;
+    }
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dsp->rfir = rfir_avx2;
+        dsp->cfir = cfir_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        dsp->rfir = rfir_sse;
+        dsp->cfir = cfir_sse;
+    }
+    // FM discriminator: no AVX-512 kernel, avx512f does not imply avx2/fma
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dsp->fmdisc = fmdisc_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        dsp->fmdisc = fmdisc_sse;
+    }
+#endif
+}
+
+// mirrored delay line buffer[0..2*taps-1]: x at sample%taps and sample%taps+taps,
+// the window buffer[sample%taps+1..] holds the last taps samples (newest last)
+float complex lowpass(dsp_t *dsp, float complex buffer[], ui32_t sample, ui32_t taps, float *ws, float complex x) {
+    ui32_t i = sample % taps;
+    buffer[i] = x;
+    buffer[i+taps] = x;
+    return dsp->cfir(buffer+i+1, ws, taps);
+}
 
-        dsp->fm_buffer[(dsp->sample_in - dsp->lpFMtaps/2 + dsp->M) % dsp->M] = s;
+static float re_lowpass(dsp_t *dsp, float buffer[], ui32_t sample, ui32_t taps, float *ws, float x) {
+    ui32_t i = sample % taps;
+    buffer[i] = x;
+    buffer[i+taps] = x;
+    return dsp->rfir(buffer+i+1, ws, taps);
+}
 
+/* ------------------------------------------------------------------------------------ */
 
-        if (dsp->opt_iq >= 2)
-        {
-            double xbit = 0.0;
-            //float complex xi = cexp(+I*M_PI*dsp->h/dsp->sps);
-            double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
-            double f2 = -f1;
+// NCO: recursive rotator z *= w (double), re-anchored every NCO_NORM samples
+// from the phase accumulator ph (cycles, mod 1), i.e. no amplitude/phase drift;
+// per sample 4 mul + 2 add, one cexp() per NCO_NORM samples
+#define NCO_NORM 1024
+
+static void nco_init(nco_t *nco, double f, double ph) {  // f: cycles/sample
+    nco->f = f;
+    nco->ph = ph - floor(ph);
+    nco->cnt = 0;
+    nco->z = cexp(2*M_PI*nco->ph*I);
+    nco->w = cexp(2*M_PI*f*I);
+}
 
-            float complex X0 = 0;
-            float complex X  = 0;
+// phase-continuous frequency update
+static void nco_freq(nco_t *nco, double f) {
+    nco->ph += nco->cnt * nco->f;
+    nco->ph -= floor(nco->ph);
+    nco->cnt = 0;
+    nco->f = f;
+    nco->w = cexp(2*M_PI*f*I);
+}
 
-            int n = dsp->sps;
-            double tn = (dsp->sample_in-n) / (double)dsp->sr;
-            //t = dsp->sample_in / (double)dsp->sr;
-            //z = dsp->rot_iqbuf[dsp->sample_in % dsp->N_IQBUF];
-            z0 = dsp->rot_iqbuf[(dsp->sample_in-n + dsp->N_IQBUF) % dsp->N_IQBUF];
+static float complex nco_step(nco_t *nco) {
+    double re = creal(nco->z), im = cimag(nco->z);
+    double wr = creal(nco->w), wi = cimag(nco->w);
 
-            // f1
-            X0 = z0 * cexp(-tn*2*M_PI*f1*I); // alt
-            X  = z  * cexp(-t *2*M_PI*f1*I); // neu
-            dsp->F1sum +=  X - X0;
+    nco->cnt += 1;
+    if (nco->cnt == NCO_NORM) {
+        nco->ph += NCO_NORM * nco->f;
+        nco->ph -= floor(nco->ph);
+        nco->cnt = 0;
+        nco->z = cexp(2*M_PI*nco->ph*I);
+    }
+    else {
+        nco->z = (re*wr - im*wi) + (re*wi + im*wr)*I;
+    }
+    return (float)re + (float)im*I;
+}
 
-            // f2
-            X0 = z0 * cexp(-tn*2*M_PI*f2*I); // alt
-            X  = z  * cexp(-t *2*M_PI*f2*I); // neu
-            dsp->F2sum +=  X - X0;
 
-            xbit = cabs(dsp->F2sum) - cabs(dsp->F1sum);
+// pfb: 2 channel samples (decMbuf) -> residual shift -> 2:1 FIR -> one IF sample
+static float complex pfb_dec(dsp_t *dsp) {
+    const pfb_t *pfb = &dsp->thd.st->pfb;
+    float complex *w;
 
-            s = xbit / dsp->sps;
-        }
-        else if (0 && dsp->opt_iq >= 4)
-        {
-            double xbit = 0.0;
-            //float complex xi = cexp(+I*M_PI*dsp->h/dsp->sps);
-            double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
-            double f2 = -f1;
-
-            float complex X1 = 0;
-            float complex X2 = 0;
-
-            int n = dsp->sps;
-
-            while (n > 0) {
-                n--;
-                t = -n / (double)dsp->sr;
-                z = dsp->rot_iqbuf[(dsp->sample_in - n + dsp->N_IQBUF) % dsp->N_IQBUF];  // +1
-                X1 += z*cexp(-t*2*M_PI*f1*I);
-                X2 += z*cexp(-t*2*M_PI*f2*I);
-            }
+    dline_push(dsp->dst.fbuf, &dsp->dst.fpos, pfb->ptaps, c_mul(dsp->decMbuf[0], nco_step(&dsp->nco_pfb)));
+    w = dline_push(dsp->dst.fbuf, &dsp->dst.fpos, pfb->ptaps, c_mul(dsp->decMbuf[1], nco_step(&dsp->nco_pfb)));
+    return dsp->cfir(w, pfb->ws_p, pfb->ptaps);
+}
 
-            xbit = cabs(X2) - cabs(X1);
+// decMbuf -> one IF sample
+float complex decimate(dsp_t *dsp) {
+    const stream_t *st = dsp->thd.st;
+    ui32_t s_reset = dsp->dectaps*dsp->lut_len;
+    ui32_t i;
+    int j;
+
+    if (st->pfb.M) return pfb_dec(dsp);
+    if (st->dec.R) return decim_block(dsp);
+
+    for (j = 0; j < dsp->decM; j++) {
+        i = dsp->sample_dec % dsp->dectaps;
+        dsp->decXbuffer[i] = c_mul(dsp->decMbuf[j], dsp->ex[dsp->sample_dec % dsp->lut_len]);
+        dsp->decXbuffer[i+dsp->dectaps] = dsp->decXbuffer[i];
+        dsp->sample_dec += 1;
+        if (dsp->sample_dec == s_reset) dsp->sample_dec = 0;
+    }
+    // window from (sample_dec+1)%dectaps, as before
+    return dsp->cfir(dsp->decXbuffer + (dsp->sample_dec+1)%dsp->dectaps, st->ws_dec, dsp->dectaps);
+}
 
-            s = xbit / dsp->sps;
+// squelch: mean |z|^2 per block (decimated IQ), averaged
+//   noise floor: follows the minimum, slowly up (not from blocks above the open level)
+//   open > SQ_ON*nf, close < SQ_OFF*nf for SQ_HOLD sec without header
+//   closed: mix/decimate only every SQ_DUTY-th block, power from the 2nd half (filters settled)
+#define SQ_ON    2.0    // +3dB
+#define SQ_OFF   1.26   // +1dB
+#define SQ_HOLD  2      // sec
+#define SQ_AVG   8      // blocks
+#define SQ_NF    1024   // blocks
+#define SQ_DUTY  8
+
+static int sq_level(dsp_t *dsp, float complex *z, int m) {
+    ui32_t hold = SQ_HOLD*dsp->sr;
+    double p = 0.0;
+    int k, k0 = dsp->sq_open ? 0 : m/2;
+
+    for (k = k0; k < m; k++) p += c_abs2(z[k]);
+    p /= m - k0;
+
+    if (dsp->sq_nf <= 0.0) dsp->sq_p = dsp->sq_nf = p;
+    dsp->sq_p += (p - dsp->sq_p)/(dsp->sq_open ? SQ_AVG : 2); // closed: every SQ_DUTY blocks
+    p = dsp->sq_p;
+
+    if (p < dsp->sq_nf) dsp->sq_nf = p;
+    else if (p < SQ_ON*dsp->sq_nf) dsp->sq_nf += (p - dsp->sq_nf)/SQ_NF;
+
+    if (dsp->sq_open) {
+        if (p > SQ_OFF*dsp->sq_nf) dsp->sq_last = dsp->sample_in;
+        else if (dsp->sample_in - dsp->sq_last > hold && dsp->sample_in - dsp->sq_hdr > hold) {
+            // closed: only sample_in advances, cleared buffers stay consistent
+            dsp->sq_open = 0;
+            memset(dsp->bufs, 0, dsp->M*sizeof(float));
+            memset(dsp->xs, 0, dsp->M*sizeof(float));
+            memset(dsp->qs, 0, dsp->M*sizeof(float));
+            memset(dsp->fm_buffer, 0, dsp->M*sizeof(float));
+            memset(dsp->rot_iqbuf, 0, dsp->N_IQBUF*sizeof(float complex));
+            dsp->xsum = dsp->qsum = 0;
+            dsp->F1sum = dsp->F2sum = 0;
         }
     }
-    else {
-        if (f32read_sample(dsp, &s) == EOF) return EOF;
+    else if (p > SQ_ON*dsp->sq_nf) {
+        dsp->sq_open = 1;
+        dsp->sq_last = dsp->sample_in;
     }
 
-    if (inv) s = -s;
-    dsp->bufs[dsp->sample_in % dsp->M] = s;
+    return dsp->sq_open;
+}
 
-    xneu = dsp->bufs[(dsp->sample_in  ) % dsp->M];
-    xalt = dsp->bufs[(dsp->sample_in+dsp->M - dsp->Nvar) % dsp->M];
-    dsp->xsum +=  xneu - xalt;                 // + xneu - xalt
-    dsp->qsum += (xneu - xalt)*(xneu + xalt);  // + xneu*xneu - xalt*xalt
-    dsp->xs[dsp->sample_in % dsp->M] = dsp->xsum;
-    dsp->qs[dsp->sample_in % dsp->M] = dsp->qsum;
+/*
+ * block pipeline: n samples, stage by stage on contiguous arrays (DSP_BLK per pass)
+ *   read/dc -> [mix/decimate] -> [squelch] -> Df-NCO -> IF-lowpass -> FM -> FM-lowpass -> [F1/F2] -> bufs/xs/qs
+ * Df, ws_lpIQ are only changed in find_header(), between blocks.
+ * returns number of samples, < n: EOF
+ */
+int f32buf_block(dsp_t *dsp, int n, int inv) {
+    float complex *z = dsp->blk_z+1;  // blk_z[0]: previous IF sample (FM)
+    float *s = dsp->blk_s;
+    float xneu, xalt;
+    float gain = FM_GAIN;
+    ui32_t si;
+    int cnt = 0;
+    int m, l, k;
+    int skip;
+
+    while (cnt < n) {
+        l = n - cnt; if (l > DSP_BLK) l = DSP_BLK;
+        si = dsp->sample_in;
+
+        if (dsp->opt_iq) {
+
+            skip = dsp->opt_sq && !dsp->sq_open && dsp->opt_iq == 5 && ++dsp->sq_blk % SQ_DUTY;
+
+            if (skip) m = f32read_skip(dsp, l);
+            else if (dsp->opt_iq == 5) {
+                m = dsp->det_z ? f32read_det(dsp, z, l) : 0;  // --auto: detector samples first
+                for ( ; m < l; m++) {
+                    if ( f32read_cblock(dsp) < dsp->decM ) break;
+                    z[m] = decimate(dsp);
+                }
+            }
+            else m = f32read_cblock_n(dsp, z, l);
+            if (m <= 0) break;
+
+            if (dsp->opt_sq && (skip || sq_level(dsp, z, m) == 0)) {
+                // squelch closed: buffers are zero, header search is off
+                dsp->sample_in += m;
+                dsp->sample_out = dsp->sample_in-1 - dsp->delay;
+                cnt += m;
+                if (m < l) break;
+                continue;
+            }
 
+            for (k = 0; k < m; k++) z[k] = c_mul(z[k], nco_step(&dsp->nco_Df)); // exp(-t*2*M_PI*dsp->Df*I)
 
-    dsp->sample_out = dsp->sample_in - dsp->delay;
+            // IF-lowpass
+            if (dsp->opt_lp) {
+                for (k = 0; k < m; k++) z[k] = lowpass(dsp, dsp->lpIQ_buf, si+k, dsp->lpIQtaps, dsp->ws_lpIQ, z[k]);
+            }
 
-    dsp->sample_in += 1;
+            dsp->blk_z[0] = dsp->rot_iqbuf[(si-1 + dsp->N_IQBUF) % dsp->N_IQBUF];
+            dsp->fmdisc(z, dsp->blk_z, s, m, gain); // s = gain * carg(z*conj(z0))/M_PI
 
-    return 0;
+            // FM-lowpass
+            if (dsp->opt_lp) {
+                for (k = 0; k < m; k++) s[k] = re_lowpass(dsp, dsp->lpFM_buf, si+k, dsp->lpFMtaps, dsp->ws_lpFM, s[k]);
+            }
+
+            for (k = 0; k < m; k++) dsp->fm_buffer[(si+k - dsp->lpFMtaps/2 + dsp->M) % dsp->M] = s[k];
+
+            if (dsp->opt_iq >= 2)
+            {
+                // f1 = -dsp->h*dsp->sr/(2*dsp->sps), f2 = -f1:
+                //   e1 = exp(-t*2*M_PI*f1*I), e2 = conj(e1)
+                //   exp(-tn*2*M_PI*f1*I) = e1 * F1c, tn = t - sps/sr
+                int d = dsp->sps;
+                for (k = 0; k < m; k++) {
+                    float complex e1 = nco_step(&dsp->nco_F1);
+                    float complex z0;
+                    double xbit;
+
+                    dsp->rot_iqbuf[(si+k) % dsp->N_IQBUF] = z[k];
+                    z0 = dsp->rot_iqbuf[(si+k-d + dsp->N_IQBUF) % dsp->N_IQBUF];
+
+                    dsp->F1sum = c_mac(dsp->F1sum, z[k] - c_mul(z0, dsp->F1c), e1);               // f1: X - X0
+                    dsp->F2sum = c_mac(dsp->F2sum, z[k] - c_mulconj(z0, dsp->F1c), conjf(e1));    // f2
+
+                    xbit = sqrtf(c_abs2(dsp->F2sum)) - sqrtf(c_abs2(dsp->F1sum));
+                    s[k] = xbit / dsp->sps;
+                }
+            }
+            else {
+                for (k = 0; k < m; k++) dsp->rot_iqbuf[(si+k) % dsp->N_IQBUF] = z[k];
+            }
+        }
+        else {
+            m = f32read_block(dsp, s, l);
+            if (m <= 0) break;
+        }
+
+        for (k = 0; k < m; k++) {
+            if (inv) s[k] = -s[k];
+            dsp->bufs[dsp->sample_in % dsp->M] = s[k];
+
+            xneu = dsp->bufs[(dsp->sample_in  ) % dsp->M];
+            xalt = dsp->bufs[(dsp->sample_in+dsp->M - dsp->Nvar) % dsp->M];
+            dsp->xsum +=  xneu - xalt;                 // + xneu - xalt
+            dsp->qsum += (xneu - xalt)*(xneu + xalt);  // + xneu*xneu - xalt*xalt
+            dsp->xs[dsp->sample_in % dsp->M] = dsp->xsum;
+            dsp->qs[dsp->sample_in % dsp->M] = dsp->qsum;
+
+            dsp->sample_out = dsp->sample_in - dsp->delay;
+
+            dsp->sample_in += 1;
+        }
+
+        cnt += m;
+        if (m < l) break;
+    }
+
+    return cnt;
+}
+
+int f32buf_sample(dsp_t *dsp, int inv) {
+    return f32buf_block(dsp, 1, inv) == 1 ? 0 : EOF;
 }
 
 static int read_bufbit(dsp_t *dsp, int symlen, char *bits, ui32_t mvp, int pos) {
@@ -805,6 +1681,13 @@ static int headcmp(dsp_t *dsp, int opt_dc) {
 
 /* -------------------------------------------------------------------------- */
 
+// samples up to bit boundary bg in one block, consumed via dsp->buffered
+static void f32buf_fill(dsp_t *dsp, double bg, int inv) {
+    int n = 1;
+    if (dsp->sc < bg) n = ceil(bg - dsp->sc);
+    if (n > dsp->buffered) dsp->buffered += f32buf_block(dsp, n - dsp->buffered, inv);
+}
+
 int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spike) {
 // symlen==2: manchester2 10->0,01->1: 2.bit
 
@@ -831,6 +1714,7 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
     if (dsp->symlen == 2) {
         mid = bg + (dsp->sps-1)/2.0;
         bg += dsp->sps;
+        f32buf_fill(dsp, bg, inv);
         do {
             if (dsp->buffered > 0) dsp->buffered -= 1;
             else if (f32buf_sample(dsp, inv) == EOF) return EOF;
@@ -851,6 +1735,7 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
 
     mid = bg + (dsp->sps-1)/2.0;
     bg += dsp->sps;
+    f32buf_fill(dsp, bg, inv);
     do {
         if (dsp->buffered > 0) dsp->buffered -= 1;
         else if (f32buf_sample(dsp, inv) == EOF) return EOF;
@@ -888,12 +1773,12 @@ int read_slbit(dsp_t *dsp, int *bit, int inv, int ofs, int pos, float l, int spi
 static double Q(double x) {
     return 0.5 - 0.5*erf(x/SQRT2);
 }
-static double pulse(double t, double sigma) {
+double pulse(double t, double sigma) {
     return Q((t-0.5)/sigma) - Q((t+0.5)/sigma);
 }
 
 
-static double norm2_vect(float *vect, int n) {
+double norm2_vect(float *vect, int n) {
     int i;
     double x, y = 0.0;
     for (i = 0; i < n; i++) {
@@ -903,25 +1788,30 @@ static double norm2_vect(float *vect, int n) {
     return y;
 }
 
-int init_buffers(dsp_t *dsp) {
-
-    int i, pos;
-    float b0, b1, b2, b, t;
-    float normMatch;
-    double sigma = sqrt(log(2)) / (2*M_PI*dsp->BT);
-
-    int p2 = 1;
-    int K, L, M;
+// mixer/decimator of the channel (opt_iq == 5), design: stream_init()
+int decim_init(dsp_t *dsp) {
+    float t;
     int n, k;
-    float *m = NULL;
-
 
-    if (dsp->opt_iq == 5)
+    if (dsp->thd.st->pfb.M)
     {
-        //
-        // pcm_dec_init()
-        //
+        // channel k: k/M nearest fq = -xlt_fq, residual at channel rate (D:1)
+        const pfb_t *pfb = &dsp->thd.st->pfb;
+        double fq = -dsp->thd.xlt_fq;
+        k = (int)floor(fq*pfb->M + 0.5);
+        nco_init(&dsp->nco_pfb, (k/(double)pfb->M - fq)*pfb->D, 0.0);
+        dsp->pfb_ch = (k + pfb->M) % pfb->M;
+        dsp->decM = 2;
+
+        memset(&dsp->dst, 0, sizeof(dsp->dst));
+        dsp->dst.fbuf = calloc(2*pfb->ptaps+1, sizeof(float complex));
+        if (dsp->dst.fbuf == NULL) return -1;
 
+        dsp->decMbuf = calloc( dsp->decM+1, sizeof(float complex));
+        if (dsp->decMbuf == NULL) return -1;
+    }
+    else
+    {
         // lookup table, exp-rotation
         int W = 2*8; // 16 Hz window
         int d = 1; // 1..W , groesster Teiler d <= W von sr_base
@@ -956,13 +1846,50 @@ int init_buffers(dsp_t *dsp) {
         }
 
 
-        dsp->decXbuffer = calloc( dsp->dectaps+1, sizeof(float complex));
-        if (dsp->decXbuffer == NULL) return -1;
+        if (dsp->thd.st->dec.R) {
+            if (decim_stages_init(dsp) < 0) return -1;
+        }
+        else {
+            dsp->decXbuffer = calloc( 2*dsp->dectaps+1, sizeof(float complex));
+            if (dsp->decXbuffer == NULL) return -1;
+        }
 
         dsp->decMbuf = calloc( dsp->decM+1, sizeof(float complex));
         if (dsp->decMbuf == NULL) return -1;
     }
 
+    return 0;
+}
+
+void decim_free(dsp_t *dsp) {
+    if (dsp->decXbuffer) { free(dsp->decXbuffer); dsp->decXbuffer = NULL; }
+    decim_stages_free(dsp);
+    if (dsp->decMbuf)    { free(dsp->decMbuf);    dsp->decMbuf    = NULL; }
+    if (dsp->ex)         { free(dsp->ex);         dsp->ex         = NULL; }
+}
+
+int init_buffers(dsp_t *dsp) {
+
+    int i, pos;
+    float b0, b1, b2, b, t;
+    float normMatch;
+    double sigma = sqrt(log(2)) / (2*M_PI*dsp->BT);
+
+    int p2 = 1;
+    int K, L, M;
+    int k;
+    float *m = NULL;
+
+
+    fir_select(dsp);
+
+    if (dsp->opt_iq == 5)
+    {
+        if (dsp->thd.det) k = det_handoff(dsp);
+        else k = decim_init(dsp);
+        if (k < 0) return -1;
+    }
+
     if (dsp->opt_iq && dsp->opt_lp)
     {
         float f_lp; // lowpass_bw
@@ -977,7 +1904,7 @@ int init_buffers(dsp_t *dsp) {
 
         dsp->lpIQ_fbw = f_lp;
         dsp->lpIQtaps = taps;
-        dsp->lpIQ_buf = calloc( dsp->lpIQtaps+3, sizeof(float complex));
+        dsp->lpIQ_buf = calloc( 2*dsp->lpIQtaps+3, sizeof(float complex));
         if (dsp->lpIQ_buf == NULL) return -1;
 
         dsp->ws_lpIQ = dsp->ws_lpIQ1;
@@ -999,7 +1926,7 @@ int init_buffers(dsp_t *dsp) {
         taps = lowpass_init(f_lp, taps, &dsp->ws_lpFM); if (taps < 0) return -1;
 
         dsp->lpFMtaps = taps;
-        dsp->lpFM_buf = calloc( dsp->lpFMtaps+3, sizeof(float complex));
+        dsp->lpFM_buf = calloc( 2*dsp->lpFMtaps+3, sizeof(float));
         if (dsp->lpFM_buf == NULL) return -1;
     }
 
@@ -1011,6 +1938,18 @@ int init_buffers(dsp_t *dsp) {
     dsp->delay = L/16;
     dsp->sample_in = 0;
 
+    nco_init(&dsp->nco_Df, -dsp->Df/(double)dsp->sr, 0.0);
+
+    dsp->sq_open = 1;
+    dsp->sq_nf = 0.0;
+
+    if (dsp->opt_iq >= 2) {
+        double f1 = -dsp->h*dsp->sr/(2*dsp->sps);
+        int n = dsp->sps;
+        nco_init(&dsp->nco_F1, -f1/(double)dsp->sr, 0.0);
+        dsp->F1c = cexp(2*M_PI*f1*n/(double)dsp->sr*I);
+    }
+
     p2 = 1;
     while (p2 < M) p2 <<= 1;
     while (p2 < 0x2000) p2 <<= 1;  // or 0x4000, if sample not too short
@@ -1075,7 +2014,9 @@ int init_buffers(dsp_t *dsp) {
     dsp->DFT.Z  = calloc(dsp->DFT.N+1, sizeof(float complex));  if (dsp->DFT.Z  == NULL) return -1;
     dsp->DFT.cx = calloc(dsp->DFT.N+1, sizeof(float complex));  if (dsp->DFT.cx == NULL) return -1;
 
-    dsp->DFT.ew = calloc(dsp->DFT.LOG2N+1, sizeof(float complex));  if (dsp->DFT.ew == NULL) return -1;
+    dsp->DFT.yn = calloc(dsp->DFT.N+1, sizeof(float));  if (dsp->DFT.yn == NULL) return -1;
+
+    if (dft_init(&dsp->DFT) < 0) return -1;
 
     // FFT window
     // a) N2 = N
@@ -1085,11 +2026,6 @@ int init_buffers(dsp_t *dsp) {
     //dsp->DFT.N2 = dsp->DFT.N/2 - 1; // N=2^log2N
     dft_window(&dsp->DFT, 1);
 
-    for (n = 0; n < dsp->DFT.LOG2N; n++) {
-        k = 1 << n;
-        dsp->DFT.ew[n] = cexp(-I*M_PI/(float)k);
-    }
-
     m = calloc(dsp->DFT.N+1, sizeof(float));  if (m  == NULL) return -1;
     for (i = 0; i < L; i++) m[L-1 - i] = dsp->match[i]; // t = L-1
     while (i < dsp->DFT.N) m[i++] = 0.0;
@@ -1108,12 +2044,24 @@ int init_buffers(dsp_t *dsp) {
 
     dsp->fm_buffer = (float *)calloc( M+1, sizeof(float));  if (dsp->fm_buffer == NULL) return -1; // dsp->bufs[]
 
+    dsp->blk_z = calloc(DSP_BLK+1, sizeof(float complex));  if (dsp->blk_z == NULL) return -1;
+    dsp->blk_s = calloc(DSP_BLK+1, sizeof(float));  if (dsp->blk_s == NULL) return -1;
+    if (dsp->sio == NULL) return -1; // pcm_io_init()
+
+    if (out_open(&dsp->thd) < 0) return -1;
 
     return K;
 }
 
 int free_buffers(dsp_t *dsp) {
 
+    if (dsp->thd.lost) fprintf(stderr, "<%d> ring: blocks dropped: %llu\n", dsp->thd.tn, (unsigned long long)dsp->thd.lost);
+    if (dsp->thd.cur) { // detach
+        atomic_store_explicit(&dsp->thd.cur->seq, IQR_OFF, memory_order_release);
+        dsp->thd.cur = NULL;
+    }
+    out_close(&dsp->thd);
+
     if (dsp->match) { free(dsp->match); dsp->match = NULL; }
     if (dsp->bufs)  { free(dsp->bufs);  dsp->bufs  = NULL; }
     if (dsp->xs)  { free(dsp->xs);  dsp->xs  = NULL; }
@@ -1121,7 +2069,7 @@ int free_buffers(dsp_t *dsp) {
     if (dsp->rawbits) { free(dsp->rawbits); dsp->rawbits = NULL; }
 
     if (dsp->DFT.xn) { free(dsp->DFT.xn); dsp->DFT.xn = NULL; }
-    if (dsp->DFT.ew) { free(dsp->DFT.ew); dsp->DFT.ew = NULL; }
+    if (dsp->DFT.yn) { free(dsp->DFT.yn); dsp->DFT.yn = NULL; }
     if (dsp->DFT.Fm) { free(dsp->DFT.Fm); dsp->DFT.Fm = NULL; }
     if (dsp->DFT.X)  { free(dsp->DFT.X);  dsp->DFT.X  = NULL; }
     if (dsp->DFT.Z)  { free(dsp->DFT.Z);  dsp->DFT.Z  = NULL; }
@@ -1129,6 +2077,8 @@ int free_buffers(dsp_t *dsp) {
 
     if (dsp->DFT.win) { free(dsp->DFT.win); dsp->DFT.win = NULL; }
 
+    dft_free(&dsp->DFT);
+
     if (dsp->opt_iq)
     {
         if (dsp->rot_iqbuf) { free(dsp->rot_iqbuf); dsp->rot_iqbuf = NULL; }
@@ -1138,11 +2088,10 @@ int free_buffers(dsp_t *dsp) {
     // decimate
     if (dsp->opt_iq == 5)
     {
-        if (dsp->decXbuffer) { free(dsp->decXbuffer); dsp->decXbuffer = NULL; }
-        if (dsp->decMbuf)    { free(dsp->decMbuf);    dsp->decMbuf    = NULL; }
-        if (dsp->ex)         { free(dsp->ex);         dsp->ex         = NULL; }
+        decim_free(dsp);
+        if (dsp->det_z) { free(dsp->det_z); dsp->det_z = NULL; }
 
-        // free(ws_dec) -> decimate_free()
+        // stream: st->ws_dec -> stream_free()
     }
 
     // IF lowpass
@@ -1157,12 +2106,25 @@ int free_buffers(dsp_t *dsp) {
     }
 
     if (dsp->fm_buffer) { free(dsp->fm_buffer); dsp->fm_buffer = NULL; }
+    if (dsp->blk_z) { free(dsp->blk_z); dsp->blk_z = NULL; }
+    if (dsp->blk_s) { free(dsp->blk_s); dsp->blk_s = NULL; }
 
     return 0;
 }
 
 /* ------------------------------------------------------------------------------------ */
 
+// correlator flops since last frame
+static void corr_ops(dsp_t *dsp) {
+    fprintf(stderr, "corr: %.1f kFLOP/frame (complex FFT: %.1f kFLOP, saved: %.1f kFLOP = %.0f%%)\n",
+                    dsp->ops_cor*1e-3, dsp->ops_ref*1e-3, (dsp->ops_ref-dsp->ops_cor)*1e-3,
+                    dsp->ops_ref > 0 ? 100.0*(dsp->ops_ref-dsp->ops_cor)/dsp->ops_ref : 0.0);
+    dsp->ops_cor = 0.0;
+    dsp->ops_ref = 0.0;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
 ui32_t get_sample(dsp_t *dsp) {
     return dsp->sample_out;
 }
@@ -1176,13 +2138,23 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
     int mp;
     int header_found = 0;
     int herrs;
+    int n, m;
+
+    while ( 1 ) {
 
-    while ( f32buf_sample(dsp, 0) != EOF ) {
+        // block up to the next correlation
+        n = dsp->K-4 - k; if (n < 1) n = 1;
+        m = f32buf_block(dsp, n, 0);
+        k += m;
+        if (m < n) {
+            if (m > 0) dsp->mv = 0.0;
+            break; // EOF
+        }
 
-        k += 1;
         if (k >= dsp->K-4) {
             mvpos0 = dsp->mv_pos;
-            mp = getCorrDFT(dsp); // correlation score -> dsp->mv
+            if (dsp->opt_sq && !dsp->sq_open) dsp->mv = 0.0; // squelch
+            else mp = getCorrDFT(dsp); // correlation score -> dsp->mv
             //if (option_auto == 0 && dsp->mv < 0) mv = 0;
             k = 0;
         }
@@ -1214,6 +2186,7 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
                         }
                     }
                 }
+                nco_freq(&dsp->nco_Df, -dsp->Df/(double)dsp->sr);
             }
 
             if (dsp->mv_pos > mvpos0) {
@@ -1222,7 +2195,12 @@ int find_header(dsp_t *dsp, float thres, int hdmax, int bitofs, int opt_dc) {
                 herrs = headcmp(dsp, opt_dc);
                 if (herrs <= hdmax) header_found = 1; // max bitfehler in header
 
-                if (header_found) return 1;
+                if (header_found) {
+                    dsp->sq_hdr = dsp->sample_in;
+                    rec_trigger(dsp, REC_HDR);
+                    if (dsp->opt_ops) corr_ops(dsp);
+                    return 1;
+                }
             }
         }
 
@@ -5,6 +5,7 @@
 #include <math.h>
 #include <complex.h>
 #include <pthread.h>
+#include <stdatomic.h>
 
 typedef unsigned char  ui8_t;
 typedef unsigned short ui16_t;
@@ -12,37 +13,143 @@ typedef unsigned int   ui32_t;
 typedef char  i8_t;
 typedef short i16_t;
 typedef int   i32_t;
-
-
-#define MAX_FQ 5
-static int blk_sz = 32; // const
-
+typedef unsigned long long ui64_t;
+typedef long long i64_t;
+
+
+#define IQR_BLK    256      // ring block: IQR_BLK IF samples (IQR_BLK*decM input samples)
+#define IQR_SLOTS  64       // ring blocks (default): max. lag of a consumer
+#define IQR_OFF    (~0ULL)  // consumer cursor: detached, the producer does not wait for it
+
+// consumer cursor; list, nodes are reused after iq_ring_release() (no limit on consumers).
+// Detached (seq IQR_OFF) is not released: the owner (channel, scanner) keeps the cursor
+// until it is joined, so a finished consumer's cursor is never handed to a new one.
+typedef struct iqr_cur_s {
+    _Atomic ui64_t seq;  // blocks released by this consumer
+    _Atomic int stop;    // remove: consumer reads EOF
+    _Atomic int own;     // attached, not yet released
+    struct iqr_cur_s *next;
+    char pad[64-2*sizeof(ui64_t)-sizeof(void*)];
+} iqr_cur_t;
+
+// single producer, multi consumer broadcast ring of IQ blocks (dc removed);
+// the producer waits if the slowest consumer lags nslot blocks, i.e. one slow decoder
+// throttles the input for all (file input: no loss); drop=1: the producer only waits for
+// the fastest consumer, a consumer nslot blocks behind loses blocks (live input)
+typedef struct iqring_s {
+    float complex *buf;  // nslot*blen
+    int *len;            // samples in slot
+    int *rawlen;         // pfb: input samples of the slot's block (last block: < blen)
+    int nslot;
+    int blen;
+    iqr_cur_t *_Atomic cur;  // consumer list
+    int keep;            // run without consumers (channels added at runtime)
+    int drop;            // --lag-drop: do not wait for lagging consumers
+    _Atomic ui64_t wseq; // blocks published
+    _Atomic int eof;
+    pthread_t tid;
+    ui64_t pwait;        // producer: ring full
+    int ssz;             // slot size: blen, or M*chlen (pfb)
+    int chlen;           // pfb: samples per channel in slot (0: raw IQ)
+    float complex *raw;  // pfb: input block
+    int rawofs;          // pfb + scanner: input block in the slot at rawofs (0: raw)
+} iqring_t;
+
+typedef struct {  // thread CPU usage (getrusage RUSAGE_THREAD)
+    double utime;   // s
+    double stime;
+    long nivcsw;    // involuntary context switches
+    long nvcsw;
+    int cpu;        // pinned (-1: any)
+} thd_use_t;
+
+typedef struct task_s task_t;  // decoder task, pool_run()
+typedef struct stream_s stream_t;  // input stream, stream_init()
+typedef struct det_s det_t;        // --auto: type detector, detect_init()
+typedef struct rec_s rec_t;        // --rec: pre-trigger IQ recorder, rec_init()
 
 typedef struct {
     int tn;
-    int tn_bit;
-    pthread_t tid;
-    pthread_mutex_t *mutex;
-    pthread_cond_t *cond;
-    //pthread_rwlock_t *lock;
-    int max_fq;
+    task_t *task;    // worker pool task (NULL: own thread)
+    FILE *out;       // output, out_frame() -> writer thread
+    char *obuf;
+    size_t olen;
     double xlt_fq;
-    float complex *blk;
+    stream_t *st;    // input: ring, decimator design
+    det_t *det;      // --auto: detector, taken over by the decoder (init_buffers)
+    iqr_cur_t *cur;  // ring: cursor, iq_ring_attach()
+    ui64_t rseq;  // ring: next block
+    int rpos;     // ring: position in block
+    ui64_t lost;  // ring: blocks dropped (--lag-drop)
 } thd_t;
 
 
+#define DEC_CIC_N   4  // CIC order
+#define DEC_HB_MAX  8  // max half-band stages
+#define PFB_MAXF   16  // pfb: max FFT stages
+
+#define DSP_BLK  256  // f32buf_block(): samples per stage pass
+
+// complex arithmetic on split re/im (limited range):
+// no C99 Annex G inf/nan recovery (__mulsc3/__muldc3), always inlined,
+// independent of -fcx-limited-range/-ffast-math
+static inline float complex c_cf(float re, float im) {
+    float complex z;
+    ((float *)&z)[0] = re;
+    ((float *)&z)[1] = im;
+    return z;
+}
+static inline float complex c_mul(float complex a, float complex b) {  // a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br - ai*bi, ar*bi + ai*br);
+}
+static inline float complex c_mulconj(float complex a, float complex b) {  // a*conj(b)
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br + ai*bi, ai*br - ar*bi);
+}
+static inline float complex c_mac(float complex acc, float complex a, float complex b) {  // acc + a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(crealf(acc) + (ar*br - ai*bi), cimagf(acc) + (ar*bi + ai*br));
+}
+static inline float c_abs2(float complex a) {  // |a|^2
+    return crealf(a)*crealf(a) + cimagf(a)*cimagf(a);
+}
+
+typedef struct {  // numerically controlled oscillator
+    double complex z;
+    double complex w;
+    double f;   // cycles/sample
+    double ph;  // phase (cycles) at cnt=0
+    int cnt;
+} nco_t;
+
+typedef struct {  // multistage decimation state
+    ui64_t ig[2][DEC_CIC_N];  // CIC integrators (re, im)
+    ui64_t cb[2][DEC_CIC_N];  // CIC combs
+    int cnt;
+    float complex *hbbuf[DEC_HB_MAX];
+    int hbpos[DEC_HB_MAX];
+    int hbph[DEC_HB_MAX];
+    float complex *fbuf;
+    int fpos;
+} decst_t;
+
 typedef struct {
     int sr;       // sample_rate
     int LOG2N;
     int N;
     int N2;
     float *xn;
-    float complex  *ew;
+    float *yn;
     float complex  *Fm;
     float complex  *X;
     float complex  *Z;
     float complex  *cx;
     float complex  *win; // float real
+    // FFT plan
+    float complex  *tw;  // twiddles exp(-2pi*I*k/N), k < N/2
+    int *brv;            // bit-reversal N/2
+    int *brvN;           // bit-reversal N
 } dft_t;
 
 
@@ -84,8 +191,11 @@ typedef struct {
     int opt_iq;
     int N_IQBUF;
     float complex *rot_iqbuf;
+    void (*fmdisc)(const float complex *, const float complex *, float *, int, float);
     float complex F1sum;
     float complex F2sum;
+    float complex F1c;  // exp(2pi*I*f1*sps/sr)
+    nco_t nco_F1;
 
     //
     char *rawbits;
@@ -98,12 +208,16 @@ typedef struct {
 
     // DFT
     dft_t DFT;
+    int opt_ops;   // report correlator flops per frame
+    double ops_cor;
+    double ops_ref;
 
     // dc offset
     int opt_dc;
     int locked;
     double dc;
     double Df;
+    nco_t nco_Df;
     double dDf;
 
     ui32_t sample_posframe;
@@ -115,7 +229,6 @@ typedef struct {
 
     // decimate
     int decM;
-    int blk_cnt;
     ui32_t sr_base;
     ui32_t dectaps;
     ui32_t sample_dec;
@@ -123,6 +236,21 @@ typedef struct {
     float complex *decXbuffer;
     float complex *decMbuf;
     float complex *ex; // exp_lut
+    decst_t dst;
+    int pfb_ch;        // pfb: channel
+    nco_t nco_pfb;     // pfb: residual shift
+    float complex *det_z;  // --auto: IF samples of the detector, read before the ring
+    ui32_t det_n;
+    ui32_t det_pos;
+
+    // squelch (IQ): block power vs. noise floor
+    int opt_sq;
+    int sq_open;
+    double sq_p;        // block power (avg)
+    double sq_nf;       // noise floor
+    ui32_t sq_last;     // last block above close level
+    ui32_t sq_hdr;      // last header
+    ui32_t sq_blk;
 
     // IF: lowpass
     int opt_lp;
@@ -134,6 +262,10 @@ typedef struct {
     float *ws_lpIQ;
     float complex *lpIQ_buf;
 
+    // FIR kernels (SSE/AVX2/AVX-512/scalar)
+    float complex (*cfir)(const float complex *, const float *, int);
+    float (*rfir)(const float *, const float *, int);
+
     // FM: lowpass
     int lpFM_bw;
     int lpFMtaps; // ui32_t
@@ -142,6 +274,12 @@ typedef struct {
 	float *fm_buffer;
 
     thd_t thd;
+
+    // block pipeline (f32buf_block)
+    float complex *blk_z;
+    float *blk_s;
+
+    struct sio_s *sio;  // sample input (RS/io/sample_io.c)
 } dsp_t;
 
 
@@ -154,22 +292,85 @@ typedef struct {
     int sr_base;
     int decM;
     int dectaps;
+    int pfb;      // polyphase channelizer: requested, stream_init(): M channels
     FILE *fp;
+    struct sio_s *sio;  // shared input, pcm_io_init()
+    double t_start;     // input window (sio_window), seconds
+    double t_dur;
 } pcm_t;
 
 
+typedef struct {  // IQ dc offset (running mean)
+    double sumIQx;
+    double sumIQy;
+    float avgIQx;
+    float avgIQy;
+    ui32_t cnt;
+    ui32_t maxcnt;
+    ui32_t maxlim;
+} iq_dc_t;
+
+typedef struct {  // multistage decimation: CIC, half-band stages, IF FIR
+    int R;      // CIC decimation
+    int nhb;    // half-band stages
+    int hbtaps[DEC_HB_MAX];
+    float hbc[DEC_HB_MAX];  // center tap
+    float *hb[DEC_HB_MAX];  // odd taps (symmetric)
+    int ftaps;
+    float *ws_f;
+    double gain;
+} decim_t;
+
+typedef struct {  // polyphase FFT channelizer
+    int M, D, L;
+    float *h;              // prototype, row l: h[2(lM+i)+c] = h[M-1-i+lM] (c: re/im)
+    float *acc;            // 2M
+    float complex *tw;     // exp(2pi*I*j/M)
+    float complex *tws;    // stage twiddles exp(2pi*I*q*j/n)
+    int nf, fac[PFB_MAXF]; // M = fac[0]*..*fac[nf-1]
+    int ptaps;             // 2:1 FIR, channel rate -> IF
+    float *ws_p;
+    // producer state
+    float complex *xb;     // input history (L*M) + block
+    int xn;
+    float complex *v, *w;
+    ui64_t m;              // output count: (-1)^(k*m)
+} pfb_t;
+
+// input stream: one IQ source (file, pipe, SDR) and its channels.
+// The decimator design is read-only after stream_init(), the producer state
+// (IQdc, pfb input) belongs to iq_ring_thread(); nothing in demod/multi is
+// process-global except the worker pool (pool.c) and the output writer (outq.c),
+// so several streams run side by side in one process.
+struct stream_s {
+    pcm_t pcm;       // after stream_init(): IF rate, decM, dectaps
+    iqring_t ring;
+    iq_dc_t IQdc;
+    decim_t dec;     // decM >= 4
+    float *ws_dec;   // single FIR, decM < 4
+    pfb_t pfb;       // pcm.pfb
+    int scan;        // scanner reads the ring: keep the input block (pfb)
+    int cpu;         // iq_ring_thread(): cpu (-1: any)
+    int prio;        // iq_ring_thread(): SCHED_FIFO priority (0: default policy)
+    thd_use_t use;   // iq_ring_thread() at EOF
+    rec_t *rec;      // pre-trigger recorder (NULL: off)
+};
+
 
 typedef struct {
     pcm_t pcm;
     thd_t thd;
     int option_jsn;
     int option_dc;
+    int option_sq;
 } thargs_t;
 
 
 
 float read_wav_header(pcm_t *);
+FILE *pcm_fopen(char *);
 int f32buf_sample(dsp_t *, int);
+int f32buf_block(dsp_t *, int, int);
 int read_slbit(dsp_t *, int*, int, int, int, float, int);
 
 int init_buffers(dsp_t *);
@@ -179,7 +380,44 @@ ui32_t get_sample(dsp_t *);
 
 int find_header(dsp_t *, float, int, int, int);
 
-int decimate_init(float f, int taps);
-int decimate_free(void);
-int iq_dc_init(pcm_t *);
-
+int decimate_init(stream_t *, float f, int taps);
+int decimate_stages_init(stream_t *, int decM, float f);
+int decimate_free(stream_t *);
+int pfb_init(stream_t *, int decM, float f);
+int iq_dc_init(stream_t *);
+int pcm_io_init(pcm_t *);
+int pcm_io_free(pcm_t *);
+int stream_init(stream_t *, int);
+void stream_free(stream_t *);
+
+// DSP of demod_base.c used by the rs_multi units (iq_ring.c, scan.c, detect.c)
+#define FM_GAIN (0.8)
+int dft_init(dft_t *);
+void dft_free(dft_t *);
+int dft_window(dft_t *, int);
+void raw_dft(dft_t *, float complex *);
+void rdft(dft_t *, float *, float complex *);
+void irdft(dft_t *, float complex *, float *);
+float bin2freq(dft_t *, int);
+float bin2fq(dft_t *, int);
+void iq_dc_block(iq_dc_t *, float complex *, int);
+int pfb_block(pfb_t *, float complex *, int, float complex *, int);
+int lowpass_init(float, int, float **);
+void fir_select(dsp_t *);
+int decim_init(dsp_t *);
+void decim_free(dsp_t *);
+int f32read_cblock(dsp_t *);
+float complex decimate(dsp_t *);
+float complex lowpass(dsp_t *, float complex *, ui32_t, ui32_t, float *, float complex);
+double pulse(double, double);
+double norm2_vect(float *, int);
+
+
+// rs_multi runtime: demod/multi/<unit>.c
+#include "iq_ring.h"
+#include "pool.h"
+#include "outq.h"
+#include "thd.h"
+#include "scan.h"
+#include "rec.h"
+#include "detect.h"
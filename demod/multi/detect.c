@@ -0,0 +1,404 @@
+
+/*
+ *  rs_multi: sonde type detector (--auto), header bank
+ *  compile:
+ *      gcc -c detect.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#include <stdio.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// --auto (rs_multi): sonde type on the channel IF stream, header bank of scan/dft_detect.c
+// (the types with a decoder in rs_multi):
+//   IF lowpass 12/22 kHz -> FM -> one DFT window per IF lowpass, FM lowpass 4/10 kHz
+//   and the matched filters of all headers in the frequency domain;
+//   a peak above thres is confirmed by the bit errors in the header (det_headcmp).
+// The last DET_HIST IF samples (after mixing/decimation) are kept. The decoder of the
+// detected type takes them together with the mixer/decimator state (det_handoff() in
+// init_buffers()), i.e. it starts on the samples with the header and continues with
+// the next ring sample; no second pass over the input.
+#define DET_NHDR  4
+#define DET_HIST  (1<<15)  // IF samples, > N_DFT
+
+static const struct {
+    char *type;    // rs_multi channel type
+    char *header;
+    int sps;       // baud
+    float BT;
+    float thres;
+    int herrs;     // max. bit errors
+    int lpIQ;      // IF lowpass: 12 kHz, 22 kHz
+    int lpFM;      // FM lowpass:  4 kHz, 10 kHz
+} det_hdr[DET_NHDR] = {
+    { "dfm",  "10011010100110010101101001010101", 2500, 1.0, 0.65, 2, 0, 0 },
+    { "rs41", "00001000011011010101001110001000"
+              "01000100011010010100100000011111", 4800, 0.5, 0.70, 2, 0, 0 },
+    { "lms",  "0101011000001000""0001110010010111"
+              "0001101010100111""0011110100111110", 4800, 1.0, 0.70, 2, 0, 0 },
+    { "m10",  "10011001100110010100110010011001", 9616, 1.0, 0.76, 2, 1, 1 }
+};
+
+struct det_s {
+    dsp_t *fe;             // detector dsp: mixer/decimator, ring cursor
+    dft_t DFT;
+    int K, Lbank, M;       // window K+Lbank, FM buffers M
+    ui32_t delay;
+    ui32_t sample_in;
+    ui32_t sample_out;
+    int cnt;               // samples since last bank pass
+    float spb[DET_NHDR];
+    int hLen[DET_NHDR];
+    int L[DET_NHDR];
+    float dc[DET_NHDR];
+    ui32_t mvpos0[DET_NHDR];
+    float complex *Fm[DET_NHDR];
+    float complex *WS[2];  // FM lowpass
+    int lpFMtaps;
+    int lpIQtaps;
+    float *ws_lpIQ[2];
+    float complex *lpIQ_buf;
+    float complex *y[2];   // IF lowpass block, y[g][0]: previous sample (FM)
+    float *s;              // FM block
+    float *buf_fm[2];
+    float *xn, *xf, *yr;
+    float complex *X, *Y, *Z;
+    float complex *z;      // IF history, DET_HIST
+};
+
+static void det_free_bank(det_t *det) {
+    int j;
+    for (j = 0; j < DET_NHDR; j++) {
+        if (det->Fm[j]) { free(det->Fm[j]); det->Fm[j] = NULL; }
+    }
+    for (j = 0; j < 2; j++) {
+        if (det->WS[j])      { free(det->WS[j]);      det->WS[j]      = NULL; }
+        if (det->ws_lpIQ[j]) { free(det->ws_lpIQ[j]); det->ws_lpIQ[j] = NULL; }
+        if (det->y[j])       { free(det->y[j]);       det->y[j]       = NULL; }
+        if (det->buf_fm[j])  { free(det->buf_fm[j]);  det->buf_fm[j]  = NULL; }
+    }
+    if (det->lpIQ_buf) { free(det->lpIQ_buf); det->lpIQ_buf = NULL; }
+    if (det->s)  { free(det->s);  det->s  = NULL; }
+    if (det->xn) { free(det->xn); det->xn = NULL; }
+    if (det->xf) { free(det->xf); det->xf = NULL; }
+    if (det->yr) { free(det->yr); det->yr = NULL; }
+    if (det->X)  { free(det->X);  det->X  = NULL; }
+    if (det->Y)  { free(det->Y);  det->Y  = NULL; }
+    if (det->Z)  { free(det->Z);  det->Z  = NULL; }
+    if (det->DFT.cx) { free(det->DFT.cx); det->DFT.cx = NULL; }
+    dft_free(&det->DFT);
+    if (det->z)  { free(det->z);  det->z  = NULL; }
+}
+
+// dsp: sr, sr_base, decM, dectaps, thd (ring cursor), opt_dc
+int detect_init(dsp_t *dsp) {
+    det_t *det;
+    dft_t *dft;
+    float *m = NULL;
+    float *match = NULL;
+    int i, j, g, pos, N, L, Lmax = 0;
+    double t, b, sigma;
+    float f_lp, nm;
+    int taps;
+
+    fir_select(dsp);
+    dsp->opt_iq = 5;
+    if (decim_init(dsp) < 0) return -1;
+
+    det = calloc(1, sizeof(det_t));  if (det == NULL) return -1;
+    det->fe = dsp;
+    dsp->thd.det = det;
+    dft = &det->DFT;
+
+    for (j = 0; j < DET_NHDR; j++) {
+        det->spb[j] = dsp->sr/(float)det_hdr[j].sps;
+        det->hLen[j] = strlen(det_hdr[j].header);
+        det->L[j] = det->hLen[j] * det->spb[j] + 0.5;
+        if (det->L[j] > Lmax) Lmax = det->L[j];
+    }
+    L = 2*Lmax;
+    det->Lbank = Lmax;
+
+    N = 0x2000;
+    while (N < 3*L) N <<= 1;
+    dft->N = N;
+    dft->N2 = N/2;
+    dft->LOG2N = log(N)/log(2)+0.1;
+    dft->sr = dsp->sr;
+    det->K = N - L;
+    det->delay = L/16;
+    det->M = N + det->delay + 8; // K+Lbank+delay < M
+
+    if (dft_init(dft) < 0) return -1;
+    dft->cx = calloc(N+1, sizeof(float complex));  if (dft->cx == NULL) return -1;
+    det->xn = calloc(N+1, sizeof(float));  if (det->xn == NULL) return -1;
+    det->xf = calloc(N+1, sizeof(float));  if (det->xf == NULL) return -1;
+    det->yr = calloc(N+1, sizeof(float));  if (det->yr == NULL) return -1;
+    det->X = calloc(N+1, sizeof(float complex));  if (det->X == NULL) return -1;
+    det->Y = calloc(N+1, sizeof(float complex));  if (det->Y == NULL) return -1;
+    det->Z = calloc(N+1, sizeof(float complex));  if (det->Z == NULL) return -1;
+    det->z = calloc(DET_HIST+1, sizeof(float complex));  if (det->z == NULL) return -1;
+
+    // IF lowpass, 4kHz transition
+    taps = 4*dsp->sr/4e3; if (taps%2==0) taps++;
+    f_lp = 12e3/(float)dsp->sr/2.0;
+    taps = lowpass_init(f_lp, taps, &det->ws_lpIQ[0]); if (taps < 0) return -1;
+    f_lp = 22e3/(float)dsp->sr/2.0;
+    taps = lowpass_init(f_lp, taps, &det->ws_lpIQ[1]); if (taps < 0) return -1;
+    det->lpIQtaps = taps;
+    det->lpIQ_buf = calloc(2*taps+1, sizeof(float complex));  if (det->lpIQ_buf == NULL) return -1;
+
+    for (g = 0; g < 2; g++) {
+        det->y[g] = calloc(DSP_BLK+1, sizeof(float complex));  if (det->y[g] == NULL) return -1;
+        det->buf_fm[g] = calloc(det->M+1, sizeof(float));  if (det->buf_fm[g] == NULL) return -1;
+    }
+
+    det->s = calloc(DSP_BLK+1, sizeof(float));  if (det->s == NULL) return -1;
+
+    m = calloc(N+1, sizeof(float));  if (m == NULL) return -1;
+
+    // FM lowpass (DFT), 2kHz transition
+    taps = 4*dsp->sr/2e3; if (taps%2==0) taps++;
+    for (g = 0; g < 2; g++) {
+        float *ws = NULL;
+        f_lp = (g == 0 ? 4e3 : 10e3)/(float)dsp->sr;
+        taps = lowpass_init(f_lp, taps, &ws); if (taps < 0) return -1;
+        for (i = 0; i < taps; i++) m[i] = ws[i];
+        while (i < N) m[i++] = 0.0;
+        det->WS[g] = calloc(N+1, sizeof(float complex));  if (det->WS[g] == NULL) return -1;
+        rdft(dft, m, det->WS[g]);
+        free(ws);
+    }
+    det->lpFMtaps = taps;
+
+    // matched filters
+    match = calloc(L+1, sizeof(float));  if (match == NULL) return -1;
+    for (j = 0; j < DET_NHDR; j++) {
+        const char *bits = det_hdr[j].header;
+        float spb = det->spb[j];
+        sigma = sqrt(log(2)) / (2*M_PI*det_hdr[j].BT);
+        for (i = 0; i < det->L[j]; i++) {
+            pos = i/spb;
+            t = (i - pos*spb)/spb - 0.5;
+            b = ((bits[pos] & 0x1) - 0.5)*2.0*pulse(t, sigma);
+            if (pos > 0) b += ((bits[pos-1] & 0x1) - 0.5)*2.0*pulse(t+1, sigma);
+            if (pos < det->hLen[j]-1) b += ((bits[pos+1] & 0x1) - 0.5)*2.0*pulse(t-1, sigma);
+            match[i] = b;
+        }
+        nm = sqrt(norm2_vect(match, det->L[j]));
+        for (i = 0; i < det->L[j]; i++) m[det->L[j]-1 - i] = match[i]/nm; // t = L-1
+        while (i < N) m[i++] = 0.0;
+        det->Fm[j] = calloc(N+1, sizeof(float complex));  if (det->Fm[j] == NULL) return -1;
+        rdft(dft, m, det->Fm[j]);
+    }
+
+    free(match); match = NULL;
+    free(m); m = NULL;
+
+    return det->K;
+}
+
+void detect_free(dsp_t *dsp) {
+    if (dsp->thd.cur) { // detach (no handoff)
+        atomic_store_explicit(&dsp->thd.cur->seq, IQR_OFF, memory_order_release);
+        dsp->thd.cur = NULL;
+    }
+    decim_free(dsp);
+    if (dsp->thd.det) {
+        det_free_bank(dsp->thd.det);
+        free(dsp->thd.det);
+        dsp->thd.det = NULL;
+    }
+}
+
+// up to DSP_BLK IF samples -> history, IF lowpass, FM -> buf_fm
+static int det_block(dsp_t *dsp) {
+    det_t *det = dsp->thd.det;
+    ui32_t si = det->sample_in;
+    float *s = det->s;
+    float complex z;
+    int g, k, m;
+
+    for (m = 0; m < DSP_BLK; m++) {
+        if ( f32read_cblock(dsp) < dsp->decM ) break;
+        z = decimate(dsp);
+        det->z[(si+m) % DET_HIST] = z;
+        det->y[0][m+1] = lowpass(dsp, det->lpIQ_buf, si+m, det->lpIQtaps, det->ws_lpIQ[0], z);
+        det->y[1][m+1] = lowpass(dsp, det->lpIQ_buf, si+m, det->lpIQtaps, det->ws_lpIQ[1], z);
+    }
+    if (m == 0) return 0;
+
+    for (g = 0; g < 2; g++) {
+        dsp->fmdisc(det->y[g]+1, det->y[g], s, m, FM_GAIN);
+        for (k = 0; k < m; k++) det->buf_fm[g][(si+k) % det->M] = s[k];
+        det->y[g][0] = det->y[g][m];
+    }
+    det->sample_in += m;
+    det->sample_out = det->sample_in-1 - det->delay;
+
+    return m;
+}
+
+// all headers on the window K+Lbank ending at sample_out
+static void det_bank(det_t *det, int opt_dc, float *mv, ui32_t *mvpos, int *mpv) {
+    dft_t *dft = &det->DFT;
+    int N = dft->N, K = det->K, W = det->K + det->Lbank;
+    ui32_t pos = det->sample_out;
+    int i, j, g, f, L, D, mp, use;
+    float mx, mx2, ws0;
+    double xnorm, xd, dc;
+
+    for (j = 0; j < DET_NHDR; j++) { mv[j] = 0.0; mpv[j] = -1; }
+
+    for (g = 0; g < 2; g++) // IF lowpass
+    {
+        for (i = 0; i < W; i++) det->xn[i] = det->buf_fm[g][(pos + det->M - (W-1) + i) % det->M];
+        while (i < N) det->xn[i++] = 0.0;
+        rdft(dft, det->xn, det->X);
+
+        for (f = 0; f < 2; f++) // FM lowpass
+        {
+            use = 0;
+            for (j = 0; j < DET_NHDR; j++) if (det_hdr[j].lpIQ == g && det_hdr[j].lpFM == f) use = 1;
+            if (!use) continue;
+
+            for (i = 0; i <= N/2; i++) det->Y[i] = c_mul(det->X[i], det->WS[f][i]);
+            irdft(dft, det->Y, det->xf);
+            for (i = 0; i < N; i++) det->xf[i] /= (float)N;
+            ws0 = crealf(det->WS[f][0]);
+
+            for (j = 0; j < DET_NHDR; j++)
+            {
+                if (det_hdr[j].lpIQ != g || det_hdr[j].lpFM != f) continue;
+                L = det->L[j];
+                D = det->Lbank - L;
+
+                dc = 0.0;
+                if (opt_dc) {
+                    for (i = K-L; i < K+L; i++) dc += det->xn[i+D]; // only last 2L samples (avoid M10 carrier offset)
+                    dc /= 2.0*(float)L;
+                }
+                det->dc[j] = dc;
+
+                for (i = 0; i <= N/2; i++) det->Z[i] = c_mul(det->Y[i], det->Fm[j][i]);
+                if (opt_dc) det->Z[0] -= N*dc * 0.98 * ws0 * det->Fm[j][0];
+                irdft(dft, det->Z, det->yr);
+
+                mp = -1; mx = 0.0; mx2 = 0.0;
+                for (i = det->Lbank-1; i < K+det->Lbank; i++) {
+                    if (det->yr[i]*det->yr[i] > mx2) {
+                        mx = det->yr[i];
+                        mx2 = mx*mx;
+                        mp = i;
+                    }
+                }
+                if (mp == det->Lbank-1 || mp == K+det->Lbank-1) continue; // Randwert
+
+                xnorm = 0.0;
+                for (i = 0; i < L; i++) {
+                    xd = det->xf[mp-i];
+                    if (opt_dc) xd -= dc * 0.98 * ws0;
+                    xnorm += xd*xd;
+                }
+                xnorm = sqrt(xnorm);
+
+                mv[j] = mx/(xnorm*N);
+                mvpos[j] = pos - (W-1) + mp - det->lpFMtaps/2;  // FM lowpass delay
+                mpv[j] = mp - D;
+            }
+        }
+    }
+}
+
+// header bits at mvp (FM, IF lowpass of header j)
+static int det_headcmp(det_t *det, int j, ui32_t mvp, int inv) {
+    const char *hdr = det_hdr[j].header;
+    float *buf = det->buf_fm[det_hdr[j].lpIQ];
+    ui32_t p = mvp+1 - (int)(det->hLen[j]*det->spb[j]);
+    ui32_t n = 0;
+    float lim = 0.0;
+    double sum;
+    int pos, errs = 0;
+
+    for (pos = 0; pos < det->hLen[j]; pos++) {
+        sum = 0.0;
+        lim += det->spb[j];
+        do {
+            sum += buf[(p + n + det->M) % det->M] - det->dc[j];
+            n++;
+        } while (n < lim);
+        if (((sum >= 0 ? '1' : '0') ^ inv) != hdr[pos]) errs += 1;
+    }
+
+    return errs;
+}
+
+// reads the channel until a header is confirmed: *type (rs_multi), *score (corr.)
+// returns 1, EOF
+int detect_header(dsp_t *dsp, char **type, float *score) {
+    det_t *det = dsp->thd.det;
+    float mv[DET_NHDR];
+    ui32_t mvpos[DET_NHDR];
+    int mp[DET_NHDR];
+    int j, jmax, m;
+
+    while (1) {
+        m = det_block(dsp);
+        if (m <= 0) return EOF;
+
+        det->cnt += m;
+        if (det->cnt < det->K-4) continue;
+        det->cnt = 0;
+
+        det_bank(det, dsp->opt_dc, mv, mvpos, mp);
+
+        jmax = -1;
+        for (j = 0; j < DET_NHDR; j++) {
+            if (mp[j] > 0 && fabs(mv[j]) > det_hdr[j].thres && mvpos[j] > det->mvpos0[j]) {
+                if (det_headcmp(det, j, mvpos[j], mv[j] < 0) < det_hdr[j].herrs) {
+                    if (jmax < 0 || fabs(mv[j]) > fabs(mv[jmax])) jmax = j;
+                }
+            }
+            if (mp[j] > 0) det->mvpos0[j] = mvpos[j];
+        }
+        if (jmax >= 0) {
+            *type = det_hdr[jmax].type;
+            *score = mv[jmax];
+            return 1;
+        }
+    }
+}
+
+// decoder dsp (init_buffers): mixer/decimator state and IF history of the detector
+int det_handoff(dsp_t *dsp) {
+    det_t *det = dsp->thd.det;
+    dsp_t *fe = det->fe;
+    ui32_t n, k, s0;
+
+    dsp->decM = fe->decM;
+    dsp->lut_len = fe->lut_len;
+    dsp->sample_dec = fe->sample_dec;
+    dsp->ex = fe->ex;                  fe->ex = NULL;
+    dsp->decXbuffer = fe->decXbuffer;  fe->decXbuffer = NULL;
+    dsp->decMbuf = fe->decMbuf;        fe->decMbuf = NULL;
+    dsp->dst = fe->dst;                memset(&fe->dst, 0, sizeof(fe->dst));
+    dsp->pfb_ch = fe->pfb_ch;
+    dsp->nco_pfb = fe->nco_pfb;
+
+    n = det->sample_in < DET_HIST ? det->sample_in : DET_HIST;
+    s0 = det->sample_in - n;
+    dsp->det_z = calloc(n+1, sizeof(float complex));  if (dsp->det_z == NULL) return -1;
+    for (k = 0; k < n; k++) dsp->det_z[k] = det->z[(s0+k) % DET_HIST];
+    dsp->det_n = n;
+    dsp->det_pos = 0;
+
+    det_free_bank(det);
+    dsp->thd.det = NULL;
+
+    return 0;
+}
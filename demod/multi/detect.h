@@ -0,0 +1,15 @@
+
+/*
+ *  rs_multi: sonde type detector, --auto (detect.c)
+ *  included by demod_base.h
+ */
+
+#ifndef DETECT_H
+#define DETECT_H
+
+int detect_init(dsp_t *);
+int detect_header(dsp_t *, char **, float *);
+void detect_free(dsp_t *);
+int det_handoff(dsp_t *);  // init_buffers(): detector state -> decoder
+
+#endif
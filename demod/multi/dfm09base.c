@@ -73,6 +73,7 @@ typedef struct {
     pcksts_t pck[9];
     option_t option;
     int ptu_out;
+    FILE *fout;  // thd.out
 } gpx_t;
 
 
@@ -374,7 +375,7 @@ static float get_Temp2(gpx_t *gpx) { // meas[0..4]
     if (R > 0)  T = 1/(1/T0 + 1/B0 * log(R/R0));
 
     if (gpx->option.ptu && gpx->ptu_out && gpx->option.dbg) {
-        printf("  (Rso: %.1f , Rb: %.1f)", Rs_o/1e3, Rb/1e3);
+        fprintf(gpx->fout, "  (Rso: %.1f , Rb: %.1f)", Rs_o/1e3, Rb/1e3);
     }
 
     return  T - 273.15;
@@ -603,59 +604,59 @@ static int print_gpx(gpx_t *gpx) {
 
         if (gpx->option.raw == 2) {
             for (i = 0; i < 9; i++) {
-                printf(" %s", gpx->dat_str[i]);
-                if (gpx->option.ecc) printf(" (%1X) ", gpx->pck[i].ec&0xF);
+                fprintf(gpx->fout, " %s", gpx->dat_str[i]);
+                if (gpx->option.ecc) fprintf(gpx->fout, " (%1X) ", gpx->pck[i].ec&0xF);
             }
             for (i = 0; i < 9; i++) {
                 for (j = 0; j < 13; j++) gpx->dat_str[i][j] = ' ';
             }
         }
         else {
-            if (gpx->option.aut && gpx->option.vbs >= 2) printf("<%c> ", gpx->option.inv?'-':'+');
-            printf("[%3d] ", gpx->frnr);
-            printf("%4d-%02d-%02d ", gpx->jahr, gpx->monat, gpx->tag);
-            printf("%02d:%02d:%04.1f ", gpx->std, gpx->min, gpx->sek);
-                                                if (gpx->option.vbs >= 2 && gpx->option.ecc) printf("(%1X,%1X,%1X) ", gpx->pck[0].ec&0xF, gpx->pck[8].ec&0xF, gpx->pck[1].ec&0xF);
-            printf(" ");
-            printf(" lat: %.5f ", gpx->lat);    if (gpx->option.vbs >= 2 && gpx->option.ecc) printf("(%1X)  ", gpx->pck[2].ec&0xF);
-            printf(" lon: %.5f ", gpx->lon);    if (gpx->option.vbs >= 2 && gpx->option.ecc) printf("(%1X)  ", gpx->pck[3].ec&0xF);
-            printf(" alt: %.1f ", gpx->alt);    if (gpx->option.vbs >= 2 && gpx->option.ecc) printf("(%1X)  ", gpx->pck[4].ec&0xF);
-            printf(" vH: %5.2f ", gpx->horiV);
-            printf(" D: %5.1f ", gpx->dir);
-            printf(" vV: %5.2f ", gpx->vertV);
+            if (gpx->option.aut && gpx->option.vbs >= 2) fprintf(gpx->fout, "<%c> ", gpx->option.inv?'-':'+');
+            fprintf(gpx->fout, "[%3d] ", gpx->frnr);
+            fprintf(gpx->fout, "%4d-%02d-%02d ", gpx->jahr, gpx->monat, gpx->tag);
+            fprintf(gpx->fout, "%02d:%02d:%04.1f ", gpx->std, gpx->min, gpx->sek);
+                                                if (gpx->option.vbs >= 2 && gpx->option.ecc) fprintf(gpx->fout, "(%1X,%1X,%1X) ", gpx->pck[0].ec&0xF, gpx->pck[8].ec&0xF, gpx->pck[1].ec&0xF);
+            fprintf(gpx->fout, " ");
+            fprintf(gpx->fout, " lat: %.5f ", gpx->lat);    if (gpx->option.vbs >= 2 && gpx->option.ecc) fprintf(gpx->fout, "(%1X)  ", gpx->pck[2].ec&0xF);
+            fprintf(gpx->fout, " lon: %.5f ", gpx->lon);    if (gpx->option.vbs >= 2 && gpx->option.ecc) fprintf(gpx->fout, "(%1X)  ", gpx->pck[3].ec&0xF);
+            fprintf(gpx->fout, " alt: %.1f ", gpx->alt);    if (gpx->option.vbs >= 2 && gpx->option.ecc) fprintf(gpx->fout, "(%1X)  ", gpx->pck[4].ec&0xF);
+            fprintf(gpx->fout, " vH: %5.2f ", gpx->horiV);
+            fprintf(gpx->fout, " D: %5.1f ", gpx->dir);
+            fprintf(gpx->fout, " vV: %5.2f ", gpx->vertV);
             if (gpx->option.ptu  &&  gpx->ptu_out) {
                 float t = get_Temp(gpx);
-                if (t > -270.0) printf("  T=%.1fC ", t);
+                if (t > -270.0) fprintf(gpx->fout, "  T=%.1fC ", t);
                 if (gpx->option.dbg) {
                     float t2 = get_Temp2(gpx);
                     float t4 = get_Temp4(gpx);
-                    if (t2 > -270.0) printf("  T2=%.1fC ", t2);
-                    if (t4 > -270.0) printf(" T4=%.1fC  ", t4);
-                    printf(" f0: %.2f ", gpx->meas24[0]);
-                    printf(" f1: %.2f ", gpx->meas24[1]);
-                    printf(" f2: %.2f ", gpx->meas24[2]);
-                    printf(" f3: %.2f ", gpx->meas24[3]);
-                    printf(" f4: %.2f ", gpx->meas24[4]);
+                    if (t2 > -270.0) fprintf(gpx->fout, "  T2=%.1fC ", t2);
+                    if (t4 > -270.0) fprintf(gpx->fout, " T4=%.1fC  ", t4);
+                    fprintf(gpx->fout, " f0: %.2f ", gpx->meas24[0]);
+                    fprintf(gpx->fout, " f1: %.2f ", gpx->meas24[1]);
+                    fprintf(gpx->fout, " f2: %.2f ", gpx->meas24[2]);
+                    fprintf(gpx->fout, " f3: %.2f ", gpx->meas24[3]);
+                    fprintf(gpx->fout, " f4: %.2f ", gpx->meas24[4]);
                     if (gpx->ptu_out >= 0xC) {
-                        printf(" f5: %.2f ", gpx->meas24[5]);
-                        printf(" f6: %.2f ", gpx->meas24[6]);
+                        fprintf(gpx->fout, " f5: %.2f ", gpx->meas24[5]);
+                        fprintf(gpx->fout, " f6: %.2f ", gpx->meas24[6]);
                     }
 
                 }
             }
             if (gpx->option.vbs == 3  &&  (gpx->ptu_out == 0xA || gpx->ptu_out >= 0xC)) {
-                printf("  U: %.2fV ", gpx->status[0]);
-                printf("  Ti: %.1fK ", gpx->status[1]);
+                fprintf(gpx->fout, "  U: %.2fV ", gpx->status[0]);
+                fprintf(gpx->fout, "  Ti: %.1fK ", gpx->status[1]);
             }
             if (gpx->option.vbs)
             {
                 if (gpx->sonde_typ & SNbit) {
-                    printf(" (%s) ", gpx->sonde_id);
+                    fprintf(gpx->fout, " (%s) ", gpx->sonde_id);
                     gpx->sonde_typ ^= SNbit;
                 }
             }
         }
-        printf("\n");
+        fprintf(gpx->fout, "\n");
 
         if (gpx->option.jsn && jsonout)
         {
@@ -670,14 +671,14 @@ static int print_gpx(gpx_t *gpx) {
             }
 
             // Print JSON blob     // valid sonde_ID?
-            printf("{ \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
+            fprintf(gpx->fout, "{ \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
                    gpx->frnr, json_sonde_id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->horiV, gpx->dir, gpx->vertV);
             if (gpx->ptu_out) { // get temperature
                 float t = get_Temp(gpx); // ecc-valid temperature?
-                if (t > -270.0) printf(", \"temp\": %.1f", t);
+                if (t > -270.0) fprintf(gpx->fout, ", \"temp\": %.1f", t);
             }
-            printf(" }\n");
-            printf("\n");
+            fprintf(gpx->fout, " }\n");
+            fprintf(gpx->fout, "\n");
         }
 
         ret = 1;
@@ -716,40 +717,40 @@ static int print_frame(gpx_t *gpx, dsp_t *dsp) {
 
         for (i = 0; i < 7; i++) {
             nib = bits2val(block_conf+S*i, S);
-            printf("%01X", nib & 0xFF);
+            fprintf(gpx->fout, "%01X", nib & 0xFF);
         }
         if (gpx->option.ecc) {
-            if      (ret0 == 0) printf(" [OK] ");
-            else if (ret0  > 0) printf(" [KO] ");
-            else                printf(" [NO] ");
+            if      (ret0 == 0) fprintf(gpx->fout, " [OK] ");
+            else if (ret0  > 0) fprintf(gpx->fout, " [KO] ");
+            else                fprintf(gpx->fout, " [NO] ");
         }
-        printf("  ");
+        fprintf(gpx->fout, "  ");
         for (i = 0; i < 13; i++) {
             nib = bits2val(block_dat1+S*i, S);
-            printf("%01X", nib & 0xFF);
+            fprintf(gpx->fout, "%01X", nib & 0xFF);
         }
         if (gpx->option.ecc) {
-            if      (ret1 == 0) printf(" [OK] ");
-            else if (ret1  > 0) printf(" [KO] ");
-            else                printf(" [NO] ");
+            if      (ret1 == 0) fprintf(gpx->fout, " [OK] ");
+            else if (ret1  > 0) fprintf(gpx->fout, " [KO] ");
+            else                fprintf(gpx->fout, " [NO] ");
         }
-        printf("  ");
+        fprintf(gpx->fout, "  ");
         for (i = 0; i < 13; i++) {
             nib = bits2val(block_dat2+S*i, S);
-            printf("%01X", nib & 0xFF);
+            fprintf(gpx->fout, "%01X", nib & 0xFF);
         }
         if (gpx->option.ecc) {
-            if      (ret2 == 0) printf(" [OK] ");
-            else if (ret2  > 0) printf(" [KO] ");
-            else                printf(" [NO] ");
+            if      (ret2 == 0) fprintf(gpx->fout, " [OK] ");
+            else if (ret2  > 0) fprintf(gpx->fout, " [KO] ");
+            else                fprintf(gpx->fout, " [NO] ");
         }
 
         if (gpx->option.ecc && gpx->option.vbs) {
-            if (gpx->option.vbs > 1) printf(" (%1X,%1X,%1X) ", cnt_biterr(ret0), cnt_biterr(ret1), cnt_biterr(ret2));
-            printf(" (%d) ", cnt_biterr(ret0)+cnt_biterr(ret1)+cnt_biterr(ret2));
+            if (gpx->option.vbs > 1) fprintf(gpx->fout, " (%1X,%1X,%1X) ", cnt_biterr(ret0), cnt_biterr(ret1), cnt_biterr(ret2));
+            fprintf(gpx->fout, " (%d) ", cnt_biterr(ret0)+cnt_biterr(ret1)+cnt_biterr(ret2));
         }
 
-        printf("\n");
+        fprintf(gpx->fout, "\n");
 
     }
     else if (gpx->option.ecc) {
@@ -760,21 +761,17 @@ static int print_frame(gpx_t *gpx, dsp_t *dsp) {
         if (ret1 == 0 || ret1 > 0) {
             frid = dat_out(gpx, block_dat1, ret1);
             if (frid == 8) {
-                pthread_mutex_lock( dsp->thd.mutex );
-                fprintf(stdout, "<%d> ", dsp->thd.tn);
+                fprintf(gpx->fout, "<%d> ", dsp->thd.tn);
                 ret1 = print_gpx(gpx);
-                if (ret1==0) fprintf(stdout, "\n");
-                pthread_mutex_unlock( dsp->thd.mutex );
+                if (ret1==0) fprintf(gpx->fout, "\n");
             }
         }
         if (ret2 == 0 || ret2 > 0) {
             frid = dat_out(gpx, block_dat2, ret2);
             if (frid == 8) {
-                pthread_mutex_lock( dsp->thd.mutex );
-                fprintf(stdout, "<%d> ", dsp->thd.tn);
+                fprintf(gpx->fout, "<%d> ", dsp->thd.tn);
                 ret2 = print_gpx(gpx);
-                if (ret2==0) fprintf(stdout, "\n");
-                pthread_mutex_unlock( dsp->thd.mutex );
+                if (ret2==0) fprintf(gpx->fout, "\n");
             }
         }
 
@@ -789,6 +786,8 @@ static int print_frame(gpx_t *gpx, dsp_t *dsp) {
 
     }
 
+    out_frame(&dsp->thd);
+
     return ret;
 }
 
@@ -859,6 +858,7 @@ void *thd_dfm09(void *targs) {
     // init dsp
     //
     dsp.fp = pcm->fp;
+    dsp.sio = pcm->sio;
     dsp.sr = pcm->sr;
     dsp.sr_base = pcm->sr_base;
     dsp.dectaps = pcm->dectaps;
@@ -883,6 +883,7 @@ void *thd_dfm09(void *targs) {
     dsp.lpIQ_bw = 12e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 4e3; // FM audio lowpass
     dsp.opt_dc = tharg->option_dc;
+    dsp.opt_sq = tharg->option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low\n");
@@ -892,8 +893,10 @@ void *thd_dfm09(void *targs) {
     k = init_buffers(&dsp);
     if ( k < 0 ) {
         fprintf(stderr, "error: init buffers\n");
+        free_buffers(&dsp); // detach from IQ ring
         return NULL;
     };
+    gpx.fout = dsp.thd.out;
 
 
     bitofs += shift;
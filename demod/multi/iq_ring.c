@@ -0,0 +1,211 @@
+
+/*
+ *  rs_multi: IQ broadcast ring (input stream -> channels, scanner)
+ *  compile:
+ *      gcc -I../../io -c iq_ring.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <sched.h>
+#include <time.h>
+
+#include "demod_base.h"
+
+#include "sample_io.h"  // RS/io/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+  #define IQR_PAUSE
+  #include <immintrin.h>  // _mm_pause
+#endif
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// IQ broadcast ring: the producer (iq_ring_thread) reads blocks of blen samples
+// and publishes wseq; a consumer reads at its own cursor and releases a block
+// with cur->seq. Slot w%nslot is reused once all attached consumers have
+// released block w-nslot. No lock; a waiting side spins, yields, then sleeps.
+// The input therefore runs at the speed of the slowest decoder once it lags nslot
+// blocks (pwait counts these stalls). With r->drop the producer waits only for the
+// fastest consumer; a slower one skips to the oldest block still in the ring
+// (iq_ring_skip()) and discards a block overwritten while read (iq_ring_valid()).
+// Consumers attach/detach at any time (iq_ring_attach(), free_buffers()); the owner
+// releases the cursor for reuse after the consumer has been joined (iq_ring_release()).
+void iqr_wait(int *spin) {
+    if (*spin < 64) {
+        *spin += 1;
+    #ifdef IQR_PAUSE
+        _mm_pause();
+    #endif
+    }
+    else if (*spin < 128) {
+        *spin += 1;
+        sched_yield();
+    }
+    else {
+        struct timespec ts = {0, 100000}; // 0.1 ms
+        nanosleep(&ts, NULL);
+    }
+}
+
+int iq_ring_init(stream_t *st, int nslot) {
+    iqring_t *r = &st->ring;
+
+    memset(r, 0, sizeof(*r));
+    if (nslot < 2) nslot = 2;
+    r->nslot = nslot;
+    r->blen = IQR_BLK * (st->pcm.decM > 1 ? st->pcm.decM : 1);
+    if (st->pcm.sio == NULL) return -1;
+
+    r->ssz = r->blen;
+    if (st->pfb.M) {
+        r->chlen = r->blen / st->pfb.D;
+        r->ssz = st->pfb.M * r->chlen;
+        if (st->scan) { // input block after the channels
+            r->rawofs = r->ssz;
+            r->ssz += r->blen;
+        }
+        else {
+            r->raw = calloc(r->blen+1, sizeof(float complex));  if (r->raw == NULL) return -1;
+        }
+        r->rawlen = calloc(r->nslot, sizeof(int));  if (r->rawlen == NULL) return -1;
+    }
+
+    r->buf = calloc((size_t)r->nslot*r->ssz, sizeof(float complex));  if (r->buf == NULL) return -1;
+    r->len = calloc(r->nslot, sizeof(int));  if (r->len == NULL) return -1;
+    atomic_init(&r->cur, NULL);
+    atomic_init(&r->wseq, 0);
+    atomic_init(&r->eof, 0);
+
+    return 0;
+}
+
+// new consumer, live=0: from the first block (before iq_ring_thread() starts),
+// live=1: at the current write position. Not thread-safe against other attach calls.
+// seq_cst: cursor published, then wseq read; the producer reads the list after
+// publishing wseq, so the block at the start position is not overwritten.
+iqr_cur_t *iq_ring_attach(iqring_t *r, int live) {
+    iqr_cur_t *c;
+    ui64_t w = live ? atomic_load(&r->wseq) : 0;
+
+    for (c = atomic_load(&r->cur); c; c = c->next) {
+        if (atomic_load(&c->own) == 0) break;
+    }
+    if (c == NULL) {
+        c = calloc(1, sizeof(iqr_cur_t));  if (c == NULL) return NULL;
+        atomic_init(&c->seq, w);
+        atomic_init(&c->stop, 0);
+        atomic_init(&c->own, 1);
+        c->next = atomic_load(&r->cur);
+        atomic_store(&r->cur, c);
+    }
+    else {
+        atomic_store(&c->stop, 0);
+        atomic_store(&c->seq, w);
+        atomic_store(&c->own, 1);
+    }
+    if (live) atomic_store(&c->seq, atomic_load(&r->wseq));
+
+    return c;
+}
+
+// owner: consumer joined, the cursor can be reused by iq_ring_attach()
+void iq_ring_release(iqr_cur_t *c) {
+    atomic_store_explicit(&c->seq, IQR_OFF, memory_order_release);
+    atomic_store_explicit(&c->own, 0, memory_order_release);
+}
+
+// drop: block *seq overwritten (or about to be), skip to the oldest block in the ring;
+// returns blocks skipped
+ui64_t iq_ring_skip(iqring_t *r, ui64_t *seq) {
+    ui64_t w, d = 0;
+    if (r->drop) {
+        w = atomic_load_explicit(&r->wseq, memory_order_acquire);
+        if (w - *seq >= (ui64_t)r->nslot) {
+            d = w - r->nslot + 1 - *seq;
+            *seq += d;
+        }
+    }
+    return d;
+}
+
+// drop: block seq (just copied) not overwritten in the meantime
+int iq_ring_valid(iqring_t *r, ui64_t seq) {
+    if (r->drop == 0) return 1;
+    atomic_thread_fence(memory_order_acquire);  // copy before wseq
+    return atomic_load_explicit(&r->wseq, memory_order_relaxed) - seq < (ui64_t)r->nslot;
+}
+
+void iq_ring_free(iqring_t *r) {
+    iqr_cur_t *c, *n;
+    if (r->buf) { free(r->buf); r->buf = NULL; }
+    if (r->len) { free(r->len); r->len = NULL; }
+    if (r->rawlen) { free(r->rawlen); r->rawlen = NULL; }
+    for (c = atomic_load(&r->cur); c; c = n) { n = c->next; free(c); }
+    atomic_store(&r->cur, NULL);
+    if (r->raw) { free(r->raw); r->raw = NULL; }
+}
+
+void *iq_ring_thread(void *arg) {
+    stream_t *st = (stream_t *)arg;
+    iqring_t *r = &st->ring;
+    ui64_t w = 0, m, s, f;
+    int n, len, slot, spin;
+    float complex *z;
+    iqr_cur_t *c;
+
+    st->use.cpu = st->cpu;
+    if (thd_place(st->cpu, st->prio) < 0) {
+        fprintf(stderr, "ring: cpu %d / SCHED_FIFO %d not set\n", st->cpu, st->prio);
+    }
+
+    while (1) {
+        spin = 0;
+        while (1) {
+            m = IQR_OFF;
+            f = 0;  // drop: fastest consumer
+            for (c = atomic_load(&r->cur); c; c = c->next) {
+                s = atomic_load_explicit(&c->seq, memory_order_acquire);
+                if (s < m) m = s;
+                if (s != IQR_OFF && s > f) f = s;
+            }
+            if (m == IQR_OFF) break;
+            if (r->drop) { // one slot spare: block f is never being written
+                if (w - f < (ui64_t)r->nslot-1) break;
+            }
+            else if (w - m < (ui64_t)r->nslot) break;
+            if (spin == 0) r->pwait += 1;
+            iqr_wait(&spin);
+        }
+        if (m == IQR_OFF && !r->keep) break; // no consumers left
+
+        slot = w % r->nslot;
+        z = r->buf + (size_t)slot*r->ssz;
+        if (r->chlen) {
+            float complex *x = r->rawofs ? z + r->rawofs : r->raw;
+            n = sio_cfloat(st->pcm.sio, (float*)x, r->blen);
+            iq_dc_block(&st->IQdc, x, n);
+            if (st->rec) rec_put(st->rec, x, n);
+            len = pfb_block(&st->pfb, x, n, z, r->chlen);
+            r->rawlen[slot] = n;
+        }
+        else {
+            n = len = sio_cfloat(st->pcm.sio, (float*)z, r->blen);
+            iq_dc_block(&st->IQdc, z, len);
+            if (st->rec) rec_put(st->rec, z, len);
+        }
+        r->len[slot] = len;
+        if (len > 0) {
+            w += 1;
+            atomic_store(&r->wseq, w);
+            atomic_thread_fence(memory_order_release);  // drop: wseq before the next slot write
+        }
+        if (n < r->blen) break;
+    }
+    atomic_store_explicit(&r->eof, 1, memory_order_release);
+    thd_usage(&st->use);
+
+    return NULL;
+}
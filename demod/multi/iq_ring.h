@@ -0,0 +1,19 @@
+
+/*
+ *  rs_multi: IQ broadcast ring (iq_ring.c)
+ *  included by demod_base.h (types iqring_t, iqr_cur_t)
+ */
+
+#ifndef IQ_RING_H
+#define IQ_RING_H
+
+int iq_ring_init(stream_t *, int);
+iqr_cur_t *iq_ring_attach(iqring_t *, int);
+void iq_ring_release(iqr_cur_t *);
+ui64_t iq_ring_skip(iqring_t *, ui64_t *);  // --lag-drop
+int iq_ring_valid(iqring_t *, ui64_t);
+void *iq_ring_thread(void *);
+void iq_ring_free(iqring_t *);
+void iqr_wait(int *);  // spin, yield, sleep
+
+#endif
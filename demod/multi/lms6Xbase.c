@@ -115,6 +115,7 @@ typedef struct {
     char rawbits[RAWBITFRAME_LEN+OVERLAP*BITS*2 +8];
     states_t state[RAWBITFRAME_LEN+OVERLAP +8][M];
     states_t d[N];
+    ui8_t code[N];
 } VIT_t;
 
 typedef struct {
@@ -141,12 +142,13 @@ typedef struct {
     option_t option;
     RS_t RS;
     VIT_t *vit;
+    FILE *fout;  // thd.out
+    int gpstow_start;
+    double time_elapsed_sec;
 } gpx_t;
 
 
 /* ------------------------------------------------------------------------------------ */
-static int gpstow_start = -1;
-static double time_elapsed_sec = 0.0;
 
 /*
  * Convert GPS Week and Seconds to Modified Julian Day.
@@ -177,9 +179,6 @@ static void Gps2Date(gpx_t *gpx) {
 
 // ------------------------------------------------------------------------
 
-static ui8_t vit_code[N];
-static int vitCodes_init = 0;
-
 static int vit_initCodes(gpx_t *gpx) {
     int cA, cB;
     int i, bits;
@@ -188,17 +187,14 @@ static int vit_initCodes(gpx_t *gpx) {
     if (pv == NULL) return -1;
     gpx->vit = pv;
 
-    if ( vitCodes_init == 0 ) {
-        for (bits = 0; bits < N; bits++) {
-            cA = 0;
-            cB = 0;
-            for (i = 0; i < L; i++) {
-                cA ^= (polyA[L-1-i]&1) & ((bits >> i)&1);
-                cB ^= (polyB[L-1-i]&1) & ((bits >> i)&1);
-            }
-            vit_code[bits] = (cA<<1) | cB;
+    for (bits = 0; bits < N; bits++) {
+        cA = 0;
+        cB = 0;
+        for (i = 0; i < L; i++) {
+            cA ^= (polyA[L-1-i]&1) & ((bits >> i)&1);
+            cB ^= (polyB[L-1-i]&1) & ((bits >> i)&1);
         }
-        vitCodes_init = 1;
+        pv->code[bits] = (cA<<1) | cB;
     }
 
     return 0;
@@ -224,7 +220,7 @@ static int vit_start(VIT_t *vit, char *rc) {
     m = 2;
     for (t = 1; t < L; t++) {
         for (j = 0; j < m; j++) {
-            c = vit_code[j];
+            c = vit->code[j];
             vit->state[t][j].bIn = j % 2;
             vit->state[t][j].codeIn = c;
             d = vit_dist( c, rc+2*(t-1) );
@@ -244,7 +240,7 @@ static int vit_next(VIT_t *vit, int t, char *rc) {
         for (b = 0; b < 2; b++) {
             nstate = j*2 + b;
             vit->d[nstate].bIn = b;
-            vit->d[nstate].codeIn = vit_code[nstate];
+            vit->d[nstate].codeIn = vit->code[nstate];
             vit->d[nstate].prevState = j;
             vit->d[nstate].w = vit->state[t][j].w + vit_dist( vit->d[nstate].codeIn, rc );
         }
@@ -464,9 +460,9 @@ static int get_GPStime(gpx_t *gpx, int crc_err) {
         gpstime |= gpstime_bytes[i] << (8*(3-i));
     }
 
-    if (gpstow_start < 0 && !crc_err) {
-        gpstow_start = gpstime; // time elapsed since start-up?
-        if (gpx->week > 0 && gpstime/1000.0 < time_elapsed_sec) gpx->week += 1;
+    if (gpx->gpstow_start < 0 && !crc_err) {
+        gpx->gpstow_start = gpstime; // time elapsed since start-up?
+        if (gpx->week > 0 && gpstime/1000.0 < gpx->time_elapsed_sec) gpx->week += 1;
     }
     gpx->gpstow = gpstime;
 
@@ -684,8 +680,8 @@ static int print_frame(gpx_t *gpx, int crc_err, int len) {
         {
             get_SondeSN(gpx);
             get_FrameNb(gpx);
-            printf("(%7d)  ", gpx->sn);
-            printf("[%5d]  ", gpx->frnr);
+            fprintf(gpx->fout, "(%7d)  ", gpx->sn);
+            fprintf(gpx->fout, "[%5d]  ", gpx->frnr);
 
             get_GPSlat(gpx);
             get_GPSlon(gpx);
@@ -700,27 +696,27 @@ static int print_frame(gpx_t *gpx, int crc_err, int len) {
                 get_GPSvel16_X(gpx);
             }
 
-            if (!err1) printf("%s ", weekday[gpx->wday]);
+            if (!err1) fprintf(gpx->fout, "%s ", weekday[gpx->wday]);
             if (gpx->week > 0) {
-                if (gpx->gpstow < gpstow_start && !crc_err) {
+                if (gpx->gpstow < gpx->gpstow_start && !crc_err) {
                     gpx->week += 1; // week roll-over
-                    gpstow_start = gpx->gpstow;
+                    gpx->gpstow_start = gpx->gpstow;
                 }
                 Gps2Date(gpx);
-                fprintf(stdout, "%04d-%02d-%02d ", gpx->jahr, gpx->monat, gpx->tag);
+                fprintf(gpx->fout, "%04d-%02d-%02d ", gpx->jahr, gpx->monat, gpx->tag);
             }
-            printf("%02d:%02d:%06.3f ", gpx->std, gpx->min, gpx->sek); // falls Rundung auf 60s: Ueberlauf
+            fprintf(gpx->fout, "%02d:%02d:%06.3f ", gpx->std, gpx->min, gpx->sek); // falls Rundung auf 60s: Ueberlauf
 
             if (!err2) {
-                printf(" lat: %.5f ", gpx->lat);
-                printf(" lon: %.5f ", gpx->lon);
-                printf(" alt: %.2fm ", gpx->alt);
-                printf("  vH: %.1fm/s  D: %.1f  vV: %.1fm/s ", gpx->vH, gpx->vD, gpx->vV);
+                fprintf(gpx->fout, " lat: %.5f ", gpx->lat);
+                fprintf(gpx->fout, " lon: %.5f ", gpx->lon);
+                fprintf(gpx->fout, " alt: %.2fm ", gpx->alt);
+                fprintf(gpx->fout, "  vH: %.1fm/s  D: %.1f  vV: %.1fm/s ", gpx->vH, gpx->vD, gpx->vV);
             }
 
-            if (crc_err==0) printf(" [OK]"); else printf(" [NO]");
+            if (crc_err==0) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
 
-            printf("\n");
+            fprintf(gpx->fout, "\n");
 
 
             if (gpx->option.jsn) {
@@ -729,13 +725,13 @@ static int print_frame(gpx_t *gpx, int crc_err, int len) {
                     // UTC oder GPS?
                     char sntyp[] = "LMS6-";
                     if (gpx->typ == 10) sntyp[3] = 'X';
-                    printf("{ \"frame\": %d, \"id\": \"%s%d\", \"datetime\": \"", gpx->frnr, sntyp, gpx->sn );
+                    fprintf(gpx->fout, "{ \"frame\": %d, \"id\": \"%s%d\", \"datetime\": \"", gpx->frnr, sntyp, gpx->sn );
                     //if (gpx->week > 0) printf("%04d-%02d-%02dT", gpx->jahr, gpx->monat, gpx->tag );
-                    printf("%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
+                    fprintf(gpx->fout, "%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f",
                            gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV );
-                    printf(", \"gpstow\": %d", gpx->gpstow );
-                    printf(" }\n");
-                    printf("\n");
+                    fprintf(gpx->fout, ", \"gpstow\": %d", gpx->gpstow );
+                    fprintf(gpx->fout, " }\n");
+                    fprintf(gpx->fout, "\n");
                 }
             }
             ret = 1;
@@ -747,11 +743,9 @@ static int print_frame(gpx_t *gpx, int crc_err, int len) {
 
 static int print_thd_frame(gpx_t *gpx, int crc_err, int len, dsp_t *dsp) {
     int ret = 0;
-    pthread_mutex_lock( dsp->thd.mutex );
-    printf("<%d> ", dsp->thd.tn);
+    fprintf(gpx->fout, "<%d> ", dsp->thd.tn);
     ret = print_frame(gpx, crc_err, len);
-    if (ret==0) printf("\n");
-    pthread_mutex_unlock( dsp->thd.mutex );
+    if (ret==0) fprintf(gpx->fout, "\n");
     return ret;
 }
 
@@ -862,9 +856,9 @@ static void proc_frame(gpx_t *gpx, int len, dsp_t *dsp) {
                 crc_err = check_CRC(gpx->frame);
 
                 if (gpx->option.raw == 1) {
-                    for (i = 0; i < FRM_LEN; i++) printf("%02x ", gpx->frame[i]);
-                    if (crc_err==0) printf(" [OK]"); else printf(" [NO]");
-                    printf("\n");
+                    for (i = 0; i < FRM_LEN; i++) fprintf(gpx->fout, "%02x ", gpx->frame[i]);
+                    if (crc_err==0) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
+                    fprintf(gpx->fout, "\n");
                 }
 
                 if (gpx->option.raw == 0) print_thd_frame(gpx, crc_err, len, dsp);
@@ -912,15 +906,16 @@ static void proc_frame(gpx_t *gpx, int len, dsp_t *dsp) {
             crc_err = check_CRC(gpx->frame);
 
             if (gpx->option.raw == 1) {
-                for (i = 0; i < FRM_LEN; i++) printf("%02x ", gpx->frame[i]);
-                if (crc_err==0) printf(" [OK]"); else printf(" [NO]");
-                printf("\n");
+                for (i = 0; i < FRM_LEN; i++) fprintf(gpx->fout, "%02x ", gpx->frame[i]);
+                if (crc_err==0) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
+                fprintf(gpx->fout, "\n");
             }
 
             if (gpx->option.raw == 0) print_thd_frame(gpx, crc_err, len, dsp);
         }
     }
 
+    out_frame(&dsp->thd);
 }
 
 
@@ -1000,6 +995,7 @@ void *thd_lms6X(void *targs) { // pcm_t *pcm, double xlt_fq
 
 
     gpx->week = gpsweek;
+    gpx->gpstow_start = -1;
 
 
     pcm->sel_ch = 0;
@@ -1009,6 +1005,7 @@ void *thd_lms6X(void *targs) { // pcm_t *pcm, double xlt_fq
     // init dsp
     //
     dsp.fp = pcm->fp;
+    dsp.sio = pcm->sio;
     dsp.sr = pcm->sr;
     dsp.sr_base = pcm->sr_base;
     dsp.dectaps = pcm->dectaps;
@@ -1033,6 +1030,7 @@ void *thd_lms6X(void *targs) { // pcm_t *pcm, double xlt_fq
     dsp.lpIQ_bw = 8e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 6e3; // FM audio lowpass
     dsp.opt_dc = tharg->option_dc;
+    dsp.opt_sq = tharg->option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
@@ -1042,8 +1040,10 @@ void *thd_lms6X(void *targs) { // pcm_t *pcm, double xlt_fq
     k = init_buffers(&dsp);  // baud difference not significant
     if ( k < 0 ) {
         fprintf(stderr, "error: init buffers\n");
+        free_buffers(&dsp); // detach from IQ ring
         return NULL;
     };
+    gpx->fout = dsp.thd.out;
 
 
     if (gpx->option.vit) {
@@ -1120,7 +1120,7 @@ void *thd_lms6X(void *targs) { // pcm_t *pcm, double xlt_fq
 
             gpx->blk_rawbits[pos] = '\0';
 
-            time_elapsed_sec = dsp.sample_in / (double)dsp.sr;
+            gpx->time_elapsed_sec = dsp.sample_in / (double)dsp.sr;
             proc_frame(gpx, pos, &dsp);
 
             if (pos < rawbitblock_len) break;
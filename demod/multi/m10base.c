@@ -84,6 +84,7 @@ typedef struct {
     char frame_bits[BITFRAME_LEN+BITAUX_LEN+8];
     int auxlen; // 0 .. 0x76-0x64
     option_t option;
+    FILE *fout;  // thd.out
 } gpx_t;
 
 
@@ -569,7 +570,7 @@ static float get_Temp(gpx_t *gpx, int csOK) {
         // INCH1A (temp.diode), slau144
         vti = ADC_Ti_raw/4095.0 * 1.5; // V_REF+ = 1.5V, no calibration
         ti = (vti-0.986)/0.00355;      // 0.986/0.00355=277.75, 1.5/4095/0.00355=0.1032
-        fprintf(stdout, "  (Ti:%.1fC)", ti);
+        fprintf(gpx->fout, "  (Ti:%.1fC)", ti);
         // SegmentA-Calibration:
         //ui16_t T30 = adr_10e2h; // CAL_ADC_15T30
         //ui16_t T85 = adr_10e4h; // CAL_ADC_15T85
@@ -698,69 +699,69 @@ static int print_pos(gpx_t *gpx, int csOK) {
         Gps2Date(gpx->week, gpx->gpssec, &gpx->jahr, &gpx->monat, &gpx->tag);
 
         if (gpx->option.col) {
-            fprintf(stdout, col_TXT);
-            if (gpx->option.vbs >= 3) fprintf(stdout, " (W "col_GPSweek"%d"col_TXT") ", gpx->week);
-            fprintf(stdout, col_GPSTOW"%s"col_TXT" ", weekday[gpx->wday]);
-            fprintf(stdout, col_GPSdate"%04d-%02d-%02d"col_TXT" "col_GPSTOW"%02d:%02d:%06.3f"col_TXT" ",
+            fprintf(gpx->fout, col_TXT);
+            if (gpx->option.vbs >= 3) fprintf(gpx->fout, " (W "col_GPSweek"%d"col_TXT") ", gpx->week);
+            fprintf(gpx->fout, col_GPSTOW"%s"col_TXT" ", weekday[gpx->wday]);
+            fprintf(gpx->fout, col_GPSdate"%04d-%02d-%02d"col_TXT" "col_GPSTOW"%02d:%02d:%06.3f"col_TXT" ",
                     gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek);
-            fprintf(stdout, " lat: "col_GPSlat"%.5f"col_TXT" ", gpx->lat);
-            fprintf(stdout, " lon: "col_GPSlon"%.5f"col_TXT" ", gpx->lon);
-            fprintf(stdout, " alt: "col_GPSalt"%.2f"col_TXT" ", gpx->alt);
+            fprintf(gpx->fout, " lat: "col_GPSlat"%.5f"col_TXT" ", gpx->lat);
+            fprintf(gpx->fout, " lon: "col_GPSlon"%.5f"col_TXT" ", gpx->lon);
+            fprintf(gpx->fout, " alt: "col_GPSalt"%.2f"col_TXT" ", gpx->alt);
             if (!err2) {
                 //if (gpx->option.vbs == 2) fprintf(stdout, "  "col_GPSvel"(%.1f , %.1f : %.1f)"col_TXT" ", gpx->vx, gpx->vy, gpx->vD2);
-                fprintf(stdout, "  vH: "col_GPSvel"%.1f"col_TXT"  D: "col_GPSvel"%.1f"col_TXT"  vV: "col_GPSvel"%.1f"col_TXT" ", gpx->vH, gpx->vD, gpx->vV);
+                fprintf(gpx->fout, "  vH: "col_GPSvel"%.1f"col_TXT"  D: "col_GPSvel"%.1f"col_TXT"  vV: "col_GPSvel"%.1f"col_TXT" ", gpx->vH, gpx->vD, gpx->vV);
             }
             if (gpx->option.vbs >= 2) {
                 get_SN(gpx);
-                fprintf(stdout, "  SN: "col_SN"%s"col_TXT, gpx->SN);
+                fprintf(gpx->fout, "  SN: "col_SN"%s"col_TXT, gpx->SN);
             }
             if (gpx->option.vbs >= 2) {
-                fprintf(stdout, "  # ");
-                if (csOK) fprintf(stdout, " "col_CSok"[OK]"col_TXT);
-                else      fprintf(stdout, " "col_CSno"[NO]"col_TXT);
+                fprintf(gpx->fout, "  # ");
+                if (csOK) fprintf(gpx->fout, " "col_CSok"[OK]"col_TXT);
+                else      fprintf(gpx->fout, " "col_CSno"[NO]"col_TXT);
             }
             if (gpx->option.ptu) {
                 float t = get_Temp(gpx, csOK);
-                if (t > -270.0) fprintf(stdout, "  T=%.1fC ", t);
+                if (t > -270.0) fprintf(gpx->fout, "  T=%.1fC ", t);
                 if (gpx->option.vbs >= 3) {
                     float t2 = get_Tntc2(gpx, csOK);
                     float fq555 = get_TLC555freq(gpx);
-                    if (t2 > -270.0) fprintf(stdout, " (T2:%.1fC) (%.3fkHz) ", t2, fq555/1e3);
+                    if (t2 > -270.0) fprintf(gpx->fout, " (T2:%.1fC) (%.3fkHz) ", t2, fq555/1e3);
                 }
             }
-            fprintf(stdout, ANSI_COLOR_RESET"");
+            fprintf(gpx->fout, ANSI_COLOR_RESET"");
         }
         else {
-            if (gpx->option.vbs >= 3) fprintf(stdout, " (W %d) ", gpx->week);
-            fprintf(stdout, "%s ", weekday[gpx->wday]);
-            fprintf(stdout, "%04d-%02d-%02d %02d:%02d:%06.3f ",
+            if (gpx->option.vbs >= 3) fprintf(gpx->fout, " (W %d) ", gpx->week);
+            fprintf(gpx->fout, "%s ", weekday[gpx->wday]);
+            fprintf(gpx->fout, "%04d-%02d-%02d %02d:%02d:%06.3f ",
                     gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek);
-            fprintf(stdout, " lat: %.5f ", gpx->lat);
-            fprintf(stdout, " lon: %.5f ", gpx->lon);
-            fprintf(stdout, " alt: %.2f ", gpx->alt);
+            fprintf(gpx->fout, " lat: %.5f ", gpx->lat);
+            fprintf(gpx->fout, " lon: %.5f ", gpx->lon);
+            fprintf(gpx->fout, " alt: %.2f ", gpx->alt);
             if (!err2) {
                 //if (gpx->option.vbs == 2) fprintf(stdout, "  (%.1f , %.1f : %.1f) ", gpx->vx, gpx->vy, gpx->vD2);
-                fprintf(stdout, "  vH: %.1f  D: %.1f  vV: %.1f ", gpx->vH, gpx->vD, gpx->vV);
+                fprintf(gpx->fout, "  vH: %.1f  D: %.1f  vV: %.1f ", gpx->vH, gpx->vD, gpx->vV);
             }
             if (gpx->option.vbs >= 2) {
                 get_SN(gpx);
-                fprintf(stdout, "  SN: %s", gpx->SN);
+                fprintf(gpx->fout, "  SN: %s", gpx->SN);
             }
             if (gpx->option.vbs >= 2) {
-                fprintf(stdout, "  # ");
-                if (csOK) fprintf(stdout, " [OK]"); else fprintf(stdout, " [NO]");
+                fprintf(gpx->fout, "  # ");
+                if (csOK) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
             }
             if (gpx->option.ptu) {
                 float t = get_Temp(gpx, csOK);
-                if (t > -270.0) fprintf(stdout, "  T=%.1fC ", t);
+                if (t > -270.0) fprintf(gpx->fout, "  T=%.1fC ", t);
                 if (gpx->option.vbs >= 3) {
                     float t2 = get_Tntc2(gpx, csOK);
                     float fq555 = get_TLC555freq(gpx);
-                    if (t2 > -270.0) fprintf(stdout, " (T2:%.1fC) (%.3fkHz) ", t2, fq555/1e3);
+                    if (t2 > -270.0) fprintf(gpx->fout, " (T2:%.1fC) (%.3fkHz) ", t2, fq555/1e3);
                 }
             }
         }
-        fprintf(stdout, "\n");
+        fprintf(gpx->fout, "\n");
 
 
         if (gpx->option.jsn) {
@@ -789,23 +790,23 @@ static int print_pos(gpx_t *gpx, int csOK) {
                 sn_id[15] = '\0';
                 for (j = 0; sn_id[j]; j++) { if (sn_id[j] == ' ') sn_id[j] = '-'; }
 
-                fprintf(stdout, "{ ");
-                fprintf(stdout, "\"frame\": %lu ,", (unsigned long)(sec_gps0+0.5));
-                fprintf(stdout, "\"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d",
+                fprintf(gpx->fout, "{ ");
+                fprintf(gpx->fout, "\"frame\": %lu ,", (unsigned long)(sec_gps0+0.5));
+                fprintf(gpx->fout, "\"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d",
                                sn_id, utc_jahr, utc_monat, utc_tag, utc_std, utc_min, utc_sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV, gpx->numSV);
                 // APRS id, 9 characters
                 aprs_id[0] = gpx->frame_bytes[pos_SN+2];
                 aprs_id[1] = gpx->frame_bytes[pos_SN] & 0xF;
                 aprs_id[2] = gpx->frame_bytes[pos_SN+4];
                 aprs_id[3] = gpx->frame_bytes[pos_SN+3];
-                fprintf(stdout, ", \"aprsid\": \"ME%02X%1X%02X%02X\"", aprs_id[0], aprs_id[1], aprs_id[2], aprs_id[3]);
+                fprintf(gpx->fout, ", \"aprsid\": \"ME%02X%1X%02X%02X\"", aprs_id[0], aprs_id[1], aprs_id[2], aprs_id[3]);
                 // temperature
                 if (gpx->option.ptu) {
                     float t = get_Temp(gpx, 0);
-                    if (t > -273.0) fprintf(stdout, ", \"temp\": %.1f", t);
+                    if (t > -273.0) fprintf(gpx->fout, ", \"temp\": %.1f", t);
                 }
-                fprintf(stdout, " }\n");
-                fprintf(stdout, "\n");
+                fprintf(gpx->fout, " }\n");
+                fprintf(gpx->fout, "\n");
             }
         }
 
@@ -834,37 +835,37 @@ static int print_frame(gpx_t *gpx, int pos, dsp_t *dsp) {
     if (gpx->option.raw) {
 
         if (gpx->option.col  &&  gpx->frame_bytes[1] != 0x49) {
-            fprintf(stdout, col_FRTXT);
+            fprintf(gpx->fout, col_FRTXT);
             for (i = 0; i < FRAME_LEN+gpx->auxlen; i++) {
                 byte = gpx->frame_bytes[i];
-                if ((i >= pos_GPSTOW)   &&  (i < pos_GPSTOW+4))   fprintf(stdout, col_GPSTOW);
-                if ((i >= pos_GPSlat)   &&  (i < pos_GPSlat+4))   fprintf(stdout, col_GPSlat);
-                if ((i >= pos_GPSlon)   &&  (i < pos_GPSlon+4))   fprintf(stdout, col_GPSlon);
-                if ((i >= pos_GPSalt)   &&  (i < pos_GPSalt+4))   fprintf(stdout, col_GPSalt);
-                if ((i >= pos_GPSweek)  &&  (i < pos_GPSweek+2))  fprintf(stdout, col_GPSweek);
-                if ((i >= pos_GPSvE)    &&  (i < pos_GPSvE+6))    fprintf(stdout, col_GPSvel);
-                if ((i >= pos_SN)       &&  (i < pos_SN+5))       fprintf(stdout, col_SN);
-                if ((i >= pos_Check+gpx->auxlen)  &&  (i < pos_Check+gpx->auxlen+2))  fprintf(stdout, col_Check);
-                fprintf(stdout, "%02x", byte);
-                fprintf(stdout, col_FRTXT);
+                if ((i >= pos_GPSTOW)   &&  (i < pos_GPSTOW+4))   fprintf(gpx->fout, col_GPSTOW);
+                if ((i >= pos_GPSlat)   &&  (i < pos_GPSlat+4))   fprintf(gpx->fout, col_GPSlat);
+                if ((i >= pos_GPSlon)   &&  (i < pos_GPSlon+4))   fprintf(gpx->fout, col_GPSlon);
+                if ((i >= pos_GPSalt)   &&  (i < pos_GPSalt+4))   fprintf(gpx->fout, col_GPSalt);
+                if ((i >= pos_GPSweek)  &&  (i < pos_GPSweek+2))  fprintf(gpx->fout, col_GPSweek);
+                if ((i >= pos_GPSvE)    &&  (i < pos_GPSvE+6))    fprintf(gpx->fout, col_GPSvel);
+                if ((i >= pos_SN)       &&  (i < pos_SN+5))       fprintf(gpx->fout, col_SN);
+                if ((i >= pos_Check+gpx->auxlen)  &&  (i < pos_Check+gpx->auxlen+2))  fprintf(gpx->fout, col_Check);
+                fprintf(gpx->fout, "%02x", byte);
+                fprintf(gpx->fout, col_FRTXT);
             }
             if (gpx->option.vbs) {
-                fprintf(stdout, " # "col_Check"%04x"col_FRTXT, cs2);
-                if (cs1 == cs2) fprintf(stdout, " "col_CSok"[OK]"col_TXT);
-                else            fprintf(stdout, " "col_CSno"[NO]"col_TXT);
+                fprintf(gpx->fout, " # "col_Check"%04x"col_FRTXT, cs2);
+                if (cs1 == cs2) fprintf(gpx->fout, " "col_CSok"[OK]"col_TXT);
+                else            fprintf(gpx->fout, " "col_CSno"[NO]"col_TXT);
             }
-            fprintf(stdout, ANSI_COLOR_RESET"\n");
+            fprintf(gpx->fout, ANSI_COLOR_RESET"\n");
         }
         else {
             for (i = 0; i < FRAME_LEN+gpx->auxlen; i++) {
                 byte = gpx->frame_bytes[i];
-                fprintf(stdout, "%02x", byte);
+                fprintf(gpx->fout, "%02x", byte);
             }
             if (gpx->option.vbs) {
-                fprintf(stdout, " # %04x", cs2);
-                if (cs1 == cs2) fprintf(stdout, " [OK]"); else fprintf(stdout, " [NO]");
+                fprintf(gpx->fout, " # %04x", cs2);
+                if (cs1 == cs2) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
             }
-            fprintf(stdout, "\n");
+            fprintf(gpx->fout, "\n");
         }
 
     }
@@ -872,20 +873,20 @@ static int print_frame(gpx_t *gpx, int pos, dsp_t *dsp) {
         if (gpx->option.vbs == 3) {
             for (i = 0; i < FRAME_LEN+gpx->auxlen; i++) {
                 byte = gpx->frame_bytes[i];
-                fprintf(stdout, "%02x", byte);
+                fprintf(gpx->fout, "%02x", byte);
             }
-            fprintf(stdout, "\n");
+            fprintf(gpx->fout, "\n");
         }
     }
     else {
         int ret = 0;
-        pthread_mutex_lock( dsp->thd.mutex );
-        fprintf(stdout, "<%d> ", dsp->thd.tn);
+        fprintf(gpx->fout, "<%d> ", dsp->thd.tn);
         ret = print_pos(gpx, cs1 == cs2);
-        if (ret==0) fprintf(stdout, "\n");
-        pthread_mutex_unlock( dsp->thd.mutex );
+        if (ret==0) fprintf(gpx->fout, "\n");
     }
 
+    out_frame(&dsp->thd);
+
     return (gpx->frame_bytes[0]<<8)|gpx->frame_bytes[1];
 }
 
@@ -950,6 +951,7 @@ void *thd_m10(void *targs) { // pcm_t *pcm, double xlt_fq
     // init dsp
     //
     dsp.fp = pcm->fp;
+    dsp.sio = pcm->sio;
     dsp.sr = pcm->sr;
     dsp.sr_base = pcm->sr_base;
     dsp.dectaps = pcm->dectaps;
@@ -974,6 +976,7 @@ void *thd_m10(void *targs) { // pcm_t *pcm, double xlt_fq
     dsp.lpIQ_bw = 24e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 10e3; // FM audio lowpass
     dsp.opt_dc = tharg->option_dc;
+    dsp.opt_sq = tharg->option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
@@ -984,8 +987,10 @@ void *thd_m10(void *targs) { // pcm_t *pcm, double xlt_fq
     k = init_buffers(&dsp);
     if ( k < 0 ) {
         fprintf(stderr, "error: init buffers\n");
+        free_buffers(&dsp); // detach from IQ ring
         return NULL;
     };
+    gpx.fout = dsp.thd.out;
 
 
     bitofs += shift;
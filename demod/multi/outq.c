@@ -0,0 +1,268 @@
+
+/*
+ *  rs_multi: decoder output queue, writer thread
+ *  compile:
+ *      gcc -c outq.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#define _GNU_SOURCE  // open_memstream
+
+#include <stdio.h>
+#include <time.h>
+#include <semaphore.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// decoder output (rs_multi): a decoder prints into its own memory stream
+// (thd.out, open_memstream), out_frame() queues what was written since the
+// last call. One writer thread drains the queue to the sinks, so a slow or
+// blocked output never stalls decoding or the IQ ring. Queue: intrusive MPSC,
+// push is one atomic exchange (no lock), only the writer pops; sem counts
+// messages. More than OUTQ_MAX pending: the frame is dropped, reported on
+// stderr at once (at most every OUTQ_REPT s) and counted at exit.
+// Sinks (--out, --out-json): stdout or a file, "%d" in the path: one file per
+// channel; JSON lines ('{', --json) to their own sink if set.
+#define OUTQ_MAX   4096
+#define OUTQ_REPT  1     // s
+
+typedef struct outmsg_s {
+    struct outmsg_s *_Atomic next;
+    int tn;
+    size_t len;
+    char buf[];
+} outmsg_t;
+
+typedef struct {
+    char *path;    // NULL: stdout
+    int per_ch;    // path with %d
+    FILE *fp;      // !per_ch
+    FILE **ch;     // per_ch: [tn]
+    int nch;
+} outsink_t;
+
+static struct {
+    outmsg_t *_Atomic head;  // last pushed
+    outmsg_t *tail;          // writer: next to pop
+    _Atomic int n;           // pending
+    _Atomic int stop;
+    atomic_ullong drop;
+    atomic_llong drop_t;     // last report (s)
+    ui64_t frames;
+    sem_t sem;
+    outsink_t txt;
+    outsink_t jsn;           // path NULL: JSON lines to txt
+    pthread_t tid;
+    int run;
+    thd_use_t use;
+} outq;
+static outmsg_t out_stub;
+
+static void outq_push(outmsg_t *m) {
+    outmsg_t *prev;
+    atomic_store_explicit(&m->next, NULL, memory_order_relaxed);
+    prev = atomic_exchange_explicit(&outq.head, m, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, m, memory_order_release);
+}
+
+// NULL: empty, or a push not yet linked
+static outmsg_t *outq_pop(void) {
+    outmsg_t *t = outq.tail;
+    outmsg_t *n = atomic_load_explicit(&t->next, memory_order_acquire);
+
+    if (t == &out_stub) {
+        if (n == NULL) return NULL;
+        outq.tail = t = n;
+        n = atomic_load_explicit(&t->next, memory_order_acquire);
+    }
+    if (n == NULL) {
+        if (t != atomic_load_explicit(&outq.head, memory_order_acquire)) return NULL;
+        outq_push(&out_stub);
+        n = atomic_load_explicit(&t->next, memory_order_acquire);
+        if (n == NULL) return NULL;
+    }
+    outq.tail = n;
+    return t;
+}
+
+static int sink_init(outsink_t *k, const char *path) {
+    memset(k, 0, sizeof(*k));
+    if (path == NULL) { k->fp = stdout; return 0; }
+    k->path = strdup(path);  if (k->path == NULL) return -1;
+    if (strstr(path, "%d")) { k->per_ch = 1; return 0; }
+    k->fp = fopen(path, "w");
+    if (k->fp == NULL) {
+        fprintf(stderr, "out: %s konnte nicht geoeffnet werden\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// writer thread: file of channel tn (opened at its first frame)
+static FILE *sink_fp(outsink_t *k, int tn) {
+    char name[1024];
+
+    if (!k->per_ch) return k->fp;
+    if (tn < 0) tn = 0;
+    if (tn >= k->nch) {
+        FILE **c = realloc(k->ch, (tn+1)*sizeof(FILE *));
+        if (c == NULL) return stdout;
+        memset(c + k->nch, 0, (tn+1-k->nch)*sizeof(FILE *));
+        k->ch = c;
+        k->nch = tn+1;
+    }
+    if (k->ch[tn] == NULL) {
+        snprintf(name, sizeof(name), k->path, tn);
+        k->ch[tn] = fopen(name, "w");
+        if (k->ch[tn] == NULL) {
+            fprintf(stderr, "<%d> out: %s konnte nicht geoeffnet werden, stdout\n", tn, name);
+            k->ch[tn] = stdout;
+        }
+    }
+    return k->ch[tn];
+}
+
+static void sink_flush(outsink_t *k) {
+    int i;
+    if (k->fp) fflush(k->fp);
+    for (i = 0; i < k->nch; i++) if (k->ch[i]) fflush(k->ch[i]);
+}
+
+static void sink_close(outsink_t *k) {
+    int i;
+    if (k->fp && k->fp != stdout) fclose(k->fp);
+    for (i = 0; i < k->nch; i++) if (k->ch[i] && k->ch[i] != stdout) fclose(k->ch[i]);
+    free(k->ch);
+    free(k->path);
+    memset(k, 0, sizeof(*k));
+}
+
+static void out_write(outmsg_t *m) {
+    char *p = m->buf, *e = m->buf + m->len, *l;
+
+    if (outq.jsn.path == NULL) {
+        fwrite(m->buf, 1, m->len, sink_fp(&outq.txt, m->tn));
+        return;
+    }
+    while (p < e) { // line by line: JSON -> jsn
+        l = memchr(p, '\n', e-p);
+        l = l ? l+1 : e;
+        fwrite(p, 1, l-p, sink_fp(*p == '{' ? &outq.jsn : &outq.txt, m->tn));
+        p = l;
+    }
+}
+
+static void *out_thread(void *arg) {
+    outmsg_t *m;
+    int spin;
+    (void)arg;
+
+    while (1) {
+        while (sem_wait(&outq.sem) != 0) ;
+        if (atomic_load(&outq.stop) && atomic_load(&outq.n) == 0) break;
+        spin = 0;
+        while ((m = outq_pop()) == NULL) iqr_wait(&spin);
+        out_write(m);
+        free(m);
+        outq.frames += 1;
+        if (atomic_fetch_sub(&outq.n, 1) == 1) {
+            sink_flush(&outq.txt);
+            sink_flush(&outq.jsn);
+        }
+    }
+    thd_usage(&outq.use);
+
+    return NULL;
+}
+
+// txt: --out (NULL: stdout), jsn: --out-json (NULL: with txt)
+int out_start(const char *txt, const char *jsn) {
+    memset(&outq, 0, sizeof(outq));
+    atomic_store(&outq.head, &out_stub);
+    outq.tail = &out_stub;
+    outq.use.cpu = -1;
+    if (sink_init(&outq.txt, txt) < 0) return -1;
+    if (jsn && sink_init(&outq.jsn, jsn) < 0) { sink_close(&outq.txt); return -1; }
+    if (sem_init(&outq.sem, 0, 0) != 0) return -1;
+    if (pthread_create(&outq.tid, NULL, out_thread, NULL) != 0) {
+        sem_destroy(&outq.sem);
+        return -1;
+    }
+    outq.run = 1;
+    return 0;
+}
+
+// after the decoders: drain, join
+void out_stop(void) {
+    ui64_t drop;
+    if (!outq.run) return;
+    atomic_store(&outq.stop, 1);
+    sem_post(&outq.sem);
+    pthread_join(outq.tid, NULL);
+    sem_destroy(&outq.sem);
+    sink_close(&outq.txt);
+    sink_close(&outq.jsn);
+    outq.run = 0;
+    drop = atomic_load(&outq.drop);
+    if (drop) fprintf(stderr, "out: %llu frames, %llu dropped\n", (unsigned long long)outq.frames, (unsigned long long)drop);
+    thd_report("out", &outq.use);
+}
+
+int out_open(thd_t *thd) {
+    thd->obuf = NULL;
+    thd->olen = 0;
+    thd->out = open_memstream(&thd->obuf, &thd->olen);
+    return thd->out ? 0 : -1;
+}
+
+// queue full (writer blocked) or no memory: frame lost, reported now (rate-limited)
+static void out_drop(thd_t *thd) {
+    struct timespec ts;
+    long long t;
+    ui64_t d;
+
+    atomic_fetch_sub(&outq.n, 1);
+    d = atomic_fetch_add(&outq.drop, 1) + 1;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    t = atomic_load_explicit(&outq.drop_t, memory_order_relaxed);
+    if (ts.tv_sec - t >= OUTQ_REPT) {
+        if (atomic_compare_exchange_strong(&outq.drop_t, &t, (long long)ts.tv_sec)) {
+            fprintf(stderr, "<%d> out: output blocked, %llu frames dropped\n", thd->tn, (unsigned long long)d);
+        }
+    }
+}
+
+void out_frame(thd_t *thd) {
+    outmsg_t *m = NULL;
+
+    if (thd->out == NULL) return;
+    fflush(thd->out);  // obuf, olen
+    if (thd->olen == 0) return;
+
+    if (!outq.run) fwrite(thd->obuf, 1, thd->olen, stdout);
+    else {
+        if (atomic_fetch_add(&outq.n, 1) < OUTQ_MAX) m = malloc(sizeof(outmsg_t) + thd->olen);
+        if (m) {
+            m->tn = thd->tn;
+            m->len = thd->olen;
+            memcpy(m->buf, thd->obuf, thd->olen);
+            outq_push(m);
+            sem_post(&outq.sem);
+        }
+        else out_drop(thd);
+    }
+    rewind(thd->out);
+}
+
+void out_close(thd_t *thd) {
+    if (thd->out == NULL) return;
+    out_frame(thd);
+    fclose(thd->out);
+    free(thd->obuf);
+    thd->out = NULL;
+    thd->obuf = NULL;
+}
@@ -0,0 +1,16 @@
+
+/*
+ *  rs_multi: decoder output queue, writer thread (outq.c)
+ *  included by demod_base.h
+ */
+
+#ifndef OUTQ_H
+#define OUTQ_H
+
+int out_start(const char *, const char *);  // --out, --out-json (NULL: stdout)
+void out_stop(void);
+int out_open(thd_t *);
+void out_frame(thd_t *);
+void out_close(thd_t *);
+
+#endif
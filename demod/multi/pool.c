@@ -0,0 +1,251 @@
+
+/*
+ *  rs_multi: worker pool, decoder tasks (coroutines)
+ *  compile:
+ *      gcc -c pool.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <assert.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// decoder tasks (rs_multi --workers): a channel runs as a coroutine (ucontext,
+// own stack) on a fixed pool of worker threads; the decoder code is unchanged,
+// its state stays on the task stack. A task yields after each ring block and
+// while waiting for input (f32read_cblock). Run queues per worker (FIFO, mutex);
+// an idle worker steals from the others. Pinned workers (cpu list) only steal
+// from workers on the same NUMA node, a task keeps its buffers node-local.
+// Task CPU time: thread CPU clock around each run.
+// A task can resume on another worker thread after any swapcontext (stealing):
+// decoder code must not keep thread-local state across a yield, i.e. no pointer
+// to errno or task_start, no value of a _Thread_local from before the yield.
+#ifdef MAP_STACK
+  #define TASK_MAP  MAP_STACK
+#else
+  #define TASK_MAP  0
+#endif
+#define TASK_STACK  (256*1024)  // + guard page (PROT_NONE) below: overflow faults, no heap damage
+
+struct task_s {
+    ucontext_t ctx;
+    ucontext_t *wctx;  // worker, to yield to
+    void *stack;       // mmap: guard page + TASK_STACK
+    size_t stlen;
+    void *(*fn)(void *);
+    void *arg;
+    int wait;          // yielded, no input
+    int fin;           // fn returned
+    double cpu;        // s, on the workers
+    _Atomic int done;
+    struct task_s *next;
+};
+
+typedef struct {
+    pthread_t tid;
+    pthread_mutex_t mtx;
+    task_t *head, *tail;  // run queue
+    int n;
+    ucontext_t ctx;
+    ui64_t runs, steals;
+    int node;             // NUMA node of the pinned cpu (-1: any)
+    thd_use_t use;
+} worker_t;
+
+static struct {
+    int nw;
+    worker_t *w;
+    _Atomic int done;
+    int rr;
+} pool;
+
+static _Thread_local task_t *task_start;
+
+static task_t *wq_pop(worker_t *w) {
+    task_t *t;
+    pthread_mutex_lock(&w->mtx);
+    t = w->head;
+    if (t) {
+        w->head = t->next;
+        if (w->head == NULL) w->tail = NULL;
+        w->n -= 1;
+    }
+    pthread_mutex_unlock(&w->mtx);
+    return t;
+}
+
+static void wq_push(worker_t *w, task_t *t) {
+    pthread_mutex_lock(&w->mtx);
+    t->next = NULL;
+    if (w->tail) w->tail->next = t;
+    else w->head = t;
+    w->tail = t;
+    w->n += 1;
+    pthread_mutex_unlock(&w->mtx);
+}
+
+static void task_main(void) {
+    task_t *t = task_start;  // set by the worker right before the first switch
+    assert(t != NULL && t->wctx != NULL && !t->fin);
+    t->fn(t->arg);
+    t->fin = 1;
+    setcontext(t->wctx); // not resumed
+}
+
+void task_yield(task_t *t, int wait) {
+    t->wait = wait;
+    swapcontext(&t->ctx, t->wctx);
+}
+
+static double cpu_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void *worker_thread(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    worker_t *v;
+    task_t *t;
+    int k, spin = 0, idle = 0;
+    double t0;
+
+    if (thd_place(w->use.cpu, 0) < 0) fprintf(stderr, "pool: cpu %d not set\n", w->use.cpu);
+
+    while (!atomic_load(&pool.done)) {
+        t = wq_pop(w);
+        for (k = 1; t == NULL && k < pool.nw; k++) {
+            v = &pool.w[(w - pool.w + k) % pool.nw];
+            if (v->node != w->node) continue;
+            t = wq_pop(v);
+            if (t) w->steals += 1;
+        }
+        if (t == NULL) {
+            iqr_wait(&spin);
+            continue;
+        }
+
+        t->wctx = &w->ctx;
+        task_start = t;
+        t0 = cpu_clock();
+        swapcontext(&w->ctx, &t->ctx);
+        t->cpu += cpu_clock() - t0;
+        w->runs += 1;
+
+        if (t->fin) {
+            atomic_store(&t->done, 1);
+            continue;
+        }
+        if (t->wait) { // all tasks of this queue waiting: back off
+            idle += 1;
+            if (idle > w->n) { iqr_wait(&spin); idle = 0; }
+        }
+        else {
+            idle = 0;
+            spin = 0;
+        }
+        wq_push(w, t);
+    }
+    thd_usage(&w->use);
+
+    return NULL;
+}
+
+// nw workers, worker k on cpu[k % ncpu] (ncpu = 0: not pinned)
+int pool_init(int nw, const int *cpu, int ncpu) {
+    int k;
+
+    memset(&pool, 0, sizeof(pool));
+    if (nw < 1) nw = 1;
+    pool.w = calloc(nw, sizeof(worker_t));  if (pool.w == NULL) return -1;
+    atomic_init(&pool.done, 0);
+    for (k = 0; k < nw; k++) {
+        pthread_mutex_init(&pool.w[k].mtx, NULL);
+        pool.w[k].use.cpu = ncpu > 0 ? cpu[k % ncpu] : -1;
+        pool.w[k].node = ncpu > 0 ? cpu_node(pool.w[k].use.cpu) : -1;
+    }
+    for (k = 0; k < nw; k++) {
+        if (pthread_create(&pool.w[k].tid, NULL, worker_thread, &pool.w[k]) != 0) break;
+    }
+    pool.nw = k;
+    if (k == 0) return -1;
+
+    return k;
+}
+
+void pool_free(void) {
+    int k;
+    ui64_t runs = 0, steals = 0;
+
+    char name[24];
+
+    atomic_store(&pool.done, 1);
+    for (k = 0; k < pool.nw; k++) {
+        pthread_join(pool.w[k].tid, NULL);
+        runs += pool.w[k].runs;
+        steals += pool.w[k].steals;
+        pthread_mutex_destroy(&pool.w[k].mtx);
+        snprintf(name, sizeof(name), "worker%d", k);
+        thd_report(name, &pool.w[k].use);
+    }
+    if (pool.nw) fprintf(stderr, "pool: %d workers, %llu runs, %llu steals\n",
+                         pool.nw, (unsigned long long)runs, (unsigned long long)steals);
+    if (pool.w) { free(pool.w); pool.w = NULL; }
+    pool.nw = 0;
+}
+
+task_t *task_new(void *(*fn)(void *), void *arg) {
+    task_t *volatile t;  // live across getcontext() (returns twice)
+    long pg;
+
+    t = calloc(1, sizeof(task_t));  if (t == NULL) return NULL;
+
+    pg = sysconf(_SC_PAGESIZE);
+    if (pg < 1) pg = 4096;
+    t->stlen = pg + TASK_STACK;
+    t->stack = mmap(NULL, t->stlen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | TASK_MAP, -1, 0);
+    if (t->stack == MAP_FAILED) {
+        free(t);
+        return NULL;
+    }
+    if (mprotect(t->stack, pg, PROT_NONE) < 0 || getcontext(&t->ctx) < 0) {
+        munmap(t->stack, t->stlen);
+        free(t);
+        return NULL;
+    }
+    t->ctx.uc_stack.ss_sp = (char *)t->stack + (t->stlen - TASK_STACK);
+    t->ctx.uc_stack.ss_size = TASK_STACK;
+    t->ctx.uc_link = NULL;
+    makecontext(&t->ctx, task_main, 0);
+    t->fn = fn;
+    t->arg = arg;
+    atomic_init(&t->done, 0);
+
+    return t;
+}
+
+// round robin; the workers balance by stealing
+void pool_run(task_t *t) {
+    wq_push(&pool.w[pool.rr % pool.nw], t);
+    pool.rr += 1;
+}
+
+// after the task has returned: CPU time of the task (s) on the workers
+double task_join(task_t *t) {
+    struct timespec ts = {0, 1000000}; // 1 ms
+    double cpu;
+    while (!atomic_load(&t->done)) nanosleep(&ts, NULL);
+    cpu = t->cpu;
+    munmap(t->stack, t->stlen);
+    free(t);
+    return cpu;
+}
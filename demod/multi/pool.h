@@ -0,0 +1,17 @@
+
+/*
+ *  rs_multi: worker pool, decoder tasks (pool.c)
+ *  included by demod_base.h
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+int pool_init(int, const int *, int);
+void pool_free(void);
+task_t *task_new(void *(*)(void *), void *);
+void pool_run(task_t *);
+void task_yield(task_t *, int);  // from the task: back to the worker
+double task_join(task_t *);  // CPU time of the task
+
+#endif
@@ -0,0 +1,282 @@
+
+/*
+ *  rs_multi: pre-trigger IQ recorder (SigMF)
+ *  compile:
+ *      gcc -c rec.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// pre-trigger recorder (rs_multi --rec): the last seconds of input IQ (dc removed,
+// cs16) in a ring, written by iq_ring_thread(). A decoder trigger (header found,
+// ECC failed) is the window [pos-pre, pos+post) of input samples; rec_trigger() is a
+// push into a bounded queue (no lock, no I/O; full: dropped). The recorder thread
+// writes a window when the producer has passed its end, overlapping windows in one
+// file: SigMF <dir>/rec_<sample>.sigmf-data/-meta, ci16_le, core:global_index =
+// input sample, one annotation per trigger. The ring is not locked: a window the
+// producer overwrites while it is copied is discarded (lost).
+#define RECQ_MAX   64
+#define REC_ANN    16      // triggers (annotations) per file
+#define REC_CHUNK  65536   // samples per copy/fwrite
+
+typedef struct {
+    _Atomic ui64_t seq;    // bounded MPSC queue (slot sequence)
+    ui64_t pos;            // input sample
+    int type;
+    int ch;
+    float fq;
+} rec_trig_t;
+
+typedef struct {
+    ui64_t s, e;           // input samples [s, e)
+    int n;
+    rec_trig_t t[REC_ANN];
+} rec_win_t;
+
+struct rec_s {
+    short *buf;            // nsmp IQ
+    ui64_t nsmp;
+    _Atomic ui64_t wpos;   // input samples written
+    _Atomic int stop;
+    ui64_t guard;          // producer writes up to one ring block ahead of wpos
+    ui64_t pre, post;
+    int sr;
+    int on;                // REC_HDR | REC_ECC
+    char dir[256];
+    rec_trig_t q[RECQ_MAX];
+    _Atomic ui64_t qtail;  // push (decoders)
+    ui64_t qhead;          // pop (recorder)
+    rec_win_t win[RECQ_MAX];
+    int nwin;
+    short *tmp;
+    ui64_t files, lost;
+    atomic_ullong drop;
+    pthread_t tid;
+};
+
+// producer: n input samples after dc removal
+void rec_put(rec_t *rc, const float complex *x, int n) {
+    ui64_t w = atomic_load_explicit(&rc->wpos, memory_order_relaxed);
+    const float *f = (const float *)x;
+    short *p;
+    float v;
+    int k, l;
+
+    while (n > 0) {
+        l = rc->nsmp - w % rc->nsmp;
+        if (l > n) l = n;
+        p = rc->buf + 2*(w % rc->nsmp);
+        for (k = 0; k < 2*l; k++) {
+            v = f[k] * 32767.0f;
+            if (v > 32767.0f) v = 32767.0f;
+            if (v < -32768.0f) v = -32768.0f;
+            p[k] = (short)v;
+        }
+        f += 2*l;
+        w += l;
+        n -= l;
+    }
+    atomic_store_explicit(&rc->wpos, w, memory_order_release);
+}
+
+// input sample at the read position of the channel
+static ui64_t ring_pos(dsp_t *dsp) {
+    iqring_t *r = &dsp->thd.st->ring;
+    int d = r->chlen ? r->blen / r->chlen : 1;
+    return dsp->thd.rseq * (ui64_t)r->blen + (ui64_t)dsp->thd.rpos * d;
+}
+
+// decoder: REC_HDR (find_header), REC_ECC (ECC failed)
+void rec_trigger(dsp_t *dsp, int type) {
+    rec_t *rc = dsp->thd.st ? dsp->thd.st->rec : NULL;
+    rec_trig_t *t;
+    ui64_t pos, seq;
+
+    if (rc == NULL || (rc->on & type) == 0) return;
+
+    pos = atomic_load_explicit(&rc->qtail, memory_order_relaxed);
+    while (1) {
+        t = &rc->q[pos % RECQ_MAX];
+        seq = atomic_load_explicit(&t->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(&rc->qtail, &pos, pos+1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        }
+        else if ((long long)(seq - pos) < 0) { // full
+            atomic_fetch_add(&rc->drop, 1);
+            return;
+        }
+        else pos = atomic_load_explicit(&rc->qtail, memory_order_relaxed);
+    }
+    t->pos = ring_pos(dsp);
+    t->type = type;
+    t->ch = dsp->thd.tn;
+    t->fq = -dsp->thd.xlt_fq;  // channel fq (--rs41 <fq>)
+    atomic_store_explicit(&t->seq, pos+1, memory_order_release);
+}
+
+static int rec_pop(rec_t *rc, rec_trig_t *out) {
+    rec_trig_t *t = &rc->q[rc->qhead % RECQ_MAX];
+    if (atomic_load_explicit(&t->seq, memory_order_acquire) != rc->qhead+1) return 0;
+    out->pos = t->pos;
+    out->type = t->type;
+    out->ch = t->ch;
+    out->fq = t->fq;
+    atomic_store_explicit(&t->seq, rc->qhead + RECQ_MAX, memory_order_release);
+    rc->qhead += 1;
+    return 1;
+}
+
+// trigger -> window; overlaps the last window: same file (up to ring length, REC_ANN)
+static void rec_add(rec_t *rc, rec_trig_t *t) {
+    rec_win_t *wn = rc->nwin > 0 ? &rc->win[rc->nwin-1] : NULL;
+    ui64_t s = t->pos > rc->pre ? t->pos - rc->pre : 0;
+    ui64_t e = t->pos + rc->post;
+
+    if (wn && s <= wn->e && wn->n < REC_ANN && e - wn->s <= rc->nsmp - 2*rc->guard) {
+        if (e > wn->e) wn->e = e;
+    }
+    else {
+        if (rc->nwin == RECQ_MAX) { atomic_fetch_add(&rc->drop, 1); return; }
+        wn = &rc->win[rc->nwin++];
+        wn->s = s;
+        wn->e = e;
+        wn->n = 0;
+    }
+    wn->t[wn->n++] = *t;
+}
+
+static int rec_write(rec_t *rc, rec_win_t *wn) {
+    char name[320];
+    FILE *fd, *fm;
+    ui64_t a, w;
+    int l, k;
+
+    w = atomic_load_explicit(&rc->wpos, memory_order_acquire);
+    if (wn->e > w) wn->e = w;  // EOF
+    if (wn->s + rc->nsmp < w + rc->guard) wn->s = w + rc->guard - rc->nsmp;  // already overwritten
+    if (wn->s >= wn->e) return -1;
+
+    snprintf(name, sizeof(name), "%s/rec_%llu.sigmf-data", rc->dir, (unsigned long long)wn->s);
+    fd = fopen(name, "wb");
+    if (fd == NULL) return -1;
+    for (a = wn->s; a < wn->e; a += l) {
+        l = wn->e - a;
+        if (l > REC_CHUNK) l = REC_CHUNK;
+        if (l > (int)(rc->nsmp - a % rc->nsmp)) l = rc->nsmp - a % rc->nsmp;
+        memcpy(rc->tmp, rc->buf + 2*(a % rc->nsmp), 4*(size_t)l);
+        atomic_thread_fence(memory_order_acquire);
+        w = atomic_load_explicit(&rc->wpos, memory_order_relaxed);
+        if (a + rc->nsmp < w + rc->guard) break;  // overwritten while copied
+        if (fwrite(rc->tmp, 4, l, fd) != (size_t)l) break;
+    }
+    fclose(fd);
+    if (a < wn->e) {
+        remove(name);
+        return -1;
+    }
+
+    snprintf(name, sizeof(name), "%s/rec_%llu.sigmf-meta", rc->dir, (unsigned long long)wn->s);
+    fm = fopen(name, "w");
+    if (fm == NULL) return -1;
+    fprintf(fm, "{\n    \"global\": {\n");
+    fprintf(fm, "        \"core:datatype\": \"ci16_le\",\n");
+    fprintf(fm, "        \"core:sample_rate\": %d,\n", rc->sr);
+    fprintf(fm, "        \"core:version\": \"1.0.0\",\n");
+    fprintf(fm, "        \"core:recorder\": \"rs_multi --rec\"\n    },\n");
+    fprintf(fm, "    \"captures\": [\n        { \"core:sample_start\": 0, \"core:global_index\": %llu }\n    ],\n",
+            (unsigned long long)wn->s);
+    fprintf(fm, "    \"annotations\": [\n");
+    for (k = 0; k < wn->n; k++) {
+        ui64_t p = wn->t[k].pos < wn->s ? 0 : wn->t[k].pos - wn->s;
+        fprintf(fm, "        { \"core:sample_start\": %llu, \"core:sample_count\": 1, "
+                    "\"core:label\": \"%s\", \"core:comment\": \"channel %d, fq %.5f, input sample %llu\" }%s\n",
+                (unsigned long long)p, wn->t[k].type == REC_ECC ? "ecc" : "hdr",
+                wn->t[k].ch, wn->t[k].fq, (unsigned long long)wn->t[k].pos, k < wn->n-1 ? "," : "");
+    }
+    fprintf(fm, "    ]\n}\n");
+    fclose(fm);
+
+    return 0;
+}
+
+static void *rec_thread(void *arg) {
+    rec_t *rc = arg;
+    rec_trig_t t;
+    ui64_t w;
+    int stop, k, j;
+
+    while (1) {
+        stop = atomic_load_explicit(&rc->stop, memory_order_acquire);
+        while (rec_pop(rc, &t)) rec_add(rc, &t);
+
+        w = atomic_load_explicit(&rc->wpos, memory_order_acquire);
+        for (k = 0; k < rc->nwin && (stop || rc->win[k].e <= w); k++) {
+            if (rec_write(rc, &rc->win[k]) == 0) rc->files += 1;
+            else rc->lost += 1;
+        }
+        for (j = 0; k+j < rc->nwin; j++) rc->win[j] = rc->win[k+j];
+        rc->nwin -= k;
+
+        if (stop) break;
+        {
+            struct timespec ts = {0, 20000000}; // 20 ms
+            nanosleep(&ts, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// after stream_init(); sec: ring length, pre/post: window around a trigger
+int rec_init(stream_t *st, float sec, float pre, float post, int on, const char *dir) {
+    rec_t *rc;
+    int k;
+
+    if (sec <= 0 || pre < 0 || post < 0 || pre + post >= sec) return -1;
+    rc = calloc(1, sizeof(rec_t));  if (rc == NULL) return -1;
+    rc->sr = st->pcm.sr_base;
+    rc->nsmp = (ui64_t)(sec * rc->sr);
+    rc->pre = (ui64_t)(pre * rc->sr);
+    rc->post = (ui64_t)(post * rc->sr);
+    rc->guard = st->ring.blen;
+    rc->on = on;
+    snprintf(rc->dir, sizeof(rc->dir), "%s", dir ? dir : ".");
+    if (rc->nsmp < rc->pre + rc->post + 2*rc->guard) { free(rc); return -1; }
+    rc->buf = calloc(2*rc->nsmp, sizeof(short));  if (rc->buf == NULL) { free(rc); return -1; }
+    rc->tmp = calloc(2*REC_CHUNK, sizeof(short));  if (rc->tmp == NULL) { free(rc->buf); free(rc); return -1; }
+    for (k = 0; k < RECQ_MAX; k++) atomic_init(&rc->q[k].seq, k);
+    atomic_init(&rc->qtail, 0);
+    atomic_init(&rc->wpos, 0);
+    atomic_init(&rc->stop, 0);
+    atomic_init(&rc->drop, 0);
+
+    if (pthread_create(&rc->tid, NULL, rec_thread, rc) != 0) {
+        free(rc->tmp); free(rc->buf); free(rc);
+        return -1;
+    }
+    st->rec = rc;
+    return 0;
+}
+
+// after the channels: remaining windows are written (up to EOF)
+void rec_free(stream_t *st) {
+    rec_t *rc = st->rec;
+    if (rc == NULL) return;
+    atomic_store_explicit(&rc->stop, 1, memory_order_release);
+    pthread_join(rc->tid, NULL);
+    fprintf(stderr, "rec: %llu files, %llu lost, %llu triggers dropped\n",
+            (unsigned long long)rc->files, (unsigned long long)rc->lost, (unsigned long long)atomic_load(&rc->drop));
+    free(rc->tmp);
+    free(rc->buf);
+    free(rc);
+    st->rec = NULL;
+}
@@ -0,0 +1,18 @@
+
+/*
+ *  rs_multi: pre-trigger IQ recorder (rec.c)
+ *  included by demod_base.h
+ */
+
+#ifndef REC_H
+#define REC_H
+
+#define REC_HDR  1  // rec_trigger(): header found
+#define REC_ECC  2  //                ECC failed
+
+int rec_init(stream_t *, float, float, float, int, const char *);
+void rec_put(rec_t *, const float complex *, int);  // iq_ring_thread()
+void rec_trigger(dsp_t *, int);
+void rec_free(stream_t *);
+
+#endif
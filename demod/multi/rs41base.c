@@ -101,6 +101,7 @@ typedef struct {
     char xdata[XDATA_LEN+16]; // xdata: aux_str1#aux_str2 ...
     option_t option;
     RS_t RS;
+    FILE *fout;  // thd.out
 } gpx_t;
 
 
@@ -575,34 +576,34 @@ static int get_PTU(gpx_t *gpx, int ofs, int pck) {
 
         if (gpx->option.vbs == 4 && (gpx->crc & (crc_PTU | crc_GPS3))==0)
         {
-            printf("  h: %8.2f   # ", gpx->alt); // crc_GPS3 ?
+            fprintf(gpx->fout, "  h: %8.2f   # ", gpx->alt); // crc_GPS3 ?
 
-            printf("1: %8d %8d %8d", meas[0], meas[1], meas[2]);
-            printf("   #   ");
-            printf("2: %8d %8d %8d", meas[3], meas[4], meas[5]);
-            printf("   #   ");
-            printf("3: %8d %8d %8d", meas[6], meas[7], meas[8]);
-            printf("   #   ");
+            fprintf(gpx->fout, "1: %8d %8d %8d", meas[0], meas[1], meas[2]);
+            fprintf(gpx->fout, "   #   ");
+            fprintf(gpx->fout, "2: %8d %8d %8d", meas[3], meas[4], meas[5]);
+            fprintf(gpx->fout, "   #   ");
+            fprintf(gpx->fout, "3: %8d %8d %8d", meas[6], meas[7], meas[8]);
+            fprintf(gpx->fout, "   #   ");
 
             //if (Tc > -273.0 && RH > -0.5)
             {
-                printf("  ");
-                printf(" Tc:%.2f ", Tc);
-                printf(" RH:%.1f ", RH);
-                printf(" TH:%.2f ", TH);
+                fprintf(gpx->fout, "  ");
+                fprintf(gpx->fout, " Tc:%.2f ", Tc);
+                fprintf(gpx->fout, " RH:%.1f ", RH);
+                fprintf(gpx->fout, " TH:%.2f ", TH);
             }
-            printf("\n");
+            fprintf(gpx->fout, "\n");
 
             //if (gpx->alt > -400.0)
             {
-                printf("    %9.2f ; %6.1f ; %6.1f ", gpx->alt, gpx->ptu_Rf1, gpx->ptu_Rf2);
-                printf("; %10.6f ; %10.6f ; %10.6f ", gpx->ptu_calT1[0], gpx->ptu_calT1[1], gpx->ptu_calT1[2]);
+                fprintf(gpx->fout, "    %9.2f ; %6.1f ; %6.1f ", gpx->alt, gpx->ptu_Rf1, gpx->ptu_Rf2);
+                fprintf(gpx->fout, "; %10.6f ; %10.6f ; %10.6f ", gpx->ptu_calT1[0], gpx->ptu_calT1[1], gpx->ptu_calT1[2]);
                 //printf(";  %8d ; %8d ; %8d ", meas[0], meas[1], meas[2]);
-                printf("; %10.6f ; %10.6f ", gpx->ptu_calH[0], gpx->ptu_calH[1]);
+                fprintf(gpx->fout, "; %10.6f ; %10.6f ", gpx->ptu_calH[0], gpx->ptu_calH[1]);
                 //printf(";  %8d ; %8d ; %8d ", meas[3], meas[4], meas[5]);
-                printf("; %10.6f ; %10.6f ; %10.6f ", gpx->ptu_calT2[0], gpx->ptu_calT2[1], gpx->ptu_calT2[2]);
+                fprintf(gpx->fout, "; %10.6f ; %10.6f ; %10.6f ", gpx->ptu_calT2[0], gpx->ptu_calT2[1], gpx->ptu_calT2[2]);
                 //printf(";  %8d ; %8d ; %8d" , meas[6], meas[7], meas[8]);
-                printf("\n");
+                fprintf(gpx->fout, "\n");
             }
         }
 
@@ -834,10 +835,10 @@ static int get_Aux(gpx_t *gpx, int out, int pos) {
 
             if ( auxcrc == crc16(gpx, pos+2, auxlen) ) {
                 if (count7E == 0) {
-                    if (out) fprintf(stdout, "\n # xdata = ");
+                    if (out) fprintf(gpx->fout, "\n # xdata = ");
                 }
                 else {
-                    if (out) fprintf(stdout, " # ");
+                    if (out) fprintf(gpx->fout, " # ");
                     gpx->xdata[n++] = '#'; // aux separator
                 }
 
@@ -845,7 +846,7 @@ static int get_Aux(gpx_t *gpx, int out, int pos) {
                 for (i = 1; i < auxlen; i++) {
                     ui8_t c = gpx->frame[pos+2+i]; // (char) or better < 0x7F
                     if (c > 0x1E && c < 0x7F) {      // ASCII-only
-                        if (out) fprintf(stdout, "%c", c);
+                        if (out) fprintf(gpx->fout, "%c", c);
                         gpx->xdata[n++] = c;
                     }
                 }
@@ -881,18 +882,18 @@ static int get_Calconf(gpx_t *gpx, int out, int ofs) {
     err = check_CRC(gpx, pos_FRAME+ofs, pck_FRAME);
 
     if (out && gpx->option.vbs == 3) {
-        fprintf(stdout, "\n");  // fflush(stdout);
-        fprintf(stdout, "[%5d] ", gpx->frnr);
-        fprintf(stdout, " 0x%02x: ", calfr);
+        fprintf(gpx->fout, "\n");  // fflush(stdout);
+        fprintf(gpx->fout, "[%5d] ", gpx->frnr);
+        fprintf(gpx->fout, " 0x%02x: ", calfr);
         for (i = 0; i < 16; i++) {
             byte = gpx->frame[pos_CalData+ofs+1+i];
-            fprintf(stdout, "%02x ", byte);
+            fprintf(gpx->fout, "%02x ", byte);
         }
 /*
-        if (err == 0) fprintf(stdout, "[OK]");
-        else          fprintf(stdout, "[NO]");
+        if (err == 0) fprintf(gpx->fout, "[OK]");
+        else          fprintf(gpx->fout, "[NO]");
 */
-        fprintf(stdout, " ");
+        fprintf(gpx->fout, " ");
     }
 
     if (err == 0)
@@ -903,21 +904,21 @@ static int get_Calconf(gpx_t *gpx, int out, int ofs) {
             byte = gpx->frame[pos_Calfreq+ofs+1];
             f1 = 40 * byte;
             freq = 400000 + f1+f0; // kHz;
-            if (out && gpx->option.vbs) fprintf(stdout, ": fq %d ", freq);
+            if (out && gpx->option.vbs) fprintf(gpx->fout, ": fq %d ", freq);
             gpx->freq = freq;
         }
 
         if (calfr == 0x01) {
             fw = gpx->frame[pos_CalData+ofs+6] | (gpx->frame[pos_CalData+ofs+7]<<8);
-            if (out && gpx->option.vbs) fprintf(stdout, ": fw 0x%04x ", fw);
+            if (out && gpx->option.vbs) fprintf(gpx->fout, ": fw 0x%04x ", fw);
             gpx->conf_fw = fw;
         }
 
         if (calfr == 0x02) {    // 0x5E, 0x5A..0x5B
             ui8_t  bk = gpx->frame[pos_Calburst+ofs];  // fw >= 0x4ef5, burst-killtimer in 0x31 relevant
             ui16_t kt = gpx->frame[pos_CalData+ofs+8] + (gpx->frame[pos_CalData+ofs+9] << 8); // killtimer (short?)
-            if (out && gpx->option.vbs) fprintf(stdout, ": BK %02X ", bk);
-            if (out && gpx->option.vbs && kt != 0xFFFF ) fprintf(stdout, ": kt %.1fmin ", kt/60.0);
+            if (out && gpx->option.vbs) fprintf(gpx->fout, ": BK %02X ", bk);
+            if (out && gpx->option.vbs && kt != 0xFFFF ) fprintf(gpx->fout, ": kt %.1fmin ", kt/60.0);
             gpx->conf_bk = bk;
             gpx->conf_kt = kt;
         }
@@ -927,7 +928,7 @@ static int get_Calconf(gpx_t *gpx, int out, int ofs) {
             // fw >= 0x4ef5: default=[88 77]=0x7788sec=510min
             if (out  && bt != 0x0000 &&
                     (gpx->option.vbs == 3  ||  gpx->option.vbs && gpx->conf_bk)
-               ) fprintf(stdout, ": bt %.1fmin ", bt/60.0);
+               ) fprintf(gpx->fout, ": bt %.1fmin ", bt/60.0);
             gpx->conf_bt = bt;
         }
 
@@ -935,7 +936,7 @@ static int get_Calconf(gpx_t *gpx, int out, int ofs) {
             ui16_t cd = gpx->frame[pos_CalData+ofs+1] + (gpx->frame[pos_CalData+ofs+2] << 8); // countdown (bt or kt) (short?)
             if (out && cd != 0xFFFF &&
                     (gpx->option.vbs == 3  ||  gpx->option.vbs && (gpx->conf_bk || gpx->conf_kt != 0xFFFF))
-               ) fprintf(stdout, ": cd %.1fmin ", cd/60.0);
+               ) fprintf(gpx->fout, ": cd %.1fmin ", cd/60.0);
             gpx->conf_cd = cd;  // (short/i16_t) ?
         }
 
@@ -946,16 +947,16 @@ static int get_Calconf(gpx_t *gpx, int out, int ofs) {
                 if ((byte >= 0x20) && (byte < 0x7F)) sondetyp[i] = byte;
                 else if (byte == 0x00) sondetyp[i] = '\0';
             }
-            if (out && gpx->option.vbs) fprintf(stdout, ": %s ", sondetyp);
+            if (out && gpx->option.vbs) fprintf(gpx->fout, ": %s ", sondetyp);
             strcpy(gpx->rstyp, sondetyp);
             if (out && gpx->option.vbs == 3) { // Stationsdruck QFE
                 float qfe1 = 0.0, qfe2 = 0.0;
                 memcpy(&qfe1, gpx->frame+pos_CalData+1, 4);
                 memcpy(&qfe2, gpx->frame+pos_CalData+5, 4);
                 if (qfe1 > 0.0 || qfe2 > 0.0) {
-                    fprintf(stdout, " ");
-                    if (qfe1 > 0.0) fprintf(stdout, "QFE1:%.1fhPa ", qfe1);
-                    if (qfe2 > 0.0) fprintf(stdout, "QFE2:%.1fhPa ", qfe2);
+                    fprintf(gpx->fout, " ");
+                    if (qfe1 > 0.0) fprintf(gpx->fout, "QFE1:%.1fhPa ", qfe1);
+                    if (qfe2 > 0.0) fprintf(gpx->fout, "QFE2:%.1fhPa ", qfe2);
                 }
             }
         }
@@ -1062,46 +1063,46 @@ static int rs41_ecc(gpx_t *gpx, int frmlen) {
 /* ------------------------------------------------------------------------------------ */
 
 static int prn_frm(gpx_t *gpx) {
-    fprintf(stdout, "[%5d] ", gpx->frnr);
-    fprintf(stdout, "(%s) ", gpx->id);
-    if (gpx->option.vbs == 3) fprintf(stdout, "(%.1f V) ", gpx->batt);
-    fprintf(stdout, " ");
+    fprintf(gpx->fout, "[%5d] ", gpx->frnr);
+    fprintf(gpx->fout, "(%s) ", gpx->id);
+    if (gpx->option.vbs == 3) fprintf(gpx->fout, "(%.1f V) ", gpx->batt);
+    fprintf(gpx->fout, " ");
     return 0;
 }
 
 static int prn_ptu(gpx_t *gpx) {
-    fprintf(stdout, " ");
-    if (gpx->T > -273.0) fprintf(stdout, " T=%.1fC ", gpx->T);
-    if (gpx->RH > -0.5)  fprintf(stdout, " RH=%.0f%% ", gpx->RH);
+    fprintf(gpx->fout, " ");
+    if (gpx->T > -273.0) fprintf(gpx->fout, " T=%.1fC ", gpx->T);
+    if (gpx->RH > -0.5)  fprintf(gpx->fout, " RH=%.0f%% ", gpx->RH);
     return 0;
 }
 
 static int prn_gpstime(gpx_t *gpx) {
     Gps2Date(gpx);
-    fprintf(stdout, "%s ", weekday[gpx->wday]);
-    fprintf(stdout, "%04d-%02d-%02d %02d:%02d:%06.3f",
+    fprintf(gpx->fout, "%s ", weekday[gpx->wday]);
+    fprintf(gpx->fout, "%04d-%02d-%02d %02d:%02d:%06.3f",
             gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek);
-    if (gpx->option.vbs == 3) fprintf(stdout, " (W %d)", gpx->week);
-    fprintf(stdout, " ");
+    if (gpx->option.vbs == 3) fprintf(gpx->fout, " (W %d)", gpx->week);
+    fprintf(gpx->fout, " ");
     return 0;
 }
 
 static int prn_gpspos(gpx_t *gpx) {
     //fprintf(stdout, " ");
-    fprintf(stdout, " lat: %.5f ", gpx->lat);
-    fprintf(stdout, " lon: %.5f ", gpx->lon);
-    fprintf(stdout, " alt: %.2f ", gpx->alt);
-    fprintf(stdout, "  vH: %4.1f  D: %5.1f  vV: %3.1f ", gpx->vH, gpx->vD, gpx->vV);
-    if (gpx->option.vbs == 3) fprintf(stdout, " sats: %02d ", gpx->numSV);
+    fprintf(gpx->fout, " lat: %.5f ", gpx->lat);
+    fprintf(gpx->fout, " lon: %.5f ", gpx->lon);
+    fprintf(gpx->fout, " alt: %.2f ", gpx->alt);
+    fprintf(gpx->fout, "  vH: %4.1f  D: %5.1f  vV: %3.1f ", gpx->vH, gpx->vD, gpx->vV);
+    if (gpx->option.vbs == 3) fprintf(gpx->fout, " sats: %02d ", gpx->numSV);
     return 0;
 }
 
 static int prn_sat1(gpx_t *gpx, int ofs) {
 
-    fprintf(stdout, "\n");
+    fprintf(gpx->fout, "\n");
 
-    fprintf(stdout, "iTOW: 0x%08X", u4(gpx->frame+pos_GPSiTOW+ofs));
-    fprintf(stdout, "  week: 0x%04X", u2(gpx->frame+pos_GPSweek+ofs));
+    fprintf(gpx->fout, "iTOW: 0x%08X", u4(gpx->frame+pos_GPSiTOW+ofs));
+    fprintf(gpx->fout, "  week: 0x%04X", u2(gpx->frame+pos_GPSweek+ofs));
 
     return 0;
 }
@@ -1112,23 +1113,23 @@ static int prn_sat2(gpx_t *gpx, int ofs) {
     int sv;
     ui32_t minPR;
 
-    fprintf(stdout, "\n");
+    fprintf(gpx->fout, "\n");
 
     minPR = u4(gpx->frame+pos_minPR+ofs);
-    fprintf(stdout, "minPR: %d", minPR);
-    fprintf(stdout, "\n");
+    fprintf(gpx->fout, "minPR: %d", minPR);
+    fprintf(gpx->fout, "\n");
 
     for (i = 0; i < 12; i++) {
         n = i*7;
         sv = gpx->frame[pos_satsN+ofs+2*i];
         if (sv == 0xFF) break;
-        fprintf(stdout, "    SV: %2d ", sv);
+        fprintf(gpx->fout, "    SV: %2d ", sv);
         //fprintf(stdout, " (%02x) ", gpx->frame[pos_satsN+2*i+1]);
-        fprintf(stdout, "#  ");
-        fprintf(stdout, "prMes: %.1f", u4(gpx->frame+pos_dataSats+ofs+n)/100.0 + minPR);
-        fprintf(stdout, "  ");
-        fprintf(stdout, "doMes: %.1f", -i3(gpx->frame+pos_dataSats+ofs+n+4)/100.0*L1/c);
-        fprintf(stdout, "\n");
+        fprintf(gpx->fout, "#  ");
+        fprintf(gpx->fout, "prMes: %.1f", u4(gpx->frame+pos_dataSats+ofs+n)/100.0 + minPR);
+        fprintf(gpx->fout, "  ");
+        fprintf(gpx->fout, "doMes: %.1f", -i3(gpx->frame+pos_dataSats+ofs+n+4)/100.0*L1/c);
+        fprintf(gpx->fout, "\n");
     }
 
     return 0;
@@ -1137,13 +1138,13 @@ static int prn_sat3(gpx_t *gpx, int ofs) {
     int numSV;
     double pDOP, sAcc;
 
-    fprintf(stdout, "\n");
+    fprintf(gpx->fout, "\n");
 
-    fprintf(stdout, "ECEF-POS: (%d,%d,%d)\n",
+    fprintf(gpx->fout, "ECEF-POS: (%d,%d,%d)\n",
                      (i32_t)u4(gpx->frame+pos_GPSecefX+ofs),
                      (i32_t)u4(gpx->frame+pos_GPSecefY+ofs),
                      (i32_t)u4(gpx->frame+pos_GPSecefZ+ofs));
-    fprintf(stdout, "ECEF-VEL: (%d,%d,%d)\n",
+    fprintf(gpx->fout, "ECEF-VEL: (%d,%d,%d)\n",
                      (i16_t)u2(gpx->frame+pos_GPSecefV+ofs+0),
                      (i16_t)u2(gpx->frame+pos_GPSecefV+ofs+2),
                      (i16_t)u2(gpx->frame+pos_GPSecefV+ofs+4));
@@ -1151,21 +1152,21 @@ static int prn_sat3(gpx_t *gpx, int ofs) {
     numSV = gpx->frame[pos_numSats+ofs];
     sAcc = gpx->frame[pos_sAcc+ofs]/10.0; if (gpx->frame[pos_sAcc+ofs] == 0xFF) sAcc = -1.0;
     pDOP = gpx->frame[pos_pDOP+ofs]/10.0; if (gpx->frame[pos_pDOP+ofs] == 0xFF) pDOP = -1.0;
-    fprintf(stdout, "numSatsFix: %2d  sAcc: %.1f  pDOP: %.1f\n", numSV, sAcc, pDOP);
+    fprintf(gpx->fout, "numSatsFix: %2d  sAcc: %.1f  pDOP: %.1f\n", numSV, sAcc, pDOP);
 
 /*
-    fprintf(stdout, "CRC: ");
-    fprintf(stdout, " %04X", pck_GPS1);
-    if (check_CRC(gpx, pos_GPS1+ofs, pck_GPS1)==0) fprintf(stdout, "[OK]"); else fprintf(stdout, "[NO]");
+    fprintf(gpx->fout, "CRC: ");
+    fprintf(gpx->fout, " %04X", pck_GPS1);
+    if (check_CRC(gpx, pos_GPS1+ofs, pck_GPS1)==0) fprintf(gpx->fout, "[OK]"); else fprintf(gpx->fout, "[NO]");
     //fprintf(stdout, "[%+d]", check_CRC(gpx, pos_GPS1, pck_GPS1));
-    fprintf(stdout, " %04X", pck_GPS2);
-    if (check_CRC(gpx, pos_GPS2+ofs, pck_GPS2)==0) fprintf(stdout, "[OK]"); else fprintf(stdout, "[NO]");
+    fprintf(gpx->fout, " %04X", pck_GPS2);
+    if (check_CRC(gpx, pos_GPS2+ofs, pck_GPS2)==0) fprintf(gpx->fout, "[OK]"); else fprintf(gpx->fout, "[NO]");
     //fprintf(stdout, "[%+d]", check_CRC(gpx, pos_GPS2, pck_GPS2));
-    fprintf(stdout, " %04X", pck_GPS3);
-    if (check_CRC(gpx, pos_GPS3+ofs, pck_GPS3)==0) fprintf(stdout, "[OK]"); else fprintf(stdout, "[NO]");
+    fprintf(gpx->fout, " %04X", pck_GPS3);
+    if (check_CRC(gpx, pos_GPS3+ofs, pck_GPS3)==0) fprintf(gpx->fout, "[OK]"); else fprintf(gpx->fout, "[NO]");
     //fprintf(stdout, "[%+d]", check_CRC(gpx, pos_GPS3, pck_GPS3));
 
-    fprintf(stdout, "\n");
+    fprintf(gpx->fout, "\n");
 */
     return 0;
 }
@@ -1273,7 +1274,7 @@ static int print_position(gpx_t *gpx, int ec) {
 
                     case pck_SGM_CRYPT: // 0x80A7
                             encrypted = 1;
-                            if (out) fprintf(stdout, " [%04X] (RS41-SGM) ", pck_SGM_CRYPT);
+                            if (out) fprintf(gpx->fout, " [%04X] (RS41-SGM) ", pck_SGM_CRYPT);
                             break;
 
                     default:
@@ -1286,13 +1287,13 @@ static int print_position(gpx_t *gpx, int ec) {
                             }
 
                             if (blk != 0x76 && blk != 0x7E) {
-                                if (out) fprintf(stdout, " [%04X] ", pck);
+                                if (out) fprintf(gpx->fout, " [%04X] ", pck);
                                 unexp = 1;
                             }
                 }
             }
             else { // CRC-ERROR (ECC-OK)
-                fprintf(stdout, " [ERROR]\n");
+                fprintf(gpx->fout, " [ERROR]\n");
                 break;
             }
 
@@ -1306,7 +1307,7 @@ static int print_position(gpx_t *gpx, int ec) {
 
                 get_Calconf(gpx, out, ofs_cal);
 
-                if (out && ec > 0 && pos > flen-1) fprintf(stdout, " (%d)", ec);
+                if (out && ec > 0 && pos > flen-1) fprintf(gpx->fout, " (%d)", ec);
 
                 if (pos_aux) gpx->aux = get_Aux(gpx, out && gpx->option.vbs > 1, pos_aux);
 
@@ -1314,34 +1315,34 @@ static int print_position(gpx_t *gpx, int ec) {
                 frm_end = FRAME_LEN-2;
 
 
-                if (out || sat) fprintf(stdout, "\n");
+                if (out || sat) fprintf(gpx->fout, "\n");
 
 
                 if (gpx->option.jsn) {
                     // Print out telemetry data as JSON
                     if ((!err && !err1 && !err3) || (!err && encrypted)) { // frame-nb/id && gps-time && gps-position  (crc-)ok; 3 CRCs, RS not needed
                         // eigentlich GPS, d.h. UTC = GPS - 18sec (ab 1.1.2017)
-                        fprintf(stdout, "{ \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d, \"bt\": %d, \"batt\": %.2f",
+                        fprintf(gpx->fout, "{ \"frame\": %d, \"id\": \"%s\", \"datetime\": \"%04d-%02d-%02dT%02d:%02d:%06.3fZ\", \"lat\": %.5f, \"lon\": %.5f, \"alt\": %.5f, \"vel_h\": %.5f, \"heading\": %.5f, \"vel_v\": %.5f, \"sats\": %d, \"bt\": %d, \"batt\": %.2f",
                                        gpx->frnr, gpx->id, gpx->jahr, gpx->monat, gpx->tag, gpx->std, gpx->min, gpx->sek, gpx->lat, gpx->lon, gpx->alt, gpx->vH, gpx->vD, gpx->vV, gpx->numSV, gpx->conf_cd, gpx->batt );
                         if (gpx->option.ptu && !err0 && gpx->T > -273.0) {
-                            fprintf(stdout, ", \"temp\": %.1f",  gpx->T );
+                            fprintf(gpx->fout, ", \"temp\": %.1f",  gpx->T );
                         }
                         if (gpx->option.ptu && !err0 && gpx->RH > -0.5) {
-                            fprintf(stdout, ", \"humidity\": %.1f",  gpx->RH );
+                            fprintf(gpx->fout, ", \"humidity\": %.1f",  gpx->RH );
                         }
                         if (gpx->aux) { // <=> gpx->xdata[0]!='\0'
-                            fprintf(stdout, ", \"aux\": \"%s\"",  gpx->xdata );
+                            fprintf(gpx->fout, ", \"aux\": \"%s\"",  gpx->xdata );
                         }
                         if (encrypted) {
-                            fprintf(stdout, ", \"subtype\": \"RS41-SGM\", \"encrypted\": true");
+                            fprintf(gpx->fout, ", \"subtype\": \"RS41-SGM\", \"encrypted\": true");
                         } else {
-                            fprintf(stdout, ", \"subtype\": \"%s\"",  *gpx->rstyp ? gpx->rstyp : "RS41" );  // RS41-SG(P/M)
+                            fprintf(gpx->fout, ", \"subtype\": \"%s\"",  *gpx->rstyp ? gpx->rstyp : "RS41" );  // RS41-SG(P/M)
                             if (strncmp(gpx->rstyp, "RS41-SGM", 8) == 0) {
-                                fprintf(stdout, ", \"encrypted\": false");
+                                fprintf(gpx->fout, ", \"encrypted\": false");
                             }
                         }
-                        fprintf(stdout, " }\n");
-                        fprintf(stdout, "\n");
+                        fprintf(gpx->fout, " }\n");
+                        fprintf(gpx->fout, "\n");
                     }
                 }
             }
@@ -1385,16 +1386,16 @@ static int print_position(gpx_t *gpx, int ec) {
                 output = ((gpx->crc & out_mask) != out_mask);
 
                 if (output) {
-                    fprintf(stdout, " ");
-                    fprintf(stdout, "[");
-                    for (i=0; i<5; i++) fprintf(stdout, "%d", (gpx->crc>>i)&1);
-                    fprintf(stdout, "]");
+                    fprintf(gpx->fout, " ");
+                    fprintf(gpx->fout, "[");
+                    for (i=0; i<5; i++) fprintf(gpx->fout, "%d", (gpx->crc>>i)&1);
+                    fprintf(gpx->fout, "]");
                 }
             }
         }
         else if (pck == pck_SGM_CRYPT) {
             if (out && !err) {
-                fprintf(stdout, " [%04X] (RS41-SGM) ", pck_SGM_CRYPT);
+                fprintf(gpx->fout, " [%04X] (RS41-SGM) ", pck_SGM_CRYPT);
                 //fprintf(stdout, "[%d] ", check_CRC(gpx, pos_PTU, pck_SGM_CRYPT));
                 output = 1;
             }
@@ -1402,11 +1403,11 @@ static int print_position(gpx_t *gpx, int ec) {
 
         if (out && output)
         {
-            if      (ec == -1)  fprintf(stdout, " (-+)");
-            else if (ec == -2)  fprintf(stdout, " (+-)");
-            else   /*ec == -3*/ fprintf(stdout, " (--)");
+            if      (ec == -1)  fprintf(gpx->fout, " (-+)");
+            else if (ec == -2)  fprintf(gpx->fout, " (+-)");
+            else   /*ec == -3*/ fprintf(gpx->fout, " (--)");
 
-            fprintf(stdout, "\n");  // fflush(stdout);
+            fprintf(gpx->fout, "\n");  // fflush(stdout);
         }
 
         ret = output;
@@ -1436,33 +1437,34 @@ static void print_frame(gpx_t *gpx, int len, dsp_t *dsp) {
 
     if (gpx->option.ecc) {
         ec = rs41_ecc(gpx, len);
+        if (ec < 0) rec_trigger(dsp, REC_ECC);
     }
 
 
     if (gpx->option.raw) {
         for (i = 0; i < len; i++) {
-            fprintf(stdout, "%02x", gpx->frame[i]);
+            fprintf(gpx->fout, "%02x", gpx->frame[i]);
         }
         if (gpx->option.ecc) {
-            if (ec >= 0) fprintf(stdout, " [OK]"); else fprintf(stdout, " [NO]");
+            if (ec >= 0) fprintf(gpx->fout, " [OK]"); else fprintf(gpx->fout, " [NO]");
             if (gpx->option.ecc /*== 2*/) {
-                if (ec > 0) fprintf(stdout, " (%d)", ec);
+                if (ec > 0) fprintf(gpx->fout, " (%d)", ec);
                 if (ec < 0) {
-                    if      (ec == -1)  fprintf(stdout, " (-+)");
-                    else if (ec == -2)  fprintf(stdout, " (+-)");
-                    else   /*ec == -3*/ fprintf(stdout, " (--)");
+                    if      (ec == -1)  fprintf(gpx->fout, " (-+)");
+                    else if (ec == -2)  fprintf(gpx->fout, " (+-)");
+                    else   /*ec == -3*/ fprintf(gpx->fout, " (--)");
                 }
             }
         }
-        fprintf(stdout, "\n");
+        fprintf(gpx->fout, "\n");
     }
     else {
-        pthread_mutex_lock( dsp->thd.mutex );
-        fprintf(stdout, "<%d> ", dsp->thd.tn);
+        fprintf(gpx->fout, "<%d> ", dsp->thd.tn);
         ret = print_position(gpx, ec);
-        if (ret==0) fprintf(stdout, "\n");
-        pthread_mutex_unlock( dsp->thd.mutex );
+        if (ret==0) fprintf(gpx->fout, "\n");
     }
+
+    out_frame(&dsp->thd);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1531,6 +1533,7 @@ void *thd_rs41(void *targs) { // pcm_t *pcm, double xlt_fq
     // init dsp
     //
     dsp.fp = pcm->fp;
+    dsp.sio = pcm->sio;
     dsp.sr = pcm->sr;
     dsp.sr_base = pcm->sr_base;
     dsp.dectaps = pcm->dectaps;
@@ -1555,6 +1558,7 @@ void *thd_rs41(void *targs) { // pcm_t *pcm, double xlt_fq
     dsp.lpIQ_bw = 8e3; // IF lowpass bandwidth
     dsp.lpFM_bw = 6e3; // FM audio lowpass
     dsp.opt_dc = tharg->option_dc;
+    dsp.opt_sq = tharg->option_sq;
 
     if ( dsp.sps < 8 ) {
         fprintf(stderr, "note: sample rate low (%.1f sps)\n", dsp.sps);
@@ -1564,8 +1568,10 @@ void *thd_rs41(void *targs) { // pcm_t *pcm, double xlt_fq
     k = init_buffers(&dsp); // BT=0.5  (IQ-Int: BT > 0.5 ?)
     if ( k < 0 ) {
         fprintf(stderr, "error: init buffers\n");
+        free_buffers(&dsp); // detach from IQ ring
         return NULL;
     };
+    gpx.fout = dsp.thd.out;
 
     //if (option_iq: 2,3) bitofs += 1; // FM: +1 , IQ: +2, IQ5: +1
     bitofs += shift;
@@ -1,15 +1,51 @@
 
 /*
-gcc -O2 -c demod_base.c
+gcc -O2 -I../../io -c demod_base.c iq_ring.c
+gcc -O2 -c pool.c outq.c thd.c scan.c rec.c detect.c
+gcc -O2 -c ../../io/sample_io.c
 gcc -O2 -c bch_ecc_mod.c
 gcc -O2 -c rs41base.c
 gcc -O2 -c dfm09base.c
 gcc -O2 -c m10base.c
 gcc -O2 -c lms6Xbase.c
-gcc -O2 rs_multi.c demod_base.o bch_ecc_mod.o rs41base.o dfm09base.o m10base.o lms6Xbase.o -lm -pthread
+gcc -O2 rs_multi.c demod_base.o iq_ring.o pool.o outq.o thd.o scan.o rec.o detect.o sample_io.o bch_ecc_mod.o rs41base.o dfm09base.o m10base.o lms6Xbase.o -lm -pthread
 
 ./a.out --rs41 <fq0> --dfm <fq1> --m10 <fq2> baseband_IQ.wav
 -0.5 < fq < 0.5 , fq=freq/sr
+input: wav, - <sr> <bps> (raw stdin), <name>.sigmf-meta, raw:<cu8|cs8|cs16|cf32>:<sr>:<path>,
+       shm:<name> (iq_bus), rtl_tcp:<host>[:<port>]?s=<sr>
+--start <s> --duration <s> : input window (file: direct offset, no replay)
+--auto <fq> : sonde type from the header bank (dft_detect: dfm, rs41, lms, m10),
+              then the decoder continues on the same samples
+--ctl <socket> : control socket (AF_UNIX), channels added/removed at runtime:
+    add <rs41|dfm|m10|lms|auto> <fq>  ->  ok <n>
+    remove <n>
+    list                         ->  <n> <type>[:<detected>] <fq>
+    e.g. echo "add rs41 0.123" | socat - UNIX-CONNECT:<socket>
+--lag <n> : IQ ring blocks (default 64), max. lag of a decoder before the input waits;
+            the input waits for the slowest decoder ("ring: producer waits")
+--lag-drop : the input does not wait for lagging decoders (live input): a decoder
+            --lag blocks behind skips blocks ("<n> ring: blocks dropped")
+--workers <n> : decoder tasks on n worker threads (default: cpus), 0: one thread per channel
+--sq      : squelch, no demodulation/header search while the channel power is at the noise floor
+--scan <sec> : scanner on the same IQ stream, averaged spectrum every <sec> seconds of input
+            (scan_fft_pow.c peaks); new peak: auto channel, peak gone for SCAN_MISS scans:
+            channel removed
+--cpus <list> : decoder threads (round robin per channel) or workers on these cpus,
+            e.g. 0,2-5; default workers: one per listed cpu, stealing within a NUMA node
+--cpu-in <n>  : input (IQ ring) thread on cpu n
+--fifo <prio> : input thread SCHED_FIFO (needs CAP_SYS_NICE / rtprio limit)
+            at exit: cpu time and context switches per thread (stderr, "cpu:")
+--rec <sec> : pre-trigger recorder, the last <sec> seconds of input IQ in memory; on a trigger
+            the window [-pre, +post] s is written (recorder thread) as SigMF
+            <dir>/rec_<sample>.sigmf-meta/-data (ci16_le, global_index: input sample)
+--rec-on <ecc|hdr|all> : trigger: rs41 ECC failed (default), header found, both
+--rec-pre <s>, --rec-post <s> : window (default 2, 1)
+--rec-dir <dir>
+--out <file> : decoder output to file instead of stdout; "%d" in the name: one file per channel
+--out-json <file> : JSON lines (--json) to their own file ("%d": per channel)
+--pfb     : polyphase FFT channelizer (IF_sr spaced channels, one pass for all decoders),
+            instead of mixing/decimating per decoder; sr/IF_sr even
 */
 
 
@@ -20,65 +56,447 @@ gcc -O2 rs_multi.c demod_base.o bch_ecc_mod.o rs41base.o dfm09base.o m10base.o l
   #include <io.h>
 #endif
 
-#include "demod_base.h"
-
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t  cond  = PTHREAD_COND_INITIALIZER;
-//static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+#include "demod_base.h"
 
-static float complex *block_decMB;
 
-int rbf1; // extern in demod_base.c
+static stream_t stream;  // input, IQ ring
 
 
 void *thd_rs41(void *);
 void *thd_dfm09(void *);
 void *thd_m10(void *);
 void *thd_lms6X(void *);
+static void *thd_auto(void *);
+
+static struct {
+    char *name;
+    void *(*thd)(void *);
+} rstype[] = {
+    { "rs41", thd_rs41  },
+    { "dfm",  thd_dfm09 },
+    { "m10",  thd_m10   },
+    { "lms",  thd_lms6X },
+    { "auto", thd_auto  },
+    { NULL,   NULL      }
+};
+
+static int rs_type(char *name) {
+    int k;
+    for (k = 0; rstype[k].name; k++) {
+        if (strcmp(name, rstype[k].name) == 0) return k;
+    }
+    return -1;
+}
 
 
-#define IF_SAMPLE_RATE  48000
+// channels: decoder threads on the IQ ring, started from argv or the control socket
+typedef struct chan_s {
+    thargs_t targ;   // first: thd_auto() -> chan_t
+    int type;
+    _Atomic int det; // auto: detected type, -1: not yet
+    _Atomic int fin; // decoder returned (EOF, error): chan_reap()
+    iqr_cur_t *cur;  // ring cursor, owned until chan_join()
+    pthread_t tid;   // own thread (not in targ: the decoder copies targ.thd)
+    double fq;
+    thd_use_t use;   // own thread: cpu, usage at exit
+    struct chan_s *next;
+} chan_t;
+
+static chan_t *chans = NULL;
+static pthread_mutex_t chan_mutex = PTHREAD_MUTEX_INITIALIZER;  // chans
+static int chan_tn = 0;  // next channel number
+static int option_jsn = 0,
+           option_dc  = 0,
+           option_sq  = 0;
+static int workers = 0;  // pool_init(), 0: pthread per channel
+static int *cpus = NULL; // --cpus
+static int ncpu = 0;
+
+// "0,2-5" -> cpus[], ncpu
+static int cpu_list(char *str) {
+    char *p = str, *e;
+    long a, b;
+
+    while (*p) {
+        a = strtol(p, &e, 10);
+        if (e == p || a < 0) return -1;
+        b = a;
+        if (*e == '-') {
+            p = e+1;
+            b = strtol(p, &e, 10);
+            if (e == p || b < a) return -1;
+        }
+        for ( ; a <= b; a++) {
+            int *c = realloc(cpus, (ncpu+1)*sizeof(int));
+            if (c == NULL) return -1;
+            cpus = c;
+            cpus[ncpu++] = a;
+        }
+        if (*e == ',') e++;
+        else if (*e) return -1;
+        p = e;
+    }
+    return ncpu;
+}
 
-static int pcm_dec_init(pcm_t *p) {
+static void *chan_thread(void *);
+
+// live=0: from the start of the input (before the ring producer runs)
+static int chan_add(stream_t *st, int type, double fq, int live) {
+    chan_t *ch, **pc;
+    int tn;
+
+    if (fq < -0.5) fq = -0.5;
+    if (fq >  0.5) fq =  0.5;
+
+    ch = calloc(1, sizeof(chan_t));  if (ch == NULL) return -1;
+    ch->type = type;
+    atomic_init(&ch->det, -1);
+    atomic_init(&ch->fin, 0);
+    ch->fq = fq;
+    ch->use.cpu = -1;
+
+    pthread_mutex_lock( &chan_mutex );
+    tn = chan_tn;
+
+    ch->targ.thd.tn = tn;
+    if (ncpu > 0 && workers == 0) ch->use.cpu = cpus[tn % ncpu];
+    ch->targ.thd.st = st;
+    ch->cur = iq_ring_attach(&st->ring, live);
+    if (ch->cur == NULL) {
+        pthread_mutex_unlock( &chan_mutex );
+        free(ch);
+        return -1;
+    }
+    ch->targ.thd.cur = ch->cur;
+    ch->targ.thd.rseq = atomic_load(&ch->cur->seq);
+    ch->targ.thd.rpos = 0;
+    ch->targ.thd.xlt_fq = -fq; // S(t)*exp(-f*2pi*I*t): fq baseband -> IF (rotate from and decimate)
 
-    int IF_sr = IF_SAMPLE_RATE; // designated IF sample rate
-    int decM = 1; // decimate M:1
-    int sr_base = p->sr;
-    float f_lp; // dec_lowpass: lowpass_bandwidth/2
-    float tbw;  // dec_lowpass: transition_bandwidth/Hz
-    int taps;   // dec_lowpass: taps
+    ch->targ.pcm = st->pcm;
 
-    if (IF_sr > sr_base) IF_sr = sr_base;
-    if (IF_sr < sr_base) {
-        while (sr_base % IF_sr) IF_sr += 1;
-        decM = sr_base / IF_sr;
+    ch->targ.option_jsn = option_jsn;
+    ch->targ.option_dc  = option_dc;
+    ch->targ.option_sq  = option_sq;
+
+    if (workers > 0) {
+        ch->targ.thd.task = task_new(chan_thread, &ch->targ);
+        if (ch->targ.thd.task) pool_run(ch->targ.thd.task);
+    }
+    if (workers > 0 ? ch->targ.thd.task == NULL
+                    : pthread_create(&ch->tid, NULL, chan_thread, &ch->targ) != 0) {
+        iq_ring_release(ch->cur);
+        pthread_mutex_unlock( &chan_mutex );
+        free(ch);
+        return -1;
     }
 
-    f_lp = (IF_sr+20e3)/(4.0*sr_base);
-    tbw  = (IF_sr-20e3)/*/2.0*/; if (tbw < 0) tbw = 8e3;
-    taps = sr_base*4.0/tbw; if (taps%2==0) taps++;
+    for (pc = &chans; *pc; pc = &(*pc)->next);
+    *pc = ch;
+    chan_tn += 1;
+    pthread_mutex_unlock( &chan_mutex );
 
-    taps = decimate_init(f_lp, taps);
+    return tn;
+}
+
+// --auto: header bank on the channel IF stream (detect_header), then the decoder of
+// the detected type in this thread/task; it takes the detector's IF samples and
+// mixer/decimator (init_buffers), i.e. no restart, the header is not lost
+static void *thd_auto(void *targs) {
+    thargs_t *tharg = targs;
+    pcm_t *pcm = &tharg->pcm;
+    dsp_t dsp = {0};
+    char *type = NULL;
+    float mv = 0.0;
+    int t = -1;
+
+    dsp.sio = pcm->sio;
+    dsp.sr = pcm->sr;
+    dsp.sr_base = pcm->sr_base;
+    dsp.dectaps = pcm->dectaps;
+    dsp.decM = pcm->decM;
+    dsp.bps = pcm->bps;
+    dsp.nch = pcm->nch;
+    dsp.thd = tharg->thd;
+    dsp.opt_dc = tharg->option_dc;
+
+    if (detect_init(&dsp) < 0) {
+        fprintf(stderr, "error: init detector\n");
+        detect_free(&dsp);
+        return NULL;
+    }
 
-    if (taps < 0) return -1;
-    p->dectaps = (ui32_t)taps;
-    p->sr_base = sr_base;
-    p->sr = IF_sr; // sr_base/decM
-    p->decM = decM;
+    if (detect_header(&dsp, &type, &mv) == 1) t = rs_type(type);
+    if (t >= 0) {
+        fprintf(stderr, "<%d> auto: %s (%.4f)\n", dsp.thd.tn, type, mv);
+        atomic_store(&((chan_t *)tharg)->det, t);
+        // ring position and detector -> decoder; the rest of targ.thd (tn, task, cur)
+        // belongs to the channel and is read by the ctl/scan threads: not rewritten
+        tharg->thd.rseq = dsp.thd.rseq;
+        tharg->thd.rpos = dsp.thd.rpos;
+        tharg->thd.lost = dsp.thd.lost;
+        tharg->thd.det = dsp.thd.det;
+        dsp.thd.cur = NULL;    // detached by the decoder
+        rstype[t].thd(tharg);
+    }
+    detect_free(&dsp);
 
-    iq_dc_init(p);
+    return NULL;
+}
 
-    fprintf(stderr, "IF: %d\n", IF_sr);
-    fprintf(stderr, "dec: %d\n", decM);
+// own thread: pinned before the decoder allocates its buffers (NUMA first touch)
+static void *chan_thread(void *targs) {
+    chan_t *ch = targs;
+    if (ch->targ.thd.task == NULL) {
+        if (thd_place(ch->use.cpu, 0) < 0) fprintf(stderr, "<%d> cpu %d not set\n", ch->targ.thd.tn, ch->use.cpu);
+    }
+    rstype[ch->type].thd(&ch->targ);
+    if (ch->targ.thd.task == NULL) thd_usage(&ch->use);
+    atomic_store(&ch->fin, 1);
+    return NULL;
+}
 
-    fprintf(stderr, "taps: %d\n", taps);
-    fprintf(stderr, "transBW: %.4f = %.1f Hz\n", tbw/sr_base, tbw);
-    fprintf(stderr, "f: +/-%.4f = +/-%.1f Hz\n", f_lp, f_lp*sr_base);
+static void chan_join(chan_t *ch) {
+    char name[16];
+
+    snprintf(name, sizeof(name), "<%d>", ch->targ.thd.tn);
+    if (ch->targ.thd.task) {
+        double cpu = task_join(ch->targ.thd.task);  // after the task has returned
+        fprintf(stderr, "cpu: %-8s task    %8.3f s\n", name, cpu);
+    }
+    else {
+        pthread_join(ch->tid, NULL);
+        thd_report(name, &ch->use);
+    }
+    iq_ring_release(ch->cur);
+    free(ch);
+}
+
+// stop (decoder reads EOF), join
+static int chan_remove(int tn) {
+    chan_t *ch, **pc;
+
+    pthread_mutex_lock( &chan_mutex );
+    for (pc = &chans; *pc && (*pc)->targ.thd.tn != tn; pc = &(*pc)->next);
+    ch = *pc;
+    if (ch) *pc = ch->next;
+    pthread_mutex_unlock( &chan_mutex );
+    if (ch == NULL) return -1;
+
+    atomic_store(&ch->cur->stop, 1);
+    chan_join(ch);
 
     return 0;
 }
 
+// finished decoders (EOF, error): unlink and join, before list/add/remove
+static void chan_reap(void) {
+    chan_t *ch, **pc, *fin = NULL;
+
+    pthread_mutex_lock( &chan_mutex );
+    for (pc = &chans; (ch = *pc) != NULL; ) {
+        if (atomic_load(&ch->fin)) {
+            *pc = ch->next;
+            ch->next = fin;
+            fin = ch;
+        }
+        else pc = &ch->next;
+    }
+    pthread_mutex_unlock( &chan_mutex );
+
+    while ((ch = fin) != NULL) {
+        fin = ch->next;
+        fprintf(stderr, "<%d> finished\n", ch->targ.thd.tn);
+        chan_join(ch);
+    }
+}
+
+
+// scanner: peaks of the averaged spectrum -> auto channels (chan_add live),
+// its channels are removed when the peak is gone for SCAN_MISS scans.
+// Peaks closer than SCAN_TOL are one signal (FSK: tones and center), the strongest
+// is taken; a peak within SCAN_TOL of any channel (argv, ctl, scan) is that channel.
+#define SCAN_MAXP  64
+#define SCAN_TOL   4e3  // Hz
+#define SCAN_MISS  3
+
+static scan_t scan;
+
+static void *thd_scan(void *arg) {
+    stream_t *st = arg;
+    float fq[SCAN_MAXP], mag[SCAN_MAXP], f0 = 0;
+    struct { int tn; float fq; int miss; } *sch = NULL;  // scanner channels
+    int nsch = 0;
+    double tol = SCAN_TOL / st->pcm.sr_base;
+    chan_t *ch;
+    void *p;
+    thd_use_t use;
+    int np, j, k, n, tn, found;
+
+    while ((np = scan_peaks(st, &scan, fq, mag, SCAN_MAXP)) != EOF) {
+
+        for (n = 0, j = 0; j < np; j++) {  // ascending fq
+            if (n > 0 && fq[j] - f0 < tol) {
+                f0 = fq[j];
+                if (mag[j] > mag[n-1]) { fq[n-1] = fq[j]; mag[n-1] = mag[j]; }
+            }
+            else {
+                f0 = fq[j];
+                fq[n] = fq[j]; mag[n] = mag[j]; n++;
+            }
+        }
+        np = n;
+
+        for (k = 0; k < nsch; k++) sch[k].miss += 1;
+
+        for (j = 0; j < np; j++) {
+            found = 0;
+            for (k = 0; k < nsch; k++) {
+                if (fabs(sch[k].fq - fq[j]) < tol) { sch[k].miss = 0; found = 1; }
+            }
+            if (found) continue;
+            pthread_mutex_lock( &chan_mutex );
+            for (ch = chans; ch; ch = ch->next) {
+                if (fabs(ch->fq - fq[j]) < tol) found = 1;
+            }
+            pthread_mutex_unlock( &chan_mutex );
+            if (found) continue;
+
+            tn = chan_add(st, rs_type("auto"), fq[j], 1);
+            if (tn < 0) {
+                fprintf(stderr, "scan: error: channel %.6f\n", fq[j]);
+                continue;
+            }
+            fprintf(stderr, "scan: add <%d> %.6f\n", tn, fq[j]);
+            p = realloc(sch, (nsch+1)*sizeof(*sch));
+            if (p == NULL) break;
+            sch = p;
+            sch[nsch].tn = tn;
+            sch[nsch].fq = fq[j];
+            sch[nsch].miss = 0;
+            nsch++;
+        }
+
+        for (k = 0; k < nsch; ) {
+            if (sch[k].miss < SCAN_MISS) { k++; continue; }
+            if (chan_remove(sch[k].tn) == 0) fprintf(stderr, "scan: remove <%d>\n", sch[k].tn);
+            sch[k] = sch[--nsch];
+        }
+    }
+
+    if (sch) free(sch);
+    use.cpu = -1;
+    thd_usage(&use);
+    thd_report("scan", &use);
+    return NULL;
+}
+
+
+// control socket
+static _Atomic int ctl_done = 0;
+
+static void ctl_cmd(int fd, char *line) {
+    char cmd[16] = "", arg[16] = "";
+    double fq;
+    chan_t *ch;
+    int n, tn;
+
+    n = sscanf(line, "%15s %15s %lf", cmd, arg, &fq);
+    if (n < 1) return;
+
+    chan_reap();
+
+    if (strcmp(cmd, "add") == 0 && n == 3 && rs_type(arg) >= 0) {
+        tn = chan_add(&stream, rs_type(arg), fq, 1);
+        if (tn < 0) dprintf(fd, "error\n");
+        else {
+            dprintf(fd, "ok %d\n", tn);
+            fprintf(stderr, "ctl: add <%d> %s %.6f\n", tn, arg, fq);
+        }
+    }
+    else if (strcmp(cmd, "remove") == 0 && n >= 2) {
+        tn = atoi(arg);
+        if (chan_remove(tn) < 0) dprintf(fd, "error\n");
+        else {
+            dprintf(fd, "ok\n");
+            fprintf(stderr, "ctl: remove <%d>\n", tn);
+        }
+    }
+    else if (strcmp(cmd, "list") == 0) {
+        pthread_mutex_lock( &chan_mutex );
+        for (ch = chans; ch; ch = ch->next) {
+            int det = atomic_load(&ch->det);
+            dprintf(fd, "%d %s%s%s %.6f\n", ch->targ.thd.tn, rstype[ch->type].name,
+                    det < 0 ? "" : ":", det < 0 ? "" : rstype[det].name, ch->fq);
+        }
+        pthread_mutex_unlock( &chan_mutex );
+    }
+    else dprintf(fd, "error\n");
+}
+
+// one connection at a time, line commands
+static void *thd_ctl(void *arg) {
+    int sfd = *(int *)arg;
+    int cfd, len, n;
+    char buf[256], *e;
+    struct pollfd pfd;
+
+    while (!atomic_load(&ctl_done)) {
+        pfd.fd = sfd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        cfd = accept(sfd, NULL, NULL);
+        if (cfd < 0) continue;
+
+        len = 0;
+        while (!atomic_load(&ctl_done)) {
+            pfd.fd = cfd;
+            pfd.events = POLLIN;
+            n = poll(&pfd, 1, 200);
+            if (n < 0) break;
+            if (n == 0) continue;
+            n = read(cfd, buf+len, sizeof(buf)-1 - len);
+            if (n <= 0) break;
+            len += n;
+            while ((e = memchr(buf, '\n', len)) != NULL) {
+                *e = '\0';
+                ctl_cmd(cfd, buf);
+                len -= e+1 - buf;
+                memmove(buf, e+1, len);
+            }
+            if (len == sizeof(buf)-1) len = 0; // line too long
+        }
+        if (len > 0) { buf[len] = '\0'; ctl_cmd(cfd, buf); }
+        close(cfd);
+    }
+
+    return NULL;
+}
+
+static int ctl_open(char *path) {
+    struct sockaddr_un sa;
+    int fd;
+
+    if (strlen(path) >= sizeof(sa.sun_path)) return -1;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, path);
+    unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(fd, 4) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
 
 int main(int argc, char **argv) {
 
@@ -86,11 +504,25 @@ int main(int argc, char **argv) {
     int wavloaded = 0;
     int k;
     int xlt_cnt = 0;
-    double base_fqs[MAX_FQ];
-    void *rstype[MAX_FQ];
-    int option_pcmraw = 0,
-        option_jsn = 0,
-        option_dc  = 0;
+    double *base_fqs = NULL;
+    int *base_type = NULL;
+    int option_pcmraw = 0;
+    int ring_lag = IQR_SLOTS;
+    int ring_drop = 0;
+    char *out_txt = NULL;  // NULL: stdout
+    char *out_jsn = NULL;
+    int option_workers = -1;
+    char *ctl_path = NULL;
+    int ctl_fd = -1;
+    pthread_t ctl_tid;
+    float scan_sec = 0;
+    pthread_t scan_tid;
+    float rec_sec = 0, rec_pre = 2.0, rec_post = 1.0;
+    int rec_on = REC_ECC;
+    char *rec_dir = ".";
+    int cpu_in = -1;
+    int fifo = 0;
+    chan_t *ch;
 
 #ifdef CYGWIN
     _setmode(fileno(stdin), _O_BINARY);  // _fileno(stdin)
@@ -100,67 +532,121 @@ int main(int argc, char **argv) {
 
     pcm_t pcm = {0};
 
-    for (k = 0; k < MAX_FQ; k++) base_fqs[k] = 0.0;
-
     ++argv;
     while ((*argv) && (!wavloaded)) {
-        if (strcmp(*argv, "--rs41") == 0) {
+        if (strncmp(*argv, "--", 2) == 0 && rs_type(*argv+2) >= 0) { // --rs41, --dfm, --m10, --lms, --auto
             double fq = 0.0;
+            int type = rs_type(*argv+2);
             ++argv;
             if (*argv) fq = atof(*argv);
             else return -1;
-            if (fq < -0.5) fq = -0.5;
-            if (fq >  0.5) fq =  0.5;
-            if (xlt_cnt < MAX_FQ) {
-                base_fqs[xlt_cnt] = fq;
-                rstype[xlt_cnt] = thd_rs41;
-                xlt_cnt++;
-            }
+            base_fqs = realloc(base_fqs, (xlt_cnt+1)*sizeof(double));
+            base_type = realloc(base_type, (xlt_cnt+1)*sizeof(int));
+            if (base_fqs == NULL || base_type == NULL) return -1;
+            base_fqs[xlt_cnt] = fq;
+            base_type[xlt_cnt] = type;
+            xlt_cnt++;
         }
-        else if (strcmp(*argv, "--dfm") == 0) {
-            double fq = 0.0;
+        else if   (strcmp(*argv, "--json") == 0) {
+            option_jsn = 1;
+        }
+        else if   (strcmp(*argv, "--out") == 0) {
             ++argv;
-            if (*argv) fq = atof(*argv);
+            if (*argv) out_txt = *argv;
             else return -1;
-            if (fq < -0.5) fq = -0.5;
-            if (fq >  0.5) fq =  0.5;
-            if (xlt_cnt < MAX_FQ) {
-                base_fqs[xlt_cnt] = fq;
-                rstype[xlt_cnt] = thd_dfm09;
-                xlt_cnt++;
-            }
         }
-        else if (strcmp(*argv, "--m10") == 0) {
-            double fq = 0.0;
+        else if   (strcmp(*argv, "--out-json") == 0) {
             ++argv;
-            if (*argv) fq = atof(*argv);
+            if (*argv) out_jsn = *argv;
             else return -1;
-            if (fq < -0.5) fq = -0.5;
-            if (fq >  0.5) fq =  0.5;
-            if (xlt_cnt < MAX_FQ) {
-                base_fqs[xlt_cnt] = fq;
-                rstype[xlt_cnt] = thd_m10;
-                xlt_cnt++;
-            }
         }
-        else if (strcmp(*argv, "--lms") == 0) {
-            double fq = 0.0;
+        else if   (strcmp(*argv, "--dc") == 0) {
+            option_dc = 1;
+        }
+        else if   (strcmp(*argv, "--sq") == 0) {
+            option_sq = 1;
+        }
+        else if   (strcmp(*argv, "--pfb") == 0) {
+            pcm.pfb = 1;
+        }
+        else if   (strcmp(*argv, "--lag") == 0) {
             ++argv;
-            if (*argv) fq = atof(*argv);
+            if (*argv) ring_lag = atoi(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--lag-drop") == 0) {
+            ring_drop = 1;
+        }
+        else if   (strcmp(*argv, "--start") == 0) {
+            ++argv;
+            if (*argv) pcm.t_start = atof(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--duration") == 0) {
+            ++argv;
+            if (*argv) pcm.t_dur = atof(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--workers") == 0) {
+            ++argv;
+            if (*argv) option_workers = atoi(*argv);
             else return -1;
-            if (fq < -0.5) fq = -0.5;
-            if (fq >  0.5) fq =  0.5;
-            if (xlt_cnt < MAX_FQ) {
-                base_fqs[xlt_cnt] = fq;
-                rstype[xlt_cnt] = thd_lms6X;
-                xlt_cnt++;
+        }
+        else if   (strcmp(*argv, "--scan") == 0) {
+            ++argv;
+            if (*argv) scan_sec = atof(*argv);
+            else return -1;
+            if (scan_sec <= 0) return -1;
+        }
+        else if   (strcmp(*argv, "--rec") == 0) {
+            ++argv;
+            if (*argv) rec_sec = atof(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--rec-on") == 0) {
+            ++argv;
+            if (*argv == NULL) return -1;
+            if      (strcmp(*argv, "ecc") == 0) rec_on = REC_ECC;
+            else if (strcmp(*argv, "hdr") == 0) rec_on = REC_HDR;
+            else if (strcmp(*argv, "all") == 0) rec_on = REC_HDR | REC_ECC;
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--rec-pre") == 0) {
+            ++argv;
+            if (*argv) rec_pre = atof(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--rec-post") == 0) {
+            ++argv;
+            if (*argv) rec_post = atof(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--rec-dir") == 0) {
+            ++argv;
+            if (*argv) rec_dir = *argv;
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--cpus") == 0) {
+            ++argv;
+            if (*argv == NULL || cpu_list(*argv) < 1) {
+                fprintf(stderr, "--cpus <list>\n");
+                return -1;
             }
         }
-        else if   (strcmp(*argv, "--json") == 0) {
-            option_jsn = 1;
+        else if   (strcmp(*argv, "--cpu-in") == 0) {
+            ++argv;
+            if (*argv) cpu_in = atoi(*argv);
+            else return -1;
         }
-        else if   (strcmp(*argv, "--dc") == 0) {
-            option_dc = 1;
+        else if   (strcmp(*argv, "--fifo") == 0) {
+            ++argv;
+            if (*argv) fifo = atoi(*argv);
+            else return -1;
+        }
+        else if   (strcmp(*argv, "--ctl") == 0) {
+            ++argv;
+            if (*argv) ctl_path = *argv;
+            else return -1;
         }
         else if (strcmp(*argv, "-") == 0) {
             int sample_rate = 0, bits_sample = 0, channels = 0;
@@ -179,7 +665,7 @@ int main(int argc, char **argv) {
             option_pcmraw = 1;
         }
         else {
-            fp = fopen(*argv, "rb");
+            fp = pcm_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -1;
@@ -190,6 +676,11 @@ int main(int argc, char **argv) {
     }
     if (!wavloaded) fp = stdin;
 
+    if (xlt_cnt == 0 && ctl_path == NULL && scan_sec == 0) {
+        fprintf(stderr, "error: no channels\n");
+        return -1;
+    }
+
     pcm.fp = fp;
     if (option_pcmraw == 0) {
         k = read_wav_header( &pcm );
@@ -204,47 +695,106 @@ int main(int argc, char **argv) {
         return -50;
     }
 
-    pcm_dec_init( &pcm );
+    stream.pcm = pcm;
+    stream.scan = scan_sec > 0;
+    stream.cpu = cpu_in;
+    stream.prio = fifo;
+    if (pcm_io_init( &stream.pcm ) < 0) {
+        fprintf(stderr, "error: input\n");
+        return -1;
+    }
 
+    if (stream_init(&stream, ring_lag) < 0) {
+        fprintf(stderr, "error: iq ring\n");
+        return -1;
+    }
+    stream.ring.drop = ring_drop;
+    fprintf(stderr, "ring: %d x %d\n", stream.ring.nslot, stream.ring.blen);
 
-    block_decMB = calloc(pcm.decM*blk_sz+1, sizeof(float complex));  if (block_decMB == NULL) return -1;
+    if (rec_sec > 0) {
+        if (rec_init(&stream, rec_sec, rec_pre, rec_post, rec_on, rec_dir) < 0) {
+            fprintf(stderr, "error: recorder\n");
+            return -1;
+        }
+        fprintf(stderr, "rec: %.1f s (%.0f MB), window -%.1f/+%.1f s\n", rec_sec,
+                rec_sec * stream.pcm.sr_base * 4 / 1e6, rec_pre, rec_post);
+    }
 
+    workers = option_workers;
+    if (workers < 0) workers = ncpu > 0 ? ncpu : sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers > 0) {
+        workers = pool_init(workers, cpus, ncpu);
+        if (workers < 0) {
+            fprintf(stderr, "error: worker pool\n");
+            return -1;
+        }
+        fprintf(stderr, "pool: %d workers\n", workers);
+    }
 
-    thargs_t tharg[xlt_cnt];
+    if (out_start(out_txt, out_jsn) < 0) {
+        fprintf(stderr, "error: output\n");
+        return -1;
+    }
 
     for (k = 0; k < xlt_cnt; k++) {
-        tharg[k].thd.tn = k;
-        tharg[k].thd.tn_bit = (1<<k);
-        tharg[k].thd.mutex = &mutex;
-        tharg[k].thd.cond = &cond;
-        //tharg[k].thd.lock = &lock;
-        tharg[k].thd.blk = block_decMB;
-        tharg[k].thd.max_fq = xlt_cnt;
-        tharg[k].thd.xlt_fq = -base_fqs[k]; // S(t)*exp(-f*2pi*I*t): fq baseband -> IF (rotate from and decimate)
-
-        tharg[k].pcm = pcm;
-
-        tharg[k].option_jsn = option_jsn;
-        tharg[k].option_dc  = option_dc;
+        if (chan_add(&stream, base_type[k], base_fqs[k], 0) < 0) {
+            fprintf(stderr, "error: channel %d\n", k);
+        }
+    }
 
-        rbf1 |= tharg[k].thd.tn_bit;
+    if (ctl_path) {
+        ctl_fd = ctl_open(ctl_path);
+        if (ctl_fd < 0) {
+            fprintf(stderr, "error: ctl socket %s\n", ctl_path);
+            return -1;
+        }
+        stream.ring.keep = 1;
+        pthread_create(&ctl_tid, NULL, thd_ctl, &ctl_fd);
     }
 
-    for (k = 0; k < xlt_cnt; k++) {
-        pthread_create(&tharg[k].thd.tid, NULL, rstype[k], &tharg[k]);
+    if (scan_sec > 0) {
+        if (scan_init(&stream, &scan, scan_sec) < 0) {
+            fprintf(stderr, "error: scanner\n");
+            return -1;
+        }
+        fprintf(stderr, "scan: %d-point, %.1f s\n", scan.DFT.N, scan_sec);
+        pthread_create(&scan_tid, NULL, thd_scan, &stream);
     }
 
+    pthread_create(&stream.ring.tid, NULL, iq_ring_thread, &stream);
 
-    for (k = 0; k < xlt_cnt; k++) {
-        pthread_join(tharg[k].thd.tid, NULL);
+
+    pthread_join(stream.ring.tid, NULL);
+    thd_report("in", &stream.use);
+
+    if (scan_sec > 0) {  // before the channel list is drained
+        pthread_join(scan_tid, NULL);
+        fprintf(stderr, "scan: blocks skipped: %llu\n", (unsigned long long)scan.skip);
+        scan_free(&scan);
     }
 
+    if (ctl_path) {
+        atomic_store(&ctl_done, 1);
+        pthread_join(ctl_tid, NULL);
+        close(ctl_fd);
+        unlink(ctl_path);
+    }
+
+    while ((ch = chans) != NULL) { // EOF
+        chans = ch->next;
+        chan_join(ch);
+    }
+    if (workers > 0) pool_free();
+    out_stop();
 
-    if (block_decMB) { free(block_decMB); block_decMB = NULL; }
-    decimate_free();
+    fprintf(stderr, "ring: producer waits: %llu\n", (unsigned long long)stream.ring.pwait);
 
+    stream_free(&stream);
     fclose(fp);
 
+    if (base_fqs) free(base_fqs);
+    if (base_type) free(base_type);
+    if (cpus) free(cpus);
+
     return 0;
 }
-
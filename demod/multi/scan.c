@@ -0,0 +1,234 @@
+
+/*
+ *  rs_multi: scanner: averaged spectrum of the input IQ, peaks
+ *  compile:
+ *      gcc -c scan.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#include <stdio.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// scanner: the input IQ (dc removed) from the ring on its own cursor,
+// Hann window, N-point FFT, dB averaged over interval input samples (scan_fft_pow.c),
+// then the symmetric peak search. If the scanner holds back the channels (they are
+// half the ring ahead), it skips to the slowest channel, i.e. it averages fewer spectra;
+// without channels it paces the input.
+#define SCAN_LOG2N  14  // 2^14: 75-150 Hz bins
+
+// before iq_ring_thread() starts; stream->scan set before stream_init() (pfb)
+int scan_init(stream_t *st, scan_t *sc, float tl) {
+    dft_t *dft = &sc->DFT;
+    float dx;
+
+    memset(sc, 0, sizeof(*sc));
+
+    dft->sr = st->pcm.sr_base;
+    dft->LOG2N = SCAN_LOG2N;
+    dft->N2 = 1 << dft->LOG2N;
+    if (dft->N2 > dft->sr/2) {
+        dft->LOG2N = 0;
+        while ( (1 << (dft->LOG2N+1)) < dft->sr/2 ) dft->LOG2N++;
+        dft->N2 = 1 << dft->LOG2N;
+    }
+    dft->N = dft->N2;
+
+    if (dft_init(dft) < 0) return -1;
+    dft->win = calloc(dft->N+1, sizeof(float complex));  if (dft->win == NULL) return -1;
+    dft_window(dft, 1);
+
+    sc->x      = calloc(dft->N+1, sizeof(float complex));  if (sc->x == NULL) return -1;
+    sc->db     = calloc(dft->N+1, sizeof(float));  if (sc->db == NULL) return -1;
+    sc->sum_db = calloc(dft->N+1, sizeof(float));  if (sc->sum_db == NULL) return -1;
+    sc->intdb  = calloc(dft->N+1, sizeof(float));  if (sc->intdb == NULL) return -1;
+
+    dx = bin2freq(dft, 1);
+    sc->delay = (int)(24000.0/dx);
+    sc->peak   = calloc(sc->delay+1, sizeof(float));  if (sc->peak == NULL) return -1;
+
+    if (tl < 0.5) tl = 0.5;
+    sc->interval = (ui64_t)(tl*dft->sr);
+    if (sc->interval < (ui64_t)dft->N) sc->interval = dft->N;
+
+    sc->cur = iq_ring_attach(&st->ring, 0);
+    if (sc->cur == NULL) return -1;
+    sc->rseq = 0;
+
+    return 0;
+}
+
+void scan_free(scan_t *sc) {
+    if (sc->cur) { iq_ring_release(sc->cur); sc->cur = NULL; }
+    if (sc->DFT.win) { free(sc->DFT.win); sc->DFT.win = NULL; }
+    dft_free(&sc->DFT);
+    if (sc->x)      { free(sc->x);      sc->x      = NULL; }
+    if (sc->db)     { free(sc->db);     sc->db     = NULL; }
+    if (sc->sum_db) { free(sc->sum_db); sc->sum_db = NULL; }
+    if (sc->intdb)  { free(sc->intdb);  sc->intdb  = NULL; }
+    if (sc->peak)   { free(sc->peak);   sc->peak   = NULL; }
+}
+
+static void scan_fft(scan_t *sc) {
+    dft_t *dft = &sc->DFT;
+    float complex *Z = sc->x;
+    int j;
+
+    for (j = 0; j < dft->N; j++) Z[j] *= crealf(dft->win[j]);
+    raw_dft(dft, Z);
+    for (j = 0; j < dft->N; j++) {  // 20log10(|Z|/N)
+        sc->sum_db[j] += 20.0f * log10f(sqrtf(c_abs2(Z[j]))/dft->N2 + 1e-20f);
+    }
+    sc->nfft += 1;
+}
+
+// scan_fft_pow.c: spike removal, integration over +/-2400 Hz,
+// symmetric peak measure (sympeak) vs. the value 24 kHz before
+static int scan_eval(scan_t *sc, float *fq, float *mag, int max) {
+    dft_t *dft = &sc->DFT;
+    int N = dft->N;
+    int j, n, k, np = 0;
+    float *sum_db = sc->sum_db, *intdb = sc->intdb, *peak = sc->peak;
+    float dx, sum, sympeak;
+    float globmin = 0.0;
+    float db_spike3 = 10.0;
+    int spike_wl3 = 3;
+    int spike_wl5 = 5;
+    int dn, dn3, delay = sc->delay;
+    int mg = 0, mg0 = 0;
+    float max_db_loc = 0.0;
+    int   max_db_idx = 0;
+
+    dx = bin2freq(dft, 1);
+    dn = 2*(int)(2400.0/dx)+1; // (odd/symmetric) integration width: 4800+dx Hz
+    dn3 = (int)(4000.0/dx);    // +/-4000 Hz
+
+    for (j = 0; j < N; j++) sum_db[j] /= (float)sc->nfft;
+
+    // dc-spike, spikes in general
+    for (j = 0; j < N; j++) {
+        if ( sum_db[j] - sum_db[(j-spike_wl5+N)%N] > db_spike3
+          && sum_db[j] - sum_db[(j-spike_wl3+N)%N] > db_spike3
+          && sum_db[j] - sum_db[(j+spike_wl3+N)%N] > db_spike3
+          && sum_db[j] - sum_db[(j+spike_wl5+N)%N] > db_spike3
+           ) {
+            sum_db[j] = (sum_db[(j-spike_wl3+N)%N]+sum_db[(j+spike_wl3+N)%N])/2.0;
+        }
+    }
+
+    for (j = 0; j < N; j++) {
+        sum = 0.0;
+        for (n = j-(dn-1)/2; n <= j+(dn-1)/2; n++) sum += sum_db[(n + N) % N];
+        sum /= (float)dn;
+        intdb[j] = sum;
+        if (sum < globmin) globmin = sum;
+    }
+
+    memset(peak, 0, (delay+1)*sizeof(float));
+    k = 0;
+    for (j = N/2; j < N/2 + N; j++) {
+        sympeak = 0.0;
+        for (n = 1; n <= dn3; n++) {
+            sympeak += (sum_db[(j+n) % N]-globmin)*(sum_db[(j-n + N) % N]-globmin);
+        }
+        sympeak = sqrt(fabs(sympeak)/(float)dn3);
+        peak[k % delay] = sympeak;
+
+        mg = (sympeak - peak[(k+1)%delay])/ 3.0;  // threshold 3.0
+        if ( mg < 0 ) mg = 0;
+
+        if (mg0 > 0 && mg == 0) {
+            if ( fabs(bin2fq(dft, max_db_idx)) < 0.425 && np < max ) { // 85% bandwidth
+                fq[np] = bin2fq(dft, max_db_idx);
+                mag[np] = max_db_loc;
+                np++;
+            }
+        }
+        if (mg0 == 0 && mg > 0) {
+            max_db_loc = sympeak;
+            max_db_idx = j % N;
+        }
+        if (mg > 0 && sympeak > max_db_loc) {
+            max_db_loc = sympeak;
+            max_db_idx = j % N;
+        }
+        mg0 = mg;
+        k++;
+    }
+
+    return np;
+}
+
+// one interval of input: peaks (fq = freq/sr, ascending) -> fq[], sympeak -> mag[],
+// at most max; EOF at the end of input
+int scan_peaks(stream_t *st, scan_t *sc, float *fq, float *mag, int max) {
+    iqring_t *r = &st->ring;
+    dft_t *dft = &sc->DFT;
+    float complex *z;
+    iqr_cur_t *c;
+    ui64_t w, m, q;
+    int spin = 0, slot, len, l, o, np;
+
+    while (sc->sample < sc->interval) {
+        w = atomic_load_explicit(&r->wseq, memory_order_acquire);
+        if (sc->rseq == w) {
+            if (atomic_load_explicit(&r->eof, memory_order_acquire)
+               && sc->rseq == atomic_load_explicit(&r->wseq, memory_order_acquire)) return EOF;
+            iqr_wait(&spin);
+            continue;
+        }
+        spin = 0;
+        if (w - sc->rseq > (ui64_t)r->nslot/2) {
+            m = IQR_OFF;
+            for (c = atomic_load(&r->cur); c; c = c->next) {
+                if (c == sc->cur) continue;
+                q = atomic_load_explicit(&c->seq, memory_order_acquire);
+                if (q < m) m = q;
+            }
+            if (m != IQR_OFF && m > sc->rseq + r->nslot/2) { // behind the channels: skip
+                if (m >= w) m = w-1;
+                sc->skip += m - sc->rseq;
+                sc->sample += (m - sc->rseq) * r->blen;
+                sc->rseq = m;
+                sc->pos = 0;
+            }
+        }
+        if (r->drop) { // --lag-drop: overwritten blocks are skipped (a block torn while read only disturbs one spectrum)
+            m = iq_ring_skip(r, &sc->rseq);
+            if (m) {
+                sc->skip += m;
+                sc->sample += m * r->blen;
+                sc->pos = 0;
+            }
+        }
+        slot = sc->rseq % r->nslot;
+        z = r->buf + (size_t)slot*r->ssz;
+        if (r->chlen) { z += r->rawofs; len = r->rawlen[slot]; }
+        else len = r->len[slot];
+        for (o = 0; o < len; o += l) {
+            l = dft->N - sc->pos;
+            if (l > len-o) l = len-o;
+            memcpy(sc->x + sc->pos, z+o, l*sizeof(float complex));
+            sc->pos += l;
+            if (sc->pos == dft->N) {
+                scan_fft(sc);
+                sc->pos = 0;
+            }
+        }
+        sc->sample += len;
+        sc->rseq += 1;
+        atomic_store_explicit(&sc->cur->seq, sc->rseq, memory_order_release);
+    }
+
+    np = 0;
+    if (sc->nfft > 0) np = scan_eval(sc, fq, mag, max);
+    memset(sc->sum_db, 0, dft->N*sizeof(float));
+    sc->nfft = 0;
+    sc->sample = 0;
+
+    return np;
+}
@@ -0,0 +1,33 @@
+
+/*
+ *  rs_multi: scanner (scan.c)
+ *  included by demod_base.h
+ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+// scanner (rs_multi --scan): averaged power spectrum of the input IQ on its own
+// ring cursor, peaks as in scan_fft_pow.c
+typedef struct {
+    dft_t DFT;
+    iqr_cur_t *cur;
+    ui64_t rseq;
+    ui64_t skip;       // blocks skipped (scanner behind)
+    int pos;           // samples in x
+    int nfft;          // spectra in sum_db
+    ui64_t sample;     // input samples in this interval
+    ui64_t interval;   // input samples per scan
+    float complex *x;  // FFT block
+    float *db;
+    float *sum_db;
+    float *intdb;
+    float *peak;
+    int delay;
+} scan_t;
+
+int scan_init(stream_t *, scan_t *, float);
+int scan_peaks(stream_t *, scan_t *, float *, float *, int);
+void scan_free(scan_t *);
+
+#endif
@@ -0,0 +1,86 @@
+
+/*
+ *  rs_multi: thread placement (cpu, SCHED_FIFO), cpu usage
+ *  compile:
+ *      gcc -c thd.c
+ */
+
+/* ------------------------------------------------------------------------------------ */
+
+#define _GNU_SOURCE  // sched_setaffinity, RUSAGE_THREAD
+
+#include <stdio.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include "demod_base.h"
+
+/* ------------------------------------------------------------------------------------ */
+
+
+// thread placement (rs_multi --cpus, --cpu-in, --fifo): the calling thread is pinned
+// before it allocates its buffers (init_buffers), so with the kernel's first-touch
+// policy the pages come from the local NUMA node. Usage from getrusage(RUSAGE_THREAD).
+int thd_place(int cpu, int prio) {
+    int ret = 0;
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t cs;
+        CPU_ZERO(&cs);
+        CPU_SET(cpu, &cs);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs) != 0) ret = -1;
+    }
+    if (prio > 0) {
+        struct sched_param sp;
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = prio;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) ret = -1;
+    }
+#else
+    if (cpu >= 0 || prio > 0) ret = -1;
+#endif
+    return ret;
+}
+
+void thd_usage(thd_use_t *u) {
+    int cpu = u->cpu;
+    memset(u, 0, sizeof(*u));
+    u->cpu = cpu;
+#ifdef RUSAGE_THREAD
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        u->utime = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec*1e-6;
+        u->stime = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec*1e-6;
+        u->nivcsw = ru.ru_nivcsw;
+        u->nvcsw = ru.ru_nvcsw;
+    }
+#endif
+}
+
+void thd_report(const char *name, thd_use_t *u) {
+    char c[16] = "-";
+    if (u->cpu >= 0) snprintf(c, sizeof(c), "%d", u->cpu);
+    fprintf(stderr, "cpu: %-8s cpu %-3s  user %8.3f s  sys %7.3f s  ivcsw %6ld  vcsw %8ld\n",
+                    name, c, u->utime, u->stime, u->nivcsw, u->nvcsw);
+}
+
+// NUMA node of a cpu (sysfs), -1: unknown
+int cpu_node(int cpu) {
+    char path[64];
+    DIR *d;
+    struct dirent *e;
+    int node = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    d = opendir(path);
+    if (d == NULL) return -1;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+            node = atoi(e->d_name+4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
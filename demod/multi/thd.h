@@ -0,0 +1,15 @@
+
+/*
+ *  rs_multi: thread placement, cpu usage (thd.c)
+ *  included by demod_base.h
+ */
+
+#ifndef THD_H
+#define THD_H
+
+int thd_place(int, int);
+void thd_usage(thd_use_t *);
+void thd_report(const char *, thd_use_t *);
+int cpu_node(int);
+
+#endif
@@ -0,0 +1,237 @@
+
+/*
+ *  iq_bus: IQ stream -> shared-memory ring (shm_ring.c), any number of readers
+ *
+ *  gcc -O2 iq_bus.c -o iq_bus      (older glibc: -lrt)
+ *
+ *  rtl_sdr -f 404500000 -s 2400000 - | ./iq_bus sdr0 - 2400000 8
+ *  ./iq_bus sdr0 baseband_iq.wav     (file: real-time pacing, --fast: none)
+ *
+ *  readers: input "shm:<name>" instead of the file, e.g.
+ *    ./rs41mod --IQ 0.1 shm:sdr0
+ *    ./rs_multi --rs41 0.1 --dfm -0.2 shm:sdr0
+ *    ./dft_detect --IQ 0.0 shm:sdr0
+ *  readers attach and detach at any time; the writer never waits for a reader,
+ *  a reader that falls behind by the ring length loses blocks (overrun, per reader).
+ *
+ *  options:
+ *    --blk <bytes>  block size (default: 1/64 s, min 4096)
+ *    --sec <s>      ring length (default 4 s)
+ *    --fast         file input without pacing
+ *    --stat <s>     reader table every <s> seconds (stderr)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#ifdef CYGWIN
+  #include <fcntl.h>  // cygwin: _setmode()
+  #include <io.h>
+#endif
+
+#define SHM_WRITER
+#include "shm_ring.c"
+
+
+static int sample_rate = 0, bits_sample = 0, channels = 0;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static int findstr(char *buff, char *str, int pos) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (buff[(pos+i)%4] != str[i]) break;
+    }
+    return i;
+}
+
+static int read_wav_header(FILE *fp) {
+    char txt[4+1] = "\0\0\0\0";
+    unsigned char dat[4];
+    int byte, p=0;
+
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    if (strncmp(txt, "RIFF", 4)) return -1;
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    // pos_WAVE = 8L
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    if (strncmp(txt, "WAVE", 4)) return -1;
+    // pos_fmt = 12L
+    for ( ; ; ) {
+        if ( (byte=fgetc(fp)) == EOF ) return -1;
+        txt[p % 4] = byte;
+        p++; if (p==4) p=0;
+        if (findstr(txt, "fmt ", p) == 4) break;
+    }
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+    channels = dat[0] + (dat[1] << 8);
+
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    memcpy(&sample_rate, dat, 4);
+
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+    bits_sample = dat[0] + (dat[1] << 8);
+
+    // pos_dat = 36L + info
+    for ( ; ; ) {
+        if ( (byte=fgetc(fp)) == EOF ) return -1;
+        txt[p % 4] = byte;
+        p++; if (p==4) p=0;
+        if (findstr(txt, "data", p) == 4) break;
+    }
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+
+    return 0;
+}
+
+static void print_readers(shm_hdr_t *h) {
+    int k, pid;
+    fprintf(stderr, "iq_bus: %llu blocks\n", (unsigned long long)atomic_load(&h->wseq));
+    for (k = 0; k < SHM_MAXRD; k++) {
+        pid = atomic_load(&h->rd[k].pid);
+        if (pid == 0) continue;
+        fprintf(stderr, "  reader %2d  pid %6d  blocks %10llu  lost %8llu  lag %4llu\n", k, pid,
+                (unsigned long long)atomic_load(&h->rd[k].blocks),
+                (unsigned long long)atomic_load(&h->rd[k].overrun),
+                (unsigned long long)(atomic_load(&h->wseq) - atomic_load(&h->rd[k].rseq)));
+    }
+}
+
+
+int main(int argc, char **argv) {
+
+    FILE *fp = NULL;
+    char *name = NULL;
+    int blksz = 0;
+    float sec = 4.0, stat_sec = 0.0;
+    int option_fast = 0, pace = 0;
+    int fs, nslot;
+    shm_out_t w;
+    unsigned char *p;
+    size_t n, len;
+    double t, dt, t0 = 0, t_stat = 0;
+    struct timespec ts;
+    struct stat st;
+
+    (void)argc;
+
+#ifdef CYGWIN
+    _setmode(fileno(stdin), _O_BINARY);
+#endif
+
+    ++argv;
+    while (*argv) {
+        if      (strcmp(*argv, "--blk") == 0) {
+            ++argv;
+            if (*argv) blksz = atoi(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--sec") == 0) {
+            ++argv;
+            if (*argv) sec = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--stat") == 0) {
+            ++argv;
+            if (*argv) stat_sec = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--fast") == 0) {
+            option_fast = 1;
+        }
+        else if (name == NULL) {
+            name = *argv;
+        }
+        else if (strcmp(*argv, "-") == 0) {
+            if (argv[1] == NULL || argv[2] == NULL) return -1;
+            sample_rate = atoi(argv[1]);
+            bits_sample = atoi(argv[2]);
+            channels = 2;
+            argv += 2;
+            fp = stdin;
+        }
+        else {
+            fp = fopen(*argv, "rb");
+            if (fp == NULL) {
+                fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
+                return -1;
+            }
+            if (read_wav_header(fp) < 0) {
+                fprintf(stderr, "error: wav header\n");
+                return -1;
+            }
+        }
+        ++argv;
+    }
+    if (name == NULL || fp == NULL) {
+        fprintf(stderr, "iq_bus [--blk <bytes>] [--sec <s>] [--fast] [--stat <s>] <name> <iq.wav | - sr bps>\n");
+        return -1;
+    }
+    if (sample_rate < 1 || (bits_sample != 8 && bits_sample != 16 && bits_sample != 32) || channels < 1) {
+        fprintf(stderr, "error: sr %d, bps %d, nch %d\n", sample_rate, bits_sample, channels);
+        return -1;
+    }
+
+    fs = channels*bits_sample/8;
+    if (blksz <= 0) blksz = sample_rate/64 * fs;
+    if (blksz < 4096) blksz = 4096;
+    nslot = (int)(sec * sample_rate * fs / blksz) + 1;
+    if (nslot < 8) nslot = 8;
+
+    if (shm_create(&w, name, sample_rate, bits_sample, channels, blksz, nslot) < 0) {
+        fprintf(stderr, "error: shm %s\n", name);
+        return -1;
+    }
+    fprintf(stderr, "iq_bus: %s  sr %d  bps %d  nch %d  %d x %u bytes\n",
+            w.name, sample_rate, bits_sample, channels, nslot, w.h->blksz);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    pace = !option_fast && fp != stdin && fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode);
+
+    while (!stop) {
+        p = shm_wbuf(&w);
+        len = 0;
+        while (len < w.h->blksz) {  // whole block, pipe reads may be short
+            n = fread(p + len, 1, w.h->blksz - len, fp);
+            if (n == 0) break;
+            len += n;
+        }
+        if (len < (size_t)fs) break;
+        t = shm_now();
+        if (pace) {  // file: block end in real time
+            if (t0 == 0) t0 = t;
+            dt = t0 + (double)(w.sample + len/fs) / sample_rate - t;
+            if (dt > 0) {
+                ts.tv_sec = (time_t)dt;
+                ts.tv_nsec = (long)((dt - ts.tv_sec)*1e9);
+                nanosleep(&ts, NULL);
+                t = shm_now();
+            }
+        }
+        shm_publish(&w, len, t);
+        if (stat_sec > 0 && t - t_stat >= stat_sec) {
+            print_readers(w.h);
+            t_stat = t;
+        }
+    }
+
+    print_readers(w.h);
+    shm_close(&w);
+    if (fp != stdin) fclose(fp);
+
+    return 0;
+}
+
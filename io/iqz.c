@@ -0,0 +1,653 @@
+
+/*
+ *  iqz: chunked lossless IQ archive (u8/s16), index of chunk offsets, first sample, time
+ *    per sub-block (IQZ_SUB frames) and channel: predictor (x-mid or delta), common
+ *    low zero bits (s16 from 8 bit sources), Rice parameter k; residuals zigzag/Rice.
+ *    Chunks are independent: seek = index[sample/chunk], O(1).
+ *
+ *  #include "iqz.c"  // RS/io/  (-pthread; reader, #define IQZ_WRITER before: + writer)
+ *
+ *  writer (RS/io/iqzip.c): iqz_create(&w, path, sr, bps, nch, chunk, t0)
+ *                          iqz_write(&w, buf, frames, t) ... iqz_finish(&w)
+ *  reader (sample_io.c: sio_fopen("<name>.iqz")):
+ *          iqz_open(&z, path, nthr)  [iqz_seek(&z, frame)]
+ *          iqz_next(&z, &dat, &len)  decoded chunks in order, decoded ahead by nthr
+ *          threads into 2*nthr+2 slots; dat valid until the next call
+ *          iqz_close(&z)
+ *
+ *  file (little endian):
+ *    header 64:  "RSIQZ" 1 0 0, version, sr, bps(16), nch(16), chunk, frames(64), nchunk(64),
+ *                index offset(64), t0 (double, 0: unknown), 8 reserved
+ *    chunks, then the index, 32 per chunk: offset(64), len, frames, first sample(64), t (double)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define IQZ_VERSION  1
+#define IQZ_HDRSZ    64
+#define IQZ_IDXSZ    32
+#define IQZ_SUB      256       // frames per sub-block (predictor, shift, k)
+#define IQZ_ESC      20        // unary quotient >= IQZ_ESC: escape, 17 bit value
+#define IQZ_CHUNK    (1<<16)   // frames per chunk (default)
+#define IQZ_MAXTHR   16
+#define IQZ_NONE     (~0ULL)
+
+
+typedef struct {
+    uint64_t ofs;
+    uint32_t len;
+    uint32_t frames;
+    uint64_t sample;
+    double t;
+} iqz_idx_t;
+
+typedef struct {
+    FILE *fp;
+    int sr, bps, nch, fs;
+    int chunk;
+    unsigned char *in;     // chunk frames
+    int n;
+    unsigned char *out;
+    double t;              // time of the first frame in the chunk
+    uint64_t frames;
+    uint64_t ofs;
+    iqz_idx_t *idx;
+    uint64_t nchunk, maxchunk;
+    double t0;
+} iqz_out_t;
+
+typedef struct iqz_s {
+    unsigned char *map;
+    size_t maplen;
+    int sr, bps, nch, fs;
+    int chunk;
+    uint64_t frames;
+    uint64_t nchunk;
+    double t0;
+    iqz_idx_t *idx;
+    // decode ahead
+    int nthr, nslot;
+    pthread_t tid[IQZ_MAXTHR];
+    unsigned char **slot;
+    uint64_t *schk;        // chunk in slot, IQZ_NONE: none/being decoded
+    uint64_t next;         // next chunk for a worker
+    uint64_t cons;         // consumer: current chunk (slot in use)
+    uint64_t skip;         // frames in the first chunk (iqz_seek)
+    int run, stop, err;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv_ready, cv_free;
+    // sample_io.c: sio_fopen()
+    unsigned char wav[44];
+    int wpos;
+    unsigned char *cdat;
+    size_t clen, cpos;
+} iqz_t;
+
+
+static uint64_t iqz_rd(const unsigned char *p, int n) {
+    uint64_t v = 0;
+    while (n-- > 0) v = (v << 8) | p[n];
+    return v;
+}
+
+static double iqz_rdd(const unsigned char *p) {
+    uint64_t v = iqz_rd(p, 8);
+    double d;
+    memcpy(&d, &v, 8);
+    return d;
+}
+
+#ifdef IQZ_WRITER
+static void iqz_le(unsigned char *p, uint64_t v, int n) {
+    while (n-- > 0) { *p++ = v & 0xFF; v >>= 8; }
+}
+
+static void iqz_led(unsigned char *p, double d) {
+    uint64_t v;
+    memcpy(&v, &d, 8);
+    iqz_le(p, v, 8);
+}
+#endif
+
+/* ------------------------------------------------------------------------------------ */
+
+typedef struct {  // MSB first
+    unsigned char *p;
+    uint64_t acc;
+    int n;
+} iqz_bw_t;
+
+static inline void bw_put(iqz_bw_t *b, uint32_t v, int n) {  // n <= 32
+    b->acc = (b->acc << n) | (v & ((n < 32 ? (1ULL << n) : 0x100000000ULL) - 1));
+    b->n += n;
+    while (b->n >= 8) {
+        b->n -= 8;
+        *b->p++ = (unsigned char)(b->acc >> b->n);
+    }
+}
+
+static inline void bw_ones(iqz_bw_t *b, int n) {
+    while (n > 24) { bw_put(b, 0xFFFFFF, 24); n -= 24; }
+    bw_put(b, (1u << n) - 1, n);
+}
+
+typedef struct {
+    const unsigned char *p, *end;
+    uint64_t acc;   // bits left aligned
+    int n;
+    int pad;        // zero bits past the end
+} iqz_br_t;
+
+static inline void br_fill(iqz_br_t *b) {  // >= 57 bits
+    if (b->end - b->p >= 8) {  // 8 bytes at once, whole bytes counted (n: 56..63)
+        uint64_t v;
+        memcpy(&v, b->p, 8);
+        b->acc |= __builtin_bswap64(v) >> b->n;
+        b->p += (63 - b->n) >> 3;
+        b->n |= 56;
+        return;
+    }
+    while (b->n <= 56) {
+        if (b->p < b->end) b->acc |= (uint64_t)*b->p++ << (56 - b->n);
+        else b->pad += 8;  // past the end: zeros
+        b->n += 8;
+    }
+}
+
+static inline uint32_t br_bits(iqz_br_t *b, int n) {  // n <= 32, no refill
+    uint32_t v;
+    if (n == 0) return 0;
+    v = (uint32_t)(b->acc >> (64 - n));
+    b->acc <<= n;
+    b->n -= n;
+    return v;
+}
+
+static inline uint32_t br_get(iqz_br_t *b, int n) {
+    br_fill(b);
+    return br_bits(b, n);
+}
+
+#define IQZ_MAXCODE  (IQZ_ESC+17)  // bits of the longest code
+
+// one Rice code (parameter k): unary quotient up to the 0 (IQZ_ESC ones: escape,
+// 17 bit value), k bit remainder; >= IQZ_MAXCODE bits in acc, no refill
+static inline uint32_t br_rice(iqz_br_t *b, int k) {
+    uint64_t a = b->acc;
+    int q = __builtin_clzll(~a | (1ULL << (63 - IQZ_ESC)));
+    uint32_t u;
+    if (q < IQZ_ESC) {
+        a <<= q+1;
+        u = ((uint32_t)q << k) | (uint32_t)((a >> 1) >> (63 - k));  // k = 0: 0
+        b->acc = a << k;
+        b->n -= q+1+k;
+    }
+    else {
+        a <<= q;
+        u = (uint32_t)(a >> (64 - 17));
+        b->acc = a << 17;
+        b->n -= q+17;
+    }
+    return u;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+static inline int iqz_smp(const unsigned char *p, int bps) {
+    if (bps == 8) return p[0] - 128;
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void iqz_put_smp(unsigned char *p, int bps, int v) {
+    if (bps == 8) p[0] = v + 128;
+    else { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; }
+}
+
+#ifdef IQZ_WRITER
+// frames (bps/nch) -> out; out: frames*nch*5 + 64 bytes
+static size_t iqz_enc_chunk(const unsigned char *in, int frames, int bps, int nch, unsigned char *out) {
+    iqz_bw_t b = { out, 0, 0 };
+    int bs = bps/8, fs = nch*bs;
+    int c, j, s, n, pred, shift, k, q, prev, x, r;
+    int buf[IQZ_SUB];
+    uint32_t u, orv;
+    uint64_t sum0, sum1, sum;
+
+    for (c = 0; c < nch; c++) {
+        prev = 0;
+        for (s = 0; s < frames; s += IQZ_SUB) {
+            n = frames - s < IQZ_SUB ? frames - s : IQZ_SUB;
+            orv = 0;
+            for (j = 0; j < n; j++) {
+                buf[j] = iqz_smp(in + (size_t)(s+j)*fs + c*bs, bps);
+                orv |= (uint32_t)buf[j];
+            }
+            shift = orv ? __builtin_ctz(orv) : 0;
+            if (shift > 15) shift = 15;
+            sum0 = sum1 = 0;
+            for (j = 0; j < n; j++) {
+                x = buf[j] >> shift;
+                sum0 += x < 0 ? -x : x;
+                r = x - (j ? buf[j-1] >> shift : prev >> shift);
+                sum1 += r < 0 ? -r : r;
+            }
+            pred = sum1 < sum0;
+            sum = 2*(pred ? sum1 : sum0);  // zigzag
+            for (k = 0; k < 16 && ((uint64_t)n << (k+1)) <= sum; k++);
+
+            bw_put(&b, pred, 1);
+            bw_put(&b, shift, 4);
+            bw_put(&b, k, 5);
+            for (j = 0; j < n; j++) {
+                x = buf[j] >> shift;
+                r = pred ? x - (j ? buf[j-1] >> shift : prev >> shift) : x;
+                u = ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+                q = u >> k;
+                if (q < IQZ_ESC) {
+                    bw_ones(&b, q);
+                    bw_put(&b, 0, 1);
+                    bw_put(&b, u, k);
+                }
+                else {
+                    bw_ones(&b, IQZ_ESC);
+                    bw_put(&b, u, 17);
+                }
+            }
+            prev = buf[n-1];
+        }
+    }
+    if (b.n > 0) bw_put(&b, 0, 8 - b.n);
+    return b.p - out;
+}
+#endif
+
+// block Rice decoding, small k (u8 captures: often 1-2 bits/sample): one lookup of the
+// next IQZ_TABW bits gives all complete codes in it (up to 7 residuals, bits used);
+// no complete code (long quotient, escape) or past the sub-block: one code (br_rice())
+#define IQZ_TABK  1
+#define IQZ_TABW  10
+
+static uint64_t iqz_tab[IQZ_TABK+1][1 << IQZ_TABW];  // cnt | bits<<3 | r[i]<<8*(i+1)
+static pthread_once_t iqz_tab_once = PTHREAD_ONCE_INIT;
+
+static void iqz_tab_init(void) {
+    int k, w, pos, q, c, l;
+    uint32_t u;
+    uint64_t e;
+
+    for (k = 0; k <= IQZ_TABK; k++) {
+        for (w = 0; w < (1 << IQZ_TABW); w++) {
+            e = 0;
+            pos = 0;
+            for (c = 0; c < 7; c++) {
+                for (q = 0; pos+q < IQZ_TABW && (w >> (IQZ_TABW-1-pos-q) & 1); q++);
+                l = q+1+k;
+                if (pos + l > IQZ_TABW) break;
+                u = ((uint32_t)q << k) | ((w >> (IQZ_TABW-pos-l)) & ((1 << k) - 1));
+                e |= (uint64_t)(uint8_t)(int8_t)((int)(u >> 1) ^ -(int)(u & 1)) << 8*(c+1);
+                pos += l;
+            }
+            iqz_tab[k][w] = e | c | pos << 3;
+        }
+    }
+}
+
+// sub-block: n residuals -> samples, refill only below one longest code
+// (a refill holds >= 56 bits, i.e. several codes); predictor as mask, no branch
+#define IQZ_DEC_SUB(PUT) \
+    if (k <= IQZ_TABK) { \
+        const uint64_t *t = iqz_tab[k]; \
+        for (j = 0; j < n; ) { \
+            if (b.n < IQZ_MAXCODE) br_fill(&b); \
+            e = t[b.acc >> (64 - IQZ_TABW)]; \
+            nc = e & 7; \
+            if (nc == 0 || nc > n-j) { \
+                u = br_rice(&b, k); \
+                x = (x & m) + ((int)(u >> 1) ^ -(int)(u & 1)); \
+                PUT; \
+                p += fs; \
+                j += 1; \
+                continue; \
+            } \
+            l = (e >> 3) & 15; \
+            b.acc <<= l; \
+            b.n -= l; \
+            j += nc; \
+            do { \
+                e >>= 8; \
+                x = (x & m) + (int8_t)(e & 0xFF); \
+                PUT; \
+                p += fs; \
+            } while (--nc); \
+        } \
+    } \
+    else { \
+        for (j = 0; j < n; j++) { \
+            if (b.n < IQZ_MAXCODE) br_fill(&b); \
+            u = br_rice(&b, k); \
+            x = (x & m) + ((int)(u >> 1) ^ -(int)(u & 1)); \
+            PUT; \
+            p += fs; \
+        } \
+    }
+
+static inline __attribute__((always_inline))
+int iqz_dec(const unsigned char *in, size_t len, int frames, int bps, int nch, unsigned char *out) {
+    iqz_br_t b = { in, in + len, 0, 0, 0 };
+    int bs = bps/8, fs = nch*bs;
+    int c, j, s, n, m, shift, k, prev, x, v, l, nc;
+    uint32_t u;
+    uint64_t e;
+    unsigned char *p;
+
+    for (c = 0; c < nch; c++) {
+        prev = 0;
+        for (s = 0; s < frames; s += IQZ_SUB) {
+            n = frames - s < IQZ_SUB ? frames - s : IQZ_SUB;
+            m = -(int)br_get(&b, 1);  // delta: x += r
+            shift = br_get(&b, 4);
+            k = br_get(&b, 5);
+            if (k > 16) return -1;
+            x = prev >> shift;
+            p = out + (size_t)s*fs + c*bs;
+            if (bps == 8) {
+                IQZ_DEC_SUB(p[0] = (x * (1 << shift)) + 128)
+            }
+            else {
+                IQZ_DEC_SUB(v = x * (1 << shift); p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF)
+            }
+            prev = x * (1 << shift);
+        }
+    }
+    return b.pad > b.n ? -1 : 0;  // read past the end: corrupt
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+  #define IQZ_X86
+// lzcnt, shlx/shrx: the code length chain (clz, shifts) is the decoder's critical path
+__attribute__((target("lzcnt,bmi2")))
+static int iqz_dec_bmi2(const unsigned char *in, size_t len, int frames, int bps, int nch, unsigned char *out) {
+    return iqz_dec(in, len, frames, bps, nch, out);
+}
+#endif
+
+static int iqz_dec_chunk(const unsigned char *in, size_t len, int frames, int bps, int nch, unsigned char *out) {
+    pthread_once(&iqz_tab_once, iqz_tab_init);
+#ifdef IQZ_X86
+    if (__builtin_cpu_supports("lzcnt") && __builtin_cpu_supports("bmi2")) {
+        return iqz_dec_bmi2(in, len, frames, bps, nch, out);
+    }
+#endif
+    return iqz_dec(in, len, frames, bps, nch, out);
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+#ifdef IQZ_WRITER
+static int iqz_create(iqz_out_t *w, const char *path, int sr, int bps, int nch, int chunk, double t0) {
+    unsigned char h[IQZ_HDRSZ];
+
+    memset(w, 0, sizeof(*w));
+    if ((bps != 8 && bps != 16) || nch < 1 || sr < 1) return -1;
+    if (chunk <= 0) chunk = IQZ_CHUNK;
+    w->sr = sr;  w->bps = bps;  w->nch = nch;
+    w->fs = nch*bps/8;
+    w->chunk = chunk;
+    w->t0 = t0;
+    w->in  = malloc((size_t)chunk*w->fs);
+    w->out = malloc((size_t)chunk*nch*5 + 64);
+    w->maxchunk = 1024;
+    w->idx = calloc(w->maxchunk, sizeof(iqz_idx_t));
+    if (w->in == NULL || w->out == NULL || w->idx == NULL) return -1;
+    w->fp = fopen(path, "wb");
+    if (w->fp == NULL) return -1;
+    memset(h, 0, IQZ_HDRSZ);  // header at iqz_finish()
+    if (fwrite(h, 1, IQZ_HDRSZ, w->fp) != IQZ_HDRSZ) return -1;
+    w->ofs = IQZ_HDRSZ;
+    return 0;
+}
+
+static int iqz_flush(iqz_out_t *w) {
+    iqz_idx_t *x;
+    size_t len;
+
+    if (w->n == 0) return 0;
+    if (w->nchunk == w->maxchunk) {
+        x = realloc(w->idx, 2*w->maxchunk*sizeof(iqz_idx_t));  if (x == NULL) return -1;
+        w->idx = x;
+        w->maxchunk *= 2;
+    }
+    len = iqz_enc_chunk(w->in, w->n, w->bps, w->nch, w->out);
+    if (fwrite(w->out, 1, len, w->fp) != len) return -1;
+    x = &w->idx[w->nchunk++];
+    x->ofs = w->ofs;
+    x->len = len;
+    x->frames = w->n;
+    x->sample = w->frames;
+    x->t = w->t;
+    w->ofs += len;
+    w->frames += w->n;
+    w->n = 0;
+    return 0;
+}
+
+// frames (whole frames), t: time of the first frame (chunk time: first frame of the chunk)
+static int iqz_write(iqz_out_t *w, const unsigned char *buf, int frames, double t) {
+    int l;
+    while (frames > 0) {
+        if (w->n == 0) w->t = t;
+        l = w->chunk - w->n;
+        if (l > frames) l = frames;
+        memcpy(w->in + (size_t)w->n*w->fs, buf, (size_t)l*w->fs);
+        w->n += l;
+        buf += (size_t)l*w->fs;
+        frames -= l;
+        t += (double)l / w->sr;
+        if (w->n == w->chunk && iqz_flush(w) < 0) return -1;
+    }
+    return 0;
+}
+
+static int iqz_finish(iqz_out_t *w) {
+    unsigned char h[IQZ_HDRSZ], e[IQZ_IDXSZ];
+    uint64_t k;
+    int ret = 0;
+
+    if (w->fp == NULL) return -1;
+    if (iqz_flush(w) < 0) ret = -1;
+    for (k = 0; k < w->nchunk && ret == 0; k++) {
+        iqz_le(e, w->idx[k].ofs, 8);
+        iqz_le(e+8, w->idx[k].len, 4);
+        iqz_le(e+12, w->idx[k].frames, 4);
+        iqz_le(e+16, w->idx[k].sample, 8);
+        iqz_led(e+24, w->idx[k].t);
+        if (fwrite(e, 1, IQZ_IDXSZ, w->fp) != IQZ_IDXSZ) ret = -1;
+    }
+    memset(h, 0, IQZ_HDRSZ);
+    memcpy(h, "RSIQZ\1\0\0", 8);
+    iqz_le(h+8, IQZ_VERSION, 4);
+    iqz_le(h+12, w->sr, 4);
+    iqz_le(h+16, w->bps, 2);
+    iqz_le(h+18, w->nch, 2);
+    iqz_le(h+20, w->chunk, 4);
+    iqz_le(h+24, w->frames, 8);
+    iqz_le(h+32, w->nchunk, 8);
+    iqz_le(h+40, w->ofs, 8);
+    iqz_led(h+48, w->t0);
+    if (fseek(w->fp, 0, SEEK_SET) != 0 || fwrite(h, 1, IQZ_HDRSZ, w->fp) != IQZ_HDRSZ) ret = -1;
+    if (fclose(w->fp) != 0) ret = -1;
+    w->fp = NULL;
+    free(w->in);  free(w->out);  free(w->idx);
+    return ret;
+}
+#endif
+
+/* ------------------------------------------------------------------------------------ */
+
+static int iqz_open(iqz_t *z, const char *path, int nthr) {
+    struct stat st;
+    unsigned char *h, *e;
+    uint64_t ofs, k;
+    int fd;
+
+    memset(z, 0, sizeof(*z));
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) < 0 || st.st_size < IQZ_HDRSZ) { close(fd); return -1; }
+    z->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (z->map == MAP_FAILED) { z->map = NULL; return -1; }
+    z->maplen = st.st_size;
+    h = z->map;
+    if (memcmp(h, "RSIQZ\1\0\0", 8) != 0 || iqz_rd(h+8, 4) != IQZ_VERSION) goto fail;
+    z->sr = iqz_rd(h+12, 4);
+    z->bps = iqz_rd(h+16, 2);
+    z->nch = iqz_rd(h+18, 2);
+    z->chunk = iqz_rd(h+20, 4);
+    z->frames = iqz_rd(h+24, 8);
+    z->nchunk = iqz_rd(h+32, 8);
+    ofs = iqz_rd(h+40, 8);
+    z->t0 = iqz_rdd(h+48);
+    if ((z->bps != 8 && z->bps != 16) || z->nch < 1 || z->chunk < 1 || z->sr < 1) goto fail;
+    if (ofs > z->maplen || (z->maplen - ofs) / IQZ_IDXSZ < z->nchunk) goto fail;
+    z->fs = z->nch * z->bps/8;
+
+    z->idx = calloc(z->nchunk + 1, sizeof(iqz_idx_t));  if (z->idx == NULL) goto fail;
+    for (k = 0; k < z->nchunk; k++) {
+        e = z->map + ofs + k*IQZ_IDXSZ;
+        z->idx[k].ofs = iqz_rd(e, 8);
+        z->idx[k].len = iqz_rd(e+8, 4);
+        z->idx[k].frames = iqz_rd(e+12, 4);
+        z->idx[k].sample = iqz_rd(e+16, 8);
+        z->idx[k].t = iqz_rdd(e+24);
+        if (z->idx[k].ofs + z->idx[k].len > ofs || z->idx[k].frames > (uint32_t)z->chunk) goto fail;
+        if (z->idx[k].sample != k*z->chunk) goto fail;  // full chunks (iqz_seek())
+    }
+    madvise(z->map, z->maplen, MADV_SEQUENTIAL);
+
+    if (nthr < 1) nthr = 1;
+    if (nthr > IQZ_MAXTHR) nthr = IQZ_MAXTHR;
+    z->nthr = nthr;
+    z->nslot = 2*nthr + 2;
+    z->slot = calloc(z->nslot, sizeof(unsigned char *));
+    z->schk = calloc(z->nslot, sizeof(uint64_t));
+    if (z->slot == NULL || z->schk == NULL) goto fail;
+    for (k = 0; k < (uint64_t)z->nslot; k++) {
+        z->slot[k] = malloc((size_t)z->chunk * z->fs);  if (z->slot[k] == NULL) goto fail;
+        z->schk[k] = IQZ_NONE;
+    }
+    pthread_mutex_init(&z->mtx, NULL);
+    pthread_cond_init(&z->cv_ready, NULL);
+    pthread_cond_init(&z->cv_free, NULL);
+    return 0;
+
+fail:
+    if (z->slot) { for (k = 0; k < (uint64_t)z->nslot; k++) free(z->slot[k]); free(z->slot); }
+    free(z->schk);
+    free(z->idx);
+    munmap(z->map, z->maplen);
+    z->map = NULL;
+    return -1;
+}
+
+// before the first iqz_next()
+static int iqz_seek(iqz_t *z, uint64_t frame) {
+    if (z->run) return -1;
+    if (frame > z->frames) frame = z->frames;
+    z->next = z->cons = frame / z->chunk;
+    z->skip = frame % z->chunk;
+    return 0;
+}
+
+static void *iqz_worker(void *arg) {
+    iqz_t *z = arg;
+    iqz_idx_t *x;
+    uint64_t c;
+    int s, e;
+
+    pthread_mutex_lock(&z->mtx);
+    while (!z->stop) {
+        c = z->next;
+        if (c >= z->nchunk) break;
+        if (c >= z->cons + z->nslot) {  // slot of chunk c-nslot still in use
+            pthread_cond_wait(&z->cv_free, &z->mtx);
+            continue;
+        }
+        z->next += 1;
+        s = c % z->nslot;
+        pthread_mutex_unlock(&z->mtx);
+
+        x = &z->idx[c];
+        e = iqz_dec_chunk(z->map + x->ofs, x->len, x->frames, z->bps, z->nch, z->slot[s]);
+
+        pthread_mutex_lock(&z->mtx);
+        if (e < 0) z->err = 1;
+        z->schk[s] = c;
+        pthread_cond_broadcast(&z->cv_ready);
+    }
+    pthread_mutex_unlock(&z->mtx);
+    return NULL;
+}
+
+// next chunk (frames in order): 1: *dat, *len bytes; 0: end, -1: error
+static int iqz_next(iqz_t *z, unsigned char **dat, size_t *len) {
+    uint64_t c;
+    int s, k;
+
+    pthread_mutex_lock(&z->mtx);
+    if (!z->run) {
+        z->run = 1;
+        for (k = 0; k < z->nthr; k++) {
+            if (pthread_create(&z->tid[k], NULL, iqz_worker, z) != 0) break;
+        }
+        z->nthr = k;
+        z->cons -= 1;  // first call: nothing to release
+    }
+    // release the current chunk
+    c = z->cons + 1;
+    if (c > 0) z->schk[(c-1) % z->nslot] = IQZ_NONE;
+    z->cons = c;
+    pthread_cond_broadcast(&z->cv_free);
+
+    if (c >= z->nchunk || z->nthr == 0) {
+        pthread_mutex_unlock(&z->mtx);
+        return 0;
+    }
+    s = c % z->nslot;
+    while (z->schk[s] != c && !z->err) pthread_cond_wait(&z->cv_ready, &z->mtx);
+    pthread_mutex_unlock(&z->mtx);
+    if (z->err) return -1;
+
+    *dat = z->slot[s] + z->skip * z->fs;
+    *len = (size_t)(z->idx[c].frames - z->skip) * z->fs;
+    z->skip = 0;
+    return 1;
+}
+
+static void iqz_close(iqz_t *z) {
+    int k;
+    if (z->map == NULL) return;
+    pthread_mutex_lock(&z->mtx);
+    z->stop = 1;
+    pthread_cond_broadcast(&z->cv_free);
+    pthread_mutex_unlock(&z->mtx);
+    for (k = 0; k < z->nthr && z->run; k++) pthread_join(z->tid[k], NULL);
+    for (k = 0; k < z->nslot; k++) free(z->slot[k]);
+    free(z->slot);
+    free(z->schk);
+    free(z->idx);
+    pthread_mutex_destroy(&z->mtx);
+    pthread_cond_destroy(&z->cv_ready);
+    pthread_cond_destroy(&z->cv_free);
+    munmap(z->map, z->maplen);
+    z->map = NULL;
+}
+
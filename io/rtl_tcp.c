@@ -0,0 +1,192 @@
+
+/*
+ *  rtl_tcp client (network input)
+ *    rtl_tcp:<host>[:<port>][?s=<sr>&f=<Hz>&g=<dB>&p=<ppm>&r=<retries>]
+ *    default port 1234, s=2048000 (rtl_tcp default), g: auto gain, r=5
+ *
+ *  server -> client: header "RTL0", tuner type, gain count (12 bytes, big endian),
+ *                    then u8 IQ
+ *  client -> server: commands, 1 byte + 4 bytes parameter (big endian)
+ *
+ *  #include "rtl_tcp.c"  // RS/io/  (sample_io.c: sio_fopen("rtl_tcp:..."))
+ *
+ *  tcp_open(&t, spec), tcp_recv(&t, buf, n), tcp_close(&t)
+ *  A broken connection is reopened (r attempts, 1 s apart), the settings are sent
+ *  again; the stream continues frame aligned (a split IQ pair is completed with 128).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define TCP_PORT     "1234"
+#define TCP_SR       2048000
+#define TCP_RETRY    5
+#define TCP_RCVBUF   (4<<20)
+
+// rtl_tcp commands
+#define TCP_FREQ      0x01
+#define TCP_SRATE     0x02
+#define TCP_GAINMODE  0x03  // 0: auto, 1: manual
+#define TCP_GAIN      0x04  // tenths dB
+#define TCP_PPM       0x05
+#define TCP_AGC       0x08
+
+
+typedef struct rtl_tcp_s {
+    char host[128];
+    char port[16];
+    int fd;
+    unsigned sr;
+    unsigned freq;       // 0: not set
+    int gain;            // tenths dB, <0: auto
+    int ppm;
+    int retry;
+    unsigned tuner;      // header: tuner type
+    unsigned ngain;
+    unsigned long long cnt;    // bytes, this connection
+    unsigned long long bytes;  // total
+    int reconnects;
+    unsigned char wav[44];     // sample_io.c: sio_fopen()
+    int wpos;
+} rtl_tcp_t;
+
+
+static int tcp_cmd(rtl_tcp_t *t, int cmd, unsigned param) {
+    unsigned char b[5];
+    b[0] = cmd;
+    b[1] = param >> 24;  b[2] = param >> 16;  b[3] = param >> 8;  b[4] = param;
+    return send(t->fd, b, 5, MSG_NOSIGNAL) == 5 ? 0 : -1;
+}
+
+static int tcp_connect(rtl_tcp_t *t) {
+    struct addrinfo hints, *res, *ai;
+    unsigned char h[12];
+    int fd = -1, k, n, one = 1, rb = TCP_RCVBUF;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(t->host, t->port, &hints, &res) != 0) return -1;
+    for (ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rb, sizeof(rb));  // before connect(): window
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // commands
+
+    for (k = 0; k < 12; k += n) {
+        n = recv(fd, h+k, 12-k, 0);
+        if (n <= 0) { close(fd); return -1; }
+    }
+    if (memcmp(h, "RTL0", 4) != 0) { close(fd); return -1; }
+    t->tuner = (h[4]<<24) | (h[5]<<16) | (h[6]<<8) | h[7];
+    t->ngain = (h[8]<<24) | (h[9]<<16) | (h[10]<<8) | h[11];
+
+    t->fd = fd;
+    t->cnt = 0;
+    if (tcp_cmd(t, TCP_SRATE, t->sr) < 0) { close(fd); t->fd = -1; return -1; }
+    if (t->freq) tcp_cmd(t, TCP_FREQ, t->freq);
+    if (t->ppm) tcp_cmd(t, TCP_PPM, (unsigned)t->ppm);
+    if (t->gain >= 0) {
+        tcp_cmd(t, TCP_GAINMODE, 1);
+        tcp_cmd(t, TCP_GAIN, (unsigned)t->gain);
+    }
+    else tcp_cmd(t, TCP_GAINMODE, 0);
+
+    return 0;
+}
+
+static int tcp_open(rtl_tcp_t *t, const char *spec) {
+    const char *q, *c;
+    size_t l;
+
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+    t->sr = TCP_SR;
+    t->gain = -1;
+    t->retry = TCP_RETRY;
+    strcpy(t->port, TCP_PORT);
+
+    q = strchr(spec, '?');
+    l = q ? (size_t)(q - spec) : strlen(spec);
+    c = memchr(spec, ':', l);
+    if (c) {
+        if ((size_t)(c - spec) >= sizeof(t->host) || l - (c-spec) - 1 >= sizeof(t->port)) return -1;
+        memcpy(t->host, spec, c - spec);
+        memcpy(t->port, c+1, l - (c-spec) - 1);
+        t->port[l - (c-spec) - 1] = '\0';
+    }
+    else {
+        if (l >= sizeof(t->host)) return -1;
+        memcpy(t->host, spec, l);
+    }
+    while (q && q[1]) {
+        q += 1;
+        if      (q[0] == 's' && q[1] == '=') t->sr = atof(q+2);
+        else if (q[0] == 'f' && q[1] == '=') t->freq = atof(q+2);
+        else if (q[0] == 'g' && q[1] == '=') t->gain = (int)(atof(q+2)*10.0 + 0.5);
+        else if (q[0] == 'p' && q[1] == '=') t->ppm = atoi(q+2);
+        else if (q[0] == 'r' && q[1] == '=') t->retry = atoi(q+2);
+        q = strchr(q, '&');
+    }
+    if (t->sr == 0) return -1;
+
+    if (tcp_connect(t) < 0) return -1;
+    fprintf(stderr, "rtl_tcp: %s:%s  tuner %u  sr %u  f %u\n", t->host, t->port, t->tuner, t->sr, t->freq);
+    return 0;
+}
+
+// up to n bytes (blocking), 0: end (connection lost, no reconnect)
+static ssize_t tcp_recv(rtl_tcp_t *t, void *buf, size_t n) {
+    ssize_t r;
+    int k;
+
+    while (1) {
+        if (t->fd >= 0) {
+            r = recv(t->fd, buf, n, 0);
+            if (r > 0) {
+                t->cnt += r;
+                t->bytes += r;
+                return r;
+            }
+            if (r < 0 && errno == EINTR) continue;
+            close(t->fd);
+            t->fd = -1;
+            if (t->cnt & 1) { // complete the IQ pair
+                t->cnt += 1;
+                t->bytes += 1;
+                *(unsigned char *)buf = 128;
+                return 1;
+            }
+        }
+        for (k = 0; k < t->retry; k++) {
+            struct timespec ts = {1, 0};
+            nanosleep(&ts, NULL);
+            if (tcp_connect(t) == 0) break;
+        }
+        if (t->fd < 0) return 0;
+        t->reconnects += 1;
+        fprintf(stderr, "rtl_tcp: %s:%s reconnected (%d)\n", t->host, t->port, t->reconnects);
+    }
+}
+
+static void tcp_close(rtl_tcp_t *t) {
+    if (t->fd >= 0) close(t->fd);
+    t->fd = -1;
+    fprintf(stderr, "rtl_tcp: %s:%s  %llu bytes, %d reconnects\n", t->host, t->port, t->bytes, t->reconnects);
+}
+
@@ -0,0 +1,314 @@
+
+/*
+ *  rtl_tcp_replay: rtl_tcp server that streams a recording (no hardware)
+ *
+ *  gcc -O2 rtl_tcp_replay.c -o rtl_tcp_replay
+ *
+ *  ./rtl_tcp_replay baseband_iq.wav           (port 1234, real-time pacing)
+ *  ./rs41mod --IQ 0.1 rtl_tcp:127.0.0.1:1234?s=<sr>
+ *  ./rs_multi --rs41 0.1 --dfm -0.2 rtl_tcp:localhost
+ *
+ *  u8/s16/f32 IQ (wav, or raw: - sr bps) is sent as u8 IQ after the rtl_tcp header
+ *  ("RTL0", tuner type, gain count); client commands are logged (stderr), a sample
+ *  rate other than the recording is reported, not resampled.
+ *  One client at a time; the recording plays on between clients (like a receiver),
+ *  a client that connects later starts at the current position.
+ *
+ *  options:
+ *    --port <p>   (default 1234)
+ *    --fast       no pacing (file)
+ *    --loop       restart at the end of the file
+ *    --drop <s>   close the connection every <s> seconds (client reconnect)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#ifdef CYGWIN
+  #include <fcntl.h>  // cygwin: _setmode()
+  #include <io.h>
+#endif
+
+#define TUNER_R820T  5
+#define NGAIN        29
+
+
+static int sample_rate = 0, bits_sample = 0, channels = 0;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static int findstr(char *buff, char *str, int pos) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        if (buff[(pos+i)%4] != str[i]) break;
+    }
+    return i;
+}
+
+static int read_wav_header(FILE *fp) {
+    char txt[4+1] = "\0\0\0\0";
+    unsigned char dat[4];
+    int byte, p=0;
+
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    if (strncmp(txt, "RIFF", 4)) return -1;
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    // pos_WAVE = 8L
+    if (fread(txt, 1, 4, fp) < 4) return -1;
+    if (strncmp(txt, "WAVE", 4)) return -1;
+    // pos_fmt = 12L
+    for ( ; ; ) {
+        if ( (byte=fgetc(fp)) == EOF ) return -1;
+        txt[p % 4] = byte;
+        p++; if (p==4) p=0;
+        if (findstr(txt, "fmt ", p) == 4) break;
+    }
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+    channels = dat[0] + (dat[1] << 8);
+
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    memcpy(&sample_rate, dat, 4);
+
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+
+    if (fread(dat, 1, 2, fp) < 2) return -1;
+    bits_sample = dat[0] + (dat[1] << 8);
+
+    // pos_dat = 36L + info
+    for ( ; ; ) {
+        if ( (byte=fgetc(fp)) == EOF ) return -1;
+        txt[p % 4] = byte;
+        p++; if (p==4) p=0;
+        if (findstr(txt, "data", p) == 4) break;
+    }
+    if (fread(dat, 1, 4, fp) < 4) return -1;
+
+    return 0;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// n frames (channels 0,1) -> u8 IQ
+static void to_u8(const unsigned char *p, unsigned char *q, int n) {
+    int k, c, v;
+    for (k = 0; k < n; k++) {
+        for (c = 0; c < 2; c++) {
+            if (bits_sample == 8) v = p[c];
+            else if (bits_sample == 16) v = ((short)(p[2*c] | (p[2*c+1] << 8)) + 32768 + 128) >> 8;
+            else {
+                float f;
+                memcpy(&f, p+4*c, 4);
+                v = (int)(f*128.0f + 128.0f);
+            }
+            if (v < 0) v = 0;
+            if (v > 255) v = 255;
+            q[2*k+c] = v;
+        }
+        p += channels*bits_sample/8;
+    }
+}
+
+// client commands (5 bytes), 0: ok, -1: connection closed
+static int read_cmd(int fd) {
+    static const char *name[] = { "", "freq", "sample rate", "gain mode", "gain", "ppm",
+                                  "if gain", "test mode", "agc", "direct sampling", "offset tuning",
+                                  "rtl xtal", "tuner xtal", "gain index", "bias tee" };
+    unsigned char b[5];
+    unsigned param;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int n, k;
+
+    while (poll(&pfd, 1, 0) > 0) {
+        if (pfd.revents & (POLLERR | POLLHUP)) return -1;
+        for (k = 0; k < 5; k += n) {
+            n = recv(fd, b+k, 5-k, 0);
+            if (n <= 0) return -1;
+        }
+        param = (b[1]<<24) | (b[2]<<16) | (b[3]<<8) | b[4];
+        fprintf(stderr, "rtl_tcp_replay: cmd 0x%02x %s %u\n", b[0], b[0] < 15 ? name[b[0]] : "?", param);
+        if (b[0] == 0x02 && param != (unsigned)sample_rate) {
+            fprintf(stderr, "rtl_tcp_replay: sample rate %u requested, recording %d\n", param, sample_rate);
+        }
+    }
+    return 0;
+}
+
+
+int main(int argc, char **argv) {
+
+    FILE *fp = NULL;
+    int port = 1234;
+    int option_fast = 0, option_loop = 0, pace = 0;
+    float drop_sec = 0.0;
+    int srv, fd = -1, one = 1;
+    struct sockaddr_in sa;
+    unsigned char h[12];
+    unsigned char *raw, *buf;
+    long data_ofs = 0;
+    int fs, blk, n;
+    unsigned long long sample = 0, bytes = 0;
+    double t0 = 0, tc = 0, dt;
+    struct timespec ts;
+
+    (void)argc;
+
+#ifdef CYGWIN
+    _setmode(fileno(stdin), _O_BINARY);
+#endif
+
+    ++argv;
+    while (*argv) {
+        if      (strcmp(*argv, "--port") == 0) {
+            ++argv;
+            if (*argv) port = atoi(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--drop") == 0) {
+            ++argv;
+            if (*argv) drop_sec = atof(*argv); else return -1;
+        }
+        else if (strcmp(*argv, "--fast") == 0) option_fast = 1;
+        else if (strcmp(*argv, "--loop") == 0) option_loop = 1;
+        else if (strcmp(*argv, "-") == 0) {
+            if (argv[1] == NULL || argv[2] == NULL) return -1;
+            sample_rate = atoi(argv[1]);
+            bits_sample = atoi(argv[2]);
+            channels = 2;
+            argv += 2;
+            fp = stdin;
+        }
+        else {
+            fp = fopen(*argv, "rb");
+            if (fp == NULL) {
+                fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
+                return -1;
+            }
+            if (read_wav_header(fp) < 0) {
+                fprintf(stderr, "error: wav header\n");
+                return -1;
+            }
+            data_ofs = ftell(fp);
+        }
+        ++argv;
+    }
+    if (fp == NULL) {
+        fprintf(stderr, "rtl_tcp_replay [--port <p>] [--fast] [--loop] [--drop <s>] <iq.wav | - sr bps>\n");
+        return -1;
+    }
+    if (sample_rate < 1 || (bits_sample != 8 && bits_sample != 16 && bits_sample != 32) || channels < 2) {
+        fprintf(stderr, "error: sr %d, bps %d, nch %d\n", sample_rate, bits_sample, channels);
+        return -1;
+    }
+    if (fp == stdin) option_loop = 0;
+    pace = !option_fast && fp != stdin;
+
+    fs = channels*bits_sample/8;
+    blk = sample_rate/64;  // frames per send
+    if (blk < 1024) blk = 1024;
+    raw = malloc((size_t)blk*fs);
+    buf = malloc((size_t)blk*2);
+    if (raw == NULL || buf == NULL) return -1;
+
+    srv = socket(AF_INET, SOCK_STREAM, 0);
+    if (srv < 0) return -1;
+    setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+    sa.sin_port = htons(port);
+    if (bind(srv, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(srv, 1) < 0) {
+        fprintf(stderr, "error: port %d: %s\n", port, strerror(errno));
+        return -1;
+    }
+    fprintf(stderr, "rtl_tcp_replay: port %d  sr %d  bps %d  nch %d\n", port, sample_rate, bits_sample, channels);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    memcpy(h, "RTL0", 4);
+    h[4] = 0; h[5] = 0; h[6] = 0; h[7] = TUNER_R820T;
+    h[8] = 0; h[9] = 0; h[10] = 0; h[11] = NGAIN;
+
+    while (!stop) {
+        if (fd < 0) {
+            struct pollfd pfd = { srv, POLLIN, 0 };
+            // without client: the recording plays on (pacing), clients connect in between
+            if (poll(&pfd, 1, pace ? 0 : -1) > 0) {
+                fd = accept(srv, NULL, NULL);
+                if (fd >= 0) {
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    if (send(fd, h, 12, MSG_NOSIGNAL) != 12) { close(fd); fd = -1; }
+                    else {
+                        tc = now();
+                        fprintf(stderr, "rtl_tcp_replay: client connected (sample %llu)\n", sample);
+                    }
+                }
+            }
+            else if (!pace) continue;
+        }
+
+        n = fread(raw, fs, blk, fp);
+        if (n == 0) {
+            if (option_loop && fseek(fp, data_ofs, SEEK_SET) == 0) continue;
+            break;
+        }
+        if (pace) {
+            if (t0 == 0) t0 = now();
+            dt = t0 + (double)(sample + n) / sample_rate - now();
+            if (dt > 0) {
+                ts.tv_sec = (time_t)dt;
+                ts.tv_nsec = (long)((dt - ts.tv_sec)*1e9);
+                nanosleep(&ts, NULL);
+            }
+        }
+        sample += n;
+        if (fd < 0) continue;
+
+        to_u8(raw, buf, n);
+        if (read_cmd(fd) < 0 || send(fd, buf, 2*n, MSG_NOSIGNAL) != 2*n) {
+            fprintf(stderr, "rtl_tcp_replay: client closed\n");
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        bytes += 2*n;
+        if (drop_sec > 0 && now() - tc >= drop_sec) {
+            fprintf(stderr, "rtl_tcp_replay: drop (sample %llu)\n", sample);
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    fprintf(stderr, "rtl_tcp_replay: %llu samples, %llu bytes sent\n", sample, bytes);
+    if (fd >= 0) close(fd);
+    close(srv);
+    if (fp != stdin) fclose(fp);
+    free(raw);
+    free(buf);
+
+    return 0;
+}
+
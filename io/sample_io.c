@@ -0,0 +1,737 @@
+
+/*
+ *  sample input
+ *    file: mmap() (whole file, read position from ftell())
+ *    pipe: aligned block buffer, fread() in chunks of ~1/32 s
+ *    u8/s16/f32 (wav or raw) -> float/int, block conversion (SSE2)
+ *
+ *  gcc -c sample_io.c  ->  sample_io.o, API: sample_io.h
+ *
+ *  only whole frames are returned (frame: nch samples).
+ *
+ *  fp = sio_fopen(path)  instead of fopen(path, "rb"):
+ *    "shm:<name>": shared-memory IQ ring of iq_bus (RS/io/shm_ring.c), the stream starts
+ *    with a wav header (read_wav_header()), sio_open() then reads the ring blocks in place;
+ *    plain fread() on fp (copy) works as well. Linux, _GNU_SOURCE (fopencookie).
+ *    "rtl_tcp:<host>[:<port>][?s=<sr>&f=<Hz>&g=<dB>&p=<ppm>&r=<retries>]": rtl_tcp server
+ *    (RS/io/rtl_tcp.c), u8 IQ, wav header as above; sio_open() recv()s straight into the
+ *    aligned block buffer, reconnects if the connection breaks.
+ *    "<name>.sigmf-meta" (or .sigmf-data): SigMF recording, core:datatype cu8/ci8/ci16_le/cf32_le
+ *    (ru8/ri8/ri16_le/rf32_le), core:sample_rate;
+ *    "raw:<fmt>:<sr>:<path>": headerless file, fmt cu8, cs8, cs16, cf32 (or the SigMF names);
+ *    wav header as above, sio_open() maps the data file (stdio: pipe).
+ *    "<name>.iqz": compressed IQ archive (RS/io/iqz.c, iqzip), wav header as above; chunks
+ *    are decoded ahead by worker threads, sio_open() reads the decoded chunks in place.
+ *    -DSIO_NOSHM, -DSIO_NOTCP, -DSIO_NOIQZ: without the backend (SIO_NOIQZ: no -pthread).
+ *
+ *  sio_window(&sio, start, dur)  after sio_open(): skip start seconds (file, iqz: offset),
+ *                                end after dur seconds (0: to the end)
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE  // fopencookie
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_io.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define SIO_MMAP
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__) && !defined(NOSIMD)
+  #define SIO_SSE2
+  #include <emmintrin.h>
+#endif
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+  #define SIO_COOKIE  // raw:, SigMF
+  #ifndef SIO_NOSHM
+    #define SIO_SHM
+    #include "shm_ring.c"  // RS/io/
+  #endif
+  #ifndef SIO_NOTCP
+    #define SIO_TCP
+    #include "rtl_tcp.c"   // RS/io/
+  #endif
+  #ifndef SIO_NOIQZ
+    #define SIO_IQZ
+    #include "iqz.c"       // RS/io/
+  #endif
+#endif
+
+#define SIO_BUFSZ  (1<<20)  // pipe buffer
+#define SIO_ALIGN  64
+
+
+#ifdef SIO_COOKIE
+#define SIO_TABMAX  8
+
+typedef struct sio_raw_s {
+    FILE *fp;   // data file
+    int sr, bps, nch;
+    int s8;
+    unsigned char wav[44];
+    int wpos;
+} sio_raw_t;
+
+static struct { FILE *fp; struct shm_in_s *shm; struct rtl_tcp_s *tcp; sio_raw_t *raw; struct iqz_s *iqz; } sio_tab[SIO_TABMAX];
+
+// raw formats, SigMF core:datatype (8 bit without endianness)
+static const struct { const char *name; int bps, nch, s8; } sio_fmt[] = {
+    { "cu8",  8, 2, 0 }, { "cs8",  8, 2, 1 }, { "cs16", 16, 2, 0 }, { "cf32", 32, 2, 0 },
+    { "ci8",  8, 2, 1 }, { "ci16_le", 16, 2, 0 }, { "cf32_le", 32, 2, 0 },
+    { "ru8",  8, 1, 0 }, { "ri8",  8, 1, 1 }, { "ri16_le", 16, 1, 0 }, { "rf32_le", 32, 1, 0 },
+    { NULL, 0, 0, 0 }
+};
+
+#ifdef SIO_SHM
+static ssize_t sio_shm_read(void *c, char *buf, size_t n) {
+    shm_in_t *r = c;
+    size_t k = 0;
+    if (r->wpos < 44) {
+        k = 44 - r->wpos;
+        if (k > n) k = n;
+        memcpy(buf, r->wav + r->wpos, k);
+        r->wpos += k;
+        return k;
+    }
+    return shm_read(r, buf, n);
+}
+
+static int sio_shm_close(void *c) {
+    int k;
+    for (k = 0; k < SIO_TABMAX; k++) {
+        if (sio_tab[k].shm == c) {
+            sio_tab[k].shm = NULL;
+            sio_tab[k].fp = NULL;
+        }
+    }
+    shm_detach(c);
+    free(c);
+    return 0;
+}
+#endif
+
+#ifdef SIO_TCP
+static ssize_t sio_tcp_read(void *c, char *buf, size_t n) {
+    rtl_tcp_t *t = c;
+    size_t k = 0;
+    if (t->wpos < 44) {
+        k = 44 - t->wpos;
+        if (k > n) k = n;
+        memcpy(buf, t->wav + t->wpos, k);
+        t->wpos += k;
+        return k;
+    }
+    return tcp_recv(t, buf, n);
+}
+
+static int sio_tcp_close(void *c) {
+    int k;
+    for (k = 0; k < SIO_TABMAX; k++) {
+        if (sio_tab[k].tcp == c) {
+            sio_tab[k].tcp = NULL;
+            sio_tab[k].fp = NULL;
+        }
+    }
+    tcp_close(c);
+    free(c);
+    return 0;
+}
+#endif
+
+static ssize_t sio_raw_read(void *c, char *buf, size_t n) {
+    sio_raw_t *f = c;
+    size_t k = 0;
+    if (f->wpos < 44) {
+        k = 44 - f->wpos;
+        if (k > n) k = n;
+        memcpy(buf, f->wav + f->wpos, k);
+        f->wpos += k;
+        return k;
+    }
+    k = fread(buf, 1, n, f->fp);
+    if (f->s8) { size_t i; for (i = 0; i < k; i++) buf[i] ^= 0x80; }  // -> u8
+    return k;
+}
+
+static int sio_raw_close(void *c) {
+    sio_raw_t *f = c;
+    int k;
+    for (k = 0; k < SIO_TABMAX; k++) {
+        if (sio_tab[k].raw == c) {
+            sio_tab[k].raw = NULL;
+            sio_tab[k].fp = NULL;
+        }
+    }
+    fclose(f->fp);
+    free(f);
+    return 0;
+}
+
+#ifdef SIO_IQZ
+static ssize_t sio_iqz_read(void *c, char *buf, size_t n) {
+    iqz_t *z = c;
+    size_t k = 0;
+    if (z->wpos < 44) {
+        k = 44 - z->wpos;
+        if (k > n) k = n;
+        memcpy(buf, z->wav + z->wpos, k);
+        z->wpos += k;
+        return k;
+    }
+    if (z->cpos == z->clen) {
+        if (iqz_next(z, &z->cdat, &z->clen) <= 0) return 0;
+        z->cpos = 0;
+    }
+    k = z->clen - z->cpos;
+    if (k > n) k = n;
+    memcpy(buf, z->cdat + z->cpos, k);
+    z->cpos += k;
+    return k;
+}
+
+static int sio_iqz_close(void *c) {
+    int k;
+    for (k = 0; k < SIO_TABMAX; k++) {
+        if (sio_tab[k].iqz == c) {
+            sio_tab[k].iqz = NULL;
+            sio_tab[k].fp = NULL;
+        }
+    }
+    iqz_close(c);
+    free(c);
+    return 0;
+}
+#endif
+
+// "key": "value" / "key": number (flat search, first occurrence)
+static const char *sio_json(const char *js, const char *key) {
+    const char *p = strstr(js, key);
+    if (p == NULL) return NULL;
+    p += strlen(key);
+    while (*p == '"' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':') p++;
+    return p;
+}
+
+// SigMF: <name>.sigmf-meta -> datatype, sample rate; data file <name>.sigmf-data
+static int sio_sigmf(sio_raw_t *f, const char *path) {
+    char name[1024], fmt[16];
+    char *js;
+    const char *v;
+    size_t l = strlen(path) - 11;
+    long n;
+    FILE *fm;
+    int k;
+
+    if (l + 12 > sizeof(name)) return -1;
+    memcpy(name, path, l);
+    strcpy(name+l, ".sigmf-meta");
+    fm = fopen(name, "rb");
+    if (fm == NULL) return -1;
+    fseek(fm, 0, SEEK_END);
+    n = ftell(fm);
+    fseek(fm, 0, SEEK_SET);
+    if (n <= 0 || n > (1<<24)) { fclose(fm); return -1; }
+    js = calloc(n+1, 1);  if (js == NULL) { fclose(fm); return -1; }
+    if (fread(js, 1, n, fm) != (size_t)n) n = 0;
+    fclose(fm);
+
+    v = n ? sio_json(js, "\"core:datatype\"") : NULL;
+    for (k = 0; v && k < 15 && v[k] && v[k] != '"'; k++) fmt[k] = v[k];
+    fmt[v ? k : 0] = '\0';
+    v = n ? sio_json(js, "\"core:sample_rate\"") : NULL;
+    f->sr = v ? (int)(atof(v) + 0.5) : 0;
+    v = n ? sio_json(js, "\"core:frequency\"") : NULL;
+    fprintf(stderr, "sigmf: %s  %s  sr %d", name, fmt, f->sr);
+    if (v) fprintf(stderr, "  f %.0f", atof(v));
+    fprintf(stderr, "\n");
+    free(js);
+
+    for (k = 0; sio_fmt[k].name && strcmp(sio_fmt[k].name, fmt) != 0; k++);
+    if (sio_fmt[k].name == NULL || f->sr <= 0) return -1;
+    f->bps = sio_fmt[k].bps;
+    f->nch = sio_fmt[k].nch;
+    f->s8  = sio_fmt[k].s8;
+
+    strcpy(name+l, ".sigmf-data");
+    f->fp = fopen(name, "rb");
+    return f->fp ? 0 : -1;
+}
+
+// raw:<fmt>:<sr>:<path>
+static int sio_raw(sio_raw_t *f, const char *spec) {
+    const char *c = strchr(spec, ':');
+    int k;
+
+    if (c == NULL) return -1;
+    for (k = 0; sio_fmt[k].name; k++) {
+        if (strlen(sio_fmt[k].name) == (size_t)(c-spec) && strncmp(sio_fmt[k].name, spec, c-spec) == 0) break;
+    }
+    if (sio_fmt[k].name == NULL) return -1;
+    f->bps = sio_fmt[k].bps;
+    f->nch = sio_fmt[k].nch;
+    f->s8  = sio_fmt[k].s8;
+    f->sr = atoi(c+1);
+    c = strchr(c+1, ':');
+    if (c == NULL || f->sr <= 0) return -1;
+    f->fp = fopen(c+1, "rb");
+    return f->fp ? 0 : -1;
+}
+
+static void sio_le(unsigned char *p, unsigned int v, int n) {  // little endian
+    while (n-- > 0) { *p++ = v & 0xFF; v >>= 8; }
+}
+
+// 44 byte header, PCM (float: format 3), data size unknown
+static void sio_wav_hdr(unsigned char *h, int sr, int bps, int nch) {
+    memcpy(h, "RIFF", 4);     sio_le(h+4, 0xFFFFFFFF, 4);
+    memcpy(h+8, "WAVE", 4);
+    memcpy(h+12, "fmt ", 4);  sio_le(h+16, 16, 4);
+    sio_le(h+20, bps == 32 ? 3 : 1, 2);
+    sio_le(h+22, nch, 2);
+    sio_le(h+24, sr, 4);
+    sio_le(h+28, sr*nch*bps/8, 4);
+    sio_le(h+32, nch*bps/8, 2);
+    sio_le(h+34, bps, 2);
+    memcpy(h+36, "data", 4);  sio_le(h+40, 0xFFFFFFFF, 4);
+}
+#endif
+
+FILE *sio_fopen(const char *path) {
+#ifdef SIO_COOKIE
+    cookie_io_functions_t fio = { sio_raw_read, NULL, NULL, sio_raw_close };
+    sio_raw_t *f;
+    FILE *fp;
+    size_t l = strlen(path);
+    int k;
+
+#ifdef SIO_SHM
+    if (strncmp(path, "shm:", 4) == 0) {
+        cookie_io_functions_t io = { sio_shm_read, NULL, NULL, sio_shm_close };
+        shm_in_t *r;
+        for (k = 0; k < SIO_TABMAX && sio_tab[k].fp; k++);
+        if (k == SIO_TABMAX) return NULL;
+        r = calloc(1, sizeof(shm_in_t));  if (r == NULL) return NULL;
+        if (shm_attach(r, path+4) < 0) { free(r); return NULL; }
+        sio_wav_hdr(r->wav, r->h->sr, r->h->bps, r->h->nch);
+        fp = fopencookie(r, "rb", io);
+        if (fp == NULL) { shm_detach(r); free(r); return NULL; }
+        sio_tab[k].fp = fp;
+        sio_tab[k].shm = r;
+        return fp;
+    }
+#endif
+#ifdef SIO_TCP
+    if (strncmp(path, "rtl_tcp:", 8) == 0) {
+        cookie_io_functions_t tio = { sio_tcp_read, NULL, NULL, sio_tcp_close };
+        rtl_tcp_t *t;
+        for (k = 0; k < SIO_TABMAX && sio_tab[k].fp; k++);
+        if (k == SIO_TABMAX) return NULL;
+        t = calloc(1, sizeof(rtl_tcp_t));  if (t == NULL) return NULL;
+        if (tcp_open(t, path+8) < 0) { free(t); return NULL; }
+        sio_wav_hdr(t->wav, t->sr, 8, 2);
+        fp = fopencookie(t, "rb", tio);
+        if (fp == NULL) { tcp_close(t); free(t); return NULL; }
+        sio_tab[k].fp = fp;
+        sio_tab[k].tcp = t;
+        return fp;
+    }
+#endif
+    if (strncmp(path, "raw:", 4) == 0
+       || (l > 11 && (strcmp(path+l-11, ".sigmf-meta") == 0 || strcmp(path+l-11, ".sigmf-data") == 0))) {
+        for (k = 0; k < SIO_TABMAX && sio_tab[k].fp; k++);
+        if (k == SIO_TABMAX) return NULL;
+        f = calloc(1, sizeof(sio_raw_t));  if (f == NULL) return NULL;
+        if ((path[0] == 'r' && strncmp(path, "raw:", 4) == 0 ? sio_raw(f, path+4) : sio_sigmf(f, path)) < 0) {
+            if (f->fp) fclose(f->fp);
+            free(f);
+            return NULL;
+        }
+        sio_wav_hdr(f->wav, f->sr, f->bps, f->nch);
+        fp = fopencookie(f, "rb", fio);
+        if (fp == NULL) { fclose(f->fp); free(f); return NULL; }
+        sio_tab[k].fp = fp;
+        sio_tab[k].raw = f;
+        return fp;
+    }
+#ifdef SIO_IQZ
+    if (l > 4 && strcmp(path+l-4, ".iqz") == 0) {
+        cookie_io_functions_t zio = { sio_iqz_read, NULL, NULL, sio_iqz_close };
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        iqz_t *z;
+        for (k = 0; k < SIO_TABMAX && sio_tab[k].fp; k++);
+        if (k == SIO_TABMAX) return NULL;
+        z = calloc(1, sizeof(iqz_t));  if (z == NULL) return NULL;
+        // decode threads: one core left for the decoder
+        if (iqz_open(z, path, ncpu > 5 ? 4 : ncpu > 2 ? ncpu-1 : 1) < 0) { free(z); return NULL; }
+        sio_wav_hdr(z->wav, z->sr, z->bps, z->nch);
+        fp = fopencookie(z, "rb", zio);
+        if (fp == NULL) { iqz_close(z); free(z); return NULL; }
+        sio_tab[k].fp = fp;
+        sio_tab[k].iqz = z;
+        return fp;
+    }
+#endif
+#endif
+    return fopen(path, "rb");
+}
+
+
+int sio_open(sio_t *sio, FILE *fp, int bps, int nch, int sr) {
+    long ofs;
+#ifdef SIO_COOKIE
+    int k;
+#endif
+
+    memset(sio, 0, sizeof(*sio));
+    if (bps != 8 && bps != 16 && bps != 32) return -1;
+    if (nch < 1) return -1;
+
+    sio->fp  = fp;
+    sio->bps = bps;
+    sio->nch = nch;
+    sio->fs  = nch*bps/8;
+    sio->sr  = sr;
+    sio->rem = SIO_NOLIM;
+
+#ifdef SIO_COOKIE
+    for (k = 0; k < SIO_TABMAX; k++) {
+#ifdef SIO_SHM
+        if (sio_tab[k].fp == fp && sio_tab[k].shm) {
+            sio->shm = sio_tab[k].shm;
+            if (sio->shm->h->bps != bps || sio->shm->h->nch != nch) return -1;
+            return 0;
+        }
+#endif
+        if (sio_tab[k].fp == fp && sio_tab[k].tcp) {
+            sio->tcp = sio_tab[k].tcp;
+            if (bps != 8 || nch != 2) return -1;
+        }
+        if (sio_tab[k].fp == fp && sio_tab[k].raw) { // data file, past the (synthesized) header
+            if (sio_tab[k].raw->bps != bps || sio_tab[k].raw->nch != nch) return -1;
+            sio->s8 = sio_tab[k].raw->s8;
+            sio->fp = fp = sio_tab[k].raw->fp;
+        }
+#ifdef SIO_IQZ
+        if (sio_tab[k].fp == fp && sio_tab[k].iqz) { // continue after stdio (cookie) reads
+            sio->iqz = sio_tab[k].iqz;
+            if (sio->iqz->bps != bps || sio->iqz->nch != nch) return -1;
+            sio->dat = sio->iqz->cdat;
+            sio->pos = sio->iqz->cpos;
+            sio->len = sio->iqz->clen;
+            return 0;
+        }
+#endif
+    }
+#endif
+
+#ifdef SIO_MMAP
+    ofs = sio->tcp ? -1 : ftell(fp);
+    if (ofs >= 0) {
+        struct stat st;
+        if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > ofs) {
+            void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                sio->map = p;
+                sio->maplen = st.st_size;
+                sio->dat = sio->map;
+                sio->pos = ofs;
+                sio->len = ofs + (st.st_size-ofs)/sio->fs * sio->fs;
+                sio->eof = 1;
+                return 0;
+            }
+        }
+    }
+#else
+    (void)ofs;
+#endif
+
+    // pipe: ~1/32 s per read (latency), at least 4kB
+    sio->chunk = (size_t)(sr > 0 ? sr : 48000) / 32 * sio->fs;
+    if (sio->chunk < 4096) sio->chunk = 4096;
+    sio->bufsz = SIO_BUFSZ;
+    if (sio->bufsz < 2*sio->chunk) sio->bufsz = 2*sio->chunk;
+    sio->bufsz -= sio->bufsz % sio->fs;
+    if (sio->chunk > sio->bufsz/2) sio->chunk = sio->bufsz/2;
+
+#ifdef SIO_MMAP
+    if (posix_memalign((void**)&sio->buf, SIO_ALIGN, sio->bufsz) != 0) sio->buf = NULL;
+#else
+    sio->buf = malloc(sio->bufsz);
+#endif
+    if (sio->buf == NULL) return -1;
+    sio->dat = sio->buf;
+
+    return 0;
+}
+
+void sio_close(sio_t *sio) {
+    if (sio->shm || sio->iqz) { // ring, archive: fclose(fp)
+#ifdef SIO_IQZ
+        if (sio->iqz) { // stdio continues at the read position
+            sio->iqz->cdat = sio->dat;
+            sio->iqz->cpos = sio->pos;
+            sio->iqz->clen = sio->len;
+        }
+#endif
+        sio->shm = NULL;
+        sio->iqz = NULL;
+        sio->dat = NULL;
+        sio->pos = sio->len = 0;
+        return;
+    }
+#ifdef SIO_MMAP
+    if (sio->map) {
+        // continue stdio at the read position
+        fseek(sio->fp, sio->pos, SEEK_SET);
+        munmap(sio->map, sio->maplen);
+    }
+#endif
+    if (sio->buf) free(sio->buf);
+    sio->map = NULL;
+    sio->buf = NULL;
+    sio->dat = NULL;
+    sio->pos = sio->len = 0;
+}
+
+// up to n whole frames available at dat+pos
+static int sio_frames(sio_t *sio, int n) {
+    size_t need = (size_t)n * sio->fs;
+    size_t avl = sio->len - sio->pos;
+
+#ifdef SIO_SHM
+    if (sio->shm) { // next ring block, in place
+        while (avl < (size_t)sio->fs) {
+            if (sio->rem == 0 || shm_block(sio->shm) == 0) return 0;
+            sio->dat = sio->shm->dat;
+            sio->pos = 0;
+            sio->len = sio->shm->len;
+            if (sio->rem != SIO_NOLIM) {
+                if (sio->len > sio->rem) sio->len = sio->rem;
+                sio->rem -= sio->len;
+            }
+            avl = sio->len;
+        }
+        avl /= sio->fs;
+        return avl < (size_t)n ? (int)avl : n;
+    }
+#endif
+#ifdef SIO_IQZ
+    if (sio->iqz) { // next decoded chunk, in place
+        while (avl < (size_t)sio->fs) {
+            if (sio->rem == 0 || iqz_next(sio->iqz, &sio->dat, &sio->len) <= 0) return 0;
+            sio->pos = 0;
+            if (sio->rem != SIO_NOLIM) {
+                if (sio->len > sio->rem) sio->len = sio->rem;
+                sio->rem -= sio->len;
+            }
+            avl = sio->len;
+        }
+        avl /= sio->fs;
+        return avl < (size_t)n ? (int)avl : n;
+    }
+#endif
+
+    if (avl < need && !sio->eof) {
+        if (need > sio->bufsz - sio->fs) need = sio->bufsz - sio->fs;
+        if (sio->pos > 0) {
+            memmove(sio->buf, sio->buf + sio->pos, avl);
+            sio->pos = 0;
+            sio->len = avl;
+        }
+#ifdef SIO_TCP
+        while (sio->tcp && sio->len < need && !sio->eof) { // whatever has arrived, up to the free space
+            size_t want = sio->bufsz - sio->len;
+            ssize_t r;
+            if (want > sio->rem) want = sio->rem;
+            r = want ? tcp_recv(sio->tcp, sio->buf + sio->len, want) : 0;
+            if (r > 0) sio->len += r;
+            else sio->eof = 1;
+            if (r > 0 && sio->rem != SIO_NOLIM) sio->rem -= r;
+        }
+#endif
+        while (sio->len < need && !sio->eof) {
+            size_t r, want = sio->chunk;
+            if (want < need - sio->len) want = need - sio->len;
+            if (want > sio->bufsz - sio->len) want = sio->bufsz - sio->len;
+            if (want > sio->rem) want = sio->rem;
+            r = want ? fread(sio->buf + sio->len, 1, want, sio->fp) : 0;
+            sio->len += r;
+            if (r < want || want == 0) sio->eof = 1;
+            if (sio->rem != SIO_NOLIM) sio->rem -= r;
+        }
+        avl = sio->len;
+        if (sio->eof) avl -= avl % sio->fs; // drop incomplete frame
+        sio->len = avl;
+    }
+
+    avl /= sio->fs;
+    return avl < (size_t)n ? (int)avl : n;
+}
+
+// skip start seconds (file: offset, stream: read), end after dur seconds (0: to the end)
+int sio_window(sio_t *sio, double start, double dur) {
+    unsigned long long nfr, lim;
+    size_t avl;
+    int m;
+
+    if (sio->sr <= 0 || start < 0 || dur < 0) return -1;
+
+    nfr = (unsigned long long)(start * sio->sr + 0.5);
+    if (sio->map) {
+        avl = (sio->len - sio->pos) / sio->fs;
+        if (nfr > avl) nfr = avl;
+        sio->pos += nfr * sio->fs;
+    }
+    else {
+#ifdef SIO_IQZ
+        // archive: chunk index, before the first chunk is decoded
+        if (sio->iqz && sio->pos == sio->len && iqz_seek(sio->iqz, nfr) == 0) nfr = 0;
+#endif
+        while (nfr > 0) {
+            m = sio_frames(sio, nfr < (1<<20) ? (int)nfr : (1<<20));
+            if (m == 0) break;
+            sio->pos += (size_t)m * sio->fs;
+            nfr -= m;
+        }
+    }
+
+    if (dur > 0) {
+        lim = (unsigned long long)(dur * sio->sr + 0.5) * sio->fs;
+        avl = sio->len - sio->pos;
+        if (lim <= avl) {
+            sio->len = sio->pos + lim;
+            sio->rem = 0;
+        }
+        else if (!sio->map) sio->rem = lim - avl;
+    }
+    return 0;
+}
+
+// n samples, stride is (input) and os (output), in samples
+static void sio_cvt(sio_t *sio, const unsigned char *p, int is, float *s, int os, int n) {
+    int k = 0;
+
+    if (sio->bps == 8) {
+        const unsigned char *u = p;
+        const int x = sio->s8 ? 0x80 : 0;  // s8 -> u8
+    #ifdef SIO_SSE2
+        if (is == 1 && os == 1) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i vx = _mm_set1_epi8((char)x);
+            const __m128 sc = _mm_set1_ps(1.0f/128.0f);
+            const __m128 one = _mm_set1_ps(1.0f);
+            for ( ; k+16 <= n; k += 16) {
+                __m128i v  = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(u+k)), vx);
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                _mm_storeu_ps(s+k,    _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), sc), one));
+                _mm_storeu_ps(s+k+4,  _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), sc), one));
+                _mm_storeu_ps(s+k+8,  _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), sc), one));
+                _mm_storeu_ps(s+k+12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), sc), one));
+            }
+        }
+    #endif
+        for ( ; k < n; k++) s[k*os] = ((u[k*is]^x)-128)/128.0f; // u8: 0..255, 128 -> 0V
+    }
+    else if (sio->bps == 16) {
+        short b;
+    #ifdef SIO_SSE2
+        if (is == 1 && os == 1) {
+            const __m128 sc = _mm_set1_ps(1.0f/32768.0f);
+            for ( ; k+8 <= n; k += 8) {
+                __m128i v  = _mm_loadu_si128((const __m128i*)(p+2*k));
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                _mm_storeu_ps(s+k,   _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+                _mm_storeu_ps(s+k+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), sc));
+            }
+        }
+    #endif
+        for ( ; k < n; k++) {
+            memcpy(&b, p+2*k*is, 2);
+            s[k*os] = b/32768.0f;
+        }
+    }
+    else { // float32
+        if (is == 1 && os == 1) memcpy(s, p, 4*n);
+        else for (k = 0; k < n; k++) memcpy(s+k*os, p+4*k*is, 4);
+    }
+}
+
+// n samples (channel ch) -> s[]
+int sio_float(sio_t *sio, int ch, float *s, int n) {
+    int bs = sio->bps/8;
+    int k = 0, m;
+
+    while (k < n) {
+        m = sio_frames(sio, n-k);
+        if (m == 0) break;
+        sio_cvt(sio, sio->dat + sio->pos + ch*bs, sio->nch, s+k, 1, m);
+        sio->pos += (size_t)m * sio->fs;
+        k += m;
+    }
+
+    return k;
+}
+
+// n IQ samples (channel 0: I, 1: Q) -> f[2k]+I*f[2k+1]
+int sio_cfloat(sio_t *sio, float *f, int n) {
+    int bs = sio->bps/8;
+    int k = 0, m;
+    unsigned char *p;
+
+    if (sio->nch < 2) return 0;
+
+    while (k < n) {
+        m = sio_frames(sio, n-k);
+        if (m == 0) break;
+        p = sio->dat + sio->pos;
+        if (sio->nch == 2) sio_cvt(sio, p, 1, f+2*k, 1, 2*m);
+        else {
+            sio_cvt(sio, p,    sio->nch, f+2*k,   2, m);
+            sio_cvt(sio, p+bs, sio->nch, f+2*k+1, 2, m);
+        }
+        sio->pos += (size_t)m * sio->fs;
+        k += m;
+    }
+
+    return k;
+}
+
+// up to n samples (channel ch) as int, 8bit: -128..127, 16bit: -32768..32767;
+// fewer at the end of a ring block/archive chunk, 0: EOF
+int sio_ints(sio_t *sio, int ch, int *v, int n) {
+    const unsigned char *p;
+    int k, m, is;
+    short b;
+
+    m = sio_frames(sio, n);
+    if (m < 1) return 0;
+    p = sio->dat + sio->pos + ch*(sio->bps/8);
+    is = sio->nch;
+    sio->pos += (size_t)m * sio->fs;
+
+    if (sio->bps == 8) {
+        const int x = sio->s8 ? 0x80 : 0;  // s8 -> u8
+        for (k = 0; k < m; k++) v[k] = (p[k*is]^x)-128;
+    }
+    else if (sio->bps == 16) {
+        for (k = 0; k < m; k++) { memcpy(&b, p+2*k*is, 2); v[k] = b; }
+    }
+    else {
+        float f;
+        for (k = 0; k < m; k++) { memcpy(&f, p+4*k*is, 4); v[k] = (int)(f*32768.0f); }
+    }
+
+    return m;
+}
@@ -0,0 +1,56 @@
+
+/*
+ *  sample input (RS/io/sample_io.c)
+ *
+ *  #include "sample_io.h"  // RS/io/
+ *  gcc -c sample_io.c      // link sample_io.o ... -pthread (iqz)
+ *
+ *  fp = sio_fopen(path)        instead of fopen(path, "rb"): file, shm:, rtl_tcp:, raw:, SigMF, .iqz
+ *  sio_open(&sio, fp, bps, nch, sr)  after the wav header (or raw)
+ *  sio_window(&sio, start, dur)      skip start seconds, end after dur seconds (0: to the end)
+ *  sio_float(&sio, ch, s, n)   n samples of channel ch -> s[], float [-1,1)
+ *  sio_cfloat(&sio, f, n)      n IQ samples (channel 0,1) -> f[2k], f[2k+1] (float complex z[])
+ *  sio_ints(&sio, ch, v, n)    up to n samples of channel ch as int (8bit: -128..127, 16bit: short)
+ *  sio_close(&sio)
+ *
+ *  build options: -DSIO_NOSHM, -DSIO_NOTCP, -DSIO_NOIQZ (no -pthread needed), -DNOSIMD
+ */
+
+#ifndef SAMPLE_IO_H
+#define SAMPLE_IO_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define SIO_NOLIM  (~0ULL)
+
+
+typedef struct sio_s {
+    FILE *fp;
+    int bps;    // 8, 16, 32 (float)
+    int nch;
+    int fs;     // frame size (bytes)
+    size_t chunk;   // pipe: bytes per fread()
+    unsigned char *map;  size_t maplen;  // file
+    unsigned char *buf;  size_t bufsz;   // pipe
+    unsigned char *dat;  // map or buf
+    size_t pos, len;     // dat[pos..len-1] not yet read
+    int eof;
+    int sr;
+    int s8;     // 8 bit signed (cs8)
+    unsigned long long rem;  // window: bytes still to read (SIO_NOLIM)
+    struct shm_in_s *shm;  // shm ring: dat is the current block
+    struct rtl_tcp_s *tcp; // network: recv() into buf
+    struct iqz_s *iqz;     // archive: dat is the current decoded chunk
+} sio_t;
+
+
+FILE *sio_fopen(const char *path);
+int  sio_open(sio_t *sio, FILE *fp, int bps, int nch, int sr);
+void sio_close(sio_t *sio);
+int  sio_window(sio_t *sio, double start, double dur);
+int  sio_float(sio_t *sio, int ch, float *s, int n);
+int  sio_cfloat(sio_t *sio, float *f, int n);
+int  sio_ints(sio_t *sio, int ch, int *v, int n);
+
+#endif
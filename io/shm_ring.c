@@ -0,0 +1,322 @@
+
+/*
+ *  shared-memory IQ ring (POSIX shm)
+ *    one writer (RS/io/iq_bus.c) publishes blocks of whole frames with
+ *    sequence number, first sample and time; any number of reader processes
+ *    attach at the newest block and read in place (sample_io.c: no copy).
+ *    The writer never waits: a reader that lags nslot blocks loses blocks,
+ *    counted per reader (overrun) in the reader table of the header.
+ *
+ *  #include "shm_ring.c"  // RS/io/  (reader; #define SHM_WRITER before: writer)
+ *
+ *  writer: shm_create(&w, name, sr, bps, nch, blksz, nslot)
+ *          p = shm_wbuf(&w); ... shm_publish(&w, len, t);  shm_close(&w)
+ *  reader: shm_attach(&r, name)
+ *          shm_block(&r) -> r.dat[0..r.len-1]  or  shm_read(&r, buf, n)
+ *          shm_detach(&r)
+ *
+ *  slot k: block seq with seq%nslot == k, seq == SHM_WRITING while written
+ *  (seqlock: a reader checks seq again after using the data).
+ *  older glibc: -lrt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+
+#define SHM_MAGIC    0x51495352  // "RSIQ"
+#define SHM_VERSION  1
+#define SHM_MAXRD    32
+#define SHM_HDRSZ    4096        // header page, slots follow
+#define SHM_BLKHDR   64          // block header, data follows
+#define SHM_WRITING  (~0ULL)
+#define SHM_NAMELEN  64
+
+
+typedef struct {
+    _Atomic uint64_t seq;  // block in this slot
+    uint64_t sample;       // first frame of the block
+    double t;              // CLOCK_REALTIME, block read from the source
+    uint32_t len;          // bytes, whole frames
+} shm_blk_t;
+
+typedef struct {  // reader table, written by the reader
+    _Atomic int pid;       // 0: free
+    _Atomic uint64_t rseq;
+    _Atomic uint64_t blocks;
+    _Atomic uint64_t overrun;  // blocks lost
+} shm_rdt_t;
+
+typedef struct {
+    _Atomic uint32_t magic;  // set last (shm_create)
+    uint32_t version;
+    int32_t sr, bps, nch;
+    uint32_t nslot;
+    uint32_t blksz;          // data bytes per slot
+    uint32_t stride;         // SHM_BLKHDR + blksz, aligned
+    int32_t wpid;
+    _Atomic uint64_t wseq;   // blocks published
+    _Atomic int eof;
+    shm_rdt_t rd[SHM_MAXRD];
+} shm_hdr_t;
+
+typedef struct {
+    char name[SHM_NAMELEN];
+    shm_hdr_t *h;
+    size_t maplen;
+    uint64_t sample;
+    int fs;
+} shm_out_t;
+
+typedef struct shm_in_s {
+    char name[SHM_NAMELEN];
+    shm_hdr_t *h;
+    size_t maplen;
+    int rd;                // reader table entry, -1: table full
+    uint64_t rseq;         // current block
+    int have;              // dat valid
+    unsigned char *dat;
+    size_t len;
+    size_t pos;            // shm_read()
+    double t;              // time of the current block
+    uint64_t sample;
+    uint64_t blocks;
+    uint64_t overrun;
+    unsigned char wav[44]; // sample_io.c: sio_fopen()
+    int wpos;
+} shm_in_t;
+
+
+static void shm_path(char *dst, const char *name) {
+    snprintf(dst, SHM_NAMELEN, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+static shm_blk_t *shm_blk(shm_hdr_t *h, uint64_t seq) {
+    return (shm_blk_t *)((unsigned char *)h + SHM_HDRSZ + (size_t)(seq % h->nslot) * h->stride);
+}
+
+#ifdef SHM_WRITER
+static double shm_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* ------------------------------------------------------------------------------------ */
+
+static int shm_create(shm_out_t *w, const char *name, int sr, int bps, int nch, int blksz, int nslot) {
+    shm_hdr_t *h;
+    size_t len;
+    int fd;
+
+    memset(w, 0, sizeof(*w));
+    if (sizeof(shm_hdr_t) > SHM_HDRSZ || sizeof(shm_blk_t) > SHM_BLKHDR) return -1;
+    w->fs = nch*bps/8;
+    if (w->fs < 1 || nslot < 4) return -1;
+    blksz -= blksz % w->fs;
+    if (blksz < w->fs) return -1;
+
+    shm_path(w->name, name);
+    len = SHM_HDRSZ + (size_t)nslot * ((SHM_BLKHDR + blksz + 63) & ~63);
+
+    fd = shm_open(w->name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, len) < 0) { close(fd); shm_unlink(w->name); return -1; }
+    h = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED) { shm_unlink(w->name); return -1; }
+
+    memset(h, 0, SHM_HDRSZ);
+    h->version = SHM_VERSION;
+    h->sr = sr;
+    h->bps = bps;
+    h->nch = nch;
+    h->nslot = nslot;
+    h->blksz = blksz;
+    h->stride = (SHM_BLKHDR + blksz + 63) & ~63;
+    h->wpid = getpid();
+    atomic_init(&h->wseq, 0);
+    atomic_init(&h->eof, 0);
+    atomic_store_explicit(&h->magic, SHM_MAGIC, memory_order_release);
+
+    w->h = h;
+    w->maplen = len;
+    return 0;
+}
+
+// data of the next block, blksz bytes; readers of the old block in this slot see SHM_WRITING
+static unsigned char *shm_wbuf(shm_out_t *w) {
+    shm_blk_t *b = shm_blk(w->h, atomic_load_explicit(&w->h->wseq, memory_order_relaxed));
+    atomic_store_explicit(&b->seq, SHM_WRITING, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    return (unsigned char *)b + SHM_BLKHDR;
+}
+
+// len bytes in shm_wbuf() (whole frames), t: time of the source read
+static void shm_publish(shm_out_t *w, size_t len, double t) {
+    uint64_t s = atomic_load_explicit(&w->h->wseq, memory_order_relaxed);
+    shm_blk_t *b = shm_blk(w->h, s);
+
+    len -= len % w->fs;
+    b->sample = w->sample;
+    b->t = t;
+    b->len = len;
+    w->sample += len / w->fs;
+    atomic_store_explicit(&b->seq, s, memory_order_release);
+    atomic_store_explicit(&w->h->wseq, s+1, memory_order_release);
+}
+
+// readers drain the ring, then read EOF; the name is removed (attached readers keep the map)
+static void shm_close(shm_out_t *w) {
+    if (w->h == NULL) return;
+    atomic_store_explicit(&w->h->eof, 1, memory_order_release);
+    munmap(w->h, w->maplen);
+    shm_unlink(w->name);
+    w->h = NULL;
+}
+
+#else
+/* ------------------------------------------------------------------------------------ */
+
+static int shm_attach(shm_in_t *r, const char *name) {
+    shm_hdr_t *h;
+    struct stat st;
+    int fd, k, pid, p0;
+
+    memset(r, 0, sizeof(*r));
+    r->rd = -1;
+    shm_path(r->name, name);
+
+    fd = shm_open(r->name, O_RDWR, 0);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < SHM_HDRSZ) { close(fd); return -1; }
+    h = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED) return -1;
+    if (atomic_load_explicit(&h->magic, memory_order_acquire) != SHM_MAGIC || h->version != SHM_VERSION
+       || (size_t)st.st_size < SHM_HDRSZ + (size_t)h->nslot * h->stride) {
+        munmap(h, st.st_size);
+        return -1;
+    }
+    r->h = h;
+    r->maplen = st.st_size;
+
+    // reader table: free entry or one of a dead process
+    pid = getpid();
+    for (k = 0; k < SHM_MAXRD; k++) {
+        p0 = atomic_load(&h->rd[k].pid);
+        if (p0 != 0 && kill(p0, 0) == 0) continue;
+        if (atomic_compare_exchange_strong(&h->rd[k].pid, &p0, pid)) {
+            atomic_store(&h->rd[k].blocks, 0);
+            atomic_store(&h->rd[k].overrun, 0);
+            r->rd = k;
+            break;
+        }
+    }
+
+    r->rseq = atomic_load_explicit(&h->wseq, memory_order_acquire);  // newest block
+    return 0;
+}
+
+// release the current block, next block -> dat, len; 1: block, 0: writer closed (EOF)
+static int shm_block(shm_in_t *r) {
+    shm_hdr_t *h = r->h;
+    shm_blk_t *b;
+    uint64_t w;
+    int spin = 0;
+
+    if (r->have) {
+        atomic_thread_fence(memory_order_acquire);
+        b = shm_blk(h, r->rseq);
+        if (atomic_load_explicit(&b->seq, memory_order_relaxed) != r->rseq) r->overrun += 1; // overwritten while read
+        r->rseq += 1;
+        r->have = 0;
+    }
+
+    while (1) {
+        w = atomic_load_explicit(&h->wseq, memory_order_acquire);
+        if (w == r->rseq) {
+            if (atomic_load_explicit(&h->eof, memory_order_acquire)
+               && atomic_load_explicit(&h->wseq, memory_order_acquire) == r->rseq) return 0;
+            if (spin < 16) sched_yield();
+            else {
+                struct timespec ts = {0, 500000}; // 0.5 ms
+                nanosleep(&ts, NULL);
+                if (spin % 1024 == 0 && kill(h->wpid, 0) < 0) return 0;  // writer gone
+            }
+            spin += 1;
+            continue;
+        }
+        if (w - r->rseq >= h->nslot - 1) { // lost: continue half a ring behind the writer
+            r->overrun += w - h->nslot/2 - r->rseq;
+            r->rseq = w - h->nslot/2;
+        }
+        b = shm_blk(h, r->rseq);
+        if (atomic_load_explicit(&b->seq, memory_order_acquire) != r->rseq) { // overwritten meanwhile
+            r->overrun += 1;
+            r->rseq += 1;
+            continue;
+        }
+        break;
+    }
+
+    r->dat = (unsigned char *)b + SHM_BLKHDR;
+    r->len = b->len;
+    r->t = b->t;
+    r->sample = b->sample;
+    r->pos = 0;
+    r->have = 1;
+    r->blocks += 1;
+    if (r->rd >= 0) {
+        atomic_store_explicit(&h->rd[r->rd].rseq, r->rseq, memory_order_relaxed);
+        atomic_store_explicit(&h->rd[r->rd].blocks, r->blocks, memory_order_relaxed);
+        atomic_store_explicit(&h->rd[r->rd].overrun, r->overrun, memory_order_relaxed);
+    }
+    return 1;
+}
+
+// copy (stdio readers): up to n bytes, 0: EOF
+static size_t shm_read(shm_in_t *r, void *buf, size_t n) {
+    size_t k = 0, l;
+
+    while (k < n) {
+        if (!r->have || r->pos == r->len) {
+            if (shm_block(r) == 0) break;
+            continue;
+        }
+        l = r->len - r->pos;
+        if (l > n-k) l = n-k;
+        memcpy((unsigned char *)buf + k, r->dat + r->pos, l);
+        r->pos += l;
+        k += l;
+    }
+    return k;
+}
+
+static void shm_detach(shm_in_t *r) {
+    if (r->h == NULL) return;
+    if (r->have) {
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shm_blk(r->h, r->rseq)->seq, memory_order_relaxed) != r->rseq) r->overrun += 1;
+        r->have = 0;
+    }
+    fprintf(stderr, "shm: %s: %llu blocks, %llu lost (overrun)\n", r->name,
+            (unsigned long long)r->blocks, (unsigned long long)r->overrun);
+    if (r->rd >= 0) {
+        atomic_store(&r->h->rd[r->rd].overrun, r->overrun);
+        atomic_store(&r->h->rd[r->rd].pid, 0);
+    }
+    munmap(r->h, r->maplen);
+    r->h = NULL;
+}
+#endif
+
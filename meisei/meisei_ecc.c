@@ -196,32 +196,34 @@ int read_wav_header(FILE *fp) {
 }
 
 
+#include "sample_io.h"  // RS/io/  (gcc -I../ecc -I../io meisei_ecc.c ../io/sample_io.c -lm -pthread)
+
 #define EOF_INT  0x1000000
+#define WAV_BLK  4096
 unsigned long sample_count = 0;
 
+static sio_t sio_wav;  // sample input (RS/io/sample_io.c)
+static int wav_state = 0;  // 0: not open, 1: open, -1: sio_open() failed
+static int wav_blk[WAV_BLK];  // channel 0, converted per block
+static int wav_pos = 0, wav_len = 0;
+
 int read_signed_sample(FILE *fp) {  // int = i32_t
-    int byte, i, ret;         //  EOF -> 0x1000000
-
-    for (i = 0; i < channels; i++) {
-                           // i = 0: links bzw. mono
-        byte = fgetc(fp);
-        if (byte == EOF) return EOF_INT;
-        if (i == 0) ret = byte;
-
-        if (bits_sample == 16) {
-            byte = fgetc(fp);
-            if (byte == EOF) return EOF_INT;
-            if (i == 0) ret +=  byte << 8;
-        }
+    int ret;                  //  EOF -> 0x1000000
 
+    if (wav_pos == wav_len) {
+        if (wav_state == 0) {  // first sample: wav data or raw
+            wav_state = sio_open(&sio_wav, fp, bits_sample, channels, sample_rate) < 0 ? -1 : 1;
+        }
+        if (wav_state < 0) return EOF_INT;
+        wav_len = sio_ints(&sio_wav, 0, wav_blk, WAV_BLK);  // ch 0: links bzw. mono
+        wav_pos = 0;
+        if (wav_len == 0) return EOF_INT;
     }
+    ret = wav_blk[wav_pos++];
 
     sample_count++;
 
-    if (bits_sample ==  8) return ret-128;   // 8bit: 00..FF, centerpoint 0x80=128
-    if (bits_sample == 16) return (short)ret;
-
-    return ret;
+    return ret;   // 8bit: 00..FF, centerpoint 0x80=128 -> -128..127; 16bit: short
 }
 
 int par=1, par_alt=1;
@@ -1,10 +1,23 @@
 
+/*
+ *  gcc -O2 -I../io dft_detect.c ../io/sample_io.c -lm -pthread -o dft_detect
+ *  input: wav, - <sr> <bs> (raw), shm:<name> (iq_bus ring, RS/io/), rtl_tcp:<host>[:<port>]?s=<sr>,
+ *         <name>.sigmf-meta, raw:<fmt>:<sr>:<path>, <name>.iqz (iqzip archive)
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <complex.h>
 
+#include "sample_io.h"  // RS/io/ (sio_fopen)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NOSIMD)
+  #define FIR_X86
+  #include <immintrin.h>
+#endif
+
 
 typedef unsigned char  ui8_t;
 typedef unsigned short ui16_t;
@@ -12,6 +25,31 @@ typedef unsigned int   ui32_t;
 typedef short i16_t;
 typedef int   i32_t;
 
+// complex arithmetic on split re/im (limited range):
+// no C99 Annex G inf/nan recovery (__mulsc3/__muldc3), always inlined,
+// independent of -fcx-limited-range/-ffast-math
+static inline float complex c_cf(float re, float im) {
+    float complex z;
+    ((float *)&z)[0] = re;
+    ((float *)&z)[1] = im;
+    return z;
+}
+static inline float complex c_mul(float complex a, float complex b) {  // a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br - ai*bi, ar*bi + ai*br);
+}
+static inline float complex c_mulconj(float complex a, float complex b) {  // a*conj(b)
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(ar*br + ai*bi, ai*br - ar*bi);
+}
+static inline float complex c_mac(float complex acc, float complex a, float complex b) {  // acc + a*b
+    float ar = crealf(a), ai = cimagf(a), br = crealf(b), bi = cimagf(b);
+    return c_cf(crealf(acc) + (ar*br - ai*bi), cimagf(acc) + (ar*bi + ai*br));
+}
+static inline float c_abs2(float complex a) {  // |a|^2
+    return crealf(a)*crealf(a) + cimagf(a)*cimagf(a);
+}
+
 
 static int option_verbose = 0,  // ausfuehrliche Anzeige
            option_inv = 0,      // invertiert Signal
@@ -176,10 +214,9 @@ static double dsp__xlt_fq = 0.0;
 
 static int LOG2N, N_DFT;
 
-static float complex  *ew;
 
 static float complex  *X, *Z, *cx;
-static float *xn;
+static float *xn, *yr;
 static float *db;
 
 // FM: lowpass
@@ -193,54 +230,92 @@ static int dsp__lpIQtaps; // ui32_t
 static float complex *lpIQ_buf;
 
 
-static void dft_raw(float complex *Z) {
-    int s, l, l2, i, j, k;
-    float complex  w1, w2, T;
+// FFT plan: tw[k] = exp(-2pi*I*k/N_DFT) (k < N_DFT/2), bit-reversal table
+// for N_DFT/2 (real transform); built once in init_buffers()
+static float complex *tw;
+static int *brv;
+
+static void fft_raw(float complex *Z, int log2n, int *br) {
+    int s, l, l2, i, j, k, st;
+    int n = 1 << log2n;
+    float complex  w, T;
 
-    j = 1;
-    for (i = 1; i < N_DFT; i++) {
+    for (i = 0; i < n; i++) {
+        j = br[i];
         if (i < j) {
-            T = Z[j-1];
-            Z[j-1] = Z[i-1];
-            Z[i-1] = T;
-        }
-        k = N_DFT/2;
-        while (k < j) {
-            j = j - k;
-            k = k/2;
+            T = Z[j];
+            Z[j] = Z[i];
+            Z[i] = T;
         }
-        j = j + k;
     }
 
-    for (s = 0; s < LOG2N; s++) {
+    for (s = 0; s < log2n; s++) {
         l2 = 1 << s;
         l  = l2 << 1;
-        w1 = (float complex)1.0;
-        w2 = ew[s]; // cexp(-I*M_PI/(float)l2)
-        for (j = 1; j <= l2; j++) {
-            for (i = j; i <= N_DFT; i += l) {
-                k = i + l2;
-                T = Z[k-1] * w1;
-                Z[k-1] = Z[i-1] - T;
-                Z[i-1] = Z[i-1] + T;
+        st = N_DFT / l; // cexp(-I*M_PI*j/(float)l2) = tw[j*st]
+        for (i = 0; i < n; i += l) {
+            for (j = 0; j < l2; j++) {
+                w = tw[j*st];
+                k = i + j;
+                T = c_mul(Z[k+l2], w);
+                Z[k+l2] = Z[k] - T;
+                Z[k]    = Z[k] + T;
             }
-            w1 = w1 * w2;
         }
     }
 }
 
+// real input, N_DFT/2-point complex FFT; Z[0..N_DFT-1] (hermitian)
 static void dft(float *x, float complex *Z) {
-    int i;
-    for (i = 0; i < N_DFT; i++)  Z[i] = (float complex)x[i];
-    dft_raw(Z);
+    int k;
+    int N2 = N_DFT/2;
+    float complex  Xe, Xo, a, b, d;
+
+    for (k = 0; k < N2; k++)  Z[k] = c_cf(x[2*k], x[2*k+1]);
+    fft_raw(Z, LOG2N-1, brv);
+
+    a = Z[0];
+    Z[0]  = crealf(a) + cimagf(a);
+    Z[N2] = crealf(a) - cimagf(a);
+    for (k = 1; k <= N2/2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        d = a - b;
+        Xe = 0.5f*(a + b);
+        Xo = c_cf(0.5f*cimagf(d), -0.5f*crealf(d)); // -0.5*I*(a-b)
+        Z[k]    = Xe + c_mul(tw[k], Xo);
+        Z[N2-k] = conjf(Xe) + c_mul(tw[N2-k], conjf(Xo));
+    }
+    for (k = N2+1; k < N_DFT; k++)  Z[k] = conjf(Z[N_DFT-k]);
 }
 
-static void Nidft(float complex *Z, float complex *z) {
-    int i;
-    for (i = 0; i < N_DFT; i++)  z[i] = conj(Z[i]);
-    dft_raw(z);
-    // idft():
-    // for (i = 0; i < N_DFT; i++)  z[i] = conj(z[i])/(float)N_DFT; // hier: z reell
+// real output x = N_DFT*idft(Z), reads Z[0..N_DFT/2]; z: N_DFT/2 work buffer
+static void Nidft_re(float complex *Z, float complex *z, float *x) {
+    int k;
+    int N2 = N_DFT/2;
+    float complex  Xe, Xo, a, b;
+
+    for (k = 0; k < N2; k++) {
+        a = Z[k];
+        b = conjf(Z[N2-k]);
+        Xe = a + b;
+        Xo = c_mulconj(a - b, tw[k]);
+        z[k] = c_cf(crealf(Xe) - cimagf(Xo), -(cimagf(Xe) + crealf(Xo))); // conj(Xe + I*Xo)
+    }
+    fft_raw(z, LOG2N-1, brv);
+    for (k = 0; k < N2; k++) {
+        x[2*k  ] =  crealf(z[k]);
+        x[2*k+1] = -cimagf(z[k]);
+    }
+}
+
+static int bitrev(int i, int log2n) {
+    int j = 0;
+    while (log2n-- > 0) {
+        j = (j << 1) | (i & 1);
+        i >>= 1;
+    }
+    return j;
 }
 
 static float freq2bin(int f) {
@@ -294,15 +369,15 @@ static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpo
 
     if (option_iq) {
         // FM-lowpass(xn)
-        for (i = 0; i < N_DFT; i++) X[i] *= WS[rshd->lpFM][i];
+        for (i = 0; i <= N_DFT/2; i++) X[i] = c_mul(X[i], WS[rshd->lpFM][i]);
     }
 
     if (option_dc || option_iq) { // mx = mx(xn[]), xn(lowpass, dc)
-        Nidft(X, cx);
-        for (i = 0; i < N_DFT; i++) xn[i] = creal(cx[i])/(float)N_DFT;
+        Nidft_re(X, cx, xn);
+        for (i = 0; i < N_DFT; i++) xn[i] /= (float)N_DFT;
     }
-    for (i = 0; i < N_DFT; i++) Z[i] = X[i] * rshd->Fm[i];
-    Nidft(Z, cx);
+    for (i = 0; i <= N_DFT/2; i++) Z[i] = c_mul(X[i], rshd->Fm[i]);
+    Nidft_re(Z, cx, yr);
 
 
     // relativ Peak - Normierung erst zum Schluss;
@@ -312,7 +387,7 @@ static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpo
     //
     mx2 = 0.0;                                 // t = L-1
     for (i = rshd->L-1; i < K+rshd->L; i++) {  // i=t .. i=t+K < t+1+K
-        re_cx = creal(cx[i]);  // imag(cx)=0
+        re_cx = yr[i];
         //if (fabs(re_cx) > fabs(mx)) {
         if (re_cx*re_cx > mx2) {
             mx = re_cx;
@@ -345,6 +420,125 @@ static int getCorrDFT(int K, unsigned int pos, float *maxv, unsigned int *maxvpo
 
 /* ------------------------------------------------------------------------------------ */
 
+// correlator bank: all headers j <= jmax on one window of K+Lbank samples;
+// one forward DFT per IF-lowpass buffer (lpIQ), one FM-lowpass/norm pass
+// per (lpIQ,lpFM), then per header only the product X*Fm and one inverse.
+// header j with L=rs_hdr[j].L sits at offset D=Lbank-L in the common window,
+// i.e. cx[i+D] = cx_j[i] , i = L-1 .. K+L-1 (same as getCorrDFT()).
+static int Lbank;
+static float *xf;
+
+static int getCorrDFT_bank(int K, unsigned int pos, float *maxv, unsigned int *maxvpos, int *mpv, int jmax) {
+    int i, j, g, f;
+    int W = K + Lbank;
+    int use;
+
+    if (W > N_DFT) return -1;
+
+    if (pos == 0) pos = sample_out;
+
+    for (j = 0; j <= jmax; j++) mpv[j] = -1;
+
+    for (g = 0; g < 3; g++) // lpIQ
+    {
+        use = 0;
+        for (j = 0; j <= jmax; j++) if (rs_hdr[j].Fm && rs_hdr[j].lpIQ == g) use = 1;
+        if (!use) continue;
+
+        bufs = buf_fm[g];
+        for (i = 0; i < W; i++) xn[i] = bufs[(pos+M -(W-1) + i) % M];
+        while (i < N_DFT) xn[i++] = 0.0;
+
+        dft(xn, X);
+
+        for (f = 0; f < 2; f++) // lpFM
+        {
+            float *xs = xn;
+            float ws0 = 1.0;
+
+            use = 0;
+            for (j = 0; j <= jmax; j++) {
+                if (rs_hdr[j].Fm && rs_hdr[j].lpIQ == g && (rs_hdr[j].lpFM == f || !option_iq)) use = 1;
+            }
+            if (!use) continue;
+
+            if (option_iq) {
+                // FM-lowpass(xn)
+                for (i = 0; i <= N_DFT/2; i++) Y[i] = c_mul(X[i], WS[f][i]);
+                Nidft_re(Y, cx, xf);
+                for (i = 0; i < N_DFT; i++) xf[i] /= (float)N_DFT;
+                xs = xf;
+                ws0 = crealf(WS[f][0]);
+            }
+            else {
+                for (i = 0; i <= N_DFT/2; i++) Y[i] = X[i];
+            }
+
+            for (j = 0; j <= jmax; j++)
+            {
+                rsheader_t *rshd = rs_hdr+j;
+                int L = rshd->L;
+                int D = Lbank - L;
+                int mp = -1;
+                float mx = 0.0, mx2 = 0.0, re_cx;
+                double xnorm, xd;
+                double dc = 0.0;
+
+                if (rshd->Fm == NULL || rshd->lpIQ != g) continue;
+                if (option_iq && rshd->lpFM != f) continue;
+                if (!option_iq && f > 0) continue;
+#ifdef NOC34C50
+                if ( strncmp(rshd->type, "C34C50", 6) == 0 ) continue;
+#endif
+                rshd->dc = 0.0;
+                maxv[j] = 0.0;
+
+                if (option_dc) {
+                    for (i = K-L; i < K+L; i++) dc += xn[i+D]; // only last 2L samples (avoid M10 carrier offset)
+                    dc /= 2.0*(float)L;
+                }
+                rshd->dc = dc;
+
+                for (i = 0; i <= N_DFT/2; i++) Z[i] = c_mul(Y[i], rshd->Fm[i]);
+                if (option_dc) Z[0] -= N_DFT*dc * 0.98 * ws0 * rshd->Fm[0];
+                Nidft_re(Z, cx, yr);
+
+                for (i = Lbank-1; i < K+Lbank; i++) {
+                    re_cx = yr[i];
+                    if (re_cx*re_cx > mx2) {
+                        mx = re_cx;
+                        mx2 = mx*mx;
+                        mp = i;
+                    }
+                }
+                if (mp == Lbank-1 || mp == K+Lbank-1) continue; // Randwert
+
+                xnorm = 0.0;
+                for (i = 0; i < L; i++) {
+                    xd = xs[mp-i];
+                    if (option_dc) xd -= dc * 0.98 * ws0;
+                    xnorm += xd*xd;
+                }
+                xnorm = sqrt(xnorm);
+
+                mx /= xnorm*N_DFT;
+
+                maxv[j] = mx;
+                maxvpos[j] = pos - (W-1) + mp;
+                if (option_iq) maxvpos[j] -= dsp__lpFMtaps/2;  // lowpass delay
+
+                if (option_dc) {
+                    rshd->df = rshd->dc / (2.0*FM_GAIN*dsp__decM);  // freq offset estimate
+                }
+
+                mpv[j] = mp - D;
+            }
+        }
+    }
+
+    return 0;
+}
+
 static int findstr(char *buff, char *str, int pos) {
     int i;
     for (i = 0; i < 4; i++) {
@@ -601,14 +795,141 @@ static float complex lowpass(float complex buffer[], ui32_t sample, ui32_t taps,
 }
 
 
+/* ------------------------------------------------------------------------------------ */
+
+/*
+ * FM discriminator: s[k] = gain * arg(z[k]*conj(z0[k])) / pi
+ * branch-free atan2: octant reduction, t = min/max in [0,1],
+ * atan(t)/pi = t*P(t^2), P minimax deg 5; |err| < 2e-6 rad
+ * (FM bit decision margin ~ h*pi/sps >> 1e-3 rad)
+ */
+#define ATP1  ((float)( 0.99997726/M_PI))
+#define ATP3  ((float)(-0.33262347/M_PI))
+#define ATP5  ((float)( 0.19354346/M_PI))
+#define ATP7  ((float)(-0.11643287/M_PI))
+#define ATP9  ((float)( 0.05265332/M_PI))
+#define ATP11 ((float)(-0.01172120/M_PI))
+
+static float atan2pi(float y, float x) {  // atan2(y,x)/pi
+    float ax = fabsf(x), ay = fabsf(y);
+    float mx = fmaxf(ax, ay), mn = fminf(ax, ay);
+    float t = mn / fmaxf(mx, 1e-30f);
+    float t2 = t*t;
+    float a = t*(ATP1+t2*(ATP3+t2*(ATP5+t2*(ATP7+t2*(ATP9+t2*ATP11)))));
+    a = (ay > ax) ? 0.5f-a : a;
+    a = (x < 0) ? 1.0f-a : a;
+    return copysignf(a, y);
+}
+
+static void fmdisc_c(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    int k;
+    for (k = 0; k < n; k++) {
+        float wr = x[2*k  ]*x0[2*k] + x[2*k+1]*x0[2*k+1];
+        float wi = x[2*k+1]*x0[2*k] - x[2*k  ]*x0[2*k+1];
+        s[k] = gain * atan2pi(wi, wr);
+    }
+}
+
+#ifdef FIR_X86
+static __m128 atan2pi_sse(__m128 y, __m128 x) {
+    const __m128 sgn = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sgn, x), ay = _mm_andnot_ps(sgn, y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    __m128 t = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(1e-30f)));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 a, m;
+    a = _mm_add_ps(_mm_set1_ps(ATP9), _mm_mul_ps(t2, _mm_set1_ps(ATP11)));
+    a = _mm_add_ps(_mm_set1_ps(ATP7), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP5), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP3), _mm_mul_ps(t2, a));
+    a = _mm_add_ps(_mm_set1_ps(ATP1), _mm_mul_ps(t2, a));
+    a = _mm_mul_ps(t, a);
+    m = _mm_cmpgt_ps(ay, ax);
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(0.5f), a)), _mm_andnot_ps(m, a));
+    m = _mm_cmplt_ps(x, _mm_setzero_ps());
+    a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(1.0f), a)), _mm_andnot_ps(m, a));
+    return _mm_or_ps(a, _mm_and_ps(sgn, y));
+}
+
+static void fmdisc_sse(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m128 a, b, zr, zi, pr, pi, wr, wi;
+    int k;
+    for (k = 0; k+4 <= n; k += 4) {
+        a = _mm_loadu_ps(x+2*k); b = _mm_loadu_ps(x+2*k+4);
+        zr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm_loadu_ps(x0+2*k); b = _mm_loadu_ps(x0+2*k+4);
+        pr = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm_add_ps(_mm_mul_ps(zr, pr), _mm_mul_ps(zi, pi));
+        wi = _mm_sub_ps(_mm_mul_ps(zi, pr), _mm_mul_ps(zr, pi));
+        _mm_storeu_ps(s+k, _mm_mul_ps(_mm_set1_ps(gain), atan2pi_sse(wi, wr)));
+    }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
+
+__attribute__((target("avx2,fma")))
+static __m256 atan2pi_avx2(__m256 y, __m256 x) {
+    const __m256 sgn = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(sgn, x), ay = _mm256_andnot_ps(sgn, y);
+    __m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+    __m256 t = _mm256_div_ps(mn, _mm256_max_ps(mx, _mm256_set1_ps(1e-30f)));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 a;
+    a = _mm256_fmadd_ps(t2, _mm256_set1_ps(ATP11), _mm256_set1_ps(ATP9));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP7));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP5));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP3));
+    a = _mm256_fmadd_ps(t2, a, _mm256_set1_ps(ATP1));
+    a = _mm256_mul_ps(t, a);
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(0.5f), a), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(1.0f), a), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+    return _mm256_or_ps(a, _mm256_and_ps(sgn, y));
+}
+
+// shuffle_ps deinterleaves per 128-bit lane: sample order 0,1,4,5,2,3,6,7 -> permute4x64 back
+__attribute__((target("avx2,fma")))
+static void fmdisc_avx2(const float complex *z, const float complex *z0, float *s, int n, float gain) {
+    const float *x = (const float*)z, *x0 = (const float*)z0;
+    __m256 a, b, zr, zi, pr, pi, wr, wi, v;
+    int k;
+    for (k = 0; k+8 <= n; k += 8) {
+        a = _mm256_loadu_ps(x+2*k); b = _mm256_loadu_ps(x+2*k+8);
+        zr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        zi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        a = _mm256_loadu_ps(x0+2*k); b = _mm256_loadu_ps(x0+2*k+8);
+        pr = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+        pi = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+        wr = _mm256_fmadd_ps(zr, pr, _mm256_mul_ps(zi, pi));
+        wi = _mm256_fmsub_ps(zi, pr, _mm256_mul_ps(zr, pi));
+        v = _mm256_mul_ps(_mm256_set1_ps(gain), atan2pi_avx2(wi, wr));
+        v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0)));
+        _mm256_storeu_ps(s+k, v);
+    }
+    if (k+4 <= n) { fmdisc_sse(z+k, z0+k, s+k, n-k, gain); return; }
+    fmdisc_c(z+k, z0+k, s+k, n-k, gain);
+}
+#endif
+
+static void (*fmdisc)(const float complex *, const float complex *, float *, int, float) = fmdisc_c;
+
+static void fm_select() {
+#ifdef FIR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) fmdisc = fmdisc_avx2;
+    else if (__builtin_cpu_supports("sse2")) fmdisc = fmdisc_sse;
+#endif
+}
+
+
 static int f32buf_sample(FILE *fp, int inv) {
     float _s = 0.0;
-    float s[3];
-    static float complex z0_fm0;
-    static float complex z0_fm1;
-    static float complex z0;
-    float complex z_fm0=0, z_fm1=0;
-    float complex z, w;
+    float s[4];
+    static float complex z0[4]; // z0_fm0, z0_fm1, z0
+    float complex zn[4] = {0};  // z_fm0, z_fm1, z (4: SSE block)
+    float complex z;
     double gain = FM_GAIN;
     int i;
 
@@ -619,7 +940,7 @@ static int f32buf_sample(FILE *fp, int inv) {
             int j;
             if ( f32read_cblock(fp) < dsp__decM ) return EOF;
             for (j = 0; j < dsp__decM; j++) {
-                dsp__decXbuffer[dsp__sample_dec % dsp__dectaps] = dsp__decMbuf[j] * dsp__ex[dsp__sample_dec % dsp__lut_len];
+                dsp__decXbuffer[dsp__sample_dec % dsp__dectaps] = c_mul(dsp__decMbuf[j], dsp__ex[dsp__sample_dec % dsp__lut_len]);
                 dsp__sample_dec += 1;
                 if (dsp__sample_dec == s_reset) dsp__sample_dec = 0;
             }
@@ -633,21 +954,13 @@ static int f32buf_sample(FILE *fp, int inv) {
         // b) 3 FM-streams
         //
         lpIQ_buf[sample_in % dsp__lpIQtaps] = z;
-        z_fm0 = lowpass(lpIQ_buf, sample_in, dsp__lpIQtaps, ws_lpIQ[0]);
-        z_fm1 = lowpass(lpIQ_buf, sample_in, dsp__lpIQtaps, ws_lpIQ[1]);
+        zn[0] = lowpass(lpIQ_buf, sample_in, dsp__lpIQtaps, ws_lpIQ[0]);
+        zn[1] = lowpass(lpIQ_buf, sample_in, dsp__lpIQtaps, ws_lpIQ[1]);
+        zn[2] = z;
 
         // IQ: different modulation indices h=h(rs) -> FM-demod
-        w = z_fm0 * conj(z0_fm0);
-        s[0] = gain * carg(w)/M_PI;
-        z0_fm0 = z_fm0;
-
-        w = z_fm1 * conj(z0_fm1);
-        s[1] = gain * carg(w)/M_PI;
-        z0_fm1 = z_fm1;
-
-        w = z * conj(z0);
-        s[2] = gain * carg(w)/M_PI;
-        z0 = z;
+        fmdisc(zn, z0, s, 4, gain);  // s[i] = gain * carg(zn[i]*conj(z0[i]))/M_PI
+        for (i = 0; i < 3; i++) z0[i] = zn[i];
     }
     else
     {
@@ -802,6 +1115,8 @@ static int init_buffers() {
     sr_base = sample_rate;
     sr_if = sample_rate;
 
+    fm_select();
+
 
     if (option_iq == 5)
     {
@@ -927,6 +1242,7 @@ static int init_buffers() {
 
     // L = hLen * sample_rate/2500.0 + 0.5; // max(hLen*spb)
     L = 2*Lmax;
+    Lbank = Lmax;
 
     M = 3*L;
     //if (samples_per_bit < 6) M = 6*N;
@@ -953,17 +1269,18 @@ static int init_buffers() {
 
 
     xn = calloc(N_DFT+1, sizeof(float));  if (xn == NULL) return -1;
+    yr = calloc(N_DFT+1, sizeof(float));  if (yr == NULL) return -1;
+    xf = calloc(N_DFT+1, sizeof(float));  if (xf == NULL) return -1;
     db = calloc(N_DFT+1, sizeof(float));  if (db == NULL) return -1;
 
-    ew = calloc(LOG2N+1, sizeof(float complex));  if (ew == NULL) return -1;
+    tw   = calloc(N_DFT/2+1, sizeof(float complex));  if (tw   == NULL) return -1;
+    brv  = calloc(N_DFT/2+1, sizeof(int));            if (brv  == NULL) return -1;
     X  = calloc(N_DFT+1, sizeof(float complex));  if (X  == NULL) return -1;
     Z  = calloc(N_DFT+1, sizeof(float complex));  if (Z  == NULL) return -1;
     cx = calloc(N_DFT+1, sizeof(float complex));  if (cx == NULL) return -1;
 
-    for (n = 0; n < LOG2N; n++) {
-        k = 1 << n;
-        ew[n] = cexp(-I*M_PI/(float)k);
-    }
+    for (k = 0; k < N_DFT/2; k++)  tw[k] = cexp(-2*M_PI*I*k/(double)N_DFT);
+    for (k = 0; k < N_DFT/2; k++)  brv[k]  = bitrev(k, LOG2N-1);
 
     match = (float *)calloc( L+1, sizeof(float)); if (match == NULL) return -1;
     m = (float *)calloc(N_DFT+1, sizeof(float));  if (m  == NULL) return -1;
@@ -1017,8 +1334,8 @@ static int init_buffers() {
             while (i < N_DFT) m[i++] = 0.0;
             dft(m, WS[j]);
         }
-        Y = (float complex *)calloc(N_DFT+1, sizeof(float complex));  if (Y == NULL) return -1;
     }
+    Y = (float complex *)calloc(N_DFT+1, sizeof(float complex));  if (Y == NULL) return -1;
 
 
     free(match); match = NULL;
@@ -1038,7 +1355,11 @@ static int free_buffers() {
 
     if (xn) { free(xn); xn = NULL; }
     if (db) { free(xn); xn = NULL; }
-    if (ew) { free(ew); ew = NULL; }
+    if (yr) { free(yr); yr = NULL; }
+    if (xf) { free(xf); xf = NULL; }
+    if (Y)  { free(Y);  Y  = NULL; }
+    if (tw)   { free(tw);   tw   = NULL; }
+    if (brv)  { free(brv);  brv  = NULL; }
     if (X)  { free(X);  X  = NULL; }
     if (Z)  { free(Z);  Z  = NULL; }
     if (cx) { free(cx); cx = NULL; }
@@ -1063,7 +1384,6 @@ static int free_buffers() {
             if (ws_lpFM[j]) { free(ws_lpFM[j]); ws_lpFM[j] = NULL; }
             if (WS[j]) { free(WS[j]); WS[j] = NULL; }
         }
-        if (Y) { free(Y); Y = NULL; }
 
         for (j = 0; j < 1; j++) {
             if (ws_lpIQ[j]) { free(ws_lpIQ[j]); ws_lpIQ[j] = NULL; }
@@ -1150,7 +1470,7 @@ int main(int argc, char **argv) {
             else return -50;
         }
         else {
-            fp = fopen(*argv, "rb");
+            fp = sio_fopen(*argv);
             if (fp == NULL) {
                 fprintf(stderr, "%s konnte nicht geoeffnet werden\n", *argv);
                 return -50;
@@ -1197,13 +1517,8 @@ int main(int argc, char **argv) {
         k += 1;
 
         if (k >= K-4) {
-            for (j = 0; j <= idxIMETs; j++) { // incl. IMET-preamble
-#ifdef NOC34C50
-                if ( strncmp(rs_hdr[j].type, "C34C50", 6) == 0 ) continue;
-#endif
-                mv0_pos[j] = mv_pos[j];
-                mp[j] = getCorrDFT(K, 0, mv+j, mv_pos+j, rs_hdr+j);
-            }
+            for (j = 0; j <= idxIMETs; j++) mv0_pos[j] = mv_pos[j];
+            getCorrDFT_bank(K, 0, mv, mv_pos, mp, idxIMETs); // incl. IMET-preamble
             k = 0;
         }
         else {